@@ -3,6 +3,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include <assert.h>
 
@@ -22,13 +23,110 @@
 #define ALACODER_CALCULATE_RICE_PARAMETER(mean) \
   ALAUtility_RoundUp2Powered(ALAUTILITY_MAX(ALACODER_FIXED_FLOAT_TO_UINT32((mean) >> 1), 1UL))
 
+/* 推定平均値の初期値の記録ビット数 */
+#define ALACODER_INITIAL_MEAN_BITS              16
+
+/* チャンネル毎のサブストリームのバイト数の記録ビット数 */
+#define ALACODER_SUBSTREAM_SIZE_BITS            32
+/* サンプルあたりのペイロードの最大バイト数（rANSはトークンと生ビットの情報量で抑えられる） */
+#define ALACODER_MAX_PAYLOAD_BYTES_PER_SAMPLE   8
+/* 復号時の読み過ぎを許す余白のバイト数（rANSの1回のレーン巡回で読む最大バイト数以上） */
+#define ALACODER_PAYLOAD_BUFFER_MARGIN          32
+
+/* 短い配列のライス符号パラメータ（2の冪指数）の記録ビット数 */
+#define ALACODER_SMALL_DATA_RICE_PARAMETER_BITS 4
+/* 短い配列のライス符号パラメータ（2の冪指数）の最大値 */
+#define ALACODER_SMALL_DATA_MAX_RICE_PARAMETER  ((1UL << ALACODER_SMALL_DATA_RICE_PARAMETER_BITS) - 1)
+
+/* rANSのレーン数（独立な状態をサンプル毎に巡回して使い、復号の依存関係を断つ） */
+#define ALACODER_RANS_NUM_LANES             4
+/* rANSの確率の精度ビット数（頻度表の合計は2の冪） */
+#define ALACODER_RANS_PROBABILITY_BITS      10
+/* rANSの確率の精度マスク */
+#define ALACODER_RANS_PROBABILITY_MASK      ((1UL << ALACODER_RANS_PROBABILITY_BITS) - 1)
+/* rANSの状態の下限（状態は[下限, 2^31)に保ち、バイト単位で入出力する） */
+#define ALACODER_RANS_LOWER_BOUND           (1UL << 23)
+/* 値をそのままトークンにする範囲（以降は1オクターブを2つのトークンに分ける） */
+#define ALACODER_RANS_NUM_DIRECT_TOKENS     16
+/* トークン数 */
+#define ALACODER_RANS_NUM_TOKENS            72
+/* 1回で状態に出し入れする生ビット数の最大値 */
+#define ALACODER_RANS_MAX_BYPASS_BITS       16
+/* シフト量の記録ビット数 */
+#define ALACODER_RANS_SHIFT_BITS            5
+/* 最大トークンの記録ビット数 */
+#define ALACODER_RANS_TOKEN_BITS            7
+/* シフト量の探索候補数 */
+#define ALACODER_RANS_NUM_SHIFT_CANDIDATES  6
+/* 復号時の正規化（状態が下限を下回ったらバイトを読み込む） */
+#define ALACODER_RANS_RENORMALIZE(state, ptr) {\
+  while ((state) < ALACODER_RANS_LOWER_BOUND) {\
+    (state) = ((state) << 8) | *(ptr)++;\
+  }\
+}
+
 /* 固定小数点型 */
 typedef uint64_t ALACoderFixedFloat;
 
+/* 残差の符号化法 */
+typedef enum ALACoderMethodTag {
+  ALACODER_METHOD_RICE = 0,   /* 適応Rice符号 */
+  ALACODER_METHOD_RANS        /* ブロック毎の頻度表によるrANS */
+} ALACoderMethod;
+
 /* 符号化/復号ハンドル */
 struct ALACoder {
   ALACoderFixedFloat* estimated_mean;
   uint32_t            max_num_channels;
+  uint8_t*            payload_buffer;       /* 1チャンネル分のペイロード（rANSの符号化時は末尾から前に向かって書く） */
+  uint32_t            payload_buffer_size;  /* ペイロード領域のバイト数（余白を除く） */
+  const uint8_t*      rans_payload;         /* rANS符号化したペイロードの先頭 */
+  uint32_t            rans_payload_size;    /* rANS符号化したペイロードのバイト数 */
+  uint32_t            rans_shift;           /* シフト量（下位ビットは生ビットで記録） */
+  uint32_t            rans_max_token;       /* 最大トークン */
+  uint32_t            rans_freq[ALACODER_RANS_NUM_TOKENS];    /* トークンの頻度 */
+  uint32_t            rans_cumfreq[ALACODER_RANS_NUM_TOKENS]; /* トークンの累積頻度 */
+  uint8_t             rans_slot_token[1UL << ALACODER_RANS_PROBABILITY_BITS]; /* 頻度スロットからトークンへの表（復号用） */
+};
+
+/* メモリ上へのビット書き出し（Rice符号のペイロード） */
+struct ALACoderBitWriter {
+  uint8_t*        ptr;          /* 次に書き出すバイト */
+  uint32_t        bit_buffer;   /* 書き出していないビット（下位bit_countビットが有効） */
+  uint32_t        bit_count;    /* bit_bufferの有効ビット数 */
+};
+
+/* メモリ上からのビット読み込み（Rice符号のペイロード） */
+struct ALACoderBitReader {
+  const uint8_t*  ptr;          /* 次に読み込むバイト */
+  const uint8_t*  end;          /* ペイロードの末尾 */
+  uint32_t        bit_buffer;   /* 読み込んだビット（下位bit_countビットが未使用） */
+  uint32_t        bit_count;    /* bit_bufferの未使用ビット数 */
+  uint32_t        overrun;      /* 末尾を超えて読もうとしたか？ */
+};
+
+/* トークンが表す値の下限 */
+static const uint32_t rans_token_base[ALACODER_RANS_NUM_TOKENS] = {
+  0x00000000UL, 0x00000001UL, 0x00000002UL, 0x00000003UL, 0x00000004UL, 0x00000005UL,
+  0x00000006UL, 0x00000007UL, 0x00000008UL, 0x00000009UL, 0x0000000AUL, 0x0000000BUL,
+  0x0000000CUL, 0x0000000DUL, 0x0000000EUL, 0x0000000FUL, 0x00000010UL, 0x00000018UL,
+  0x00000020UL, 0x00000030UL, 0x00000040UL, 0x00000060UL, 0x00000080UL, 0x000000C0UL,
+  0x00000100UL, 0x00000180UL, 0x00000200UL, 0x00000300UL, 0x00000400UL, 0x00000600UL,
+  0x00000800UL, 0x00000C00UL, 0x00001000UL, 0x00001800UL, 0x00002000UL, 0x00003000UL,
+  0x00004000UL, 0x00006000UL, 0x00008000UL, 0x0000C000UL, 0x00010000UL, 0x00018000UL,
+  0x00020000UL, 0x00030000UL, 0x00040000UL, 0x00060000UL, 0x00080000UL, 0x000C0000UL,
+  0x00100000UL, 0x00180000UL, 0x00200000UL, 0x00300000UL, 0x00400000UL, 0x00600000UL,
+  0x00800000UL, 0x00C00000UL, 0x01000000UL, 0x01800000UL, 0x02000000UL, 0x03000000UL,
+  0x04000000UL, 0x06000000UL, 0x08000000UL, 0x0C000000UL, 0x10000000UL, 0x18000000UL,
+  0x20000000UL, 0x30000000UL, 0x40000000UL, 0x60000000UL, 0x80000000UL, 0xC0000000UL
+};
+
+/* トークンに続く値の下位ビット数 */
+static const uint32_t rans_token_extra_bits[ALACODER_RANS_NUM_TOKENS] = {
+   0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  0,  3,  3,
+   4,  4,  5,  5,  6,  6,  7,  7,  8,  8,  9,  9, 10, 10, 11, 11, 12, 12,
+  13, 13, 14, 14, 15, 15, 16, 16, 17, 17, 18, 18, 19, 19, 20, 20, 21, 21,
+  22, 22, 23, 23, 24, 24, 25, 25, 26, 26, 27, 27, 28, 28, 29, 29, 30, 30
 };
 
 /* ライス符号の出力 */
@@ -62,12 +160,16 @@ static uint32_t ALACoder_GetRiceCode(
 
   assert(strm != NULL);
   
-  /* 商部分を取得 */
+  /* 商部分を取得（終端に達したら打ち切る） */
   quot = 0;
-  BitStream_GetBit(strm, &bit);
+  if (BitStream_GetBit(strm, &bit) != BITSTREAM_APIRESULT_OK) {
+    return 0;
+  }
   while (bit == 0) {
     quot++;
-    BitStream_GetBit(strm, &bit);
+    if (BitStream_GetBit(strm, &bit) != BITSTREAM_APIRESULT_OK) {
+      return 0;
+    }
   }
 
   /* 剰余部分を取得 */
@@ -84,8 +186,47 @@ static uint32_t ALACoder_GetRiceCode(
   return (rice_parameter * quot + rest);
 }
 
+/* 推定平均値の初期値（配列の平均）の計算 */
+/* code_sumがNULLでなければ、予測時に求めた符号なし整数に変換した値の和を使い、配列を走査しない */
+static ALACoderFixedFloat ALACoder_CalculateInitialMean(
+    const int32_t* data, const uint64_t* code_sum, uint32_t num_samples)
+{
+  uint32_t smpl;
+  uint64_t mean_uint = 0;
+
+  assert((data != NULL) && (num_samples > 0));
+
+  if (code_sum != NULL) {
+    mean_uint = (*code_sum);
+  } else {
+    for (smpl = 0; smpl < num_samples; smpl++) {
+      mean_uint += ALAUTILITY_SINT32_TO_UINT32(data[smpl]);
+    }
+  }
+  mean_uint /= num_samples;
+  /* 平均の最大は記録ビット数で表せる最大値に制限 */
+  mean_uint = ALAUTILITY_MIN(mean_uint, (1UL << ALACODER_INITIAL_MEAN_BITS) - 1);
+
+  return ALACODER_UINT32_TO_FIXED_FLOAT(mean_uint);
+}
+
+/* 各チャンネルの推定平均値の初期値を取得 */
+static void ALACoder_GetInitialMean(
+    struct ALACoder* coder, struct BitStream* strm, uint32_t num_channels)
+{
+  uint32_t ch;
+
+  assert((coder != NULL) && (strm != NULL));
+
+  for (ch = 0; ch < num_channels; ch++) {
+    uint64_t bitsbuf;
+    BitStream_GetBits(strm, ALACODER_INITIAL_MEAN_BITS, &bitsbuf);
+    coder->estimated_mean[ch] = ALACODER_UINT32_TO_FIXED_FLOAT(bitsbuf);
+  }
+}
+
 /* 符号化ハンドルの作成 */
-struct ALACoder* ALACoder_Create(uint32_t max_num_channels)
+struct ALACoder* ALACoder_Create(uint32_t max_num_channels, uint32_t max_num_samples)
 {
   struct ALACoder* coder;
   
@@ -95,6 +236,14 @@ struct ALACoder* ALACoder_Create(uint32_t max_num_channels)
   coder->estimated_mean
     = (ALACoderFixedFloat *)malloc(sizeof(ALACoderFixedFloat) * max_num_channels);
 
+  /* 1チャンネル分のペイロードの作業領域（rANSの最終状態の分を含む） */
+  coder->payload_buffer_size
+    = max_num_samples * ALACODER_MAX_PAYLOAD_BYTES_PER_SAMPLE + 4 * ALACODER_RANS_NUM_LANES;
+  coder->payload_buffer
+    = (uint8_t *)malloc(coder->payload_buffer_size + ALACODER_PAYLOAD_BUFFER_MARGIN);
+  coder->rans_payload       = NULL;
+  coder->rans_payload_size  = 0;
+
   return coder;
 }
 
@@ -102,81 +251,926 @@ struct ALACoder* ALACoder_Create(uint32_t max_num_channels)
 void ALACoder_Destroy(struct ALACoder* coder)
 {
   if (coder != NULL) {
+    free(coder->payload_buffer);
     free(coder->estimated_mean);
     free(coder);
   }
 }
 
-/* 符号付き整数配列の符号化 */
-ALACoderApiResult ALACoder_PutDataArray(
+/* メモリ上へのビット書き出し（1回に24bitまで） */
+static void ALACoder_PutBitsToBuffer(
+    struct ALACoderBitWriter* writer, uint32_t num_bits, uint32_t bits)
+{
+  assert((writer != NULL) && (num_bits <= 24));
+
+  writer->bit_buffer = (writer->bit_buffer << num_bits) | bits;
+  writer->bit_count += num_bits;
+  while (writer->bit_count >= 8) {
+    writer->bit_count -= 8;
+    *(writer->ptr++) = (uint8_t)((writer->bit_buffer >> writer->bit_count) & 0xFF);
+  }
+}
+
+/* メモリ上へのライス符号の出力 */
+static void ALACoder_PutRiceCodeToBuffer(
+    struct ALACoderBitWriter* writer, uint32_t log2_rice_parameter, uint32_t val)
+{
+  uint32_t quot = val >> log2_rice_parameter;
+
+  assert(writer != NULL);
+
+  /* 商部分（0の並び）は8bitずつまとめて出力 */
+  while (quot >= 8) {
+    ALACoder_PutBitsToBuffer(writer, 8, 0);
+    quot -= 8;
+  }
+  ALACoder_PutBitsToBuffer(writer, quot + 1, 1);
+
+  /* 剰余部分の出力（16bitを超える分は上位から先に） */
+  if (log2_rice_parameter > 16) {
+    ALACoder_PutBitsToBuffer(writer, log2_rice_parameter - 16,
+        (uint32_t)((val >> 16) & ((1UL << (log2_rice_parameter - 16)) - 1)));
+    log2_rice_parameter = 16;
+  }
+  ALACoder_PutBitsToBuffer(writer, log2_rice_parameter,
+      (uint32_t)(val & ((1UL << log2_rice_parameter) - 1)));
+}
+
+/* メモリ上から1バイト補充 末尾を超えたら1で埋めて記録する（商の読み込みを必ず止めるため） */
+static uint32_t ALACoder_GetByteFromBuffer(struct ALACoderBitReader* reader)
+{
+  assert(reader != NULL);
+
+  if (reader->ptr < reader->end) {
+    return *(reader->ptr++);
+  }
+  reader->overrun = 1;
+  return 0xFF;
+}
+
+/* メモリ上からのビット読み込み（1回に16bitまで） */
+static uint32_t ALACoder_GetBitsFromBuffer(struct ALACoderBitReader* reader, uint32_t num_bits)
+{
+  assert((reader != NULL) && (num_bits <= 16));
+
+  while (reader->bit_count < num_bits) {
+    reader->bit_buffer = (reader->bit_buffer << 8) | ALACoder_GetByteFromBuffer(reader);
+    reader->bit_count += 8;
+  }
+  reader->bit_count -= num_bits;
+
+  return (uint32_t)((reader->bit_buffer >> reader->bit_count) & ((1UL << num_bits) - 1));
+}
+
+/* メモリ上からのライス符号の取得 */
+static uint32_t ALACoder_GetRiceCodeFromBuffer(
+    struct ALACoderBitReader* reader, uint32_t log2_rice_parameter)
+{
+  uint32_t quot, rest, msb;
+
+  assert(reader != NULL);
+
+  /* 商部分: 未使用ビットが全て0ならまとめて数える */
+  quot = 0;
+  while ((reader->bit_buffer & ((1UL << reader->bit_count) - 1)) == 0) {
+    quot += reader->bit_count;
+    reader->bit_buffer = ALACoder_GetByteFromBuffer(reader);
+    reader->bit_count  = 8;
+  }
+  /* 最初の1の位置まで */
+  msb = ALAUtility_Log2Floor((uint32_t)(reader->bit_buffer & ((1UL << reader->bit_count) - 1)));
+  quot += reader->bit_count - 1 - msb;
+  reader->bit_count = msb;
+
+  /* 剰余部分（16bitを超える分は上位から先に） */
+  if (log2_rice_parameter > 16) {
+    rest = ALACoder_GetBitsFromBuffer(reader, log2_rice_parameter - 16) << 16;
+    rest |= ALACoder_GetBitsFromBuffer(reader, 16);
+  } else {
+    rest = ALACoder_GetBitsFromBuffer(reader, log2_rice_parameter);
+  }
+
+  return (quot << log2_rice_parameter) + rest;
+}
+
+/* 1チャンネルの適応Rice符号のペイロードのビット数 */
+static uint64_t ALACoder_CalculateRicePayloadBits(
+    const int32_t* data, uint32_t num_samples, ALACoderFixedFloat mean)
+{
+  uint32_t smpl, uint, log2_rice_parameter;
+  uint64_t num_bits;
+
+  assert(data != NULL);
+
+  /* 符号化と同じ順序で推定平均値を更新しながら符号長を数える */
+  num_bits = 0;
+  for (smpl = 0; smpl < num_samples; smpl++) {
+    uint = ALAUTILITY_SINT32_TO_UINT32(data[smpl]);
+    log2_rice_parameter = ALAUtility_Log2Ceil(ALACODER_CALCULATE_RICE_PARAMETER(mean));
+    num_bits += (uint >> log2_rice_parameter) + 1 + log2_rice_parameter;
+    ALACODER_UPDATE_ESTIMATED_MEAN(mean, uint);
+  }
+
+  return num_bits;
+}
+
+/* 1チャンネルの適応Rice符号のペイロードを作業領域に作成し、バイト数を返す */
+static uint32_t ALACoder_PutRicePayload(
+    struct ALACoder* coder, const int32_t* data, uint32_t num_samples, ALACoderFixedFloat mean)
+{
+  uint32_t smpl, uint;
+  struct ALACoderBitWriter writer;
+
+  assert((coder != NULL) && (data != NULL));
+
+  writer.ptr        = coder->payload_buffer;
+  writer.bit_buffer = 0;
+  writer.bit_count  = 0;
+  for (smpl = 0; smpl < num_samples; smpl++) {
+    /* 符号なし整数に変換 */
+    uint = ALAUTILITY_SINT32_TO_UINT32(data[smpl]);
+    /* ライス符号化 */
+    ALACoder_PutRiceCodeToBuffer(&writer,
+        ALAUtility_Log2Ceil(ALACODER_CALCULATE_RICE_PARAMETER(mean)), uint);
+    /* 推定平均値を更新 */
+    ALACODER_UPDATE_ESTIMATED_MEAN(mean, uint);
+  }
+
+  /* バイト境界まで0で埋める */
+  if (writer.bit_count > 0) {
+    ALACoder_PutBitsToBuffer(&writer, 8 - writer.bit_count, 0);
+  }
+  assert(writer.ptr <= coder->payload_buffer + coder->payload_buffer_size);
+
+  return (uint32_t)(writer.ptr - coder->payload_buffer);
+}
+
+/* 1チャンネルの適応Rice符号のペイロードの復号 */
+static ALACoderApiResult ALACoder_GetRicePayload(
+    struct ALACoder* coder, uint32_t payload_size,
+    int32_t* data, uint32_t num_samples, ALACoderFixedFloat mean)
+{
+  uint32_t smpl, uint;
+  struct ALACoderBitReader reader;
+
+  assert((coder != NULL) && (data != NULL));
+
+  reader.ptr        = coder->payload_buffer;
+  reader.end        = coder->payload_buffer + payload_size;
+  reader.bit_buffer = 0;
+  reader.bit_count  = 0;
+  reader.overrun    = 0;
+  for (smpl = 0; smpl < num_samples; smpl++) {
+    /* ライス符号を復号 */
+    uint = ALACoder_GetRiceCodeFromBuffer(&reader,
+        ALAUtility_Log2Ceil(ALACODER_CALCULATE_RICE_PARAMETER(mean)));
+    /* 推定平均値を更新 */
+    ALACODER_UPDATE_ESTIMATED_MEAN(mean, uint);
+    /* 符号付き整数に変換 */
+    data[smpl] = ALAUTILITY_UINT32_TO_SINT32(uint);
+  }
+
+  /* 正しいペイロードなら末尾のバイトでちょうど読み終わる */
+  if ((reader.overrun != 0) || (reader.ptr != reader.end)) {
+    return ALACODER_APIRESULT_INVALID_FORMAT;
+  }
+
+  return ALACODER_APIRESULT_OK;
+}
+
+/* 符号付き整数配列の符号化（サンプル毎にチャンネルをインターリーブした順） */
+ALACoderApiResult ALACoder_PutDataArrayInterleaved(
     struct ALACoder* coder, struct BitStream* strm,
-    const int32_t** data, uint32_t num_channels, uint32_t num_samples)
+    const int32_t** data, const uint64_t* code_sums, uint32_t num_channels, uint32_t num_samples)
 {
   uint32_t smpl, ch, uint;
+  uint64_t num_bits;
 
   /* 引数チェック */
   if ((strm == NULL) || (data == NULL) || (coder == NULL)) {
     return ALACODER_APIRESULT_INVALID_ARGUMENT;
   }
 
-  /* 各チャンネルの平均値をセット/記録 */
+  /* 各チャンネルの推定平均値の初期値をセットし、初期値とRice符号の合計ビット数を数える */
+  /* 推定平均値はチャンネル毎に独立に更新するから、インターリーブしても合計はチャンネル毎の和になる */
+  num_bits = 0;
   for (ch = 0; ch < num_channels; ch++) {
-    uint64_t mean_uint = 0;
-    for (smpl = 0; smpl < num_samples; smpl++) {
-      mean_uint += ALAUTILITY_SINT32_TO_UINT32(data[ch][smpl]);
-    }
-    mean_uint /= num_samples;
-    /* 平均の最大は符号無し16bit整数の最大値に制限 */
-    mean_uint = ALAUTILITY_MIN(mean_uint, UINT16_MAX);
-    BitStream_PutBits(strm, 16, mean_uint);
-    coder->estimated_mean[ch] = ALACODER_UINT32_TO_FIXED_FLOAT(mean_uint);
+    coder->estimated_mean[ch] = ALACoder_CalculateInitialMean(data[ch],
+        (code_sums != NULL) ? &code_sums[ch] : NULL, num_samples);
+    num_bits += ALACODER_INITIAL_MEAN_BITS
+      + ALACoder_CalculateRicePayloadBits(data[ch], num_samples, coder->estimated_mean[ch]);
   }
+  if (((num_bits + 7) / 8) > UINT32_MAX) {
+    return ALACODER_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* バイト境界からバイト数を記録（復号側はこのバイト数が揃うまで待てばよい） */
+  BitStream_Flush(strm);
+  BitStream_PutBits(strm, ALACODER_SUBSTREAM_SIZE_BITS, (num_bits + 7) / 8);
 
-  /* 各チャンネル毎に符号化 */
+  /* 各チャンネルの推定平均値の初期値 */
   for (ch = 0; ch < num_channels; ch++) {
-    for (smpl = 0; smpl < num_samples; smpl++) {
-      /* 符号なし整数に変換 */
+    BitStream_PutBits(strm, ALACODER_INITIAL_MEAN_BITS, coder->estimated_mean[ch] >> ALACODER_NUM_FRACTION_PART_BITS);
+  }
+
+  /* サンプル毎に全チャンネルを符号化 */
+  /* 推定平均値はチャンネル毎に独立に更新するから、パラメータはチャンネル毎の順序と同じになる */
+  for (smpl = 0; smpl < num_samples; smpl++) {
+    for (ch = 0; ch < num_channels; ch++) {
       uint = ALAUTILITY_SINT32_TO_UINT32(data[ch][smpl]);
-      /* ライス符号化 */
       ALACoder_PutRiceCode(strm, ALACODER_CALCULATE_RICE_PARAMETER(coder->estimated_mean[ch]), uint);
-      /* 推定平均値を更新 */
       ALACODER_UPDATE_ESTIMATED_MEAN(coder->estimated_mean[ch], uint);
     }
   }
 
+  /* 末尾もバイト境界に揃える */
+  BitStream_Flush(strm);
+
   return ALACODER_APIRESULT_OK;
 }
 
-/* 符号付き整数配列の復号 */
-ALACoderApiResult ALACoder_GetDataArray(
+/* 符号付き整数配列の復号（サンプル毎にチャンネルをインターリーブした順） */
+ALACoderApiResult ALACoder_GetDataArrayInterleaved(
     struct ALACoder* coder, struct BitStream* strm,
     int32_t** data, uint32_t num_channels, uint32_t num_samples)
 {
   uint32_t ch, smpl, uint;
+  uint64_t bitsbuf;
 
   /* 引数チェック */
   if ((strm == NULL) || (data == NULL) || (coder == NULL)) {
     return ALACODER_APIRESULT_INVALID_ARGUMENT;
   }
 
-  /* 平均値初期値の取得 */
-  for (ch = 0; ch < num_channels; ch++) {
-    uint64_t bitsbuf;
-    BitStream_GetBits(strm, 16, &bitsbuf);
-    coder->estimated_mean[ch] = ALACODER_UINT32_TO_FIXED_FLOAT(bitsbuf);
+  /* バイト数が揃っていなければ読まない（メモリ読み込みでは揃うべきバイト数が記録される） */
+  BitStream_Flush(strm);
+  BitStream_GetBits(strm, ALACODER_SUBSTREAM_SIZE_BITS, &bitsbuf);
+  if (BitStream_RequireBytes(strm, (uint32_t)bitsbuf) != BITSTREAM_APIRESULT_OK) {
+    return ALACODER_APIRESULT_INVALID_FORMAT;
   }
 
-  /* 各チャンネル毎に復号 */
-  for (ch = 0; ch < num_channels; ch++) {
-    for (smpl = 0; smpl < num_samples; smpl++) {
-      /* ライス符号を復号 */
+  /* 平均値初期値の取得 */
+  ALACoder_GetInitialMean(coder, strm, num_channels);
+
+  /* サンプル毎に全チャンネルを復号 */
+  for (smpl = 0; smpl < num_samples; smpl++) {
+    for (ch = 0; ch < num_channels; ch++) {
       uint = ALACoder_GetRiceCode(strm, ALACODER_CALCULATE_RICE_PARAMETER(coder->estimated_mean[ch]));
-      /* 推定平均値を更新 */
       ALACODER_UPDATE_ESTIMATED_MEAN(coder->estimated_mean[ch], uint);
-      /* 符号付き整数に変換 */
       data[ch][smpl] = ALAUTILITY_UINT32_TO_SINT32(uint);
     }
   }
 
+  /* 末尾のバイト境界まで読み飛ばす */
+  BitStream_Flush(strm);
+
+  return ALACODER_APIRESULT_OK;
+}
+
+/* 短い配列のライス符号パラメータ（2の冪指数）を選択 符号化ビット数も返す */
+static uint32_t ALACoder_SelectSmallDataRiceParameter(
+    const int32_t* data, uint32_t num_data, uint32_t* num_bits)
+{
+  uint32_t i, k, best_k;
+  uint64_t bits, best_bits;
+
+  assert((data != NULL) && (num_bits != NULL));
+
+  /* 全パラメータでビット数を数えて最小のものを選ぶ（配列が短いので全探索でよい） */
+  best_k = 0;
+  best_bits = UINT64_MAX;
+  for (k = 0; k <= ALACODER_SMALL_DATA_MAX_RICE_PARAMETER; k++) {
+    bits = (uint64_t)num_data * (k + 1);
+    for (i = 0; i < num_data; i++) {
+      bits += ALAUTILITY_SINT32_TO_UINT32(data[i]) >> k;
+    }
+    if (bits < best_bits) {
+      best_bits = bits;
+      best_k    = k;
+    }
+  }
+
+  (*num_bits) = (uint32_t)ALAUTILITY_MIN(best_bits + ALACODER_SMALL_DATA_RICE_PARAMETER_BITS, UINT32_MAX);
+  return best_k;
+}
+
+/* 符号付き整数配列の符号化ビット数の推定 */
+uint64_t ALACoder_EstimateDataArrayBits(
+    const int32_t** data, const uint64_t* code_sums, uint32_t num_channels, uint32_t num_samples)
+{
+  uint32_t ch, smpl, k;
+  uint64_t code_sum, num_bits, best_bits, total_bits;
+
+  assert(data != NULL);
+
+  total_bits = 0;
+  for (ch = 0; ch < num_channels; ch++) {
+    if (code_sums != NULL) {
+      code_sum = code_sums[ch];
+    } else {
+      code_sum = 0;
+      for (smpl = 0; smpl < num_samples; smpl++) {
+        code_sum += ALAUTILITY_SINT32_TO_UINT32(data[ch][smpl]);
+      }
+    }
+    /* パラメータ2^kのRice符号長は n(k+1) + 商の和
+     * 商の和は、下位kビットを一様分布とみなして (sum - n(2^k-1)/2) / 2^k で近似する */
+    best_bits = (uint64_t)num_samples + code_sum;
+    for (k = 1; k < 32; k++) {
+      const uint64_t rest_sum = ((uint64_t)num_samples * ((1UL << k) - 1)) >> 1;
+      num_bits = (uint64_t)num_samples * (k + 1) + ((code_sum - ALAUTILITY_MIN(code_sum, rest_sum)) >> k);
+      best_bits = ALAUTILITY_MIN(best_bits, num_bits);
+    }
+    total_bits += best_bits + ALACODER_SUBSTREAM_SIZE_BITS + 1 + ALACODER_INITIAL_MEAN_BITS;
+  }
+
+  return total_bits;
+}
+
+/* 短い符号付き整数配列の符号化ビット数 */
+uint32_t ALACoder_CalculateSmallDataArrayBits(const int32_t* data, uint32_t num_data)
+{
+  uint32_t num_bits;
+
+  assert(data != NULL);
+
+  (void)ALACoder_SelectSmallDataRiceParameter(data, num_data, &num_bits);
+
+  return num_bits;
+}
+
+/* 短い符号付き整数配列（係数など）の符号化 */
+ALACoderApiResult ALACoder_PutSmallDataArray(
+    struct BitStream* strm, const int32_t* data, uint32_t num_data)
+{
+  uint32_t i, k, num_bits;
+
+  /* 引数チェック */
+  if ((strm == NULL) || (data == NULL)) {
+    return ALACODER_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* パラメータを選択して記録 */
+  k = ALACoder_SelectSmallDataRiceParameter(data, num_data, &num_bits);
+  BitStream_PutBits(strm, ALACODER_SMALL_DATA_RICE_PARAMETER_BITS, k);
+
+  /* ライス符号化 */
+  for (i = 0; i < num_data; i++) {
+    ALACoder_PutRiceCode(strm, 1UL << k, ALAUTILITY_SINT32_TO_UINT32(data[i]));
+  }
+
+  return ALACODER_APIRESULT_OK;
+}
+
+/* 短い符号付き整数配列（係数など）の復号 */
+ALACoderApiResult ALACoder_GetSmallDataArray(
+    struct BitStream* strm, int32_t* data, uint32_t num_data)
+{
+  uint32_t i, k, uint;
+  uint64_t bitsbuf;
+
+  /* 引数チェック */
+  if ((strm == NULL) || (data == NULL)) {
+    return ALACODER_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* パラメータを取得 */
+  BitStream_GetBits(strm, ALACODER_SMALL_DATA_RICE_PARAMETER_BITS, &bitsbuf);
+  k = (uint32_t)bitsbuf;
+
+  /* ライス符号を復号 */
+  for (i = 0; i < num_data; i++) {
+    uint = ALACoder_GetRiceCode(strm, 1UL << k);
+    data[i] = ALAUTILITY_UINT32_TO_SINT32(uint);
+  }
+
+  return ALACODER_APIRESULT_OK;
+}
+
+/* rANSのトークン（値の区分）の取得 */
+static uint32_t ALACoder_RANSGetToken(uint32_t val)
+{
+  uint32_t log2_val;
+
+  if (val < ALACODER_RANS_NUM_DIRECT_TOKENS) {
+    return val;
+  }
+
+  /* オクターブと、最上位の次のビット */
+  log2_val = ALAUtility_Log2Floor(val);
+  return ALACODER_RANS_NUM_DIRECT_TOKENS + 2 * (log2_val - 4) + ((val >> (log2_val - 1)) & 1);
+}
+
+/* rANSの頻度表の作成 */
+/* 出現したトークンには最低1を割り当て、合計を2^ALACODER_RANS_PROBABILITY_BITSに揃える */
+static void ALACoder_RANSNormalizeFrequency(
+    const uint32_t* count, uint32_t num_data, uint32_t* freq)
+{
+  uint32_t token, max_token, sum;
+  const uint32_t total = 1UL << ALACODER_RANS_PROBABILITY_BITS;
+
+  assert((count != NULL) && (freq != NULL) && (num_data > 0));
+
+  sum = 0;
+  for (token = 0; token < ALACODER_RANS_NUM_TOKENS; token++) {
+    if (count[token] == 0) {
+      freq[token] = 0;
+    } else {
+      freq[token] = (uint32_t)(((uint64_t)count[token] * total + num_data / 2) / num_data);
+      freq[token] = ALAUTILITY_MAX(freq[token], 1);
+    }
+    sum += freq[token];
+  }
+
+  /* 丸めの誤差は最も頻度の高いトークンで吸収する */
+  while (sum != total) {
+    max_token = 0;
+    for (token = 1; token < ALACODER_RANS_NUM_TOKENS; token++) {
+      if (freq[token] > freq[max_token]) {
+        max_token = token;
+      }
+    }
+    if (sum < total) {
+      freq[max_token] += total - sum;
+      sum = total;
+    } else {
+      const uint32_t diff = ALAUTILITY_MIN(sum - total, freq[max_token] - 1);
+      freq[max_token] -= diff;
+      sum -= diff;
+    }
+  }
+}
+
+/* rANSの頻度表の記録ビット数 頻度は直前のトークンとの差分を記録する */
+static uint32_t ALACoder_RANSCalculateTableBits(const uint32_t* freq, uint32_t max_token)
+{
+  uint32_t token;
+  int32_t  delta[ALACODER_RANS_NUM_TOKENS];
+
+  assert(freq != NULL);
+
+  delta[0] = (int32_t)freq[0];
+  for (token = 1; token <= max_token; token++) {
+    delta[token] = (int32_t)freq[token] - (int32_t)freq[token - 1];
+  }
+
+  return ALACODER_RANS_SHIFT_BITS + ALACODER_RANS_TOKEN_BITS
+    + ALACoder_CalculateSmallDataArrayBits(delta, max_token + 1);
+}
+
+/* rANSのシフト量と頻度表の選択 */
+/* シフト量の候補毎にトークンのエントロピーと生ビット数、頻度表のビット数の合計を比べる */
+static void ALACoder_RANSSelectTable(
+    struct ALACoder* coder, const int32_t* data, uint32_t num_samples)
+{
+  uint32_t smpl, token, shift, max_shift, cand, max_token;
+  uint64_t mean_uint, num_bypass_bits;
+  double   bits, best_bits;
+  uint32_t count[ALACODER_RANS_NUM_TOKENS];
+  uint32_t freq[ALACODER_RANS_NUM_TOKENS];
+
+  assert((coder != NULL) && (data != NULL) && (num_samples > 0));
+
+  /* 平均値の桁数を最大のシフト量とする */
+  mean_uint = 0;
+  for (smpl = 0; smpl < num_samples; smpl++) {
+    mean_uint += ALAUTILITY_SINT32_TO_UINT32(data[smpl]);
+  }
+  mean_uint /= num_samples;
+  max_shift = ALAUtility_Log2Floor((uint32_t)ALAUTILITY_INNER_VALUE(mean_uint, 1, UINT32_MAX));
+
+  best_bits = -1.0f;
+  for (cand = 0; (cand < ALACODER_RANS_NUM_SHIFT_CANDIDATES) && (cand <= max_shift); cand++) {
+    shift = max_shift - cand;
+
+    /* トークンの頻度と生ビット数を数える */
+    memset(count, 0, sizeof(count));
+    num_bypass_bits = 0;
+    max_token = 0;
+    for (smpl = 0; smpl < num_samples; smpl++) {
+      token = ALACoder_RANSGetToken(ALAUTILITY_SINT32_TO_UINT32(data[smpl]) >> shift);
+      count[token]++;
+      num_bypass_bits += rans_token_extra_bits[token] + shift;
+      max_token = ALAUTILITY_MAX(max_token, token);
+    }
+
+    /* 頻度表を作ってビット数を見積もる */
+    ALACoder_RANSNormalizeFrequency(count, num_samples, freq);
+    bits = (double)num_bypass_bits + ALACoder_RANSCalculateTableBits(freq, max_token);
+    for (token = 0; token <= max_token; token++) {
+      if (count[token] > 0) {
+        bits += count[token] * (ALACODER_RANS_PROBABILITY_BITS - log(freq[token]) / log(2.0f));
+      }
+    }
+
+    if ((best_bits < 0.0f) || (bits < best_bits)) {
+      best_bits = bits;
+      coder->rans_shift     = shift;
+      coder->rans_max_token = max_token;
+      memcpy(coder->rans_freq, freq, sizeof(freq));
+    }
+  }
+
+  /* 累積頻度 */
+  coder->rans_cumfreq[0] = 0;
+  for (token = 1; token < ALACODER_RANS_NUM_TOKENS; token++) {
+    coder->rans_cumfreq[token] = coder->rans_cumfreq[token - 1] + coder->rans_freq[token - 1];
+  }
+}
+
+/* rANSの状態にシンボルを符号化 */
+static void ALACoder_RANSPutSymbol(
+    uint32_t* state, uint8_t** ptr, uint32_t cumfreq, uint32_t freq)
+{
+  uint32_t x = (*state);
+  const uint32_t x_max = ((ALACODER_RANS_LOWER_BOUND >> ALACODER_RANS_PROBABILITY_BITS) << 8) * freq;
+
+  /* 符号化後に状態が上限を超えないように下位バイトを書き出す */
+  while (x >= x_max) {
+    *(--(*ptr)) = (uint8_t)(x & 0xFF);
+    x >>= 8;
+  }
+
+  (*state) = ((x / freq) << ALACODER_RANS_PROBABILITY_BITS) + (x % freq) + cumfreq;
+}
+
+/* rANSの状態に生ビット（一様分布のシンボル）を符号化 */
+static void ALACoder_RANSPutBits(
+    uint32_t* state, uint8_t** ptr, uint32_t num_bits, uint32_t bits)
+{
+  uint32_t x = (*state);
+  const uint32_t x_max = (uint32_t)((ALACODER_RANS_LOWER_BOUND >> num_bits) << 8);
+
+  assert(num_bits <= ALACODER_RANS_MAX_BYPASS_BITS);
+
+  while (x >= x_max) {
+    *(--(*ptr)) = (uint8_t)(x & 0xFF);
+    x >>= 8;
+  }
+
+  (*state) = (x << num_bits) | bits;
+}
+
+/* 1チャンネルのrANS符号化 ペイロードを作業領域に作成し、サブストリームのバイト数を返す */
+/* 符号化は復号と逆順に行う。復号は先頭から、レーン数ずつのサンプルについて
+ * トークンを全レーン分、続けて生ビットを全レーン分取り出す */
+static uint32_t ALACoder_RANSEncode(
+    struct ALACoder* coder, const int32_t* data, uint32_t num_samples)
+{
+  uint32_t smpl, lane, num_lanes, uint, num_bits, bypass, shift;
+  uint32_t state[ALACODER_RANS_NUM_LANES];
+  uint32_t token[ALACODER_RANS_NUM_LANES];
+  uint8_t* ptr;
+
+  assert((coder != NULL) && (data != NULL) && (num_samples > 0));
+  assert(num_samples * ALACODER_MAX_PAYLOAD_BYTES_PER_SAMPLE
+      + 4 * ALACODER_RANS_NUM_LANES <= coder->payload_buffer_size);
+
+  /* 頻度表の選択 */
+  ALACoder_RANSSelectTable(coder, data, num_samples);
+  shift = coder->rans_shift;
+
+  /* 作業領域の末尾から符号化 */
+  ptr = coder->payload_buffer + coder->payload_buffer_size;
+  for (lane = 0; lane < ALACODER_RANS_NUM_LANES; lane++) {
+    state[lane] = ALACODER_RANS_LOWER_BOUND;
+  }
+  for (smpl = ((num_samples - 1) / ALACODER_RANS_NUM_LANES) * ALACODER_RANS_NUM_LANES; ;
+      smpl -= ALACODER_RANS_NUM_LANES) {
+    num_lanes = ALAUTILITY_MIN(ALACODER_RANS_NUM_LANES, num_samples - smpl);
+    /* 生ビット（上位の塊から） */
+    for (lane = num_lanes; lane-- > 0; ) {
+      uint = ALAUTILITY_SINT32_TO_UINT32(data[smpl + lane]);
+      token[lane] = ALACoder_RANSGetToken(uint >> shift);
+      num_bits = rans_token_extra_bits[token[lane]] + shift;
+      bypass = uint - (rans_token_base[token[lane]] << shift);
+      if (num_bits > ALACODER_RANS_MAX_BYPASS_BITS) {
+        ALACoder_RANSPutBits(&state[lane], &ptr,
+            num_bits - ALACODER_RANS_MAX_BYPASS_BITS, bypass >> ALACODER_RANS_MAX_BYPASS_BITS);
+        num_bits = ALACODER_RANS_MAX_BYPASS_BITS;
+        bypass &= (1UL << ALACODER_RANS_MAX_BYPASS_BITS) - 1;
+      }
+      if (num_bits > 0) {
+        ALACoder_RANSPutBits(&state[lane], &ptr, num_bits, bypass);
+      }
+    }
+    /* トークン */
+    for (lane = num_lanes; lane-- > 0; ) {
+      ALACoder_RANSPutSymbol(&state[lane], &ptr,
+          coder->rans_cumfreq[token[lane]], coder->rans_freq[token[lane]]);
+    }
+    if (smpl == 0) {
+      break;
+    }
+  }
+
+  /* 状態を書き出す（復号時にレーン0から読めるように逆順） */
+  for (lane = ALACODER_RANS_NUM_LANES; lane-- > 0; ) {
+    ptr -= 4;
+    ptr[0] = (uint8_t)((state[lane] >>  0) & 0xFF);
+    ptr[1] = (uint8_t)((state[lane] >>  8) & 0xFF);
+    ptr[2] = (uint8_t)((state[lane] >> 16) & 0xFF);
+    ptr[3] = (uint8_t)((state[lane] >> 24) & 0xFF);
+  }
+  assert(ptr >= coder->payload_buffer);
+
+  coder->rans_payload       = ptr;
+  coder->rans_payload_size  = (uint32_t)(coder->payload_buffer + coder->payload_buffer_size - ptr);
+
+  /* 符号化法のビットと頻度表はバイト境界に揃えてからペイロードが続く */
+  return (1 + ALACoder_RANSCalculateTableBits(coder->rans_freq, coder->rans_max_token) + 7) / 8
+    + coder->rans_payload_size;
+}
+
+/* rANSのシフト量と頻度表の書き出し */
+static void ALACoder_RANSPutTable(struct ALACoder* coder, struct BitStream* strm)
+{
+  uint32_t token;
+  int32_t  delta[ALACODER_RANS_NUM_TOKENS];
+
+  assert((coder != NULL) && (strm != NULL));
+
+  BitStream_PutBits(strm, ALACODER_RANS_SHIFT_BITS, coder->rans_shift);
+  BitStream_PutBits(strm, ALACODER_RANS_TOKEN_BITS, coder->rans_max_token);
+  delta[0] = (int32_t)coder->rans_freq[0];
+  for (token = 1; token <= coder->rans_max_token; token++) {
+    delta[token] = (int32_t)coder->rans_freq[token] - (int32_t)coder->rans_freq[token - 1];
+  }
+  ALACoder_PutSmallDataArray(strm, delta, coder->rans_max_token + 1);
+}
+
+/* rANSのシフト量と頻度表の読み込み */
+static ALACoderApiResult ALACoder_RANSGetTable(struct ALACoder* coder, struct BitStream* strm)
+{
+  uint32_t token, sum;
+  int32_t  delta[ALACODER_RANS_NUM_TOKENS];
+  uint64_t bitsbuf;
+
+  assert((coder != NULL) && (strm != NULL));
+
+  BitStream_GetBits(strm, ALACODER_RANS_SHIFT_BITS, &bitsbuf);
+  coder->rans_shift = (uint32_t)bitsbuf;
+  BitStream_GetBits(strm, ALACODER_RANS_TOKEN_BITS, &bitsbuf);
+  if (bitsbuf >= ALACODER_RANS_NUM_TOKENS) {
+    return ALACODER_APIRESULT_INVALID_FORMAT;
+  }
+  coder->rans_max_token = (uint32_t)bitsbuf;
+  /* 値が32bitに収まらないシフト量は不正 */
+  if (rans_token_extra_bits[coder->rans_max_token] + coder->rans_shift > 32) {
+    return ALACODER_APIRESULT_INVALID_FORMAT;
+  }
+  ALACoder_GetSmallDataArray(strm, delta, coder->rans_max_token + 1);
+
+  /* 頻度を復元しつつ、合計が2^ALACODER_RANS_PROBABILITY_BITSになっているか確認 */
+  sum = 0;
+  for (token = 0; token < ALACODER_RANS_NUM_TOKENS; token++) {
+    int32_t tmp = 0;
+    if (token <= coder->rans_max_token) {
+      tmp = ((token > 0) ? (int32_t)coder->rans_freq[token - 1] : 0) + delta[token];
+      if ((tmp < 0) || (tmp > (1L << ALACODER_RANS_PROBABILITY_BITS))) {
+        return ALACODER_APIRESULT_INVALID_FORMAT;
+      }
+    }
+    coder->rans_freq[token]     = (uint32_t)tmp;
+    coder->rans_cumfreq[token]  = sum;
+    sum += coder->rans_freq[token];
+    if (sum > (1UL << ALACODER_RANS_PROBABILITY_BITS)) {
+      return ALACODER_APIRESULT_INVALID_FORMAT;
+    }
+  }
+  if (sum != (1UL << ALACODER_RANS_PROBABILITY_BITS)) {
+    return ALACODER_APIRESULT_INVALID_FORMAT;
+  }
+
+  /* スロットからトークンを引く表 */
+  for (token = 0; token <= coder->rans_max_token; token++) {
+    memset(&coder->rans_slot_token[coder->rans_cumfreq[token]], (int)token, coder->rans_freq[token]);
+  }
+
+  return ALACODER_APIRESULT_OK;
+}
+
+/* 1チャンネルのrANSのペイロードの復号 */
+static ALACoderApiResult ALACoder_RANSGetPayload(
+    struct ALACoder* coder, uint32_t payload_size, int32_t* data, uint32_t num_samples)
+{
+  uint32_t smpl, lane, num_lanes, slot, uint, num_bits, bypass;
+  uint32_t state[ALACODER_RANS_NUM_LANES];
+  uint32_t lane_token[ALACODER_RANS_NUM_LANES];
+  const uint32_t  shift       = coder->rans_shift;
+  const uint32_t* freq        = coder->rans_freq;
+  const uint32_t* cumfreq     = coder->rans_cumfreq;
+  const uint8_t*  slot_token  = coder->rans_slot_token;
+  const uint8_t*  ptr         = coder->payload_buffer;
+  const uint8_t*  end         = coder->payload_buffer + payload_size;
+
+  assert((coder != NULL) && (data != NULL));
+
+  if (payload_size < 4 * ALACODER_RANS_NUM_LANES) {
+    return ALACODER_APIRESULT_INVALID_FORMAT;
+  }
+
+  /* 各レーンの状態を読み込む */
+  for (lane = 0; lane < ALACODER_RANS_NUM_LANES; lane++) {
+    state[lane] = (uint32_t)ptr[0] | ((uint32_t)ptr[1] << 8) | ((uint32_t)ptr[2] << 16) | ((uint32_t)ptr[3] << 24);
+    ptr += 4;
+    /* 範囲外の状態からは正しく復号できない（正規化が終わらない）ので弾く */
+    if ((state[lane] < ALACODER_RANS_LOWER_BOUND) || (state[lane] >= (1UL << 31))) {
+      return ALACODER_APIRESULT_INVALID_FORMAT;
+    }
+  }
+
+  /* 復号 */
+  for (smpl = 0; smpl < num_samples; smpl += ALACODER_RANS_NUM_LANES) {
+    num_lanes = ALAUTILITY_MIN(ALACODER_RANS_NUM_LANES, num_samples - smpl);
+    /* トークン（各レーンの状態は独立に更新できる） */
+    for (lane = 0; lane < num_lanes; lane++) {
+      slot = state[lane] & ALACODER_RANS_PROBABILITY_MASK;
+      lane_token[lane] = slot_token[slot];
+      state[lane] = freq[lane_token[lane]] * (state[lane] >> ALACODER_RANS_PROBABILITY_BITS)
+        + slot - cumfreq[lane_token[lane]];
+      ALACODER_RANS_RENORMALIZE(state[lane], ptr);
+    }
+    /* 生ビット（下位の塊から） */
+    for (lane = 0; lane < num_lanes; lane++) {
+      num_bits = rans_token_extra_bits[lane_token[lane]] + shift;
+      bypass = 0;
+      if (num_bits > ALACODER_RANS_MAX_BYPASS_BITS) {
+        bypass = state[lane] & ((1UL << ALACODER_RANS_MAX_BYPASS_BITS) - 1);
+        state[lane] >>= ALACODER_RANS_MAX_BYPASS_BITS;
+        ALACODER_RANS_RENORMALIZE(state[lane], ptr);
+        num_bits -= ALACODER_RANS_MAX_BYPASS_BITS;
+        bypass |= (uint32_t)((state[lane] & ((1UL << num_bits) - 1)) << ALACODER_RANS_MAX_BYPASS_BITS);
+        state[lane] >>= num_bits;
+        ALACODER_RANS_RENORMALIZE(state[lane], ptr);
+      } else if (num_bits > 0) {
+        bypass = (uint32_t)(state[lane] & ((1UL << num_bits) - 1));
+        state[lane] >>= num_bits;
+        ALACODER_RANS_RENORMALIZE(state[lane], ptr);
+      }
+      uint = (rans_token_base[lane_token[lane]] << shift) + bypass;
+      data[smpl + lane] = ALAUTILITY_UINT32_TO_SINT32(uint);
+    }
+    /* 読み過ぎ（余白の範囲内で検出できる） */
+    if (ptr > end) {
+      return ALACODER_APIRESULT_INVALID_FORMAT;
+    }
+  }
+
+  /* 正しいペイロードなら全て読み切り、状態は初期値に戻る */
+  if (ptr != end) {
+    return ALACODER_APIRESULT_INVALID_FORMAT;
+  }
+  for (lane = 0; lane < ALACODER_RANS_NUM_LANES; lane++) {
+    if (state[lane] != ALACODER_RANS_LOWER_BOUND) {
+      return ALACODER_APIRESULT_INVALID_FORMAT;
+    }
+  }
+
+  return ALACODER_APIRESULT_OK;
+}
+
+/* 符号付き整数配列の符号化 */
+ALACoderApiResult ALACoder_PutDataArray(
+    struct ALACoder* coder, struct BitStream* strm,
+    const int32_t** data, const uint64_t* code_sums, uint32_t num_channels, uint32_t num_samples,
+    uint32_t enable_rans)
+{
+  uint32_t ch, rice_payload_size, rice_size, rans_size, payload_size;
+  uint64_t rice_payload_bits;
+  ALACoderFixedFloat mean;
+
+  /* 引数チェック */
+  if ((strm == NULL) || (data == NULL) || (coder == NULL)) {
+    return ALACODER_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* サブストリームはバイト境界から始める */
+  BitStream_Flush(strm);
+
+  for (ch = 0; ch < num_channels; ch++) {
+    /* Rice符号のサイズ */
+    mean = (num_samples > 0) ? ALACoder_CalculateInitialMean(data[ch],
+        (code_sums != NULL) ? &code_sums[ch] : NULL, num_samples) : 0;
+    rice_payload_bits = ALACoder_CalculateRicePayloadBits(data[ch], num_samples, mean);
+    rice_size = (1 + ALACODER_INITIAL_MEAN_BITS + 7) / 8;
+    rice_payload_size = UINT32_MAX;
+    if (rice_payload_bits <= 8 * (uint64_t)coder->payload_buffer_size) {
+      rice_payload_size = (uint32_t)((rice_payload_bits + 7) / 8);
+      rice_size += rice_payload_size;
+    }
+
+    /* rANSの方が短い（またはRice符号が作業領域に収まらない）ならrANSで記録 */
+    if ((num_samples > 0) && ((enable_rans != 0) || (rice_payload_size == UINT32_MAX))) {
+      rans_size = ALACoder_RANSEncode(coder, data[ch], num_samples);
+      if ((rice_payload_size == UINT32_MAX) || (rans_size < rice_size)) {
+        BitStream_PutBits(strm, ALACODER_SUBSTREAM_SIZE_BITS, rans_size);
+        BitStream_PutBit(strm, ALACODER_METHOD_RANS);
+        ALACoder_RANSPutTable(coder, strm);
+        BitStream_Flush(strm);
+        BitStream_PutBytes(strm, coder->rans_payload, coder->rans_payload_size);
+        continue;
+      }
+    }
+
+    payload_size = ALACoder_PutRicePayload(coder, data[ch], num_samples, mean);
+    assert(payload_size == rice_payload_size);
+    BitStream_PutBits(strm, ALACODER_SUBSTREAM_SIZE_BITS, rice_size);
+    BitStream_PutBit(strm, ALACODER_METHOD_RICE);
+    BitStream_PutBits(strm, ALACODER_INITIAL_MEAN_BITS, mean >> ALACODER_NUM_FRACTION_PART_BITS);
+    BitStream_Flush(strm);
+    BitStream_PutBytes(strm, coder->payload_buffer, payload_size);
+  }
+
+  return ALACODER_APIRESULT_OK;
+}
+
+/* サブストリームの読み飛ばし */
+static ALACoderApiResult ALACoder_SkipSubstream(
+    struct ALACoder* coder, struct BitStream* strm, uint32_t size)
+{
+  uint32_t num_bytes;
+
+  assert((coder != NULL) && (strm != NULL));
+
+  /* シークできない入力もあるので作業領域に読み捨てる */
+  while (size > 0) {
+    num_bytes = ALAUTILITY_MIN(size, coder->payload_buffer_size);
+    if (BitStream_GetBytes(strm, coder->payload_buffer, num_bytes) != BITSTREAM_APIRESULT_OK) {
+      return ALACODER_APIRESULT_INVALID_FORMAT;
+    }
+    size -= num_bytes;
+  }
+
+  return ALACODER_APIRESULT_OK;
+}
+
+/* 符号付き整数配列の復号 */
+ALACoderApiResult ALACoder_GetDataArray(
+    struct ALACoder* coder, struct BitStream* strm,
+    int32_t** data, uint32_t num_channels, uint32_t num_samples)
+{
+  uint32_t ch, size, header_size, payload_size;
+  uint64_t bitsbuf;
+  uint8_t method;
+  ALACoderFixedFloat mean;
+  ALACoderApiResult ret;
+
+  /* 引数チェック */
+  if ((strm == NULL) || (data == NULL) || (coder == NULL)) {
+    return ALACODER_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* サブストリームはバイト境界から始まる */
+  BitStream_Flush(strm);
+
+  for (ch = 0; ch < num_channels; ch++) {
+    BitStream_GetBits(strm, ALACODER_SUBSTREAM_SIZE_BITS, &bitsbuf);
+    size = (uint32_t)bitsbuf;
+
+    /* 出力先のないチャンネルは読み飛ばす */
+    if (data[ch] == NULL) {
+      if ((ret = ALACoder_SkipSubstream(coder, strm, size)) != ALACODER_APIRESULT_OK) {
+        return ret;
+      }
+      continue;
+    }
+
+    /* 符号化法毎のパラメータ */
+    mean = 0;
+    BitStream_GetBit(strm, &method);
+    if (method == ALACODER_METHOD_RANS) {
+      if ((ret = ALACoder_RANSGetTable(coder, strm)) != ALACODER_APIRESULT_OK) {
+        return ret;
+      }
+      header_size = (1 + ALACoder_RANSCalculateTableBits(coder->rans_freq, coder->rans_max_token) + 7) / 8;
+    } else {
+      BitStream_GetBits(strm, ALACODER_INITIAL_MEAN_BITS, &bitsbuf);
+      mean = ALACODER_UINT32_TO_FIXED_FLOAT(bitsbuf);
+      header_size = (1 + ALACODER_INITIAL_MEAN_BITS + 7) / 8;
+    }
+    BitStream_Flush(strm);
+
+    /* ペイロードをまとめて読み込む（末尾の余白は0で埋め、読み過ぎても範囲内に収める） */
+    if ((size < header_size) || ((size - header_size) > coder->payload_buffer_size)) {
+      return ALACODER_APIRESULT_INVALID_FORMAT;
+    }
+    payload_size = size - header_size;
+    if (BitStream_GetBytes(strm, coder->payload_buffer, payload_size) != BITSTREAM_APIRESULT_OK) {
+      return ALACODER_APIRESULT_INVALID_FORMAT;
+    }
+    memset(&coder->payload_buffer[payload_size], 0, ALACODER_PAYLOAD_BUFFER_MARGIN);
+
+    /* 復号 */
+    if (method == ALACODER_METHOD_RANS) {
+      ret = ALACoder_RANSGetPayload(coder, payload_size, data[ch], num_samples);
+    } else {
+      ret = ALACoder_GetRicePayload(coder, payload_size, data[ch], num_samples, mean);
+    }
+    if (ret != ALACODER_APIRESULT_OK) {
+      return ret;
+    }
+  }
+
   return ALACODER_APIRESULT_OK;
 }
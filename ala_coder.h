@@ -11,7 +11,8 @@ struct ALACoder;
 typedef enum ALACoderApiResultTag {
   ALACODER_APIRESULT_OK,                /* OK */
   ALACODER_APIRESULT_NG,                /* 分類不能なエラー */
-  ALACODER_APIRESULT_INVALID_ARGUMENT   /* 不正な引数 */
+  ALACODER_APIRESULT_INVALID_ARGUMENT,  /* 不正な引数 */
+  ALACODER_APIRESULT_INVALID_FORMAT     /* 不正なフォーマット */
 } ALACoderApiResult;
 
 #ifdef __cplusplus
@@ -19,21 +20,61 @@ extern "C" {
 #endif 
 
 /* 符号化ハンドルの作成 */
-struct ALACoder* ALACoder_Create(uint32_t max_num_channels);
+struct ALACoder* ALACoder_Create(uint32_t max_num_channels, uint32_t max_num_samples);
 
 /* 符号化ハンドルの破棄 */
 void ALACoder_Destroy(struct ALACoder* coder);
 
 /* 符号付き整数配列の符号化 */
+/* チャンネル毎に、バイト数を先頭に付けたバイト境界から始まるサブストリームとして記録する
+ * サブストリームの先頭1bitで符号化法を示す。enable_ransが0でなければ、適応Rice符号と
+ * 頻度表によるrANS（複数レーンをインターリーブ）のうち短い方を選ぶ
+ * （Rice符号が作業領域に収まらない場合はenable_ransによらずrANSを使う）
+ * code_sumsには各チャンネルのデータを符号なし整数に変換した値（ALAUTILITY_SINT32_TO_UINT32）の和を
+ * 予測時に求めてあれば渡す（NULLなら内部で計算する） */
 ALACoderApiResult ALACoder_PutDataArray(
     struct ALACoder* coder, struct BitStream* strm,
-    const int32_t** data, uint32_t num_channels, uint32_t num_samples);
+    const int32_t** data, const uint64_t* code_sums, uint32_t num_channels, uint32_t num_samples,
+    uint32_t enable_rans);
 
 /* 符号付き整数配列の復号 */
+/* data[ch]がNULLのチャンネルはサブストリームを復号せずに読み飛ばす */
 ALACoderApiResult ALACoder_GetDataArray(
     struct ALACoder* coder, struct BitStream* strm,
     int32_t** data, uint32_t num_channels, uint32_t num_samples);
 
+/* 符号付き整数配列の符号化（サンプル毎にチャンネルをインターリーブした順） */
+/* 復号側はブロック全体を待たずに先頭のサンプルから全チャンネルを揃えられる
+ * バイト境界から始め、先頭に全体のバイト数を記録する（受信したデータから復号する側はこのバイト数が揃うまで待てる）
+ * code_sumsはALACoder_PutDataArrayと同じ（NULL可） */
+ALACoderApiResult ALACoder_PutDataArrayInterleaved(
+    struct ALACoder* coder, struct BitStream* strm,
+    const int32_t** data, const uint64_t* code_sums, uint32_t num_channels, uint32_t num_samples);
+
+/* 符号付き整数配列の復号（サンプル毎にチャンネルをインターリーブした順） */
+/* メモリから読み込む場合、記録されたバイト数が揃っていなければ何も復号せずにALACODER_APIRESULT_INVALID_FORMATを返す */
+ALACoderApiResult ALACoder_GetDataArrayInterleaved(
+    struct ALACoder* coder, struct BitStream* strm,
+    int32_t** data, uint32_t num_channels, uint32_t num_samples);
+
+/* 符号付き整数配列の符号化ビット数の推定 */
+/* 配列全体で固定のRice符号パラメータを使った場合の最小のビット数（サブストリームの先頭情報を含む）を返す
+ * 配列の走査は行わないので、code_sumsはALACoder_PutDataArrayと同じ（NULLなら内部で計算する） */
+uint64_t ALACoder_EstimateDataArrayBits(
+    const int32_t** data, const uint64_t* code_sums, uint32_t num_channels, uint32_t num_samples);
+
+/* 短い符号付き整数配列の符号化ビット数 */
+uint32_t ALACoder_CalculateSmallDataArrayBits(const int32_t* data, uint32_t num_data);
+
+/* 短い符号付き整数配列（係数など）の符号化 */
+/* 配列全体で最適なライス符号パラメータを先頭4bitに記録する */
+ALACoderApiResult ALACoder_PutSmallDataArray(
+    struct BitStream* strm, const int32_t* data, uint32_t num_data);
+
+/* 短い符号付き整数配列（係数など）の復号 */
+ALACoderApiResult ALACoder_GetSmallDataArray(
+    struct BitStream* strm, int32_t* data, uint32_t num_data);
+
 #ifdef __cplusplus
 }
 #endif 
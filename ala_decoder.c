@@ -0,0 +1,1015 @@
+#include "ala_decoder.h"
+#include "ala_utility.h"
+#include "ala_coder.h"
+#include "ala_predictor.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+/* 合成以降の処理を行う単位のサンプル数 */
+/* 全チャンネルの残差と出力がL1キャッシュに収まる程度にする */
+#define ALADECODER_TILE_SIZE 256
+
+/* 素のブロックのPCMを読み込む作業バッファのバイト数 */
+#define ALADECODER_VERBATIM_BUFFER_SIZE 1024
+
+/* ブロックの種類 */
+typedef enum ALADecoderBlockTypeTag {
+  ALADECODER_BLOCK_TYPE_PREDICTED = 0,  /* 予測残差を記録した通常のブロック */
+  ALADECODER_BLOCK_TYPE_CONSTANT,       /* 定数ブロック */
+  ALADECODER_BLOCK_TYPE_VERBATIM        /* 素のブロック */
+} ALADecoderBlockType;
+
+/* デコーダハンドル */
+struct ALADecoder {
+  struct ALADecoderConfig   config;             /* 生成時のコンフィグ */
+  struct ALAHeaderInfo      header;             /* ヘッダ情報 */
+  uint8_t                   set_header;         /* ヘッダ情報がセットされたか？ */
+  uint8_t                   has_parcor_index;   /* 直前のブロックのPARCOR係数の量子化インデックスがあるか？ */
+  uint64_t                  num_decoded_samples;/* デコード済みサンプル数 */
+  uint32_t                  stream_crc32;       /* デコード済みブロックのCRC32列のCRC32 */
+  struct ALACoder*          coder;              /* 残差復号ハンドル */
+  struct ALALPCSynthesizer** lpcs;              /* チャンネル毎のLPC音声合成ハンドル */
+  struct ALALMSFilter*      lms[ALA_MAX_NUM_LMS_STAGES]; /* 適応フィルタハンドル */
+  int32_t**                 residual;           /* 残差 */
+  int32_t**                 parcor_coef;        /* PARCOR係数 */
+  int32_t**                 parcor_index;       /* 復号中のブロックのPARCOR係数の量子化インデックス */
+  int32_t**                 prev_parcor_index;  /* 直前のブロックのPARCOR係数の量子化インデックス（差分の基準） */
+  int32_t*                  parcor_delta;       /* PARCOR係数の量子化インデックスの差分 */
+  uint32_t*                 reference_offset;   /* 参照チャンネル予測の参照先オフセット */
+  int32_t*                  reference_gain;     /* 参照チャンネル予測のゲイン */
+  uint32_t*                 ltp_lag;            /* 長期予測のラグ（0で予測なし） */
+  uint32_t*                 wasted_bits;        /* 全サンプルに共通する下位の0ビット数 */
+  int32_t**                 ltp_coef;           /* 長期予測係数 */
+  int32_t**                 tile;               /* 処理中のタイルの先頭を指すポインタ配列 */
+  uint32_t*                 channel_crc32;      /* チャンネル毎の途中までのCRC32 */
+  ALADecoderBlockType       block_type;         /* 復号中のブロックの種類 */
+  int32_t*                  constant_value;     /* 定数ブロックのチャンネル毎の値 */
+  uint32_t                  frame_block_num_samples;  /* フレーム単位のデコード中のブロックのサンプル数 */
+  uint32_t                  frame_num_synthesized;    /* 同ブロックの合成済みサンプル数 */
+  uint32_t                  frame_num_output;         /* 同ブロックの出力済みサンプル数 */
+  uint32_t                  frame_block_crc32;        /* 同ブロックのCRC32 */
+  ALAChannelProcessMethod   frame_ch_process_method;  /* 同ブロックのチャンネル処理法 */
+  uint8_t                   end_of_stream;      /* ストリーム終端に達したか？ */
+};
+
+/* デコーダハンドルの作成 */
+struct ALADecoder* ALADecoder_Create(const struct ALADecoderConfig* config)
+{
+  uint32_t ch, stage;
+  struct ALADecoder* decoder;
+
+  /* 引数チェック */
+  if (config == NULL) {
+    return NULL;
+  }
+
+  decoder = (struct ALADecoder *)malloc(sizeof(struct ALADecoder));
+  decoder->config     = (*config);
+  decoder->set_header = 0;
+
+  /* 領域割当て */
+  decoder->residual     = (int32_t **)malloc(sizeof(int32_t *) * config->max_num_channels);
+  decoder->parcor_coef  = (int32_t **)malloc(sizeof(int32_t *) * config->max_num_channels);
+  decoder->parcor_index = (int32_t **)malloc(sizeof(int32_t *) * config->max_num_channels);
+  decoder->prev_parcor_index = (int32_t **)malloc(sizeof(int32_t *) * config->max_num_channels);
+  for (ch = 0; ch < config->max_num_channels; ch++) {
+    decoder->residual[ch]     = (int32_t *)malloc(sizeof(int32_t) * config->max_num_samples_per_block);
+    decoder->parcor_coef[ch]  = (int32_t *)malloc(sizeof(int32_t) * (config->max_parcor_order + 1));
+    decoder->parcor_index[ch] = (int32_t *)malloc(sizeof(int32_t) * (config->max_parcor_order + 1));
+    decoder->prev_parcor_index[ch] = (int32_t *)malloc(sizeof(int32_t) * (config->max_parcor_order + 1));
+  }
+  decoder->parcor_delta = (int32_t *)malloc(sizeof(int32_t) * (config->max_parcor_order + 1));
+
+  decoder->reference_offset = (uint32_t *)malloc(sizeof(uint32_t) * config->max_num_channels);
+  decoder->reference_gain   = (int32_t *)malloc(sizeof(int32_t) * config->max_num_channels);
+  decoder->ltp_lag          = (uint32_t *)malloc(sizeof(uint32_t) * config->max_num_channels);
+  decoder->wasted_bits      = (uint32_t *)malloc(sizeof(uint32_t) * config->max_num_channels);
+  decoder->ltp_coef         = (int32_t **)malloc(sizeof(int32_t *) * config->max_num_channels);
+  for (ch = 0; ch < config->max_num_channels; ch++) {
+    decoder->ltp_coef[ch] = (int32_t *)malloc(sizeof(int32_t) * ALA_LTP_NUM_TAPS);
+  }
+
+  decoder->tile             = (int32_t **)malloc(sizeof(int32_t *) * config->max_num_channels);
+  decoder->channel_crc32    = (uint32_t *)malloc(sizeof(uint32_t) * config->max_num_channels);
+  decoder->constant_value   = (int32_t *)malloc(sizeof(int32_t) * config->max_num_channels);
+  decoder->block_type       = ALADECODER_BLOCK_TYPE_PREDICTED;
+
+  /* 合成ハンドル作成（タイル間で内部状態を引き継ぐためチャンネル毎に持つ） */
+  decoder->lpcs = (struct ALALPCSynthesizer **)malloc(sizeof(struct ALALPCSynthesizer *) * config->max_num_channels);
+  for (ch = 0; ch < config->max_num_channels; ch++) {
+    decoder->lpcs[ch] = ALALPCSynthesizer_Create(config->max_parcor_order);
+  }
+
+  /* 適応フィルタハンドル作成 */
+  for (stage = 0; stage < ALA_MAX_NUM_LMS_STAGES; stage++) {
+    decoder->lms[stage] = (config->max_lms_num_taps > 0)
+      ? ALALMSFilter_Create(config->max_lms_num_taps) : NULL;
+  }
+
+  /* 残差復号ハンドル作成 */
+  decoder->coder = ALACoder_Create(config->max_num_channels, config->max_num_samples_per_block);
+
+  return decoder;
+}
+
+/* デコーダハンドルの破棄 */
+void ALADecoder_Destroy(struct ALADecoder* decoder)
+{
+  uint32_t ch, stage;
+
+  if (decoder != NULL) {
+    for (ch = 0; ch < decoder->config.max_num_channels; ch++) {
+      free(decoder->residual[ch]);
+      free(decoder->parcor_coef[ch]);
+      free(decoder->parcor_index[ch]);
+      free(decoder->prev_parcor_index[ch]);
+    }
+    free(decoder->residual);
+    free(decoder->parcor_coef);
+    free(decoder->parcor_index);
+    free(decoder->prev_parcor_index);
+    free(decoder->parcor_delta);
+    free(decoder->reference_offset);
+    free(decoder->reference_gain);
+    for (ch = 0; ch < decoder->config.max_num_channels; ch++) {
+      free(decoder->ltp_coef[ch]);
+    }
+    free(decoder->ltp_lag);
+    free(decoder->wasted_bits);
+    free(decoder->ltp_coef);
+    free(decoder->tile);
+    free(decoder->channel_crc32);
+    free(decoder->constant_value);
+    for (ch = 0; ch < decoder->config.max_num_channels; ch++) {
+      ALALPCSynthesizer_Destroy(decoder->lpcs[ch]);
+    }
+    free(decoder->lpcs);
+    for (stage = 0; stage < ALA_MAX_NUM_LMS_STAGES; stage++) {
+      ALALMSFilter_Destroy(decoder->lms[stage]);
+    }
+    ALACoder_Destroy(decoder->coder);
+    free(decoder);
+  }
+}
+
+/* ヘッダの読み込み */
+ALADecoderApiResult ALADecoder_DecodeHeader(
+    struct BitStream* strm, struct ALAHeaderInfo* header)
+{
+  uint32_t stage;
+  uint64_t bitsbuf;
+  struct ALAHeaderInfo tmp_header;
+
+  /* 引数チェック */
+  if ((strm == NULL) || (header == NULL)) {
+    return ALADECODER_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* シグネチャ */
+  BitStream_GetBits(strm, 32, &bitsbuf);
+  /* シグネチャの確認 */
+  if (   (((bitsbuf >> 24) & 0xFF) != 'A')
+      || (((bitsbuf >> 16) & 0xFF) != 'L')
+      || (((bitsbuf >>  8) & 0xFF) != 'A')
+      || (((bitsbuf >>  0) & 0xFF) != '\0')) {
+    return ALADECODER_APIRESULT_INVALID_FORMAT;
+  }
+  /* フォーマットバージョン */
+  BitStream_GetBits(strm, 16, &bitsbuf);
+  /* バージョンの確認 */
+  if (bitsbuf != ALA_FORMAT_VERSION) {
+    return ALADECODER_APIRESULT_INVALID_FORMAT;
+  }
+  /* チャンネル数 */
+  BitStream_GetBits(strm,  8, &bitsbuf);
+  tmp_header.num_channels = (uint32_t)bitsbuf;
+  /* サンプル数 */
+  BitStream_GetBits(strm, 64, &bitsbuf);
+  tmp_header.num_samples = bitsbuf;
+  /* サンプリングレート */
+  BitStream_GetBits(strm, 32, &bitsbuf);
+  tmp_header.sampling_rate = (uint32_t)bitsbuf;
+  /* サンプルあたりbit数 */
+  BitStream_GetBits(strm,  8, &bitsbuf);
+  tmp_header.bits_per_sample = (uint32_t)bitsbuf;
+  /* ブロックあたりサンプル数 */
+  BitStream_GetBits(strm, 16, &bitsbuf);
+  tmp_header.num_samples_per_block = (uint32_t)bitsbuf;
+  /* PARCOR係数次数 */
+  BitStream_GetBits(strm,  8, &bitsbuf);
+  tmp_header.parcor_order = (uint32_t)bitsbuf;
+  /* ストリーム全体のCRC32 */
+  BitStream_GetBits(strm, 32, &bitsbuf);
+  tmp_header.stream_crc32 = (uint32_t)bitsbuf;
+  /* 適応フィルタの段数 */
+  BitStream_GetBits(strm,  8, &bitsbuf);
+  if (bitsbuf > ALA_MAX_NUM_LMS_STAGES) {
+    return ALADECODER_APIRESULT_INVALID_FORMAT;
+  }
+  tmp_header.num_lms_stages = (uint32_t)bitsbuf;
+  /* 各段のタップ数と係数の小数部ビット数 */
+  for (stage = 0; stage < tmp_header.num_lms_stages; stage++) {
+    BitStream_GetBits(strm, 16, &bitsbuf);
+    tmp_header.lms_num_taps[stage] = (uint32_t)bitsbuf;
+    BitStream_GetBits(strm,  8, &bitsbuf);
+    tmp_header.lms_shift[stage] = (uint32_t)bitsbuf;
+    if ((tmp_header.lms_num_taps[stage] == 0)
+        || ((tmp_header.lms_num_taps[stage] % ALA_LMS_NUM_TAPS_UNIT) != 0)
+        || (tmp_header.lms_shift[stage] == 0) || (tmp_header.lms_shift[stage] > ALA_LMS_MAX_SHIFT)) {
+      return ALADECODER_APIRESULT_INVALID_FORMAT;
+    }
+  }
+  /* エンファシスフィルタのシフト量 */
+  BitStream_GetBits(strm,  8, &bitsbuf);
+  if (bitsbuf > ALA_MAX_EMPHASIS_FILTER_SHIFT) {
+    return ALADECODER_APIRESULT_INVALID_FORMAT;
+  }
+  tmp_header.emphasis_shift = (uint32_t)bitsbuf;
+  /* 低遅延モードか？ */
+  BitStream_GetBits(strm,  8, &bitsbuf);
+  if (bitsbuf > 1) {
+    return ALADECODER_APIRESULT_INVALID_FORMAT;
+  }
+  tmp_header.low_latency = (uint32_t)bitsbuf;
+
+  /* 構造体コピー */
+  *header = tmp_header;
+
+  return ALADECODER_APIRESULT_OK;
+}
+
+/* ヘッダ情報のセット */
+ALADecoderApiResult ALADecoder_SetHeader(
+    struct ALADecoder* decoder, const struct ALAHeaderInfo* header)
+{
+  uint32_t stage;
+
+  /* 引数チェック */
+  if ((decoder == NULL) || (header == NULL)) {
+    return ALADECODER_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* エンファシスフィルタのシフト量チェック */
+  if (header->emphasis_shift > ALA_MAX_EMPHASIS_FILTER_SHIFT) {
+    return ALADECODER_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* 低遅延モードのフラグチェック */
+  if (header->low_latency > 1) {
+    return ALADECODER_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* サンプルあたりbit数チェック（定数ブロックの値とCRC32はこの範囲を前提とする） */
+  if ((header->bits_per_sample == 0) || (header->bits_per_sample > 32)) {
+    return ALADECODER_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* ハンドルの容量チェック */
+  if ((header->num_channels > decoder->config.max_num_channels)
+      || (header->num_samples_per_block > decoder->config.max_num_samples_per_block)
+      || (header->parcor_order > decoder->config.max_parcor_order)) {
+    return ALADECODER_APIRESULT_EXCEED_HANDLE_CAPACITY;
+  }
+  for (stage = 0; stage < header->num_lms_stages; stage++) {
+    if (header->lms_num_taps[stage] > decoder->config.max_lms_num_taps) {
+      return ALADECODER_APIRESULT_EXCEED_HANDLE_CAPACITY;
+    }
+  }
+
+  /* ヘッダ情報を記録 */
+  decoder->header               = (*header);
+  decoder->set_header           = 1;
+  decoder->has_parcor_index     = 0;
+  decoder->block_type           = ALADECODER_BLOCK_TYPE_PREDICTED;
+  decoder->num_decoded_samples  = 0;
+  decoder->stream_crc32         = 0;
+  decoder->frame_block_num_samples  = 0;
+  decoder->frame_num_synthesized    = 0;
+  decoder->frame_num_output         = 0;
+  decoder->end_of_stream            = 0;
+
+  return ALADECODER_APIRESULT_OK;
+}
+
+/* ここまでの読み込みでストリーム終端を超えたか？（途中で途切れたブロックは不正とする） */
+static uint8_t ALADecoder_IsTruncated(struct BitStream* strm)
+{
+  uint8_t is_eos;
+
+  if (BitStream_IsEndOfStream(strm, &is_eos) != BITSTREAM_APIRESULT_OK) {
+    return 0;
+  }
+
+  return is_eos;
+}
+
+/* 素のブロックのPCMの読み込み */
+static ALADecoderApiResult ALADecoder_GetVerbatimPcm(
+    struct ALADecoder* decoder, struct BitStream* strm, uint32_t num_samples)
+{
+  uint32_t ch, smpl, pos, byte, num_rest, num_buffered;
+  uint8_t  buffer[ALADECODER_VERBATIM_BUFFER_SIZE];
+  const uint32_t num_channels     = decoder->header.num_channels;
+  const uint32_t bytes_per_sample = (decoder->header.bits_per_sample + 7) / 8;
+  const uint32_t shift            = 32 - decoder->header.bits_per_sample;
+
+  /* まとめて読み込んでから符号拡張して展開 */
+  ch = smpl = 0;
+  for (num_rest = num_channels * num_samples; num_rest > 0; num_rest -= num_buffered) {
+    num_buffered = ALAUTILITY_MIN(num_rest, ALADECODER_VERBATIM_BUFFER_SIZE / bytes_per_sample);
+    if (BitStream_GetBytes(strm, buffer, bytes_per_sample * num_buffered) != BITSTREAM_APIRESULT_OK) {
+      return ALADECODER_APIRESULT_INVALID_FORMAT;
+    }
+    for (pos = 0; pos < num_buffered; pos++) {
+      uint32_t sample = 0;
+      for (byte = 0; byte < bytes_per_sample; byte++) {
+        sample |= (uint32_t)buffer[bytes_per_sample * pos + byte] << (8 * byte);
+      }
+      decoder->residual[ch][smpl] = ALAUTILITY_SHIFT_RIGHT_ARITHMETIC((int32_t)(sample << shift), shift);
+      /* 次のサンプル（低遅延モードではチャンネルインターリーブ順） */
+      if (decoder->header.low_latency != 0) {
+        if (++ch == num_channels) {
+          ch = 0;
+          smpl++;
+        }
+      } else {
+        if (++smpl == num_samples) {
+          smpl = 0;
+          ch++;
+        }
+      }
+    }
+  }
+
+  return ALADECODER_APIRESULT_OK;
+}
+
+/* ブロックヘッダと残差の復号 */
+/* 長期予測の合成まで行い、PARCOR合成前の残差をdecoder->residualに残す */
+/* 定数ブロックでは値をdecoder->constant_valueに読むだけで、残差は触らない
+ * 素のブロックではPCMをそのままdecoder->residualに読む */
+static ALADecoderApiResult ALADecoder_DecodeResidual(
+    struct ALADecoder* decoder, struct BitStream* strm,
+    uint32_t* num_samples_out, uint32_t* block_crc32_out, ALAChannelProcessMethod* ch_process_method_out)
+{
+  uint32_t  ch, ord, stage;
+  uint64_t  bitsbuf;
+  uint32_t  num_channels, parcor_order, num_samples;
+  uint32_t  block_crc32;
+  ALAChannelProcessMethod ch_process_method;
+
+  /* 頻繁に使用する変数をオート変数に受けておく */
+  num_channels  = decoder->header.num_channels;
+  parcor_order  = decoder->header.parcor_order;
+
+  /* 同期コード */
+  if (BitStream_GetBits(strm, 16, &bitsbuf) != BITSTREAM_APIRESULT_OK) {
+    return ALADECODER_APIRESULT_INVALID_FORMAT;
+  }
+  if (bitsbuf == ALA_END_OF_STREAM_CODE) {
+    /* ストリーム終端: 総サンプル数を確認 */
+    BitStream_GetBits(strm, 64, &bitsbuf);
+    if (bitsbuf != decoder->num_decoded_samples) {
+      return ALADECODER_APIRESULT_INVALID_FORMAT;
+    }
+    /* ストリーム全体のCRC32を確認 */
+    /* ヘッダの値は書き換えられていない（不明）ことがあるので、終端の値で確認 */
+    BitStream_GetBits(strm, 32, &bitsbuf);
+    if (ALADecoder_IsTruncated(strm)) {
+      return ALADECODER_APIRESULT_INVALID_FORMAT;
+    }
+    if (((uint32_t)bitsbuf != decoder->stream_crc32)
+        || ((decoder->header.stream_crc32 != ALA_STREAM_CRC32_UNKNOWN)
+          && (decoder->header.stream_crc32 != decoder->stream_crc32))) {
+      return ALADECODER_APIRESULT_DETECT_DATA_CORRUPTION;
+    }
+    return ALADECODER_APIRESULT_END_OF_STREAM;
+  }
+  switch (bitsbuf) {
+    case ALA_BLOCK_SYNC_CODE:           decoder->block_type = ALADECODER_BLOCK_TYPE_PREDICTED; break;
+    case ALA_CONSTANT_BLOCK_SYNC_CODE:  decoder->block_type = ALADECODER_BLOCK_TYPE_CONSTANT;  break;
+    case ALA_VERBATIM_BLOCK_SYNC_CODE:  decoder->block_type = ALADECODER_BLOCK_TYPE_VERBATIM;  break;
+    default:                            return ALADECODER_APIRESULT_INVALID_FORMAT;
+  }
+
+  /* ブロックのサンプル数 */
+  if (decoder->header.low_latency != 0) {
+    uint8_t is_full_block;
+    BitStream_GetBit(strm, &is_full_block);
+    if (is_full_block != 0) {
+      bitsbuf = decoder->header.num_samples_per_block;
+    } else {
+      BitStream_GetBits(strm, 16, &bitsbuf);
+    }
+  } else {
+    BitStream_GetBits(strm, 16, &bitsbuf);
+  }
+  num_samples = (uint32_t)bitsbuf;
+  if (num_samples > decoder->header.num_samples_per_block) {
+    return ALADECODER_APIRESULT_INVALID_FORMAT;
+  }
+
+  /* ブロックのCRC32（低遅延モードでは下位ビットのみ） */
+  BitStream_GetBits(strm,
+      (decoder->header.low_latency != 0) ? ALA_LOW_LATENCY_BLOCK_CRC_BITS : 32, &bitsbuf);
+  block_crc32 = (uint32_t)bitsbuf;
+
+  /* 定数ブロックはチャンネル毎の値、素のブロックはPCMを読んで終わり（合成時に値で埋めるかコピーする） */
+  if (decoder->block_type != ALADECODER_BLOCK_TYPE_PREDICTED) {
+    const uint32_t bits_per_sample = decoder->header.bits_per_sample;
+    if (decoder->block_type == ALADECODER_BLOCK_TYPE_CONSTANT) {
+      for (ch = 0; ch < num_channels; ch++) {
+        BitStream_GetBits(strm, bits_per_sample, &bitsbuf);
+        /* 符号拡張 */
+        decoder->constant_value[ch] = ALAUTILITY_SHIFT_RIGHT_ARITHMETIC(
+            (int32_t)((uint32_t)bitsbuf << (32 - bits_per_sample)), 32 - bits_per_sample);
+      }
+      BitStream_Flush(strm);
+    } else {
+      BitStream_Flush(strm);
+      if (ALADecoder_GetVerbatimPcm(decoder, strm, num_samples) != ALADECODER_APIRESULT_OK) {
+        return ALADECODER_APIRESULT_INVALID_FORMAT;
+      }
+    }
+    if (ALADecoder_IsTruncated(strm)) {
+      return ALADECODER_APIRESULT_INVALID_FORMAT;
+    }
+    *num_samples_out          = num_samples;
+    *block_crc32_out          = block_crc32;
+    *ch_process_method_out    = ALA_CHANNEL_PROCESS_METHOD_LR;
+    return ALADECODER_APIRESULT_OK;
+  }
+
+  /* チャンネル処理法 */
+  BitStream_GetBits(strm,
+      (decoder->header.low_latency != 0) ? ALA_LOW_LATENCY_CHANNEL_PROCESS_METHOD_BITS : 8, &bitsbuf);
+  if (bitsbuf >= ALA_CHANNEL_PROCESS_METHOD_NUM) {
+    return ALADECODER_APIRESULT_INVALID_FORMAT;
+  }
+  ch_process_method = (ALAChannelProcessMethod)bitsbuf;
+
+  /* 各チャンネルの下位の0ビット数 */
+  for (ch = 0; ch < num_channels; ch++) {
+    uint8_t has_wasted_bits;
+    BitStream_GetBit(strm, &has_wasted_bits);
+    decoder->wasted_bits[ch] = 0;
+    if (has_wasted_bits != 0) {
+      BitStream_GetBits(strm, ALA_WASTED_BITS_BITS, &bitsbuf);
+      if (bitsbuf + 1 >= decoder->header.bits_per_sample) {
+        return ALADECODER_APIRESULT_INVALID_FORMAT;
+      }
+      decoder->wasted_bits[ch] = (uint32_t)bitsbuf + 1;
+    }
+  }
+
+  /* 参照チャンネル予測の参照先オフセットとゲイン */
+  for (ch = 0; ch < num_channels; ch++) {
+    decoder->reference_offset[ch] = 0;
+    decoder->reference_gain[ch]   = 0;
+  }
+  for (ch = ALA_CHANNEL_REFERENCE_BEGIN_CHANNEL; ch < num_channels; ch++) {
+    BitStream_GetBits(strm,  8, &bitsbuf);
+    if (bitsbuf > ch) {
+      return ALADECODER_APIRESULT_INVALID_FORMAT;
+    }
+    decoder->reference_offset[ch] = (uint32_t)bitsbuf;
+    if (decoder->reference_offset[ch] != 0) {
+      BitStream_GetBits(strm,  8, &bitsbuf);
+      decoder->reference_gain[ch] = ALAUTILITY_UINT32_TO_SINT32(bitsbuf);
+    }
+  }
+
+  /* PARCOR係数 */
+  /* 量子化インデックスは直前のブロックとの差分か、そのままの値が記録されている */
+  for (ch = 0; ch < num_channels; ch++) {
+    uint8_t is_delta;
+    BitStream_GetBit(strm, &is_delta);
+    if ((is_delta != 0) && (decoder->has_parcor_index == 0)) {
+      return ALADECODER_APIRESULT_INVALID_FORMAT;
+    }
+    ALACoder_GetSmallDataArray(strm, &decoder->parcor_delta[1], parcor_order);
+    decoder->parcor_index[ch][0] = 0;
+    for (ord = 1; ord < parcor_order + 1; ord++) {
+      /* 加算のオーバーフロー対策（正常なインデックスの差分はこの範囲に収まる） */
+      if ((decoder->parcor_delta[ord] < -INT16_MAX) || (decoder->parcor_delta[ord] > INT16_MAX)) {
+        return ALADECODER_APIRESULT_INVALID_FORMAT;
+      }
+      decoder->parcor_index[ch][ord]
+        = ((is_delta != 0) ? decoder->prev_parcor_index[ch][ord] : 0) + decoder->parcor_delta[ord];
+    }
+    if (ALAPARCORQuantizer_Dequantize(decoder->parcor_index[ch],
+          parcor_order, decoder->parcor_coef[ch]) != ALAPREDICTOR_APIRESULT_OK) {
+      return ALADECODER_APIRESULT_INVALID_FORMAT;
+    }
+  }
+
+  /* 各チャンネルの長期予測のラグと係数 */
+  for (ch = 0; ch < num_channels; ch++) {
+    bitsbuf = 1;
+    if (decoder->header.low_latency != 0) {
+      uint8_t has_lag;
+      BitStream_GetBit(strm, &has_lag);
+      bitsbuf = has_lag;
+    }
+    if (bitsbuf != 0) {
+      BitStream_GetBits(strm, 16, &bitsbuf);
+    }
+    decoder->ltp_lag[ch] = (uint32_t)bitsbuf;
+    if (decoder->ltp_lag[ch] != 0) {
+      if (decoder->ltp_lag[ch] <= ALA_LTP_NUM_TAPS / 2) {
+        return ALADECODER_APIRESULT_INVALID_FORMAT;
+      }
+      for (ord = 0; ord < ALA_LTP_NUM_TAPS; ord++) {
+        BitStream_GetBits(strm,  8, &bitsbuf);
+        decoder->ltp_coef[ch][ord] = ALAUTILITY_UINT32_TO_SINT32(bitsbuf);
+      }
+    }
+  }
+
+  /* 残差復号（低遅延モードではチャンネルインターリーブ順のRice符号のみ） */
+  if (decoder->header.low_latency != 0) {
+    if (ALACoder_GetDataArrayInterleaved(decoder->coder, strm,
+          decoder->residual, num_channels, num_samples) != ALACODER_APIRESULT_OK) {
+      return ALADECODER_APIRESULT_INVALID_FORMAT;
+    }
+  } else if (ALACoder_GetDataArray(decoder->coder, strm,
+        decoder->residual, num_channels, num_samples) != ALACODER_APIRESULT_OK) {
+    return ALADECODER_APIRESULT_INVALID_FORMAT;
+  }
+
+  /* バイト境界に揃える */
+  BitStream_Flush(strm);
+  if (ALADecoder_IsTruncated(strm)) {
+    return ALADECODER_APIRESULT_INVALID_FORMAT;
+  }
+
+  /* ブロックを最後まで読めたら、PARCOR係数の量子化インデックスを次のブロックの差分の基準にする */
+  /* 途中で失敗したブロックの値は基準に残さないため、データが届いてから同じブロックを読み直せる */
+  for (ch = 0; ch < num_channels; ch++) {
+    memcpy(decoder->prev_parcor_index[ch], decoder->parcor_index[ch], sizeof(int32_t) * (parcor_order + 1));
+  }
+  decoder->has_parcor_index = 1;
+
+  /* 残差から合成 */
+  /* 適応フィルタ（エンコード時と逆順に適用） */
+  for (ch = 0; ch < num_channels; ch++) {
+    for (stage = decoder->header.num_lms_stages; stage-- > 0; ) {
+      if ((ALALMSFilter_Reset(decoder->lms[stage],
+              decoder->header.lms_num_taps[stage], decoder->header.lms_shift[stage]) != ALAPREDICTOR_APIRESULT_OK)
+          || (ALALMSFilter_SynthesizeInt32(decoder->lms[stage],
+              decoder->residual[ch], num_samples, decoder->residual[ch]) != ALAPREDICTOR_APIRESULT_OK)) {
+        return ALADECODER_APIRESULT_FAILED_TO_CALCULATION;
+      }
+    }
+  }
+  /* 長期予測 */
+  for (ch = 0; ch < num_channels; ch++) {
+    if ((decoder->ltp_lag[ch] != 0)
+        && (ALALongTermPredictor_SynthesizeInt32(decoder->residual[ch], num_samples,
+            decoder->ltp_lag[ch], decoder->ltp_coef[ch], decoder->residual[ch]) != ALAPREDICTOR_APIRESULT_OK)) {
+      return ALADECODER_APIRESULT_FAILED_TO_CALCULATION;
+    }
+  }
+  *num_samples_out          = num_samples;
+  *block_crc32_out          = block_crc32;
+  *ch_process_method_out    = ch_process_method;
+
+  return ALADECODER_APIRESULT_OK;
+}
+
+/* ブロックの合成開始 チャンネル毎の状態をリセット */
+static void ALADecoder_BeginSynthesis(struct ALADecoder* decoder)
+{
+  uint32_t ch;
+
+  for (ch = 0; ch < decoder->header.num_channels; ch++) {
+    ALALPCSynthesizer_Reset(decoder->lpcs[ch]);
+    decoder->channel_crc32[ch] = 0;
+  }
+}
+
+/* 1タイル分の合成 */
+/* 残差のoffsetサンプル目からnum_samplesサンプルを、PARCOR合成とデエンファシス、
+ * チャンネル処理と下位の0ビットの復元まで続けて行い、decoder->tileの指す先に書き出す */
+/* 出力先は残差と同じ位置でもよい */
+static ALADecoderApiResult ALADecoder_SynthesizeTile(
+    struct ALADecoder* decoder, uint32_t offset, uint32_t num_samples,
+    ALAChannelProcessMethod ch_process_method)
+{
+  uint32_t  ch, smpl;
+  const uint32_t num_channels = decoder->header.num_channels;
+
+  if (decoder->block_type == ALADECODER_BLOCK_TYPE_CONSTANT) {
+    /* 定数ブロックは値で埋めるだけ */
+    for (ch = 0; ch < num_channels; ch++) {
+      ALAUtility_FillInt32(decoder->tile[ch], num_samples, decoder->constant_value[ch]);
+    }
+  } else if (decoder->block_type == ALADECODER_BLOCK_TYPE_VERBATIM) {
+    /* 素のブロックはコピーするだけ（出力先が残差と同じ位置ならば何もしない） */
+    for (ch = 0; ch < num_channels; ch++) {
+      if (decoder->tile[ch] != &decoder->residual[ch][offset]) {
+        memcpy(decoder->tile[ch], &decoder->residual[ch][offset], sizeof(int32_t) * num_samples);
+      }
+    }
+  } else {
+    for (ch = 0; ch < num_channels; ch++) {
+      /* PARCOR合成フィルタとデエンファシスフィルタ（状態は直前のタイルから引き継ぐ） */
+      if (ALALPCSynthesizer_SynthesizeAndDeEmphasizeInt32(decoder->lpcs[ch],
+            &decoder->residual[ch][offset], num_samples,
+            decoder->parcor_coef[ch], decoder->header.parcor_order,
+            (int32_t)decoder->header.emphasis_shift, decoder->tile[ch]) != ALAPREDICTOR_APIRESULT_OK) {
+        return ALADECODER_APIRESULT_FAILED_TO_CALCULATION;
+      }
+    }
+
+    /* チャンネル処理を元に戻す */
+    if (ALAChannelDecorrelator_ReconstructInt32(decoder->tile,
+          num_channels, num_samples, ch_process_method) != ALAPREDICTOR_APIRESULT_OK) {
+      return ALADECODER_APIRESULT_INVALID_FORMAT;
+    }
+
+    /* 参照チャンネル予測を元に戻す（参照先の先頭2チャンネルが復元済みであること） */
+    if (ALAChannelDecorrelator_ReconstructFromReferenceInt32(decoder->tile,
+          num_channels, num_samples, ALA_CHANNEL_REFERENCE_GAIN_SHIFT,
+          decoder->reference_offset, decoder->reference_gain) != ALAPREDICTOR_APIRESULT_OK) {
+      return ALADECODER_APIRESULT_INVALID_FORMAT;
+    }
+
+    /* 落とした下位の0ビットを戻す */
+    for (ch = 0; ch < num_channels; ch++) {
+      const uint32_t shift = decoder->wasted_bits[ch];
+      if (shift != 0) {
+        int32_t* tile = decoder->tile[ch];
+        for (smpl = 0; smpl < num_samples; smpl++) {
+          tile[smpl] = (int32_t)((uint32_t)tile[smpl] << shift);
+        }
+      }
+    }
+  }
+
+  /* チャンネル毎のCRC32を更新 */
+  for (ch = 0; ch < num_channels; ch++) {
+    decoder->channel_crc32[ch] = ALAUtility_UpdateCRC32OfPcm(decoder->channel_crc32[ch],
+        (const int32_t* const*)&decoder->tile[ch], 1, num_samples, decoder->header.bits_per_sample);
+  }
+
+  return ALADECODER_APIRESULT_OK;
+}
+
+/* ブロックの合成終了 CRC32を確認してストリーム全体のCRC32を更新 */
+static ALADecoderApiResult ALADecoder_EndSynthesis(
+    struct ALADecoder* decoder, uint32_t num_samples, uint32_t block_crc32)
+{
+  uint32_t  ch, crc32;
+  uint8_t   crc_bytes[4];
+  const uint32_t num_channel_bytes = num_samples * ((decoder->header.bits_per_sample + 7) / 8);
+
+  /* チャンネル毎のCRC32をチャンネル順に連結した値がブロックのCRC32 */
+  crc32 = decoder->channel_crc32[0];
+  for (ch = 1; ch < decoder->header.num_channels; ch++) {
+    crc32 = ALAUtility_CombineCRC32(crc32, decoder->channel_crc32[ch], num_channel_bytes);
+  }
+
+  decoder->num_decoded_samples += num_samples;
+
+  /* ブロックのCRC32の確認 */
+  /* 低遅延モードでは記録された下位ビットだけを比較し、ストリーム全体のCRC32には計算値を使う */
+  if (decoder->header.low_latency != 0) {
+    if ((crc32 & ((1UL << ALA_LOW_LATENCY_BLOCK_CRC_BITS) - 1)) != block_crc32) {
+      return ALADECODER_APIRESULT_DETECT_DATA_CORRUPTION;
+    }
+    block_crc32 = crc32;
+  } else if (crc32 != block_crc32) {
+    return ALADECODER_APIRESULT_DETECT_DATA_CORRUPTION;
+  }
+
+  /* ストリーム全体のCRC32を更新 */
+  crc_bytes[0] = (uint8_t)((block_crc32 >>  0) & 0xFF);
+  crc_bytes[1] = (uint8_t)((block_crc32 >>  8) & 0xFF);
+  crc_bytes[2] = (uint8_t)((block_crc32 >> 16) & 0xFF);
+  crc_bytes[3] = (uint8_t)((block_crc32 >> 24) & 0xFF);
+  decoder->stream_crc32 = ALAUtility_UpdateCRC32(decoder->stream_crc32, crc_bytes, 4);
+
+  return ALADECODER_APIRESULT_OK;
+}
+
+/* 1ブロックのデコード */
+ALADecoderApiResult ALADecoder_DecodeBlock(
+    struct ALADecoder* decoder, struct BitStream* strm,
+    int32_t** output, uint32_t* num_decoded_samples)
+{
+  uint32_t  ch, offset, num_tile_samples;
+  uint32_t  num_samples, block_crc32;
+  ALAChannelProcessMethod ch_process_method;
+  ALADecoderApiResult     ret;
+
+  /* 引数チェック */
+  if ((decoder == NULL) || (strm == NULL)
+      || (output == NULL) || (num_decoded_samples == NULL)) {
+    return ALADECODER_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* ヘッダ情報がセットされていない */
+  if (decoder->set_header == 0) {
+    return ALADECODER_APIRESULT_PARAMETER_NOT_SET;
+  }
+
+  /* 残差の復号 */
+  *num_decoded_samples = 0;
+  if ((ret = ALADecoder_DecodeResidual(decoder, strm,
+          &num_samples, &block_crc32, &ch_process_method)) != ALADECODER_APIRESULT_OK) {
+    return ret;
+  }
+
+  /* タイル毎に合成して出力に書き出す */
+  ALADecoder_BeginSynthesis(decoder);
+  for (offset = 0; offset < num_samples; offset += num_tile_samples) {
+    num_tile_samples = ALAUTILITY_MIN(ALADECODER_TILE_SIZE, num_samples - offset);
+    for (ch = 0; ch < decoder->header.num_channels; ch++) {
+      decoder->tile[ch] = &output[ch][offset];
+    }
+    if ((ret = ALADecoder_SynthesizeTile(decoder,
+            offset, num_tile_samples, ch_process_method)) != ALADECODER_APIRESULT_OK) {
+      return ret;
+    }
+  }
+  *num_decoded_samples = num_samples;
+
+  return ALADecoder_EndSynthesis(decoder, num_samples, block_crc32);
+}
+
+/* インターリーブしたバイト列への書き出し */
+/* サンプルはbytes_per_sampleバイトのコンテナに左詰めし、リトルエンディアンで並べる（8bitは128のオフセット付き） */
+static void ALADecoder_PackInterleaved(
+    const int32_t* const* data, uint32_t num_channels, uint32_t num_samples,
+    uint32_t bits_per_sample, uint8_t* bytes)
+{
+  uint32_t ch, smpl;
+  uint32_t pcm;
+  const uint32_t bytes_per_sample = (bits_per_sample + 7) / 8;
+  const uint32_t shift = 8 * bytes_per_sample - bits_per_sample;
+
+  switch (bytes_per_sample) {
+    case 1:
+      for (smpl = 0; smpl < num_samples; smpl++) {
+        for (ch = 0; ch < num_channels; ch++) {
+          *(bytes++) = (uint8_t)(((uint32_t)data[ch][smpl] << shift) + 128);
+        }
+      }
+      break;
+    case 2:
+      /* 16bitステレオは最も多いので専用のループで処理 */
+      if ((num_channels == 2) && (shift == 0)) {
+        for (smpl = 0; smpl < num_samples; smpl++) {
+          const uint32_t l = (uint32_t)data[0][smpl], r = (uint32_t)data[1][smpl];
+          bytes[0] = (uint8_t)(l & 0xFF); bytes[1] = (uint8_t)((l >> 8) & 0xFF);
+          bytes[2] = (uint8_t)(r & 0xFF); bytes[3] = (uint8_t)((r >> 8) & 0xFF);
+          bytes += 4;
+        }
+        break;
+      }
+      for (smpl = 0; smpl < num_samples; smpl++) {
+        for (ch = 0; ch < num_channels; ch++) {
+          pcm = (uint32_t)data[ch][smpl] << shift;
+          bytes[0] = (uint8_t)(pcm & 0xFF); bytes[1] = (uint8_t)((pcm >> 8) & 0xFF);
+          bytes += 2;
+        }
+      }
+      break;
+    case 3:
+      for (smpl = 0; smpl < num_samples; smpl++) {
+        for (ch = 0; ch < num_channels; ch++) {
+          pcm = (uint32_t)data[ch][smpl] << shift;
+          bytes[0] = (uint8_t)(pcm & 0xFF); bytes[1] = (uint8_t)((pcm >> 8) & 0xFF);
+          bytes[2] = (uint8_t)((pcm >> 16) & 0xFF);
+          bytes += 3;
+        }
+      }
+      break;
+    case 4:
+      for (smpl = 0; smpl < num_samples; smpl++) {
+        for (ch = 0; ch < num_channels; ch++) {
+          pcm = (uint32_t)data[ch][smpl] << shift;
+          bytes[0] = (uint8_t)(pcm & 0xFF);         bytes[1] = (uint8_t)((pcm >> 8) & 0xFF);
+          bytes[2] = (uint8_t)((pcm >> 16) & 0xFF); bytes[3] = (uint8_t)((pcm >> 24) & 0xFF);
+          bytes += 4;
+        }
+      }
+      break;
+    default:
+      assert(0);
+  }
+}
+
+/* 1ブロックのデコード（インターリーブしたバイト列に出力） */
+ALADecoderApiResult ALADecoder_DecodeBlockInterleaved(
+    struct ALADecoder* decoder, struct BitStream* strm,
+    uint8_t* buffer, uint32_t buffer_size, uint32_t* num_decoded_samples)
+{
+  uint32_t  ch, offset, num_tile_samples;
+  uint32_t  num_samples, block_crc32, frame_bytes;
+  ALAChannelProcessMethod ch_process_method;
+  ALADecoderApiResult     ret;
+
+  /* 引数チェック */
+  if ((decoder == NULL) || (strm == NULL)
+      || (buffer == NULL) || (num_decoded_samples == NULL)) {
+    return ALADECODER_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* ヘッダ情報がセットされていない */
+  if (decoder->set_header == 0) {
+    return ALADECODER_APIRESULT_PARAMETER_NOT_SET;
+  }
+
+  /* 1ブロック分が収まらないバッファは受け付けない */
+  frame_bytes = decoder->header.num_channels * ((decoder->header.bits_per_sample + 7) / 8);
+  if (buffer_size < frame_bytes * decoder->header.num_samples_per_block) {
+    return ALADECODER_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* 残差の復号 */
+  *num_decoded_samples = 0;
+  if ((ret = ALADecoder_DecodeResidual(decoder, strm,
+          &num_samples, &block_crc32, &ch_process_method)) != ALADECODER_APIRESULT_OK) {
+    return ret;
+  }
+
+  /* タイル毎に残差の位置で合成し、キャッシュにあるうちにバイト列に詰める */
+  ALADecoder_BeginSynthesis(decoder);
+  for (offset = 0; offset < num_samples; offset += num_tile_samples) {
+    num_tile_samples = ALAUTILITY_MIN(ALADECODER_TILE_SIZE, num_samples - offset);
+    for (ch = 0; ch < decoder->header.num_channels; ch++) {
+      decoder->tile[ch] = &decoder->residual[ch][offset];
+    }
+    if ((ret = ALADecoder_SynthesizeTile(decoder,
+            offset, num_tile_samples, ch_process_method)) != ALADECODER_APIRESULT_OK) {
+      return ret;
+    }
+    ALADecoder_PackInterleaved((const int32_t* const*)decoder->tile,
+        decoder->header.num_channels, num_tile_samples, decoder->header.bits_per_sample,
+        &buffer[offset * frame_bytes]);
+  }
+  *num_decoded_samples = num_samples;
+
+  return ALADecoder_EndSynthesis(decoder, num_samples, block_crc32);
+}
+
+/* インターリーブした指定形式のサンプル列への書き出し */
+static void ALADecoder_ConvertInterleaved(
+    const int32_t* const* data, uint32_t num_channels, uint32_t num_samples,
+    uint32_t bits_per_sample, ALADecoderSampleFormat format, void* buffer)
+{
+  uint32_t ch, smpl;
+  int32_t  pcm;
+  /* 一旦32bitに左詰めしてから出力のビット数に合わせる */
+  const uint32_t shift = 32 - bits_per_sample;
+
+  switch (format) {
+    case ALADECODER_SAMPLEFORMAT_INT16:
+      {
+        int16_t* out = (int16_t *)buffer;
+        for (smpl = 0; smpl < num_samples; smpl++) {
+          for (ch = 0; ch < num_channels; ch++) {
+            pcm = (int32_t)((uint32_t)data[ch][smpl] << shift);
+            *(out++) = (int16_t)ALAUTILITY_SHIFT_RIGHT_ARITHMETIC(pcm, 16);
+          }
+        }
+      }
+      break;
+    case ALADECODER_SAMPLEFORMAT_INT24:
+      {
+        uint8_t* out = (uint8_t *)buffer;
+        for (smpl = 0; smpl < num_samples; smpl++) {
+          for (ch = 0; ch < num_channels; ch++) {
+            const uint32_t upcm = (uint32_t)data[ch][smpl] << shift;
+            out[0] = (uint8_t)((upcm >>  8) & 0xFF);
+            out[1] = (uint8_t)((upcm >> 16) & 0xFF);
+            out[2] = (uint8_t)((upcm >> 24) & 0xFF);
+            out += 3;
+          }
+        }
+      }
+      break;
+    case ALADECODER_SAMPLEFORMAT_INT32:
+      {
+        int32_t* out = (int32_t *)buffer;
+        for (smpl = 0; smpl < num_samples; smpl++) {
+          for (ch = 0; ch < num_channels; ch++) {
+            *(out++) = (int32_t)((uint32_t)data[ch][smpl] << shift);
+          }
+        }
+      }
+      break;
+    case ALADECODER_SAMPLEFORMAT_FLOAT32:
+      {
+        float* out = (float *)buffer;
+        /* 2^-31 */
+        const float scale = 1.0f / 2147483648.0f;
+        for (smpl = 0; smpl < num_samples; smpl++) {
+          for (ch = 0; ch < num_channels; ch++) {
+            pcm = (int32_t)((uint32_t)data[ch][smpl] << shift);
+            *(out++) = (float)pcm * scale;
+          }
+        }
+      }
+      break;
+    default:
+      assert(0);
+  }
+}
+
+/* 次のフレームのデコード（インターリーブした指定形式のサンプル列に出力） */
+ALADecoderApiResult ALADecoder_DecodeFrames(
+    struct ALADecoder* decoder, struct BitStream* strm,
+    void* buffer, uint32_t num_frames, ALADecoderSampleFormat format, uint32_t* num_decoded_frames)
+{
+  uint32_t  ch, num_output, num_tile_samples, frame_bytes;
+  ALADecoderApiResult ret;
+  /* 形式毎のサンプルあたりバイト数 */
+  static const uint32_t sample_bytes[ALADECODER_SAMPLEFORMAT_NUM] = { 2, 3, 4, 4 };
+
+  /* 引数チェック */
+  if ((decoder == NULL) || (strm == NULL)
+      || (buffer == NULL) || (num_decoded_frames == NULL)
+      || ((uint32_t)format >= ALADECODER_SAMPLEFORMAT_NUM)) {
+    return ALADECODER_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* ヘッダ情報がセットされていない */
+  if (decoder->set_header == 0) {
+    return ALADECODER_APIRESULT_PARAMETER_NOT_SET;
+  }
+
+  *num_decoded_frames = 0;
+  frame_bytes = decoder->header.num_channels * sample_bytes[format];
+
+  while ((*num_decoded_frames) < num_frames) {
+    /* ブロックを出力し終えていれば次のブロックの残差を復号 */
+    if (decoder->frame_num_output == decoder->frame_block_num_samples) {
+      if (decoder->end_of_stream != 0) {
+        break;
+      }
+      ret = ALADecoder_DecodeResidual(decoder, strm,
+          &decoder->frame_block_num_samples, &decoder->frame_block_crc32, &decoder->frame_ch_process_method);
+      if (ret != ALADECODER_APIRESULT_OK) {
+        decoder->frame_block_num_samples = 0;
+        decoder->frame_num_synthesized = decoder->frame_num_output = 0;
+        if (ret == ALADECODER_APIRESULT_END_OF_STREAM) {
+          decoder->end_of_stream = 1;
+          break;
+        }
+        return ret;
+      }
+      decoder->frame_num_synthesized = decoder->frame_num_output = 0;
+      ALADecoder_BeginSynthesis(decoder);
+      /* 空のブロックはここでCRC32を確認して次へ */
+      if (decoder->frame_block_num_samples == 0) {
+        if ((ret = ALADecoder_EndSynthesis(decoder, 0, decoder->frame_block_crc32)) != ALADECODER_APIRESULT_OK) {
+          return ret;
+        }
+        continue;
+      }
+    }
+
+    /* 合成済みのサンプルを出力し終えていれば次のタイルを残差の位置で合成 */
+    if (decoder->frame_num_output == decoder->frame_num_synthesized) {
+      num_tile_samples = ALAUTILITY_MIN(ALADECODER_TILE_SIZE,
+          decoder->frame_block_num_samples - decoder->frame_num_synthesized);
+      for (ch = 0; ch < decoder->header.num_channels; ch++) {
+        decoder->tile[ch] = &decoder->residual[ch][decoder->frame_num_synthesized];
+      }
+      if ((ret = ALADecoder_SynthesizeTile(decoder, decoder->frame_num_synthesized,
+              num_tile_samples, decoder->frame_ch_process_method)) != ALADECODER_APIRESULT_OK) {
+        return ret;
+      }
+      decoder->frame_num_synthesized += num_tile_samples;
+      if ((decoder->frame_num_synthesized == decoder->frame_block_num_samples)
+          && ((ret = ALADecoder_EndSynthesis(decoder,
+                decoder->frame_block_num_samples, decoder->frame_block_crc32)) != ALADECODER_APIRESULT_OK)) {
+        return ret;
+      }
+    }
+
+    /* 合成済みのタイルがキャッシュにあるうちに書き出す */
+    num_output = ALAUTILITY_MIN(decoder->frame_num_synthesized - decoder->frame_num_output,
+        num_frames - (*num_decoded_frames));
+    for (ch = 0; ch < decoder->header.num_channels; ch++) {
+      decoder->tile[ch] = &decoder->residual[ch][decoder->frame_num_output];
+    }
+    ALADecoder_ConvertInterleaved((const int32_t* const*)decoder->tile,
+        decoder->header.num_channels, num_output, decoder->header.bits_per_sample, format,
+        (uint8_t *)buffer + (size_t)(*num_decoded_frames) * frame_bytes);
+    decoder->frame_num_output += num_output;
+    (*num_decoded_frames) += num_output;
+  }
+
+  /* 1フレームも出力せずに終端に達した */
+  if ((decoder->end_of_stream != 0) && ((*num_decoded_frames) == 0) && (num_frames > 0)) {
+    return ALADECODER_APIRESULT_END_OF_STREAM;
+  }
+
+  return ALADECODER_APIRESULT_OK;
+}
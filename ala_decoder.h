@@ -0,0 +1,94 @@
+#ifndef ALADECODER_H_INCLUDED
+#define ALADECODER_H_INCLUDED
+
+#include "ala_format.h"
+#include "bit_stream.h"
+#include <stdint.h>
+
+/* デコーダハンドル */
+struct ALADecoder;
+
+/* デコーダ生成コンフィグ */
+struct ALADecoderConfig {
+  uint32_t max_num_channels;            /* 最大チャンネル数 */
+  uint32_t max_num_samples_per_block;   /* 最大ブロックあたりサンプル数 */
+  uint32_t max_parcor_order;            /* 最大PARCOR係数次数 */
+  uint32_t max_lms_num_taps;            /* 適応フィルタの最大タップ数（0で適応フィルタを使わない） */
+};
+
+/* API結果型 */
+typedef enum ALADecoderApiResultTag {
+  ALADECODER_APIRESULT_OK,                    /* OK */
+  ALADECODER_APIRESULT_NG,                    /* 分類不能なエラー */
+  ALADECODER_APIRESULT_INVALID_ARGUMENT,      /* 不正な引数 */
+  ALADECODER_APIRESULT_INVALID_FORMAT,        /* 不正なフォーマット */
+  ALADECODER_APIRESULT_EXCEED_HANDLE_CAPACITY,/* ハンドルの容量を超えたパラメータ */
+  ALADECODER_APIRESULT_PARAMETER_NOT_SET,     /* ヘッダ情報がセットされていない */
+  ALADECODER_APIRESULT_FAILED_TO_CALCULATION, /* 計算に失敗 */
+  ALADECODER_APIRESULT_DETECT_DATA_CORRUPTION,/* CRC32の不一致によりデータ破損を検出 */
+  ALADECODER_APIRESULT_END_OF_STREAM          /* ストリーム終端に達した */
+} ALADecoderApiResult;
+
+/* フレーム単位のデコードで出力するサンプル形式 */
+/* 整数形式はストリームのサンプルを左詰めした値（ビット数が多ければ下位ビットを切り捨てる） */
+typedef enum ALADecoderSampleFormatTag {
+  ALADECODER_SAMPLEFORMAT_INT16,              /* int16_t（ホストのバイト順） */
+  ALADECODER_SAMPLEFORMAT_INT24,              /* 24bit整数を3バイトに詰めたリトルエンディアン */
+  ALADECODER_SAMPLEFORMAT_INT32,              /* int32_t（ホストのバイト順） */
+  ALADECODER_SAMPLEFORMAT_FLOAT32,            /* float（[-1,1)に正規化、ホストのバイト順） */
+  ALADECODER_SAMPLEFORMAT_NUM                 /* 形式の数 */
+} ALADecoderSampleFormat;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* デコーダハンドルの作成 */
+struct ALADecoder* ALADecoder_Create(const struct ALADecoderConfig* config);
+
+/* デコーダハンドルの破棄 */
+void ALADecoder_Destroy(struct ALADecoder* decoder);
+
+/* ヘッダの読み込み */
+ALADecoderApiResult ALADecoder_DecodeHeader(
+    struct BitStream* strm, struct ALAHeaderInfo* header);
+
+/* ヘッダ情報のセット */
+/* 以降のブロックはここで指定したヘッダ情報に従ってデコードする */
+ALADecoderApiResult ALADecoder_SetHeader(
+    struct ALADecoder* decoder, const struct ALAHeaderInfo* header);
+
+/* 1ブロックのデコード */
+/* 出力outputはチャンネル毎のブロックあたりサンプル数分の配列で、値は右詰めの符号付き整数 */
+/* ストリーム終端に達したらALADECODER_APIRESULT_END_OF_STREAMを返す */
+/* ブロックまたはストリーム全体のCRC32が一致しなければALADECODER_APIRESULT_DETECT_DATA_CORRUPTIONを返す */
+ALADecoderApiResult ALADecoder_DecodeBlock(
+    struct ALADecoder* decoder, struct BitStream* strm,
+    int32_t** output, uint32_t* num_decoded_samples);
+
+/* 1ブロックのデコード（インターリーブしたバイト列に出力） */
+/* bufferにはWAVのデータチャンクと同じ形式（サンプル毎に全チャンネルを並べ、各値を(bits_per_sample+7)/8バイトに
+ * 左詰めしてリトルエンディアンで格納、8bitは128のオフセット付き）で書き出す */
+/* buffer_sizeはブロックあたりサンプル数分が収まるバイト数であること */
+/* 合成からバイト列への書き出しまでをキャッシュに収まる単位でまとめて行うため、ALADecoder_DecodeBlockより速い */
+ALADecoderApiResult ALADecoder_DecodeBlockInterleaved(
+    struct ALADecoder* decoder, struct BitStream* strm,
+    uint8_t* buffer, uint32_t buffer_size, uint32_t* num_decoded_samples);
+
+/* 次のフレームのデコード（インターリーブした指定形式のサンプル列に出力） */
+/* 1フレームは全チャンネルの1サンプルで、bufferにはnum_frames * チャンネル数のサンプルが収まること */
+/* ブロック境界によらず、前回の続きから最大num_framesフレームを書き出してnum_decoded_framesに返す
+ * 作業領域はデコーダハンドルのものを使い、ブロックはタイル単位で必要な分だけ合成する */
+/* ストリーム終端に達するとnum_framesより少ないフレーム数でOKを返し、以降はALADECODER_APIRESULT_END_OF_STREAMを返す */
+/* ブロックのCRC32はブロックの最後のタイルを合成した時点で確認し、
+ * 不一致ならそこまでに書き出したフレーム数とともにALADECODER_APIRESULT_DETECT_DATA_CORRUPTIONを返す */
+/* 途中まで書き出したブロックがある間は、ブロック単位のデコード関数と混ぜて呼ばないこと */
+ALADecoderApiResult ALADecoder_DecodeFrames(
+    struct ALADecoder* decoder, struct BitStream* strm,
+    void* buffer, uint32_t num_frames, ALADecoderSampleFormat format, uint32_t* num_decoded_frames);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ALADECODER_H_INCLUDED */
@@ -0,0 +1,725 @@
+#include "ala_encoder.h"
+#include "ala_utility.h"
+#include "ala_coder.h"
+#include "ala_predictor.h"
+
+#include <stdlib.h>
+#include <math.h>
+#include <string.h>
+
+/* 参照チャンネル予測で探索する直前チャンネル数の既定値 */
+#define ALAENCODER_DEFAULT_MAX_REFERENCE_OFFSET 4
+
+/* 長期予測のラグの最小値と最大値の既定値 */
+#define ALAENCODER_LTP_MIN_LAG          20
+#define ALAENCODER_DEFAULT_MAX_LTP_LAG  1024
+
+/* 素のブロックのPCMを詰めて書き出す作業バッファのバイト数 */
+#define ALAENCODER_VERBATIM_BUFFER_SIZE 1024
+
+/* 係数計算で試す窓の種類数 */
+#define ALAENCODER_NUM_WINDOW_TYPES 3
+
+/* 窓の作成関数 */
+typedef void (*ALAEncoderMakeWindowFunction)(double* window, uint32_t window_size);
+
+/* 矩形窓を作成 */
+static void ALAEncoder_MakeRectangularWindow(double* window, uint32_t window_size);
+
+/* 係数計算で試す窓（試行回数が少ないときは先頭から使う） */
+static const ALAEncoderMakeWindowFunction window_functions[ALAENCODER_NUM_WINDOW_TYPES] = {
+  ALAUtility_MakeSinWindow,
+  ALAUtility_MakeHannWindow,
+  ALAEncoder_MakeRectangularWindow
+};
+
+/* エンコーダハンドル */
+struct ALAEncoder {
+  struct ALAEncoderConfig   config;             /* 生成時のコンフィグ */
+  struct ALAHeaderInfo      header;             /* ヘッダ情報 */
+  struct ALAEncodeParameter parameter;          /* エンコードパラメータ */
+  uint8_t                   set_header;         /* ヘッダ情報がセットされたか？ */
+  uint8_t                   has_parcor_index;   /* 直前のブロックのPARCOR係数の量子化インデックスがあるか？ */
+  uint64_t                  num_encoded_samples;/* エンコード済みサンプル数 */
+  uint32_t                  stream_crc32;       /* エンコード済みブロックのCRC32列のCRC32 */
+  int64_t                   header_offset;      /* ヘッダの書き出し位置（不明な場合は負値） */
+  struct ALACoder*          coder;              /* 残差符号化ハンドル */
+  struct ALALPCCalculator*  lpcc;               /* LPC係数計算ハンドル */
+  struct ALALPCSynthesizer* lpcs;               /* LPC音声合成ハンドル */
+  struct ALALTPCalculator*  ltpc;               /* 長期予測パラメータ計算ハンドル */
+  struct ALALMSFilter*      lms[ALA_MAX_NUM_LMS_STAGES]; /* 適応フィルタハンドル */
+  int32_t**                 input_int32;        /* 残差計算用の入力（整数） */
+  int32_t**                 residual;           /* 残差 */
+  uint64_t*                 code_sum;           /* 残差を符号なし整数に変換した値の和 */
+  double**                  parcor_coef;        /* PARCOR係数（倍精度） */
+  int32_t**                 parcor_coef_int32;  /* 量子化したPARCOR係数 */
+  int32_t**                 parcor_index;       /* PARCOR係数の量子化インデックス */
+  int32_t**                 prev_parcor_index;  /* 直前のブロックのPARCOR係数の量子化インデックス */
+  int32_t*                  parcor_delta;       /* PARCOR係数の量子化インデックスの差分 */
+  double*                   window[ALAENCODER_NUM_WINDOW_TYPES];  /* 窓 */
+  uint32_t                  window_size[ALAENCODER_NUM_WINDOW_TYPES]; /* 作成済みの窓のサイズ */
+  double*                   analysis;           /* 窓掛けした係数計算用の入力 */
+  int32_t*                  trial_coef_int32;   /* 試行中の量子化したPARCOR係数 */
+  int32_t*                  trial_index;        /* 試行中のPARCOR係数の量子化インデックス */
+  int32_t*                  trial_residual;     /* 試行中の残差 */
+  uint32_t*                 reference_offset;   /* 参照チャンネル予測の参照先オフセット */
+  int32_t*                  reference_gain;     /* 参照チャンネル予測のゲイン */
+  uint32_t*                 ltp_lag;            /* 長期予測のラグ（0で予測なし） */
+  uint32_t*                 wasted_bits;        /* 全サンプルに共通する下位の0ビット数 */
+  int32_t**                 ltp_coef;           /* 長期予測係数 */
+};
+
+/* 矩形窓を作成 */
+static void ALAEncoder_MakeRectangularWindow(double* window, uint32_t window_size)
+{
+  uint32_t smpl;
+
+  for (smpl = 0; smpl < window_size; smpl++) {
+    window[smpl] = 1.0f;
+  }
+}
+
+/* 係数計算用の入力を作成 */
+/* 正規化・窓掛け・プリエンファシスを1回の走査で行う（順に別々に処理した結果と一致する） */
+static void ALAEncoder_MakeAnalysisInput(
+    const int32_t* input, uint32_t num_samples, double input_scale,
+    const double* window, int32_t emphasis_shift, double* analysis)
+{
+  uint32_t smpl;
+  double   prev, tmp, coef;
+
+  /* プリエンファシスフィルタ係数の計算 */
+  coef = (pow(2.0f, (double)emphasis_shift) - 1.0f) * pow(2.0f, (double)-emphasis_shift);
+
+  prev = 0.0f;
+  for (smpl = 0; smpl < num_samples; smpl++) {
+    tmp             = (input[smpl] * input_scale) * window[smpl];
+    analysis[smpl]  = tmp - prev * coef;
+    prev            = tmp;
+  }
+}
+
+/* エンコーダハンドルの作成 */
+struct ALAEncoder* ALAEncoder_Create(const struct ALAEncoderConfig* config)
+{
+  uint32_t ch, stage, win;
+  struct ALAEncoder* encoder;
+
+  /* 引数チェック */
+  if (config == NULL) {
+    return NULL;
+  }
+
+  encoder = (struct ALAEncoder *)malloc(sizeof(struct ALAEncoder));
+  encoder->config     = (*config);
+  encoder->set_header = 0;
+
+  /* エンコードパラメータの既定値 */
+  encoder->parameter.num_window_trials              = 1;
+  encoder->parameter.enable_channel_process_search  = 1;
+  encoder->parameter.max_reference_offset           = ALAENCODER_DEFAULT_MAX_REFERENCE_OFFSET;
+  encoder->parameter.max_ltp_lag                    = ALAENCODER_DEFAULT_MAX_LTP_LAG;
+  encoder->parameter.enable_rans                    = 1;
+
+  /* 領域割当て */
+  encoder->input_int32        = (int32_t **)malloc(sizeof(int32_t *) * config->max_num_channels);
+  encoder->residual           = (int32_t **)malloc(sizeof(int32_t *) * config->max_num_channels);
+  encoder->parcor_coef        = (double **)malloc(sizeof(double *) * config->max_num_channels);
+  encoder->parcor_coef_int32  = (int32_t **)malloc(sizeof(int32_t *) * config->max_num_channels);
+  encoder->parcor_index       = (int32_t **)malloc(sizeof(int32_t *) * config->max_num_channels);
+  encoder->prev_parcor_index  = (int32_t **)malloc(sizeof(int32_t *) * config->max_num_channels);
+  for (ch = 0; ch < config->max_num_channels; ch++) {
+    encoder->input_int32[ch]        = (int32_t *)malloc(sizeof(int32_t) * config->max_num_samples_per_block);
+    encoder->residual[ch]           = (int32_t *)malloc(sizeof(int32_t) * config->max_num_samples_per_block);
+    encoder->parcor_coef[ch]        = (double *)malloc(sizeof(double) * (config->max_parcor_order + 1));
+    encoder->parcor_coef_int32[ch]  = (int32_t *)malloc(sizeof(int32_t) * (config->max_parcor_order + 1));
+    encoder->parcor_index[ch]       = (int32_t *)malloc(sizeof(int32_t) * (config->max_parcor_order + 1));
+    encoder->prev_parcor_index[ch]  = (int32_t *)malloc(sizeof(int32_t) * (config->max_parcor_order + 1));
+  }
+  encoder->code_sum         = (uint64_t *)malloc(sizeof(uint64_t) * config->max_num_channels);
+  encoder->parcor_delta     = (int32_t *)malloc(sizeof(int32_t) * (config->max_parcor_order + 1));
+  for (win = 0; win < ALAENCODER_NUM_WINDOW_TYPES; win++) {
+    encoder->window[win]      = (double *)malloc(sizeof(double) * config->max_num_samples_per_block);
+    encoder->window_size[win] = 0;
+  }
+  encoder->analysis         = (double *)malloc(sizeof(double) * config->max_num_samples_per_block);
+  encoder->trial_coef_int32 = (int32_t *)malloc(sizeof(int32_t) * (config->max_parcor_order + 1));
+  encoder->trial_index      = (int32_t *)malloc(sizeof(int32_t) * (config->max_parcor_order + 1));
+  encoder->trial_residual   = (int32_t *)malloc(sizeof(int32_t) * config->max_num_samples_per_block);
+  encoder->reference_offset = (uint32_t *)malloc(sizeof(uint32_t) * config->max_num_channels);
+  encoder->reference_gain   = (int32_t *)malloc(sizeof(int32_t) * config->max_num_channels);
+  encoder->ltp_lag          = (uint32_t *)malloc(sizeof(uint32_t) * config->max_num_channels);
+  encoder->wasted_bits      = (uint32_t *)malloc(sizeof(uint32_t) * config->max_num_channels);
+  encoder->ltp_coef         = (int32_t **)malloc(sizeof(int32_t *) * config->max_num_channels);
+  for (ch = 0; ch < config->max_num_channels; ch++) {
+    encoder->ltp_coef[ch] = (int32_t *)malloc(sizeof(int32_t) * ALA_LTP_NUM_TAPS);
+  }
+
+  /* 分析合成ハンドル作成 */
+  encoder->lpcc = ALALPCCalculator_Create(config->max_parcor_order);
+  encoder->lpcs = ALALPCSynthesizer_Create(config->max_parcor_order);
+  encoder->ltpc = ALALTPCalculator_Create(config->max_num_samples_per_block);
+
+  /* 適応フィルタハンドル作成 */
+  for (stage = 0; stage < ALA_MAX_NUM_LMS_STAGES; stage++) {
+    encoder->lms[stage] = (config->max_lms_num_taps > 0)
+      ? ALALMSFilter_Create(config->max_lms_num_taps) : NULL;
+  }
+
+  /* 残差符号化ハンドル作成 */
+  encoder->coder = ALACoder_Create(config->max_num_channels, config->max_num_samples_per_block);
+
+  return encoder;
+}
+
+/* エンコーダハンドルの破棄 */
+void ALAEncoder_Destroy(struct ALAEncoder* encoder)
+{
+  uint32_t ch, stage, win;
+
+  if (encoder != NULL) {
+    for (ch = 0; ch < encoder->config.max_num_channels; ch++) {
+      free(encoder->input_int32[ch]);
+      free(encoder->residual[ch]);
+      free(encoder->parcor_coef[ch]);
+      free(encoder->parcor_coef_int32[ch]);
+      free(encoder->parcor_index[ch]);
+      free(encoder->prev_parcor_index[ch]);
+    }
+    free(encoder->input_int32);
+    free(encoder->residual);
+    free(encoder->code_sum);
+    free(encoder->parcor_coef);
+    free(encoder->parcor_coef_int32);
+    free(encoder->parcor_index);
+    free(encoder->prev_parcor_index);
+    free(encoder->parcor_delta);
+    for (win = 0; win < ALAENCODER_NUM_WINDOW_TYPES; win++) {
+      free(encoder->window[win]);
+    }
+    free(encoder->analysis);
+    free(encoder->trial_coef_int32);
+    free(encoder->trial_index);
+    free(encoder->trial_residual);
+    free(encoder->reference_offset);
+    free(encoder->reference_gain);
+    for (ch = 0; ch < encoder->config.max_num_channels; ch++) {
+      free(encoder->ltp_coef[ch]);
+    }
+    free(encoder->ltp_lag);
+    free(encoder->wasted_bits);
+    free(encoder->ltp_coef);
+    ALALPCCalculator_Destroy(encoder->lpcc);
+    ALALPCSynthesizer_Destroy(encoder->lpcs);
+    ALALTPCalculator_Destroy(encoder->ltpc);
+    for (stage = 0; stage < ALA_MAX_NUM_LMS_STAGES; stage++) {
+      ALALMSFilter_Destroy(encoder->lms[stage]);
+    }
+    ALACoder_Destroy(encoder->coder);
+    free(encoder);
+  }
+}
+
+/* エンコードパラメータの設定 */
+ALAEncoderApiResult ALAEncoder_SetEncodeParameter(
+    struct ALAEncoder* encoder, const struct ALAEncodeParameter* parameter)
+{
+  /* 引数チェック */
+  if ((encoder == NULL) || (parameter == NULL)) {
+    return ALAENCODER_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* パラメータチェック */
+  if ((parameter->num_window_trials == 0)
+      || (parameter->num_window_trials > ALAENCODER_NUM_WINDOW_TYPES)
+      || ((parameter->max_ltp_lag != 0) && (parameter->max_ltp_lag < ALAENCODER_LTP_MIN_LAG))) {
+    return ALAENCODER_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  encoder->parameter = (*parameter);
+
+  return ALAENCODER_APIRESULT_OK;
+}
+
+/* ヘッダの書き出し */
+ALAEncoderApiResult ALAEncoder_EncodeHeader(
+    struct ALAEncoder* encoder, const struct ALAHeaderInfo* header, struct BitStream* strm)
+{
+  uint32_t stage;
+
+  /* 引数チェック */
+  if ((encoder == NULL) || (header == NULL) || (strm == NULL)) {
+    return ALAENCODER_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* ハンドルの容量チェック */
+  if ((header->num_channels > encoder->config.max_num_channels)
+      || (header->num_samples_per_block > encoder->config.max_num_samples_per_block)
+      || (header->parcor_order > encoder->config.max_parcor_order)) {
+    return ALAENCODER_APIRESULT_EXCEED_HANDLE_CAPACITY;
+  }
+
+  /* エンファシスフィルタのパラメータチェック */
+  if (header->emphasis_shift > ALA_MAX_EMPHASIS_FILTER_SHIFT) {
+    return ALAENCODER_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* 低遅延モードのフラグチェック */
+  if (header->low_latency > 1) {
+    return ALAENCODER_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* 適応フィルタのパラメータチェック */
+  if (header->num_lms_stages > ALA_MAX_NUM_LMS_STAGES) {
+    return ALAENCODER_APIRESULT_INVALID_ARGUMENT;
+  }
+  for (stage = 0; stage < header->num_lms_stages; stage++) {
+    if ((header->lms_num_taps[stage] == 0)
+        || ((header->lms_num_taps[stage] % ALA_LMS_NUM_TAPS_UNIT) != 0)
+        || (header->lms_shift[stage] == 0) || (header->lms_shift[stage] > ALA_LMS_MAX_SHIFT)) {
+      return ALAENCODER_APIRESULT_INVALID_ARGUMENT;
+    }
+    if (header->lms_num_taps[stage] > encoder->config.max_lms_num_taps) {
+      return ALAENCODER_APIRESULT_EXCEED_HANDLE_CAPACITY;
+    }
+  }
+
+  /* ヘッダ位置を記録（シークできないストリームでは不明） */
+  if (BitStream_Tell(strm, &encoder->header_offset) != BITSTREAM_APIRESULT_OK) {
+    encoder->header_offset = -1;
+  }
+
+  /* シグネチャ */
+  BitStream_PutBits(strm,  8, 'A');
+  BitStream_PutBits(strm,  8, 'L');
+  BitStream_PutBits(strm,  8, 'A');
+  BitStream_PutBits(strm,  8, '\0');
+  /* フォーマットバージョン */
+  BitStream_PutBits(strm, 16, ALA_FORMAT_VERSION);
+  /* チャンネル数 */
+  BitStream_PutBits(strm,  8, header->num_channels);
+  /* サンプル数 */
+  BitStream_PutBits(strm, 64, header->num_samples);
+  /* サンプリングレート */
+  BitStream_PutBits(strm, 32, header->sampling_rate);
+  /* サンプルあたりbit数 */
+  BitStream_PutBits(strm,  8, header->bits_per_sample);
+  /* ブロックあたりサンプル数 */
+  BitStream_PutBits(strm, 16, header->num_samples_per_block);
+  /* PARCOR係数次数 */
+  BitStream_PutBits(strm,  8, header->parcor_order);
+  /* ストリーム全体のCRC32（終端で確定したら書き換える） */
+  BitStream_PutBits(strm, 32, ALA_STREAM_CRC32_UNKNOWN);
+  /* 適応フィルタの段数と各段のタップ数/係数の小数部ビット数 */
+  BitStream_PutBits(strm,  8, header->num_lms_stages);
+  for (stage = 0; stage < header->num_lms_stages; stage++) {
+    BitStream_PutBits(strm, 16, header->lms_num_taps[stage]);
+    BitStream_PutBits(strm,  8, header->lms_shift[stage]);
+  }
+  /* エンファシスフィルタのシフト量 */
+  BitStream_PutBits(strm,  8, header->emphasis_shift);
+  /* 低遅延モードか？ */
+  BitStream_PutBits(strm,  8, header->low_latency);
+  /* ここまでの書き出しの失敗を確認 */
+  if (BitStream_Flush(strm) != BITSTREAM_APIRESULT_OK) {
+    return ALAENCODER_APIRESULT_IOERROR;
+  }
+
+  /* ヘッダ情報を記録 */
+  encoder->header               = (*header);
+  encoder->set_header           = 1;
+  encoder->has_parcor_index     = 0;
+  encoder->num_encoded_samples  = 0;
+  encoder->stream_crc32         = 0;
+
+  return ALAENCODER_APIRESULT_OK;
+}
+
+/* ブロックのサンプル数とCRC32の書き出し（通常ブロックと定数ブロックで共通） */
+static void ALAEncoder_PutBlockSizeAndCRC32(
+    const struct ALAEncoder* encoder, struct BitStream* strm, uint32_t num_samples, uint32_t block_crc32)
+{
+  if (encoder->header.low_latency != 0) {
+    /* ブロックのサンプル数（ブロックあたりサンプル数に一致するときはフラグのみ） */
+    if (num_samples == encoder->header.num_samples_per_block) {
+      BitStream_PutBit(strm, 1);
+    } else {
+      BitStream_PutBit(strm, 0);
+      BitStream_PutBits(strm, 16, num_samples);
+    }
+    /* ブロックのCRC32の下位ビット */
+    BitStream_PutBits(strm, ALA_LOW_LATENCY_BLOCK_CRC_BITS, block_crc32);
+  } else {
+    /* ブロックのサンプル数 */
+    BitStream_PutBits(strm, 16, num_samples);
+    /* ブロックのCRC32 */
+    BitStream_PutBits(strm, 32, block_crc32);
+  }
+}
+
+/* 素のブロックのPCMの書き出し */
+static void ALAEncoder_PutVerbatimPcm(
+    const struct ALAEncoder* encoder, struct BitStream* strm, const int32_t** input, uint32_t num_samples)
+{
+  uint32_t ch, smpl, pos, byte, num_rest, num_buffered;
+  uint8_t  buffer[ALAENCODER_VERBATIM_BUFFER_SIZE];
+  const uint32_t num_channels     = encoder->header.num_channels;
+  const uint32_t bytes_per_sample = (encoder->header.bits_per_sample + 7) / 8;
+
+  /* バッファに詰めながらまとめて書き出す */
+  ch = smpl = 0;
+  for (num_rest = num_channels * num_samples; num_rest > 0; num_rest -= num_buffered) {
+    num_buffered = ALAUTILITY_MIN(num_rest, ALAENCODER_VERBATIM_BUFFER_SIZE / bytes_per_sample);
+    for (pos = 0; pos < num_buffered; pos++) {
+      const uint32_t sample = (uint32_t)input[ch][smpl];
+      for (byte = 0; byte < bytes_per_sample; byte++) {
+        buffer[bytes_per_sample * pos + byte] = (uint8_t)((sample >> (8 * byte)) & 0xFF);
+      }
+      /* 次のサンプル（低遅延モードではチャンネルインターリーブ順） */
+      if (encoder->header.low_latency != 0) {
+        if (++ch == num_channels) {
+          ch = 0;
+          smpl++;
+        }
+      } else {
+        if (++smpl == num_samples) {
+          smpl = 0;
+          ch++;
+        }
+      }
+    }
+    BitStream_PutBytes(strm, buffer, bytes_per_sample * num_buffered);
+  }
+}
+
+/* 1ブロックのエンコード */
+ALAEncoderApiResult ALAEncoder_EncodeBlock(
+    struct ALAEncoder* encoder,
+    const int32_t** input, uint32_t num_samples, struct BitStream* strm)
+{
+  uint32_t  ch, smpl, ord, stage, win;
+  uint32_t  num_channels, parcor_order;
+  int32_t   emphasis_shift;
+  uint32_t  block_crc32;
+  uint64_t  cost, best_cost;
+  uint8_t   crc_bytes[4];
+  ALAChannelProcessMethod ch_process_method;
+  double    input_scale;
+  int32_t** input_int32;
+
+  /* 引数チェック */
+  if ((encoder == NULL) || (input == NULL) || (strm == NULL)) {
+    return ALAENCODER_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* ヘッダ情報がセットされていない */
+  if (encoder->set_header == 0) {
+    return ALAENCODER_APIRESULT_PARAMETER_NOT_SET;
+  }
+
+  /* ブロックサイズを超えている */
+  if (num_samples > encoder->header.num_samples_per_block) {
+    return ALAENCODER_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* 頻繁に使用する変数をオート変数に受けておく */
+  num_channels  = encoder->header.num_channels;
+  parcor_order  = encoder->header.parcor_order;
+  emphasis_shift = (int32_t)encoder->header.emphasis_shift;
+  input_int32   = encoder->input_int32;
+
+  /* ブロックとストリーム全体のCRC32を計算 */
+  block_crc32 = ALAUtility_UpdateCRC32OfPcm(0,
+      input, num_channels, num_samples, encoder->header.bits_per_sample);
+  crc_bytes[0] = (uint8_t)((block_crc32 >>  0) & 0xFF);
+  crc_bytes[1] = (uint8_t)((block_crc32 >>  8) & 0xFF);
+  crc_bytes[2] = (uint8_t)((block_crc32 >> 16) & 0xFF);
+  crc_bytes[3] = (uint8_t)((block_crc32 >> 24) & 0xFF);
+  encoder->stream_crc32 = ALAUtility_UpdateCRC32(encoder->stream_crc32, crc_bytes, 4);
+
+  /* 全チャンネルが定数ならば、解析と予測を省いて定数ブロックとして値だけを記録 */
+  for (ch = 0; ch < num_channels; ch++) {
+    if (ALAUtility_IsConstantInt32(input[ch], num_samples) == 0) {
+      break;
+    }
+  }
+  if ((num_samples > 0) && (ch == num_channels)) {
+    BitStream_PutBits(strm, 16, ALA_CONSTANT_BLOCK_SYNC_CODE);
+    ALAEncoder_PutBlockSizeAndCRC32(encoder, strm, num_samples, block_crc32);
+    for (ch = 0; ch < num_channels; ch++) {
+      BitStream_PutBits(strm, encoder->header.bits_per_sample, (uint32_t)input[ch][0]);
+    }
+    if (BitStream_Flush(strm) != BITSTREAM_APIRESULT_OK) {
+      return ALAENCODER_APIRESULT_IOERROR;
+    }
+    encoder->num_encoded_samples += num_samples;
+    return ALAENCODER_APIRESULT_OK;
+  }
+
+  /* 入力データ取得 */
+  /* 全サンプルに共通する下位の0ビットは落とし、以降の処理はビット数を減らした信号に対して行う */
+  for (ch = 0; ch < num_channels; ch++) {
+    const uint32_t shift = ALAUTILITY_MIN(ALAUtility_GetNumWastedBitsInt32(input[ch], num_samples),
+        encoder->header.bits_per_sample - 1);
+    encoder->wasted_bits[ch] = shift;
+    for (smpl = 0; smpl < num_samples; smpl++) {
+      input_int32[ch][smpl] = ALAUTILITY_SHIFT_RIGHT_ARITHMETIC(input[ch][smpl], shift);
+    }
+  }
+
+  /* 参照チャンネル予測を選択して適用 */
+  /* 参照先は原信号なので、先頭2チャンネルのステレオ処理より先に行う */
+  if (ALAChannelDecorrelator_SelectReferenceInt32(
+        (const int32_t* const*)input_int32, num_channels, num_samples,
+        encoder->parameter.max_reference_offset, ALA_CHANNEL_REFERENCE_GAIN_SHIFT,
+        encoder->reference_offset, encoder->reference_gain) != ALAPREDICTOR_APIRESULT_OK) {
+    return ALAENCODER_APIRESULT_FAILED_TO_CALCULATION;
+  }
+  if (ALAChannelDecorrelator_PredictFromReferenceInt32(input_int32, num_channels, num_samples,
+        ALA_CHANNEL_REFERENCE_GAIN_SHIFT,
+        encoder->reference_offset, encoder->reference_gain) != ALAPREDICTOR_APIRESULT_OK) {
+    return ALAENCODER_APIRESULT_FAILED_TO_CALCULATION;
+  }
+
+  /* チャンネル処理法を選択して適用（参照チャンネル予測は先頭2チャンネルを変えない） */
+  ch_process_method = ALA_CHANNEL_PROCESS_METHOD_LR;
+  if ((encoder->parameter.enable_channel_process_search != 0)
+      && (ALAChannelDecorrelator_SelectMethodInt32((const int32_t* const*)input_int32,
+          num_channels, num_samples, &ch_process_method) != ALAPREDICTOR_APIRESULT_OK)) {
+    return ALAENCODER_APIRESULT_FAILED_TO_CALCULATION;
+  }
+  if (ALAChannelDecorrelator_DecorrelateInt32(
+        input_int32, num_channels, num_samples, ch_process_method) != ALAPREDICTOR_APIRESULT_OK) {
+    return ALAENCODER_APIRESULT_FAILED_TO_CALCULATION;
+  }
+
+  /* 係数計算用の入力は[-1,1)の範囲に正規化（サイドチャンネルは[-2,2)） */
+  input_scale = pow(2.0f, 1.0f - (double)encoder->header.bits_per_sample);
+
+  /* 試行する窓の作成（窓はサンプル数だけで決まるので、サイズが変わったときのみ作り直す） */
+  for (win = 0; win < encoder->parameter.num_window_trials; win++) {
+    if (encoder->window_size[win] != num_samples) {
+      window_functions[win](encoder->window[win], num_samples);
+      encoder->window_size[win] = num_samples;
+    }
+  }
+
+  /* PARCOR係数の導出と残差計算 */
+  /* 窓毎に係数を求めて予測し、残差を符号なし整数に変換した値の和が最小の窓を採用する
+   * チャンネル毎に、係数計算用の入力は整数の入力から1回の走査で作り、
+   * 残差計算ではプリエンファシス・予測・和の計算を1回の走査で行う */
+  for (ch = 0; ch < num_channels; ch++) {
+    best_cost = 0;
+    for (win = 0; win < encoder->parameter.num_window_trials; win++) {
+      /* 正規化・窓掛け・プリエンファシス */
+      ALAEncoder_MakeAnalysisInput(input_int32[ch], num_samples,
+          input_scale, encoder->window[win], emphasis_shift, encoder->analysis);
+      /* PARCOR係数計算 */
+      /* 窓によっては係数が発散する（収束条件を満たさない）ので、その窓の候補は予測なし（係数0）とする */
+      switch (ALALPCCalculator_CalculatePARCORCoefDouble(encoder->lpcc,
+            encoder->analysis, num_samples, encoder->parcor_coef[ch], parcor_order)) {
+        case ALAPREDICTOR_APIRESULT_OK:
+          break;
+        case ALAPREDICTOR_APIRESULT_FAILED_TO_CALCULATION:
+          memset(encoder->parcor_coef[ch], 0, sizeof(double) * (parcor_order + 1));
+          break;
+        default:
+          return ALAENCODER_APIRESULT_FAILED_TO_CALCULATION;
+      }
+      /* PARCOR係数量子化 */
+      if ((ALAPARCORQuantizer_Quantize(encoder->parcor_coef[ch],
+              parcor_order, encoder->trial_index) != ALAPREDICTOR_APIRESULT_OK)
+          || (ALAPARCORQuantizer_Dequantize(encoder->trial_index,
+              parcor_order, encoder->trial_coef_int32) != ALAPREDICTOR_APIRESULT_OK)) {
+        return ALAENCODER_APIRESULT_FAILED_TO_CALCULATION;
+      }
+      /* プリエンファシスとPARCOR予測フィルタ */
+      /* ブロック毎・チャンネル毎にフィルタの内部状態をリセットし、ブロックを独立にデコードできるようにする */
+      ALALPCSynthesizer_Reset(encoder->lpcs);
+      if (ALALPCSynthesizer_PreEmphasizeAndPredictInt32(encoder->lpcs,
+            input_int32[ch], num_samples,
+            encoder->trial_coef_int32, parcor_order, emphasis_shift,
+            encoder->trial_residual, &cost) != ALAPREDICTOR_APIRESULT_OK) {
+        return ALAENCODER_APIRESULT_FAILED_TO_CALCULATION;
+      }
+      /* 残差が小さければ係数と残差を入れ替えて採用 */
+      if ((win == 0) || (cost < best_cost)) {
+        int32_t* tmp;
+        best_cost = cost;
+        tmp = encoder->parcor_coef_int32[ch];
+        encoder->parcor_coef_int32[ch] = encoder->trial_coef_int32;
+        encoder->trial_coef_int32 = tmp;
+        tmp = encoder->parcor_index[ch];
+        encoder->parcor_index[ch] = encoder->trial_index;
+        encoder->trial_index = tmp;
+        tmp = encoder->residual[ch];
+        encoder->residual[ch] = encoder->trial_residual;
+        encoder->trial_residual = tmp;
+      }
+    }
+    /* 後段の予測で残差が変わらなければ、この和から符号化パラメータを決める */
+    encoder->code_sum[ch] = best_cost;
+  }
+
+  /* 長期予測 */
+  for (ch = 0; ch < num_channels; ch++) {
+    encoder->ltp_lag[ch] = 0;
+    if (encoder->parameter.max_ltp_lag == 0) {
+      continue;
+    }
+    if (ALALTPCalculator_CalculateCoef(encoder->ltpc, encoder->residual[ch], num_samples,
+          ALAENCODER_LTP_MIN_LAG, encoder->parameter.max_ltp_lag,
+          &encoder->ltp_lag[ch], encoder->ltp_coef[ch]) != ALAPREDICTOR_APIRESULT_OK) {
+      return ALAENCODER_APIRESULT_FAILED_TO_CALCULATION;
+    }
+    if ((encoder->ltp_lag[ch] != 0)
+        && (ALALongTermPredictor_PredictInt32(encoder->residual[ch], num_samples,
+            encoder->ltp_lag[ch], encoder->ltp_coef[ch],
+            encoder->residual[ch], &encoder->code_sum[ch]) != ALAPREDICTOR_APIRESULT_OK)) {
+      return ALAENCODER_APIRESULT_FAILED_TO_CALCULATION;
+    }
+  }
+  /* 適応フィルタ（長期予測の残差に縦続接続） */
+  for (ch = 0; ch < num_channels; ch++) {
+    for (stage = 0; stage < encoder->header.num_lms_stages; stage++) {
+      if ((ALALMSFilter_Reset(encoder->lms[stage],
+              encoder->header.lms_num_taps[stage], encoder->header.lms_shift[stage]) != ALAPREDICTOR_APIRESULT_OK)
+          || (ALALMSFilter_PredictInt32(encoder->lms[stage],
+              encoder->residual[ch], num_samples,
+              encoder->residual[ch], &encoder->code_sum[ch]) != ALAPREDICTOR_APIRESULT_OK)) {
+        return ALAENCODER_APIRESULT_FAILED_TO_CALCULATION;
+      }
+    }
+  }
+
+  /* 残差の推定符号長が素のPCMを超えるならば、PCMをそのまま記録する */
+  /* 雑音のような信号でもファイルサイズとデコード時間はPCMのコピー程度に収まる */
+  if (ALACoder_EstimateDataArrayBits((const int32_t **)encoder->residual, encoder->code_sum, num_channels, num_samples)
+      > 8 * (uint64_t)num_channels * num_samples * ((encoder->header.bits_per_sample + 7) / 8)) {
+    BitStream_PutBits(strm, 16, ALA_VERBATIM_BLOCK_SYNC_CODE);
+    ALAEncoder_PutBlockSizeAndCRC32(encoder, strm, num_samples, block_crc32);
+    BitStream_Flush(strm);
+    ALAEncoder_PutVerbatimPcm(encoder, strm, input, num_samples);
+    if (BitStream_Flush(strm) != BITSTREAM_APIRESULT_OK) {
+      return ALAENCODER_APIRESULT_IOERROR;
+    }
+    encoder->num_encoded_samples += num_samples;
+    return ALAENCODER_APIRESULT_OK;
+  }
+
+  /* ブロック符号化 */
+  /* ブロック先頭を示す同期コード */
+  BitStream_PutBits(strm, 16, ALA_BLOCK_SYNC_CODE);
+  /* ブロックのサンプル数とCRC32 */
+  ALAEncoder_PutBlockSizeAndCRC32(encoder, strm, num_samples, block_crc32);
+  /* チャンネル処理法 */
+  BitStream_PutBits(strm,
+      (encoder->header.low_latency != 0) ? ALA_LOW_LATENCY_CHANNEL_PROCESS_METHOD_BITS : 8, ch_process_method);
+  /* 各チャンネルの下位の0ビット数（0ならフラグのみ） */
+  for (ch = 0; ch < num_channels; ch++) {
+    BitStream_PutBit(strm, (encoder->wasted_bits[ch] != 0) ? 1 : 0);
+    if (encoder->wasted_bits[ch] != 0) {
+      BitStream_PutBits(strm, ALA_WASTED_BITS_BITS, encoder->wasted_bits[ch] - 1);
+    }
+  }
+  /* 参照チャンネル予測の参照先オフセットとゲイン */
+  for (ch = ALA_CHANNEL_REFERENCE_BEGIN_CHANNEL; ch < num_channels; ch++) {
+    BitStream_PutBits(strm,  8, encoder->reference_offset[ch]);
+    if (encoder->reference_offset[ch] != 0) {
+      BitStream_PutBits(strm,  8, ALAUTILITY_SINT32_TO_UINT32(encoder->reference_gain[ch]));
+    }
+  }
+  /* 各チャンネルのPARCOR係数の量子化インデックス */
+  /* 直前のブロックとの差分とそのままの値のうち、符号化ビット数が少ない方を記録 */
+  for (ch = 0; ch < num_channels; ch++) {
+    uint8_t is_delta = 0;
+    /* 0次係数は0だから飛ばす */
+    if (encoder->has_parcor_index != 0) {
+      for (ord = 1; ord < parcor_order + 1; ord++) {
+        encoder->parcor_delta[ord] = encoder->parcor_index[ch][ord] - encoder->prev_parcor_index[ch][ord];
+      }
+      is_delta = (ALACoder_CalculateSmallDataArrayBits(&encoder->parcor_delta[1], parcor_order)
+          < ALACoder_CalculateSmallDataArrayBits(&encoder->parcor_index[ch][1], parcor_order)) ? 1 : 0;
+    }
+    BitStream_PutBit(strm, is_delta);
+    ALACoder_PutSmallDataArray(strm,
+        (is_delta != 0) ? &encoder->parcor_delta[1] : &encoder->parcor_index[ch][1], parcor_order);
+    for (ord = 0; ord < parcor_order + 1; ord++) {
+      encoder->prev_parcor_index[ch][ord] = encoder->parcor_index[ch][ord];
+    }
+  }
+  encoder->has_parcor_index = 1;
+  /* 各チャンネルの長期予測のラグと係数 */
+  /* 低遅延モードでは予測しないチャンネルのラグを1bitのフラグで済ませる */
+  for (ch = 0; ch < num_channels; ch++) {
+    if (encoder->header.low_latency != 0) {
+      BitStream_PutBit(strm, (encoder->ltp_lag[ch] != 0) ? 1 : 0);
+    }
+    if ((encoder->header.low_latency == 0) || (encoder->ltp_lag[ch] != 0)) {
+      BitStream_PutBits(strm, 16, encoder->ltp_lag[ch]);
+    }
+    if (encoder->ltp_lag[ch] != 0) {
+      for (ord = 0; ord < ALA_LTP_NUM_TAPS; ord++) {
+        BitStream_PutBits(strm,  8, ALAUTILITY_SINT32_TO_UINT32(encoder->ltp_coef[ch][ord]));
+      }
+    }
+  }
+  /* 残差符号化（低遅延モードではチャンネルインターリーブ順のRice符号のみ） */
+  if (encoder->header.low_latency != 0) {
+    ALACoder_PutDataArrayInterleaved(encoder->coder, strm,
+        (const int32_t **)encoder->residual, encoder->code_sum, num_channels, num_samples);
+  } else {
+    ALACoder_PutDataArray(encoder->coder, strm,
+        (const int32_t **)encoder->residual, encoder->code_sum,
+        num_channels, num_samples, encoder->parameter.enable_rans);
+  }
+
+  /* バイト境界に揃え、ブロックの書き出しの失敗を確認 */
+  if (BitStream_Flush(strm) != BITSTREAM_APIRESULT_OK) {
+    return ALAENCODER_APIRESULT_IOERROR;
+  }
+
+  encoder->num_encoded_samples += num_samples;
+
+  return ALAENCODER_APIRESULT_OK;
+}
+
+/* ストリーム終端の書き出し */
+ALAEncoderApiResult ALAEncoder_EncodeEndOfStream(
+    struct ALAEncoder* encoder, struct BitStream* strm)
+{
+  /* 引数チェック */
+  if ((encoder == NULL) || (strm == NULL)) {
+    return ALAENCODER_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* ヘッダ情報がセットされていない */
+  if (encoder->set_header == 0) {
+    return ALAENCODER_APIRESULT_PARAMETER_NOT_SET;
+  }
+
+  /* 終端コードと総サンプル数、ストリーム全体のCRC32 */
+  BitStream_PutBits(strm, 16, ALA_END_OF_STREAM_CODE);
+  BitStream_PutBits(strm, 64, encoder->num_encoded_samples);
+  BitStream_PutBits(strm, 32, encoder->stream_crc32);
+  BitStream_Flush(strm);
+
+  /* シークできる場合に限り、ヘッダのサンプル数とCRC32を書き換える */
+  if (encoder->header_offset >= 0) {
+    if ((BitStream_Seek(strm,
+            encoder->header_offset + ALA_HEADER_NUM_SAMPLES_OFFSET, BITSTREAM_SEEK_SET) == BITSTREAM_APIRESULT_OK)
+        && (BitStream_PutBits(strm, 64, encoder->num_encoded_samples) == BITSTREAM_APIRESULT_OK)
+        && (BitStream_Seek(strm,
+            encoder->header_offset + ALA_HEADER_STREAM_CRC32_OFFSET, BITSTREAM_SEEK_SET) == BITSTREAM_APIRESULT_OK)
+        && (BitStream_PutBits(strm, 32, encoder->stream_crc32) == BITSTREAM_APIRESULT_OK)) {
+      BitStream_Seek(strm, 0, BITSTREAM_SEEK_END);
+    }
+  }
+
+  /* 終端とヘッダの書き換えまでの書き出しの失敗を確認 */
+  if (BitStream_Flush(strm) != BITSTREAM_APIRESULT_OK) {
+    return ALAENCODER_APIRESULT_IOERROR;
+  }
+
+  return ALAENCODER_APIRESULT_OK;
+}
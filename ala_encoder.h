@@ -0,0 +1,76 @@
+#ifndef ALAENCODER_H_INCLUDED
+#define ALAENCODER_H_INCLUDED
+
+#include "ala_format.h"
+#include "bit_stream.h"
+#include <stdint.h>
+
+/* エンコーダハンドル */
+struct ALAEncoder;
+
+/* エンコーダ生成コンフィグ */
+struct ALAEncoderConfig {
+  uint32_t max_num_channels;            /* 最大チャンネル数 */
+  uint32_t max_num_samples_per_block;   /* 最大ブロックあたりサンプル数 */
+  uint32_t max_parcor_order;            /* 最大PARCOR係数次数 */
+  uint32_t max_lms_num_taps;            /* 適応フィルタの最大タップ数（0で適応フィルタを使わない） */
+};
+
+/* エンコードパラメータ */
+/* デコードには影響しない、エンコーダの探索の設定 */
+struct ALAEncodeParameter {
+  uint32_t num_window_trials;           /* 係数計算で試す窓の数（1以上。多いほど遅い） */
+  uint32_t enable_channel_process_search; /* ステレオ処理法を探索するか？（0ならL/R固定） */
+  uint32_t max_reference_offset;        /* 参照チャンネル予測で探索する直前チャンネル数（0で使わない） */
+  uint32_t max_ltp_lag;                 /* 長期予測の最大ラグ（0で使わない） */
+  uint32_t enable_rans;                 /* 残差のrANS符号化を試すか？（0ならRice符号のみ） */
+};
+
+/* API結果型 */
+typedef enum ALAEncoderApiResultTag {
+  ALAENCODER_APIRESULT_OK,                    /* OK */
+  ALAENCODER_APIRESULT_NG,                    /* 分類不能なエラー */
+  ALAENCODER_APIRESULT_INVALID_ARGUMENT,      /* 不正な引数 */
+  ALAENCODER_APIRESULT_EXCEED_HANDLE_CAPACITY,/* ハンドルの容量を超えたパラメータ */
+  ALAENCODER_APIRESULT_PARAMETER_NOT_SET,     /* ヘッダ情報がセットされていない */
+  ALAENCODER_APIRESULT_FAILED_TO_CALCULATION, /* 計算に失敗 */
+  ALAENCODER_APIRESULT_IOERROR                /* 書き出しに失敗 */
+} ALAEncoderApiResult;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* エンコーダハンドルの作成 */
+struct ALAEncoder* ALAEncoder_Create(const struct ALAEncoderConfig* config);
+
+/* エンコーダハンドルの破棄 */
+void ALAEncoder_Destroy(struct ALAEncoder* encoder);
+
+/* エンコードパラメータの設定 */
+/* 設定しなければ既定値（窓は1つ、その他の探索は全て行う）でエンコードする */
+ALAEncoderApiResult ALAEncoder_SetEncodeParameter(
+    struct ALAEncoder* encoder, const struct ALAEncodeParameter* parameter);
+
+/* ヘッダの書き出し */
+/* 以降のブロックはここで指定したヘッダ情報に従ってエンコードする */
+ALAEncoderApiResult ALAEncoder_EncodeHeader(
+    struct ALAEncoder* encoder, const struct ALAHeaderInfo* header, struct BitStream* strm);
+
+/* 1ブロックのエンコード */
+/* 入力inputはチャンネル毎のnum_samples個の配列で、値は右詰めの符号付き整数 */
+ALAEncoderApiResult ALAEncoder_EncodeBlock(
+    struct ALAEncoder* encoder,
+    const int32_t** input, uint32_t num_samples, struct BitStream* strm);
+
+/* ストリーム終端の書き出し */
+/* シーク可能ならばヘッダのサンプル数とストリーム全体のCRC32を確定値に書き換える */
+/* それまでの書き出しに失敗していればALAENCODER_APIRESULT_IOERRORを返す */
+ALAEncoderApiResult ALAEncoder_EncodeEndOfStream(
+    struct ALAEncoder* encoder, struct BitStream* strm);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ALAENCODER_H_INCLUDED */
@@ -0,0 +1,94 @@
+#ifndef ALAFORMAT_H_INCLUDED
+#define ALAFORMAT_H_INCLUDED
+
+#include <stdint.h>
+
+/* フォーマットバージョン */
+#define ALA_FORMAT_VERSION        17
+
+/* ブロック先頭を示す同期コード */
+#define ALA_BLOCK_SYNC_CODE       0xFFFF
+
+/* ストリーム終端を示すコード（後ろに64bitの総サンプル数とストリーム全体のCRC32が続く） */
+#define ALA_END_OF_STREAM_CODE    0xFFFE
+
+/* 全チャンネルが定数のブロック（定数ブロック）の先頭を示す同期コード */
+/* 通常のブロックと同じ形式のサンプル数とCRC32の後に、チャンネル毎の値がbits_per_samplebitの2の補数で続く */
+/* PARCOR係数は記録しないため、次のブロックの差分の基準は直前の通常ブロックのまま */
+#define ALA_CONSTANT_BLOCK_SYNC_CODE 0xFFFD
+
+/* PCMをそのまま記録したブロック（素のブロック）の先頭を示す同期コード */
+/* 通常のブロックと同じ形式のサンプル数とCRC32の後に、バイト境界から各サンプルの下位(bits_per_sample+7)/8バイトが
+ * リトルエンディアンでチャンネル順に続く（低遅延モードではサンプル毎に全チャンネルをインターリーブした順）
+ * 定数ブロックと同様にPARCOR係数は記録しない */
+#define ALA_VERBATIM_BLOCK_SYNC_CODE 0xFFFC
+
+/* ヘッダのサンプル数が不明（ストリーミング入力）であることを示す値 */
+#define ALA_NUM_SAMPLES_UNKNOWN   (~(uint64_t)0)
+
+/* ヘッダ先頭からサンプル数フィールドまでのバイト数 */
+#define ALA_HEADER_NUM_SAMPLES_OFFSET 7
+
+/* ヘッダ先頭からストリーム全体のCRC32フィールドまでのバイト数 */
+#define ALA_HEADER_STREAM_CRC32_OFFSET 23
+
+/* ヘッダのストリームCRC32が不明（シークできない出力）であることを示す値 */
+/* 終端のCRC32は常に有効 */
+#define ALA_STREAM_CRC32_UNKNOWN  0
+
+/* 通常のブロックでは、チャンネル処理法の後にチャンネル毎の下位の0ビット数（ワーストビット数）を記録する
+ * 1bitのフラグ（1なら0でない）の後、0でない場合のみ続けて（ビット数-1）をALA_WASTED_BITS_BITSbitで記録する
+ * エンコーダは入力をこのビット数だけ右シフトしてから予測し、デコーダはチャンネル処理を元に戻した後に左シフトする */
+#define ALA_WASTED_BITS_BITS      5
+
+/* エンファシスフィルタのシフト量の最大値（0でエンファシスなし） */
+#define ALA_MAX_EMPHASIS_FILTER_SHIFT 8
+
+/* 参照チャンネル予測ゲインの小数部ビット数 */
+#define ALA_CHANNEL_REFERENCE_GAIN_SHIFT 4
+
+/* PARCOR残差に縦続接続する適応（LMS）フィルタの最大段数 */
+#define ALA_MAX_NUM_LMS_STAGES    3
+
+/* 適応フィルタのタップ数はこの値の倍数 */
+#define ALA_LMS_NUM_TAPS_UNIT     8
+
+/* CRC32はデコード結果のPCMに対して計算する（対象のバイト列はALAUtility_UpdateCRC32OfPcmを参照）
+ * ブロック毎のCRC32はブロック内のPCMに対して計算し、
+ * ストリーム全体のCRC32は各ブロックのCRC32（リトルエンディアン4バイト）を順に連結したバイト列に対して計算する */
+
+/* PARCOR係数の量子化インデックスは直前のブロックとの差分で記録されることがあるため、
+ * ブロックはストリームの先頭から順に復号する（フィルタの内部状態はブロック毎にリセットする） */
+
+/* 残差はチャンネル毎のサブストリームとしてバイト境界から順に記録する
+ * 各サブストリームは32bitのバイト数（この値自身を含まない）から始まり、他のチャンネルに依存せずに復号できる
+ * そのため一部のチャンネルだけを読む場合は、残りのサブストリームをバイト数だけ読み飛ばせばよい */
+
+/* 低遅延モード（ヘッダのlow_latencyが1）のブロックは以下のように短縮して記録する
+ * サンプル数: 1bitのフラグ（1ならブロックあたりサンプル数に一致）、0の場合のみ続けて16bit
+ * CRC32: 下位ALA_LOW_LATENCY_BLOCK_CRC_BITSbitのみ（ストリーム全体のCRC32は完全な値から計算する）
+ * チャンネル処理法: ALA_LOW_LATENCY_CHANNEL_PROCESS_METHOD_BITSbit
+ * 長期予測: チャンネル毎に1bitのフラグ（1ならラグと係数が続く）
+ * 残差: バイト境界から32bitのバイト数（この値自身を含まない）に続けて、各チャンネルの推定平均値の初期値と
+ *       先頭サンプルから順にサンプル毎に全チャンネルをインターリーブしたRice符号を記録する
+ *       （受信側はブロックのバイト数が揃うまで待てばよく、途中までのデータを何度も解析せずに済む） */
+#define ALA_LOW_LATENCY_BLOCK_CRC_BITS              16
+#define ALA_LOW_LATENCY_CHANNEL_PROCESS_METHOD_BITS 2
+
+/* ヘッダ情報 */
+struct ALAHeaderInfo {
+  uint32_t num_channels;            /* チャンネル数 */
+  uint64_t num_samples;             /* サンプル数（64bit、不明な場合はALA_NUM_SAMPLES_UNKNOWN） */
+  uint32_t sampling_rate;           /* サンプリングレート */
+  uint32_t bits_per_sample;         /* サンプルあたりbit数 */
+  uint32_t num_samples_per_block;   /* ブロックあたりサンプル数 */
+  uint32_t parcor_order;            /* PARCOR係数次数 */
+  uint32_t emphasis_shift;          /* エンファシスフィルタのシフト量（係数は1-2^-shift） */
+  uint32_t low_latency;             /* 低遅延モードか？（1でブロックヘッダを短縮し、残差をチャンネルインターリーブ順に記録） */
+  uint32_t stream_crc32;            /* ストリーム全体のCRC32（エンコーダが計算するためエンコード時は無視） */
+  uint32_t num_lms_stages;          /* 適応フィルタの段数（0で適応フィルタなし） */
+  uint32_t lms_num_taps[ALA_MAX_NUM_LMS_STAGES];  /* 各段のタップ数（PARCOR残差に近い段から） */
+  uint32_t lms_shift[ALA_MAX_NUM_LMS_STAGES];     /* 各段の係数の小数部ビット数 */
+};
+
+#endif /* ALAFORMAT_H_INCLUDED */
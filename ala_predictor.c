@@ -8,6 +8,12 @@
 #include <float.h>
 #include <assert.h>
 
+/* SSE2が使える環境ではチャンネル処理をベクトル化する */
+#if defined(__SSE2__)
+#define ALAPREDICTOR_USE_SSE2
+#include <emmintrin.h>
+#endif
+
 /* 内部エラー型 */
 typedef enum ALAPredictorErrorTag {
   ALA_PREDICTOR_ERROR_OK,
@@ -34,6 +40,76 @@ struct ALALPCSynthesizer {
   uint32_t  max_order;            /* 最大次数     */
   int32_t*  forward_residual;     /* 前向き誤差   */
   int32_t*  backward_residual;    /* 後ろ向き誤差 */
+  int32_t   preemphasis_prev;     /* 直前のプリエンファシス入力 */
+  int32_t   deemphasis_prev;      /* 直前のデエンファシス出力 */
+};
+
+/* LMSフィルタの履歴バッファに余分に確保するサンプル数（履歴の詰め直し間隔） */
+#define ALALMSFILTER_HISTORY_WINDOW 512
+
+/* 符号なし32bit数値を符号付き32bit数値に変換（2の補数表現で解釈） */
+#define ALALMSFILTER_UINT32_TO_SINT32(u32) \
+  (((u32) <= (uint32_t)INT32_MAX) ? (int32_t)(u32) : (-(int32_t)(~(u32)) - 1))
+
+/* 適応フィルタハンドル（符号LMS） */
+struct ALALMSFilter {
+  uint32_t  max_num_taps;   /* 最大タップ数 */
+  uint32_t  num_taps;       /* タップ数 */
+  uint32_t  shift;          /* 係数の小数部ビット数 */
+  int16_t*  weight;         /* 係数 */
+  int16_t*  history;        /* 入力履歴（16bitに飽和） */
+  int16_t*  adapt;          /* 係数更新量（入力の符号 x 更新幅） */
+  uint32_t  pos;            /* 履歴の次の書き込み位置 */
+};
+
+/* 長期予測で採用する最小の改善率（採用時の絶対値和/不採用時の絶対値和がこれ未満なら採用） */
+#define ALALTPCALCULATOR_MIN_GAIN_RATIO 0.99f
+
+/* PARCOR係数の量子化テーブルのビット数（符号含む。次数毎の量子化ビット数の最大値） */
+#define ALAPARCORQUANTIZER_TABLE_BITS 9
+/* 量子化ビット数に対するインデックスの絶対値の最大値（pi/2に対応） */
+#define ALAPARCORQUANTIZER_MAX_INDEX(num_bits) ((int32_t)(1UL << ((num_bits) - 1)))
+/* 次数毎の量子化ビット数テーブルのサイズ */
+#define ALAPARCORQUANTIZER_NUM_BITS_TABLE_SIZE 5
+
+/* 次数毎の量子化ビット数（符号含む） */
+/* 1に近い値を取る低次の係数ほど精度が必要。表より高い次数は最後の値を使う */
+static const uint32_t parcor_quantize_bits[ALAPARCORQUANTIZER_NUM_BITS_TABLE_SIZE] = { 0, 9, 8, 7, 6 };
+
+/* 逆正弦で圧伸したPARCOR係数の復元テーブル */
+/* round(sin(i * (pi/2) / 256) * 2^15)を2^15-1で飽和させた値 */
+static const int32_t parcor_sin_table[ALAPARCORQUANTIZER_MAX_INDEX(ALAPARCORQUANTIZER_TABLE_BITS) + 1] = {
+      0,   201,   402,   603,   804,  1005,  1206,  1407,  1608,  1809,  2009,  2210,
+   2411,  2611,  2811,  3012,  3212,  3412,  3612,  3812,  4011,  4211,  4410,  4609,
+   4808,  5007,  5205,  5404,  5602,  5800,  5998,  6195,  6393,  6590,  6787,  6983,
+   7180,  7376,  7571,  7767,  7962,  8157,  8351,  8546,  8740,  8933,  9127,  9319,
+   9512,  9704,  9896, 10088, 10279, 10469, 10660, 10850, 11039, 11228, 11417, 11605,
+  11793, 11980, 12167, 12354, 12540, 12725, 12910, 13095, 13279, 13463, 13646, 13828,
+  14010, 14192, 14373, 14553, 14733, 14912, 15091, 15269, 15447, 15624, 15800, 15976,
+  16151, 16326, 16500, 16673, 16846, 17018, 17190, 17361, 17531, 17700, 17869, 18037,
+  18205, 18372, 18538, 18703, 18868, 19032, 19195, 19358, 19520, 19681, 19841, 20001,
+  20160, 20318, 20475, 20632, 20788, 20943, 21097, 21251, 21403, 21555, 21706, 21856,
+  22006, 22154, 22302, 22449, 22595, 22740, 22884, 23028, 23170, 23312, 23453, 23593,
+  23732, 23870, 24008, 24144, 24279, 24414, 24548, 24680, 24812, 24943, 25073, 25202,
+  25330, 25457, 25583, 25708, 25833, 25956, 26078, 26199, 26320, 26439, 26557, 26674,
+  26791, 26906, 27020, 27133, 27246, 27357, 27467, 27576, 27684, 27791, 27897, 28002,
+  28106, 28209, 28311, 28411, 28511, 28610, 28707, 28803, 28899, 28993, 29086, 29178,
+  29269, 29359, 29448, 29535, 29622, 29707, 29792, 29875, 29957, 30038, 30118, 30196,
+  30274, 30350, 30425, 30499, 30572, 30644, 30715, 30784, 30853, 30920, 30986, 31050,
+  31114, 31177, 31238, 31298, 31357, 31415, 31471, 31527, 31581, 31634, 31686, 31737,
+  31786, 31834, 31881, 31927, 31972, 32015, 32058, 32099, 32138, 32177, 32214, 32251,
+  32286, 32319, 32352, 32383, 32413, 32442, 32470, 32496, 32522, 32546, 32568, 32590,
+  32610, 32629, 32647, 32664, 32679, 32693, 32706, 32718, 32729, 32738, 32746, 32753,
+  32758, 32762, 32766, 32767, 32767
+};
+
+/* 長期予測パラメータ計算ハンドル */
+struct ALALTPCalculator {
+  uint32_t  max_num_samples;  /* 最大サンプル数 */
+  float*    signal;           /* 探索用の入力（単精度） */
+  float*    decimated;        /* 粗探索用の2:1間引き信号 */
+  double*   energy;           /* 信号パワーの累積和 */
+  int32_t*  work;             /* 予測誤差の試算用 */
 };
 
 /* エンファシスフィルタハンドル */
@@ -106,6 +182,8 @@ static ALAPredictorError ALA_CalculateAutoCorrelation(
 }
 
 /* Levinson-Durbin再帰計算 */
+/* 正弦波やランプのように自己相関行列がほぼ特異な入力では、丸め誤差で反射係数の絶対値が1以上になる
+ * その場合は不安定な係数を返さずにALA_PREDICTOR_ERROR_NGを返す */
 static ALAPredictorError ALA_LevinsonDurbinRecursion(
     struct ALALPCCalculator* lpc, const double* auto_corr,
     double* lpc_coef, double* parcor_coef, uint32_t order)
@@ -145,6 +223,9 @@ static ALAPredictorError ALA_LevinsonDurbinRecursion(
   a_vec[1]        = - auto_corr[1] / auto_corr[0];
   parcor_coef[0]  = 0.0f;
   parcor_coef[1]  = auto_corr[1] / e_vec[0];
+  if (!(fabs(parcor_coef[1]) < 1.0f)) {
+    return ALA_PREDICTOR_ERROR_NG;
+  }
   e_vec[1]        = auto_corr[0] + auto_corr[1] * a_vec[1];
   u_vec[0]        = 1.0f; u_vec[1] = 0.0f; 
   v_vec[0]        = 0.0f; v_vec[1] = 1.0f; 
@@ -156,6 +237,10 @@ static ALAPredictorError ALA_LevinsonDurbinRecursion(
       gamma += a_vec[i] * auto_corr[delay + 1 - i];
     }
     gamma /= (-e_vec[delay]);
+    /* PARCOR係数の絶対値は1未満（収束条件） 満たさなければ打ち切る（NaNもここで弾く） */
+    if (!(fabs(gamma) < 1.0f)) {
+      return ALA_PREDICTOR_ERROR_NG;
+    }
     e_vec[delay + 1] = (1.0f - gamma * gamma) * e_vec[delay];
     /* 誤差分散（パワー）は非負 */
     assert(e_vec[delay] >= 0.0f);
@@ -173,8 +258,6 @@ static ALAPredictorError ALA_LevinsonDurbinRecursion(
     }
     /* PARCOR係数は反射係数の符号反転 */
     parcor_coef[delay + 1] = -gamma;
-    /* PARCOR係数の絶対値は1未満（収束条件） */
-    assert(fabs(gamma) < 1.0f);
   }
 
   /* 結果を取得 */
@@ -248,6 +331,66 @@ ALAPredictorApiResult ALALPCCalculator_CalculatePARCORCoefDouble(
   return ALAPREDICTOR_APIRESULT_OK;
 }
 
+/* 次数の量子化ビット数（符号含む） */
+static uint32_t ALAPARCORQuantizer_GetNumBits(uint32_t ord)
+{
+  assert(ord > 0);
+  return parcor_quantize_bits[ALAUTILITY_MIN(ord, ALAPARCORQUANTIZER_NUM_BITS_TABLE_SIZE - 1)];
+}
+
+/* PARCOR係数の量子化 */
+ALAPredictorApiResult ALAPARCORQuantizer_Quantize(
+    const double* parcor_coef, uint32_t order, int32_t* index)
+{
+  uint32_t ord;
+  int32_t  max_index;
+  double   scale;
+
+  /* 引数チェック */
+  if ((parcor_coef == NULL) || (index == NULL)) {
+    return ALAPREDICTOR_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  index[0] = 0;
+  for (ord = 1; ord < order + 1; ord++) {
+    /* 逆正弦で圧伸した値[-pi/2, pi/2]をインデックス[-max_index, max_index]に線形量子化 */
+    max_index = ALAPARCORQUANTIZER_MAX_INDEX(ALAPARCORQuantizer_GetNumBits(ord));
+    scale = max_index / (ALA_PI / 2.0f);
+    index[ord] = (int32_t)ALAUtility_Round(asin(ALAUTILITY_INNER_VALUE(parcor_coef[ord], -1.0f, 1.0f)) * scale);
+    index[ord] = ALAUTILITY_INNER_VALUE(index[ord], -max_index, max_index);
+  }
+
+  return ALAPREDICTOR_APIRESULT_OK;
+}
+
+/* 量子化インデックスからPARCOR係数を復元 */
+ALAPredictorApiResult ALAPARCORQuantizer_Dequantize(
+    const int32_t* index, uint32_t order, int32_t* parcor_coef_int32)
+{
+  uint32_t ord, num_bits, abs_index;
+  int32_t  max_index;
+
+  /* 引数チェック */
+  if ((index == NULL) || (parcor_coef_int32 == NULL)) {
+    return ALAPREDICTOR_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* 環境によって結果が変わらないよう、正弦は表引きで求める */
+  parcor_coef_int32[0] = 0;
+  for (ord = 1; ord < order + 1; ord++) {
+    num_bits  = ALAPARCORQuantizer_GetNumBits(ord);
+    max_index = ALAPARCORQUANTIZER_MAX_INDEX(num_bits);
+    if ((index[ord] < -max_index) || (index[ord] > max_index)) {
+      return ALAPREDICTOR_APIRESULT_INVALID_ARGUMENT;
+    }
+    /* 表の分解能に合わせてからインデックスの絶対値で引く */
+    abs_index = (uint32_t)((index[ord] < 0) ? -index[ord] : index[ord]) << (ALAPARCORQUANTIZER_TABLE_BITS - num_bits);
+    parcor_coef_int32[ord] = (index[ord] < 0) ? -parcor_sin_table[abs_index] : parcor_sin_table[abs_index];
+  }
+
+  return ALAPREDICTOR_APIRESULT_OK;
+}
+
 /* LPC音声合成ハンドルの作成 */
 struct ALALPCSynthesizer* ALALPCSynthesizer_Create(uint32_t max_order)
 {
@@ -266,6 +409,8 @@ struct ALALPCSynthesizer* ALALPCSynthesizer_Create(uint32_t max_order)
   for (ord = 0; ord < max_order + 1; ord++) {
     lpcs->forward_residual[ord] = lpcs->backward_residual[ord] = 0;
   }
+  lpcs->preemphasis_prev = 0;
+  lpcs->deemphasis_prev = 0;
 
   return lpcs;
 }
@@ -280,22 +425,290 @@ void ALALPCSynthesizer_Destroy(struct ALALPCSynthesizer* lpc)
   }
 }
 
-/* PARCOR係数により予測/誤差出力（32bit整数入出力） */
-ALAPredictorApiResult ALALPCSynthesizer_PredictByParcorCoefInt32(
+/* LPC音声合成ハンドルの内部状態リセット */
+ALAPredictorApiResult ALALPCSynthesizer_Reset(struct ALALPCSynthesizer* lpc)
+{
+  uint32_t ord;
+
+  /* 引数チェック */
+  if (lpc == NULL) {
+    return ALAPREDICTOR_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* 誤差をゼロクリア */
+  for (ord = 0; ord < lpc->max_order + 1; ord++) {
+    lpc->forward_residual[ord] = lpc->backward_residual[ord] = 0;
+  }
+  lpc->preemphasis_prev = 0;
+  lpc->deemphasis_prev = 0;
+
+  return ALAPREDICTOR_APIRESULT_OK;
+}
+
+/* 展開済みカーネルを用意する最大次数（これを超える次数は汎用のループで処理） */
+#define ALALPCSYNTHESIZER_MAX_UNROLLED_ORDER 32
+
+/* 格子型フィルタの乗算項 coef * x / 2^15（0.5を加えて丸める） */
+#define ALALPCSYNTHESIZER_MUL(coef, x) \
+  ((int32_t)ALAUTILITY_SHIFT_RIGHT_ARITHMETIC((int64_t)(coef) * (x) + (1L << 14), 15))
+
+/* STEP(ord)を次数1からorderまで昇順/降順に並べて展開 */
+#define ALALPCSYNTHESIZER_UNROLL_ASCENDING_0(STEP)
+#define ALALPCSYNTHESIZER_UNROLL_ASCENDING_1(STEP) ALALPCSYNTHESIZER_UNROLL_ASCENDING_0(STEP) STEP(1)
+#define ALALPCSYNTHESIZER_UNROLL_ASCENDING_2(STEP) ALALPCSYNTHESIZER_UNROLL_ASCENDING_1(STEP) STEP(2)
+#define ALALPCSYNTHESIZER_UNROLL_ASCENDING_3(STEP) ALALPCSYNTHESIZER_UNROLL_ASCENDING_2(STEP) STEP(3)
+#define ALALPCSYNTHESIZER_UNROLL_ASCENDING_4(STEP) ALALPCSYNTHESIZER_UNROLL_ASCENDING_3(STEP) STEP(4)
+#define ALALPCSYNTHESIZER_UNROLL_ASCENDING_5(STEP) ALALPCSYNTHESIZER_UNROLL_ASCENDING_4(STEP) STEP(5)
+#define ALALPCSYNTHESIZER_UNROLL_ASCENDING_6(STEP) ALALPCSYNTHESIZER_UNROLL_ASCENDING_5(STEP) STEP(6)
+#define ALALPCSYNTHESIZER_UNROLL_ASCENDING_7(STEP) ALALPCSYNTHESIZER_UNROLL_ASCENDING_6(STEP) STEP(7)
+#define ALALPCSYNTHESIZER_UNROLL_ASCENDING_8(STEP) ALALPCSYNTHESIZER_UNROLL_ASCENDING_7(STEP) STEP(8)
+#define ALALPCSYNTHESIZER_UNROLL_ASCENDING_9(STEP) ALALPCSYNTHESIZER_UNROLL_ASCENDING_8(STEP) STEP(9)
+#define ALALPCSYNTHESIZER_UNROLL_ASCENDING_10(STEP) ALALPCSYNTHESIZER_UNROLL_ASCENDING_9(STEP) STEP(10)
+#define ALALPCSYNTHESIZER_UNROLL_ASCENDING_11(STEP) ALALPCSYNTHESIZER_UNROLL_ASCENDING_10(STEP) STEP(11)
+#define ALALPCSYNTHESIZER_UNROLL_ASCENDING_12(STEP) ALALPCSYNTHESIZER_UNROLL_ASCENDING_11(STEP) STEP(12)
+#define ALALPCSYNTHESIZER_UNROLL_ASCENDING_13(STEP) ALALPCSYNTHESIZER_UNROLL_ASCENDING_12(STEP) STEP(13)
+#define ALALPCSYNTHESIZER_UNROLL_ASCENDING_14(STEP) ALALPCSYNTHESIZER_UNROLL_ASCENDING_13(STEP) STEP(14)
+#define ALALPCSYNTHESIZER_UNROLL_ASCENDING_15(STEP) ALALPCSYNTHESIZER_UNROLL_ASCENDING_14(STEP) STEP(15)
+#define ALALPCSYNTHESIZER_UNROLL_ASCENDING_16(STEP) ALALPCSYNTHESIZER_UNROLL_ASCENDING_15(STEP) STEP(16)
+#define ALALPCSYNTHESIZER_UNROLL_ASCENDING_17(STEP) ALALPCSYNTHESIZER_UNROLL_ASCENDING_16(STEP) STEP(17)
+#define ALALPCSYNTHESIZER_UNROLL_ASCENDING_18(STEP) ALALPCSYNTHESIZER_UNROLL_ASCENDING_17(STEP) STEP(18)
+#define ALALPCSYNTHESIZER_UNROLL_ASCENDING_19(STEP) ALALPCSYNTHESIZER_UNROLL_ASCENDING_18(STEP) STEP(19)
+#define ALALPCSYNTHESIZER_UNROLL_ASCENDING_20(STEP) ALALPCSYNTHESIZER_UNROLL_ASCENDING_19(STEP) STEP(20)
+#define ALALPCSYNTHESIZER_UNROLL_ASCENDING_21(STEP) ALALPCSYNTHESIZER_UNROLL_ASCENDING_20(STEP) STEP(21)
+#define ALALPCSYNTHESIZER_UNROLL_ASCENDING_22(STEP) ALALPCSYNTHESIZER_UNROLL_ASCENDING_21(STEP) STEP(22)
+#define ALALPCSYNTHESIZER_UNROLL_ASCENDING_23(STEP) ALALPCSYNTHESIZER_UNROLL_ASCENDING_22(STEP) STEP(23)
+#define ALALPCSYNTHESIZER_UNROLL_ASCENDING_24(STEP) ALALPCSYNTHESIZER_UNROLL_ASCENDING_23(STEP) STEP(24)
+#define ALALPCSYNTHESIZER_UNROLL_ASCENDING_25(STEP) ALALPCSYNTHESIZER_UNROLL_ASCENDING_24(STEP) STEP(25)
+#define ALALPCSYNTHESIZER_UNROLL_ASCENDING_26(STEP) ALALPCSYNTHESIZER_UNROLL_ASCENDING_25(STEP) STEP(26)
+#define ALALPCSYNTHESIZER_UNROLL_ASCENDING_27(STEP) ALALPCSYNTHESIZER_UNROLL_ASCENDING_26(STEP) STEP(27)
+#define ALALPCSYNTHESIZER_UNROLL_ASCENDING_28(STEP) ALALPCSYNTHESIZER_UNROLL_ASCENDING_27(STEP) STEP(28)
+#define ALALPCSYNTHESIZER_UNROLL_ASCENDING_29(STEP) ALALPCSYNTHESIZER_UNROLL_ASCENDING_28(STEP) STEP(29)
+#define ALALPCSYNTHESIZER_UNROLL_ASCENDING_30(STEP) ALALPCSYNTHESIZER_UNROLL_ASCENDING_29(STEP) STEP(30)
+#define ALALPCSYNTHESIZER_UNROLL_ASCENDING_31(STEP) ALALPCSYNTHESIZER_UNROLL_ASCENDING_30(STEP) STEP(31)
+#define ALALPCSYNTHESIZER_UNROLL_ASCENDING_32(STEP) ALALPCSYNTHESIZER_UNROLL_ASCENDING_31(STEP) STEP(32)
+#define ALALPCSYNTHESIZER_UNROLL_DESCENDING_0(STEP)
+#define ALALPCSYNTHESIZER_UNROLL_DESCENDING_1(STEP) STEP(1) ALALPCSYNTHESIZER_UNROLL_DESCENDING_0(STEP)
+#define ALALPCSYNTHESIZER_UNROLL_DESCENDING_2(STEP) STEP(2) ALALPCSYNTHESIZER_UNROLL_DESCENDING_1(STEP)
+#define ALALPCSYNTHESIZER_UNROLL_DESCENDING_3(STEP) STEP(3) ALALPCSYNTHESIZER_UNROLL_DESCENDING_2(STEP)
+#define ALALPCSYNTHESIZER_UNROLL_DESCENDING_4(STEP) STEP(4) ALALPCSYNTHESIZER_UNROLL_DESCENDING_3(STEP)
+#define ALALPCSYNTHESIZER_UNROLL_DESCENDING_5(STEP) STEP(5) ALALPCSYNTHESIZER_UNROLL_DESCENDING_4(STEP)
+#define ALALPCSYNTHESIZER_UNROLL_DESCENDING_6(STEP) STEP(6) ALALPCSYNTHESIZER_UNROLL_DESCENDING_5(STEP)
+#define ALALPCSYNTHESIZER_UNROLL_DESCENDING_7(STEP) STEP(7) ALALPCSYNTHESIZER_UNROLL_DESCENDING_6(STEP)
+#define ALALPCSYNTHESIZER_UNROLL_DESCENDING_8(STEP) STEP(8) ALALPCSYNTHESIZER_UNROLL_DESCENDING_7(STEP)
+#define ALALPCSYNTHESIZER_UNROLL_DESCENDING_9(STEP) STEP(9) ALALPCSYNTHESIZER_UNROLL_DESCENDING_8(STEP)
+#define ALALPCSYNTHESIZER_UNROLL_DESCENDING_10(STEP) STEP(10) ALALPCSYNTHESIZER_UNROLL_DESCENDING_9(STEP)
+#define ALALPCSYNTHESIZER_UNROLL_DESCENDING_11(STEP) STEP(11) ALALPCSYNTHESIZER_UNROLL_DESCENDING_10(STEP)
+#define ALALPCSYNTHESIZER_UNROLL_DESCENDING_12(STEP) STEP(12) ALALPCSYNTHESIZER_UNROLL_DESCENDING_11(STEP)
+#define ALALPCSYNTHESIZER_UNROLL_DESCENDING_13(STEP) STEP(13) ALALPCSYNTHESIZER_UNROLL_DESCENDING_12(STEP)
+#define ALALPCSYNTHESIZER_UNROLL_DESCENDING_14(STEP) STEP(14) ALALPCSYNTHESIZER_UNROLL_DESCENDING_13(STEP)
+#define ALALPCSYNTHESIZER_UNROLL_DESCENDING_15(STEP) STEP(15) ALALPCSYNTHESIZER_UNROLL_DESCENDING_14(STEP)
+#define ALALPCSYNTHESIZER_UNROLL_DESCENDING_16(STEP) STEP(16) ALALPCSYNTHESIZER_UNROLL_DESCENDING_15(STEP)
+#define ALALPCSYNTHESIZER_UNROLL_DESCENDING_17(STEP) STEP(17) ALALPCSYNTHESIZER_UNROLL_DESCENDING_16(STEP)
+#define ALALPCSYNTHESIZER_UNROLL_DESCENDING_18(STEP) STEP(18) ALALPCSYNTHESIZER_UNROLL_DESCENDING_17(STEP)
+#define ALALPCSYNTHESIZER_UNROLL_DESCENDING_19(STEP) STEP(19) ALALPCSYNTHESIZER_UNROLL_DESCENDING_18(STEP)
+#define ALALPCSYNTHESIZER_UNROLL_DESCENDING_20(STEP) STEP(20) ALALPCSYNTHESIZER_UNROLL_DESCENDING_19(STEP)
+#define ALALPCSYNTHESIZER_UNROLL_DESCENDING_21(STEP) STEP(21) ALALPCSYNTHESIZER_UNROLL_DESCENDING_20(STEP)
+#define ALALPCSYNTHESIZER_UNROLL_DESCENDING_22(STEP) STEP(22) ALALPCSYNTHESIZER_UNROLL_DESCENDING_21(STEP)
+#define ALALPCSYNTHESIZER_UNROLL_DESCENDING_23(STEP) STEP(23) ALALPCSYNTHESIZER_UNROLL_DESCENDING_22(STEP)
+#define ALALPCSYNTHESIZER_UNROLL_DESCENDING_24(STEP) STEP(24) ALALPCSYNTHESIZER_UNROLL_DESCENDING_23(STEP)
+#define ALALPCSYNTHESIZER_UNROLL_DESCENDING_25(STEP) STEP(25) ALALPCSYNTHESIZER_UNROLL_DESCENDING_24(STEP)
+#define ALALPCSYNTHESIZER_UNROLL_DESCENDING_26(STEP) STEP(26) ALALPCSYNTHESIZER_UNROLL_DESCENDING_25(STEP)
+#define ALALPCSYNTHESIZER_UNROLL_DESCENDING_27(STEP) STEP(27) ALALPCSYNTHESIZER_UNROLL_DESCENDING_26(STEP)
+#define ALALPCSYNTHESIZER_UNROLL_DESCENDING_28(STEP) STEP(28) ALALPCSYNTHESIZER_UNROLL_DESCENDING_27(STEP)
+#define ALALPCSYNTHESIZER_UNROLL_DESCENDING_29(STEP) STEP(29) ALALPCSYNTHESIZER_UNROLL_DESCENDING_28(STEP)
+#define ALALPCSYNTHESIZER_UNROLL_DESCENDING_30(STEP) STEP(30) ALALPCSYNTHESIZER_UNROLL_DESCENDING_29(STEP)
+#define ALALPCSYNTHESIZER_UNROLL_DESCENDING_31(STEP) STEP(31) ALALPCSYNTHESIZER_UNROLL_DESCENDING_30(STEP)
+#define ALALPCSYNTHESIZER_UNROLL_DESCENDING_32(STEP) STEP(32) ALALPCSYNTHESIZER_UNROLL_DESCENDING_31(STEP)
+
+/* 各次数の展開ステップ（k:係数, f:前向き誤差, b:後ろ向き誤差 いずれもオート変数） */
+#define ALALPCSYNTHESIZER_LOAD_STEP(ord) \
+  k[ord] = parcor_coef[ord]; b[ord] = backward_residual[ord];
+#define ALALPCSYNTHESIZER_STORE_STEP(ord) \
+  backward_residual[ord] = b[ord];
+#define ALALPCSYNTHESIZER_PREDICT_FORWARD_STEP(ord) \
+  f[ord] = f[ord - 1] - ALALPCSYNTHESIZER_MUL(k[ord], b[ord - 1]);
+#define ALALPCSYNTHESIZER_PREDICT_BACKWARD_STEP(ord) \
+  b[ord] = b[ord - 1] - ALALPCSYNTHESIZER_MUL(k[ord], f[ord - 1]);
+#define ALALPCSYNTHESIZER_SYNTHESIZE_STEP(ord) \
+  f += ALALPCSYNTHESIZER_MUL(k[ord], b[ord - 1]); \
+  b[ord] = b[ord - 1] - ALALPCSYNTHESIZER_MUL(k[ord], f);
+
+/* 次数を固定して展開した予測/合成カーネルの定義 */
+/* 定数添字のみで参照するため、係数と誤差はレジスタに載る */
+#define ALALPCSYNTHESIZER_DEFINE_KERNELS(order) \
+static uint64_t ALALPCSynthesizer_PredictOrder##order( \
+    int32_t* backward_residual, const int32_t* parcor_coef, \
+    const int32_t* data, uint32_t num_samples, \
+    int32_t emphasis_shift, int32_t* preemphasis_prev, int32_t* residual) \
+{ \
+  uint32_t samp; \
+  uint64_t code_sum = 0; \
+  int32_t k[order + 1], f[order + 1], b[order + 1], x, p; \
+  const int32_t emphasis_numer = (int32_t)((1 << emphasis_shift) - 1); \
+  b[0] = backward_residual[0]; \
+  ALALPCSYNTHESIZER_UNROLL_ASCENDING_##order(ALALPCSYNTHESIZER_LOAD_STEP) \
+  p = (*preemphasis_prev); \
+  for (samp = 0; samp < num_samples; samp++) { \
+    x = data[samp]; \
+    f[0] = x - (int32_t)ALAUTILITY_SHIFT_RIGHT_ARITHMETIC(p * emphasis_numer, emphasis_shift); \
+    p = x; \
+    ALALPCSYNTHESIZER_UNROLL_ASCENDING_##order(ALALPCSYNTHESIZER_PREDICT_FORWARD_STEP) \
+    ALALPCSYNTHESIZER_UNROLL_DESCENDING_##order(ALALPCSYNTHESIZER_PREDICT_BACKWARD_STEP) \
+    b[0] = f[0]; \
+    residual[samp] = f[order]; \
+    code_sum += ALAUTILITY_SINT32_TO_UINT32(f[order]); \
+  } \
+  backward_residual[0] = b[0]; \
+  ALALPCSYNTHESIZER_UNROLL_ASCENDING_##order(ALALPCSYNTHESIZER_STORE_STEP) \
+  (*preemphasis_prev) = p; \
+  return code_sum; \
+} \
+static void ALALPCSynthesizer_SynthesizeOrder##order( \
+    int32_t* backward_residual, const int32_t* parcor_coef, \
+    const int32_t* residual, uint32_t num_samples, \
+    int32_t emphasis_shift, int32_t* deemphasis_prev, int32_t* output) \
+{ \
+  uint32_t samp; \
+  int32_t k[order + 1], f, b[order + 1], d; \
+  const int32_t emphasis_numer = (int32_t)((1 << emphasis_shift) - 1); \
+  b[0] = backward_residual[0]; \
+  ALALPCSYNTHESIZER_UNROLL_ASCENDING_##order(ALALPCSYNTHESIZER_LOAD_STEP) \
+  d = (*deemphasis_prev); \
+  for (samp = 0; samp < num_samples; samp++) { \
+    f = residual[samp]; \
+    ALALPCSYNTHESIZER_UNROLL_DESCENDING_##order(ALALPCSYNTHESIZER_SYNTHESIZE_STEP) \
+    b[0] = f; \
+    d = f + (int32_t)ALAUTILITY_SHIFT_RIGHT_ARITHMETIC(d * emphasis_numer, emphasis_shift); \
+    output[samp] = d; \
+  } \
+  backward_residual[0] = b[0]; \
+  ALALPCSYNTHESIZER_UNROLL_ASCENDING_##order(ALALPCSYNTHESIZER_STORE_STEP) \
+  (*deemphasis_prev) = d; \
+}
+
+/* 0次の予測（プリエンファシスした入力をそのまま残差とする） */
+static uint64_t ALALPCSynthesizer_PredictOrder0(
+    int32_t* backward_residual, const int32_t* parcor_coef,
+    const int32_t* data, uint32_t num_samples,
+    int32_t emphasis_shift, int32_t* preemphasis_prev, int32_t* residual)
+{
+  uint32_t samp;
+  uint64_t code_sum = 0;
+  int32_t x, e, p;
+  const int32_t emphasis_numer = (int32_t)((1 << emphasis_shift) - 1);
+
+  ALAUTILITY_UNUSED_ARGUMENT(parcor_coef);
+
+  p = (*preemphasis_prev);
+  e = backward_residual[0];
+  for (samp = 0; samp < num_samples; samp++) {
+    x = data[samp];
+    e = x - (int32_t)ALAUTILITY_SHIFT_RIGHT_ARITHMETIC(p * emphasis_numer, emphasis_shift);
+    p = x;
+    residual[samp] = e;
+    code_sum += ALAUTILITY_SINT32_TO_UINT32(e);
+  }
+  backward_residual[0] = e;
+  (*preemphasis_prev) = p;
+
+  return code_sum;
+}
+
+/* 0次の合成（残差をそのままデエンファシスして出力とする） */
+static void ALALPCSynthesizer_SynthesizeOrder0(
+    int32_t* backward_residual, const int32_t* parcor_coef,
+    const int32_t* residual, uint32_t num_samples,
+    int32_t emphasis_shift, int32_t* deemphasis_prev, int32_t* output)
+{
+  uint32_t samp;
+  int32_t d;
+  const int32_t emphasis_numer = (int32_t)((1 << emphasis_shift) - 1);
+
+  ALAUTILITY_UNUSED_ARGUMENT(parcor_coef);
+
+  if (num_samples > 0) {
+    backward_residual[0] = residual[num_samples - 1];
+  }
+  d = (*deemphasis_prev);
+  for (samp = 0; samp < num_samples; samp++) {
+    d = residual[samp] + (int32_t)ALAUTILITY_SHIFT_RIGHT_ARITHMETIC(d * emphasis_numer, emphasis_shift);
+    output[samp] = d;
+  }
+  (*deemphasis_prev) = d;
+}
+
+ALALPCSYNTHESIZER_DEFINE_KERNELS(1) ALALPCSYNTHESIZER_DEFINE_KERNELS(2) ALALPCSYNTHESIZER_DEFINE_KERNELS(3) ALALPCSYNTHESIZER_DEFINE_KERNELS(4)
+ALALPCSYNTHESIZER_DEFINE_KERNELS(5) ALALPCSYNTHESIZER_DEFINE_KERNELS(6) ALALPCSYNTHESIZER_DEFINE_KERNELS(7) ALALPCSYNTHESIZER_DEFINE_KERNELS(8)
+ALALPCSYNTHESIZER_DEFINE_KERNELS(9) ALALPCSYNTHESIZER_DEFINE_KERNELS(10) ALALPCSYNTHESIZER_DEFINE_KERNELS(11) ALALPCSYNTHESIZER_DEFINE_KERNELS(12)
+ALALPCSYNTHESIZER_DEFINE_KERNELS(13) ALALPCSYNTHESIZER_DEFINE_KERNELS(14) ALALPCSYNTHESIZER_DEFINE_KERNELS(15) ALALPCSYNTHESIZER_DEFINE_KERNELS(16)
+ALALPCSYNTHESIZER_DEFINE_KERNELS(17) ALALPCSYNTHESIZER_DEFINE_KERNELS(18) ALALPCSYNTHESIZER_DEFINE_KERNELS(19) ALALPCSYNTHESIZER_DEFINE_KERNELS(20)
+ALALPCSYNTHESIZER_DEFINE_KERNELS(21) ALALPCSYNTHESIZER_DEFINE_KERNELS(22) ALALPCSYNTHESIZER_DEFINE_KERNELS(23) ALALPCSYNTHESIZER_DEFINE_KERNELS(24)
+ALALPCSYNTHESIZER_DEFINE_KERNELS(25) ALALPCSYNTHESIZER_DEFINE_KERNELS(26) ALALPCSYNTHESIZER_DEFINE_KERNELS(27) ALALPCSYNTHESIZER_DEFINE_KERNELS(28)
+ALALPCSYNTHESIZER_DEFINE_KERNELS(29) ALALPCSYNTHESIZER_DEFINE_KERNELS(30) ALALPCSYNTHESIZER_DEFINE_KERNELS(31) ALALPCSYNTHESIZER_DEFINE_KERNELS(32)
+
+/* 展開済み予測カーネルの型（backward_residualは呼び出し間で引き継ぐ後ろ向き誤差、
+ * preemphasis_prevは呼び出し間で引き継ぐプリエンファシス入力） 残差を符号なし整数に変換した値の和を返す */
+typedef uint64_t (*ALALPCSynthesizerPredictFunction)(
+    int32_t* backward_residual, const int32_t* parcor_coef,
+    const int32_t* data, uint32_t num_samples,
+    int32_t emphasis_shift, int32_t* preemphasis_prev, int32_t* residual);
+
+/* 展開済み合成カーネルの型（deemphasis_prevは呼び出し間で引き継ぐデエンファシス出力） */
+typedef void (*ALALPCSynthesizerSynthesizeFunction)(
+    int32_t* backward_residual, const int32_t* parcor_coef,
+    const int32_t* residual, uint32_t num_samples,
+    int32_t emphasis_shift, int32_t* deemphasis_prev, int32_t* output);
+
+/* 次数をインデックスとする予測カーネルの表 */
+static const ALALPCSynthesizerPredictFunction predict_kernels[ALALPCSYNTHESIZER_MAX_UNROLLED_ORDER + 1] = {
+  ALALPCSynthesizer_PredictOrder0, ALALPCSynthesizer_PredictOrder1, ALALPCSynthesizer_PredictOrder2,
+  ALALPCSynthesizer_PredictOrder3, ALALPCSynthesizer_PredictOrder4, ALALPCSynthesizer_PredictOrder5,
+  ALALPCSynthesizer_PredictOrder6, ALALPCSynthesizer_PredictOrder7, ALALPCSynthesizer_PredictOrder8,
+  ALALPCSynthesizer_PredictOrder9, ALALPCSynthesizer_PredictOrder10, ALALPCSynthesizer_PredictOrder11,
+  ALALPCSynthesizer_PredictOrder12, ALALPCSynthesizer_PredictOrder13, ALALPCSynthesizer_PredictOrder14,
+  ALALPCSynthesizer_PredictOrder15, ALALPCSynthesizer_PredictOrder16, ALALPCSynthesizer_PredictOrder17,
+  ALALPCSynthesizer_PredictOrder18, ALALPCSynthesizer_PredictOrder19, ALALPCSynthesizer_PredictOrder20,
+  ALALPCSynthesizer_PredictOrder21, ALALPCSynthesizer_PredictOrder22, ALALPCSynthesizer_PredictOrder23,
+  ALALPCSynthesizer_PredictOrder24, ALALPCSynthesizer_PredictOrder25, ALALPCSynthesizer_PredictOrder26,
+  ALALPCSynthesizer_PredictOrder27, ALALPCSynthesizer_PredictOrder28, ALALPCSynthesizer_PredictOrder29,
+  ALALPCSynthesizer_PredictOrder30, ALALPCSynthesizer_PredictOrder31, ALALPCSynthesizer_PredictOrder32
+};
+
+/* 次数をインデックスとする合成カーネルの表 */
+static const ALALPCSynthesizerSynthesizeFunction synthesize_kernels[ALALPCSYNTHESIZER_MAX_UNROLLED_ORDER + 1] = {
+  ALALPCSynthesizer_SynthesizeOrder0, ALALPCSynthesizer_SynthesizeOrder1, ALALPCSynthesizer_SynthesizeOrder2,
+  ALALPCSynthesizer_SynthesizeOrder3, ALALPCSynthesizer_SynthesizeOrder4, ALALPCSynthesizer_SynthesizeOrder5,
+  ALALPCSynthesizer_SynthesizeOrder6, ALALPCSynthesizer_SynthesizeOrder7, ALALPCSynthesizer_SynthesizeOrder8,
+  ALALPCSynthesizer_SynthesizeOrder9, ALALPCSynthesizer_SynthesizeOrder10, ALALPCSynthesizer_SynthesizeOrder11,
+  ALALPCSynthesizer_SynthesizeOrder12, ALALPCSynthesizer_SynthesizeOrder13, ALALPCSynthesizer_SynthesizeOrder14,
+  ALALPCSynthesizer_SynthesizeOrder15, ALALPCSynthesizer_SynthesizeOrder16, ALALPCSynthesizer_SynthesizeOrder17,
+  ALALPCSynthesizer_SynthesizeOrder18, ALALPCSynthesizer_SynthesizeOrder19, ALALPCSynthesizer_SynthesizeOrder20,
+  ALALPCSynthesizer_SynthesizeOrder21, ALALPCSynthesizer_SynthesizeOrder22, ALALPCSynthesizer_SynthesizeOrder23,
+  ALALPCSynthesizer_SynthesizeOrder24, ALALPCSynthesizer_SynthesizeOrder25, ALALPCSynthesizer_SynthesizeOrder26,
+  ALALPCSynthesizer_SynthesizeOrder27, ALALPCSynthesizer_SynthesizeOrder28, ALALPCSynthesizer_SynthesizeOrder29,
+  ALALPCSynthesizer_SynthesizeOrder30, ALALPCSynthesizer_SynthesizeOrder31, ALALPCSynthesizer_SynthesizeOrder32
+};
+
+/* プリエンファシスとPARCOR係数による予測（emphasis_shiftが0ならプリエンファシスなし） */
+static ALAPredictorApiResult ALALPCSynthesizer_Predict(
     struct ALALPCSynthesizer* lpc,
     const int32_t* data, uint32_t num_samples,
-    const int32_t* parcor_coef, uint32_t order, int32_t* residual)
+    const int32_t* parcor_coef, uint32_t order, int32_t emphasis_shift,
+    int32_t* residual, uint64_t* code_sum)
 {
   uint32_t      samp, ord;
   int32_t*      forward_residual;
   int32_t*      backward_residual;
-  int32_t       mul_temp;
+  int32_t       mul_temp, input, preemphasis_prev;
+  int32_t       emphasis_numer;
+  uint64_t      sum;
   /* 丸め誤差軽減のための加算定数 = 0.5 */
-  const int32_t half = (1UL << 14); 
+  const int64_t half = (1UL << 14); 
 
   /* 引数チェック */
   if (lpc == NULL || data == NULL
-      || parcor_coef == NULL || residual == NULL) {
+      || parcor_coef == NULL || residual == NULL
+      || (emphasis_shift < 0) || (emphasis_shift > 30)) {
     return ALAPREDICTOR_APIRESULT_INVALID_ARGUMENT;
   }
 
@@ -304,50 +717,94 @@ ALAPredictorApiResult ALALPCSynthesizer_PredictByParcorCoefInt32(
     return ALAPREDICTOR_APIRESULT_EXCEED_MAX_ORDER;
   }
 
-  /* オート変数にポインタをコピー */
+  /* 展開済みカーネルがあれば使う */
+  if (order <= ALALPCSYNTHESIZER_MAX_UNROLLED_ORDER) {
+    sum = predict_kernels[order](lpc->backward_residual, parcor_coef, data, num_samples,
+        emphasis_shift, &lpc->preemphasis_prev, residual);
+    if (code_sum != NULL) {
+      (*code_sum) = sum;
+    }
+    return ALAPREDICTOR_APIRESULT_OK;
+  }
+
+  /* オート変数にコピー */
   forward_residual  = lpc->forward_residual;
   backward_residual = lpc->backward_residual;
+  preemphasis_prev  = lpc->preemphasis_prev;
+  emphasis_numer    = (int32_t)((1 << emphasis_shift) - 1);
 
   /* 誤差計算 */
+  sum = 0;
   for (samp = 0; samp < num_samples; samp++) {
-    /* 格子型フィルタにデータ入力 */
-    forward_residual[0] = data[samp];
+    /* プリエンファシスして格子型フィルタにデータ入力 */
+    input = data[samp];
+    forward_residual[0] = input
+      - (int32_t)ALAUTILITY_SHIFT_RIGHT_ARITHMETIC(preemphasis_prev * emphasis_numer, emphasis_shift);
+    preemphasis_prev = input;
     /* 前向き誤差計算 */
     for (ord = 1; ord <= order; ord++) {
       mul_temp 
-        = (int32_t)ALAUTILITY_SHIFT_RIGHT_ARITHMETIC(parcor_coef[ord] * backward_residual[ord - 1] + half, 15);
+        = (int32_t)ALAUTILITY_SHIFT_RIGHT_ARITHMETIC((int64_t)parcor_coef[ord] * backward_residual[ord - 1] + half, 15);
       forward_residual[ord] = forward_residual[ord - 1] - mul_temp;
     }
     /* 後ろ向き誤差計算 */
     for (ord = order; ord >= 1; ord--) {
       mul_temp 
-        = (int32_t)ALAUTILITY_SHIFT_RIGHT_ARITHMETIC(parcor_coef[ord] * forward_residual[ord - 1] + half, 15);
+        = (int32_t)ALAUTILITY_SHIFT_RIGHT_ARITHMETIC((int64_t)parcor_coef[ord] * forward_residual[ord - 1] + half, 15);
       backward_residual[ord] = backward_residual[ord - 1] - mul_temp;
     }
     /* 後ろ向き誤差計算部にデータ入力 */
-    backward_residual[0] = data[samp];
+    backward_residual[0] = forward_residual[0];
     /* 残差信号 */
     residual[samp] = forward_residual[order];
+    sum += ALAUTILITY_SINT32_TO_UINT32(forward_residual[order]);
+  }
+  lpc->preemphasis_prev = preemphasis_prev;
+
+  if (code_sum != NULL) {
+    (*code_sum) = sum;
   }
 
   return ALAPREDICTOR_APIRESULT_OK;
 }
 
-/* PARCOR係数により誤差信号から音声合成（32bit整数入出力） */
-ALAPredictorApiResult ALALPCSynthesizer_SynthesizeByParcorCoefInt32(
+/* PARCOR係数により予測/誤差出力（32bit整数入出力） */
+ALAPredictorApiResult ALALPCSynthesizer_PredictByParcorCoefInt32(
+    struct ALALPCSynthesizer* lpc,
+    const int32_t* data, uint32_t num_samples,
+    const int32_t* parcor_coef, uint32_t order, int32_t* residual)
+{
+  return ALALPCSynthesizer_Predict(lpc, data, num_samples, parcor_coef, order, 0, residual, NULL);
+}
+
+/* プリエンファシスし、続けてPARCOR係数により予測/誤差出力（32bit整数入出力） */
+ALAPredictorApiResult ALALPCSynthesizer_PreEmphasizeAndPredictInt32(
+    struct ALALPCSynthesizer* lpc,
+    const int32_t* data, uint32_t num_samples,
+    const int32_t* parcor_coef, uint32_t order, int32_t emphasis_shift,
+    int32_t* residual, uint64_t* code_sum)
+{
+  return ALALPCSynthesizer_Predict(lpc, data, num_samples,
+      parcor_coef, order, emphasis_shift, residual, code_sum);
+}
+
+/* PARCOR係数による音声合成とデエンファシス（emphasis_shiftが0ならデエンファシスなし） */
+static ALAPredictorApiResult ALALPCSynthesizer_Synthesize(
     struct ALALPCSynthesizer* lpc,
     const int32_t* residual, uint32_t num_samples,
-    const int32_t* parcor_coef, uint32_t order, int32_t* output)
+    const int32_t* parcor_coef, uint32_t order, int32_t emphasis_shift, int32_t* output)
 {
   uint32_t      ord, samp;
   int32_t       forward_residual;   /* 合成時は記憶領域を持つ必要なし */
   int32_t*      backward_residual;
-  int32_t       mul_temp;
-  const int32_t half = (1UL << 14); /* 丸め誤差軽減のための加算定数 = 0.5 */
+  int32_t       mul_temp, deemphasis_prev;
+  const int64_t half = (1UL << 14); /* 丸め誤差軽減のための加算定数 = 0.5 */
+  int32_t       emphasis_numer;
 
   /* 引数チェック */
   if (lpc == NULL || residual == NULL
-      || parcor_coef == NULL || output == NULL) {
+      || parcor_coef == NULL || output == NULL
+      || (emphasis_shift < 0) || (emphasis_shift > 30)) {
     return ALAPREDICTOR_APIRESULT_INVALID_ARGUMENT;
   }
 
@@ -356,8 +813,17 @@ ALAPredictorApiResult ALALPCSynthesizer_SynthesizeByParcorCoefInt32(
     return ALAPREDICTOR_APIRESULT_EXCEED_MAX_ORDER;
   }
 
-  /* オート変数にポインタをコピー */
+  /* 展開済みカーネルがあれば使う */
+  if (order <= ALALPCSYNTHESIZER_MAX_UNROLLED_ORDER) {
+    synthesize_kernels[order](lpc->backward_residual, parcor_coef, residual, num_samples,
+        emphasis_shift, &lpc->deemphasis_prev, output);
+    return ALAPREDICTOR_APIRESULT_OK;
+  }
+
+  /* オート変数にコピー */
   backward_residual = lpc->backward_residual;
+  deemphasis_prev   = lpc->deemphasis_prev;
+  emphasis_numer    = (int32_t)((1 << emphasis_shift) - 1);
 
   /* 格子型フィルタによる音声合成 */
   for (samp = 0; samp < num_samples; samp++) {
@@ -366,16 +832,544 @@ ALAPredictorApiResult ALALPCSynthesizer_SynthesizeByParcorCoefInt32(
     for (ord = order; ord >= 1; ord--) {
       /* 前向き誤差計算 */
       forward_residual
-        += (int32_t)ALAUTILITY_SHIFT_RIGHT_ARITHMETIC(parcor_coef[ord] * backward_residual[ord - 1] + half, 15);
+        += (int32_t)ALAUTILITY_SHIFT_RIGHT_ARITHMETIC((int64_t)parcor_coef[ord] * backward_residual[ord - 1] + half, 15);
       /* 後ろ向き誤差計算 */
       mul_temp
-        = (int32_t)ALAUTILITY_SHIFT_RIGHT_ARITHMETIC(parcor_coef[ord] * forward_residual + half, 15);
+        = (int32_t)ALAUTILITY_SHIFT_RIGHT_ARITHMETIC((int64_t)parcor_coef[ord] * forward_residual + half, 15);
       backward_residual[ord] = backward_residual[ord - 1] - mul_temp;
     }
-    /* 合成信号 */
-    output[samp] = forward_residual;
     /* 後ろ向き誤差計算部にデータ入力 */
     backward_residual[0] = forward_residual;
+    /* デエンファシスして合成信号とする */
+    deemphasis_prev = forward_residual
+      + (int32_t)ALAUTILITY_SHIFT_RIGHT_ARITHMETIC(deemphasis_prev * emphasis_numer, emphasis_shift);
+    output[samp] = deemphasis_prev;
+  }
+  lpc->deemphasis_prev = deemphasis_prev;
+
+  return ALAPREDICTOR_APIRESULT_OK;
+}
+
+/* PARCOR係数により誤差信号から音声合成（32bit整数入出力） */
+ALAPredictorApiResult ALALPCSynthesizer_SynthesizeByParcorCoefInt32(
+    struct ALALPCSynthesizer* lpc,
+    const int32_t* residual, uint32_t num_samples,
+    const int32_t* parcor_coef, uint32_t order, int32_t* output)
+{
+  return ALALPCSynthesizer_Synthesize(lpc, residual, num_samples, parcor_coef, order, 0, output);
+}
+
+/* PARCOR係数により誤差信号から音声合成し、続けてデエンファシス（32bit整数入出力） */
+ALAPredictorApiResult ALALPCSynthesizer_SynthesizeAndDeEmphasizeInt32(
+    struct ALALPCSynthesizer* lpc,
+    const int32_t* residual, uint32_t num_samples,
+    const int32_t* parcor_coef, uint32_t order, int32_t emphasis_shift, int32_t* output)
+{
+  return ALALPCSynthesizer_Synthesize(lpc, residual, num_samples, parcor_coef, order, emphasis_shift, output);
+}
+
+/* 適応フィルタハンドルの作成 */
+struct ALALMSFilter* ALALMSFilter_Create(uint32_t max_num_taps)
+{
+  struct ALALMSFilter* lms;
+
+  /* 引数チェック */
+  if (max_num_taps == 0) {
+    return NULL;
+  }
+
+  lms = (struct ALALMSFilter *)malloc(sizeof(struct ALALMSFilter));
+  lms->max_num_taps = max_num_taps;
+
+  /* 領域割当て */
+  lms->weight   = (int16_t *)malloc(sizeof(int16_t) * max_num_taps);
+  lms->history  = (int16_t *)malloc(sizeof(int16_t) * (max_num_taps + ALALMSFILTER_HISTORY_WINDOW));
+  lms->adapt    = (int16_t *)malloc(sizeof(int16_t) * (max_num_taps + ALALMSFILTER_HISTORY_WINDOW));
+
+  /* パラメータはリセット時に設定する */
+  lms->num_taps = 0;
+  lms->shift    = 0;
+  lms->pos      = 0;
+
+  return lms;
+}
+
+/* 適応フィルタハンドルの破棄 */
+void ALALMSFilter_Destroy(struct ALALMSFilter* lms)
+{
+  if (lms != NULL) {
+    free(lms->weight);
+    free(lms->history);
+    free(lms->adapt);
+    free(lms);
+  }
+}
+
+/* 適応フィルタのパラメータ設定と内部状態リセット */
+ALAPredictorApiResult ALALMSFilter_Reset(struct ALALMSFilter* lms, uint32_t num_taps, uint32_t shift)
+{
+  /* 引数チェック */
+  if (lms == NULL) {
+    return ALAPREDICTOR_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* タップ数チェック */
+  if (num_taps > lms->max_num_taps) {
+    return ALAPREDICTOR_APIRESULT_EXCEED_MAX_ORDER;
+  }
+  if ((num_taps == 0) || (shift == 0) || (shift > ALA_LMS_MAX_SHIFT)) {
+    return ALAPREDICTOR_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  lms->num_taps = num_taps;
+  lms->shift    = shift;
+  lms->pos      = num_taps;
+  memset(lms->weight,  0, sizeof(int16_t) * num_taps);
+  memset(lms->history, 0, sizeof(int16_t) * num_taps);
+  memset(lms->adapt,   0, sizeof(int16_t) * num_taps);
+
+  return ALAPREDICTOR_APIRESULT_OK;
+}
+
+/* 適応フィルタの予測値計算 */
+static int32_t ALALMSFilter_Predict(const struct ALALMSFilter* lms)
+{
+  uint32_t i;
+  uint32_t sum;
+  const int16_t* weight  = lms->weight;
+  const int16_t* history = &lms->history[lms->pos - lms->num_taps];
+
+  /* 積和はラップアラウンドする32bitで計算（SIMDの結果と一致させるため） */
+  sum = 0;
+  i = 0;
+#if defined(ALAPREDICTOR_USE_SSE2)
+  {
+    __m128i acc = _mm_setzero_si128();
+    uint32_t lane[4];
+    for (; i + 8 <= lms->num_taps; i += 8) {
+      acc = _mm_add_epi32(acc, _mm_madd_epi16(
+            _mm_loadu_si128((const __m128i *)&weight[i]),
+            _mm_loadu_si128((const __m128i *)&history[i])));
+    }
+    _mm_storeu_si128((__m128i *)lane, acc);
+    sum = lane[0] + lane[1] + lane[2] + lane[3];
+  }
+#endif
+  for (; i < lms->num_taps; i++) {
+    sum += (uint32_t)((int32_t)weight[i] * history[i]);
+  }
+
+  return ALAUTILITY_SHIFT_RIGHT_ARITHMETIC(
+      ALALMSFILTER_UINT32_TO_SINT32(sum) + (1 << (lms->shift - 1)), lms->shift);
+}
+
+/* 適応フィルタの係数更新と入力履歴の追加 */
+static void ALALMSFilter_Update(struct ALALMSFilter* lms, int32_t input, int32_t error)
+{
+  uint32_t i;
+  int32_t  tmp;
+  int16_t* weight = lms->weight;
+  const int16_t* adapt = &lms->adapt[lms->pos - lms->num_taps];
+
+  /* 誤差の符号の向きに係数を更新（16bitに飽和） */
+  if (error != 0) {
+    i = 0;
+#if defined(ALAPREDICTOR_USE_SSE2)
+    if (error > 0) {
+      for (; i + 8 <= lms->num_taps; i += 8) {
+        _mm_storeu_si128((__m128i *)&weight[i], _mm_adds_epi16(
+              _mm_loadu_si128((const __m128i *)&weight[i]), _mm_loadu_si128((const __m128i *)&adapt[i])));
+      }
+    } else {
+      for (; i + 8 <= lms->num_taps; i += 8) {
+        _mm_storeu_si128((__m128i *)&weight[i], _mm_subs_epi16(
+              _mm_loadu_si128((const __m128i *)&weight[i]), _mm_loadu_si128((const __m128i *)&adapt[i])));
+      }
+    }
+#endif
+    for (; i < lms->num_taps; i++) {
+      tmp = (error > 0) ? (weight[i] + adapt[i]) : (weight[i] - adapt[i]);
+      weight[i] = (int16_t)ALAUTILITY_INNER_VALUE(tmp, INT16_MIN, INT16_MAX);
+    }
+  }
+
+  /* 入力履歴の追加（積和が32bitに収まるよう±INT16_MAXに飽和） */
+  lms->history[lms->pos]  = (int16_t)ALAUTILITY_INNER_VALUE(input, -INT16_MAX, INT16_MAX);
+  lms->adapt[lms->pos]    = (int16_t)((input > 0) ? ALA_LMS_STEP_SIZE : ((input < 0) ? -ALA_LMS_STEP_SIZE : 0));
+  lms->pos++;
+
+  /* バッファ末尾に達したら直近の履歴を先頭に詰め直す */
+  if (lms->pos >= lms->num_taps + ALALMSFILTER_HISTORY_WINDOW) {
+    memmove(lms->history, &lms->history[ALALMSFILTER_HISTORY_WINDOW], sizeof(int16_t) * lms->num_taps);
+    memmove(lms->adapt, &lms->adapt[ALALMSFILTER_HISTORY_WINDOW], sizeof(int16_t) * lms->num_taps);
+    lms->pos = lms->num_taps;
+  }
+}
+
+/* 適応フィルタにより予測/誤差出力（32bit整数入出力, in-place可） */
+ALAPredictorApiResult ALALMSFilter_PredictInt32(
+    struct ALALMSFilter* lms, const int32_t* data, uint32_t num_samples,
+    int32_t* residual, uint64_t* code_sum)
+{
+  uint32_t  smpl;
+  int32_t   input, error;
+  uint64_t  sum = 0;
+
+  /* 引数チェック */
+  if ((lms == NULL) || (data == NULL) || (residual == NULL)) {
+    return ALAPREDICTOR_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* パラメータが設定されていない */
+  if (lms->shift == 0) {
+    return ALAPREDICTOR_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  for (smpl = 0; smpl < num_samples; smpl++) {
+    input = data[smpl];
+    error = input - ALALMSFilter_Predict(lms);
+    ALALMSFilter_Update(lms, input, error);
+    residual[smpl] = error;
+    sum += ALAUTILITY_SINT32_TO_UINT32(error);
+  }
+
+  if (code_sum != NULL) {
+    (*code_sum) = sum;
+  }
+
+  return ALAPREDICTOR_APIRESULT_OK;
+}
+
+/* 適応フィルタにより誤差信号から合成（32bit整数入出力, in-place可） */
+ALAPredictorApiResult ALALMSFilter_SynthesizeInt32(
+    struct ALALMSFilter* lms, const int32_t* residual, uint32_t num_samples, int32_t* output)
+{
+  uint32_t  smpl;
+  int32_t   input, error;
+
+  /* 引数チェック */
+  if ((lms == NULL) || (residual == NULL) || (output == NULL)) {
+    return ALAPREDICTOR_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* パラメータが設定されていない */
+  if (lms->shift == 0) {
+    return ALAPREDICTOR_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  for (smpl = 0; smpl < num_samples; smpl++) {
+    error = residual[smpl];
+    input = error + ALALMSFilter_Predict(lms);
+    ALALMSFilter_Update(lms, input, error);
+    output[smpl] = input;
+  }
+
+  return ALAPREDICTOR_APIRESULT_OK;
+}
+
+/* 長期予測パラメータ計算ハンドルの作成 */
+struct ALALTPCalculator* ALALTPCalculator_Create(uint32_t max_num_samples)
+{
+  struct ALALTPCalculator* ltpc;
+
+  ltpc = (struct ALALTPCalculator *)malloc(sizeof(struct ALALTPCalculator));
+  ltpc->max_num_samples = max_num_samples;
+
+  /* 領域割当て */
+  ltpc->signal    = (float *)malloc(sizeof(float) * max_num_samples);
+  ltpc->decimated = (float *)malloc(sizeof(float) * (max_num_samples / 2 + 1));
+  ltpc->energy    = (double *)malloc(sizeof(double) * (max_num_samples + 1));
+  ltpc->work      = (int32_t *)malloc(sizeof(int32_t) * max_num_samples);
+
+  return ltpc;
+}
+
+/* 長期予測パラメータ計算ハンドルの破棄 */
+void ALALTPCalculator_Destroy(struct ALALTPCalculator* ltpc)
+{
+  if (ltpc != NULL) {
+    free(ltpc->signal);
+    free(ltpc->decimated);
+    free(ltpc->energy);
+    free(ltpc->work);
+    free(ltpc);
+  }
+}
+
+/* 内積（単精度） */
+static float ALALTPCalculator_DotProduct(const float* a, const float* b, uint32_t num_samples)
+{
+  uint32_t  i;
+  float     sum;
+
+  sum = 0.0f;
+  i = 0;
+#if defined(ALAPREDICTOR_USE_SSE2)
+  {
+    float   lane[4];
+    __m128  acc0 = _mm_setzero_ps();
+    __m128  acc1 = _mm_setzero_ps();
+    for (; i + 8 <= num_samples; i += 8) {
+      acc0 = _mm_add_ps(acc0, _mm_mul_ps(_mm_loadu_ps(&a[i]),     _mm_loadu_ps(&b[i])));
+      acc1 = _mm_add_ps(acc1, _mm_mul_ps(_mm_loadu_ps(&a[i + 4]), _mm_loadu_ps(&b[i + 4])));
+    }
+    _mm_storeu_ps(lane, _mm_add_ps(acc0, acc1));
+    sum = lane[0] + lane[1] + lane[2] + lane[3];
+  }
+#endif
+  for (; i < num_samples; i++) {
+    sum += a[i] * b[i];
+  }
+
+  return sum;
+}
+
+/* 正規化相互相関が最大となるラグの探索 */
+/* signal[lag..num_samples)とsignal[0..num_samples-lag)の相関を、後者のパワーで正規化して比較する */
+static uint32_t ALALTPCalculator_SearchLag(
+    const float* signal, double* energy, uint32_t num_samples, uint32_t min_lag, uint32_t max_lag)
+{
+  uint32_t  smpl, lag, best_lag;
+  double    corr, score, best_score;
+
+  assert((signal != NULL) && (energy != NULL));
+  assert((min_lag <= max_lag) && (max_lag < num_samples));
+
+  /* パワーの累積和 energy[i] = Σ_{j<i} signal[j]^2 */
+  energy[0] = 0.0f;
+  for (smpl = 0; smpl < num_samples; smpl++) {
+    energy[smpl + 1] = energy[smpl] + (double)signal[smpl] * (double)signal[smpl];
+  }
+
+  best_lag    = 0;
+  best_score  = 0.0f;
+  for (lag = min_lag; lag <= max_lag; lag++) {
+    corr = ALALTPCalculator_DotProduct(&signal[lag], &signal[0], num_samples - lag);
+    if ((corr <= 0.0f) || (energy[num_samples - lag] <= 0.0f)) {
+      continue;
+    }
+    score = corr * corr / energy[num_samples - lag];
+    if (score > best_score) {
+      best_score  = score;
+      best_lag    = lag;
+    }
+  }
+
+  return best_lag;
+}
+
+/* 3x3の連立一次方程式をガウスの消去法で解く 解けなければ0を返す */
+static int ALALTPCalculator_Solve3x3(double a[3][3], double* b, double* x)
+{
+  uint32_t i, j, k, pivot;
+  double   tmp, ratio;
+
+  for (i = 0; i < 3; i++) {
+    /* ピボット選択 */
+    pivot = i;
+    for (j = i + 1; j < 3; j++) {
+      if (fabs(a[j][i]) > fabs(a[pivot][i])) {
+        pivot = j;
+      }
+    }
+    if (fabs(a[pivot][i]) < DBL_EPSILON) {
+      return 0;
+    }
+    if (pivot != i) {
+      for (k = 0; k < 3; k++) {
+        tmp = a[i][k]; a[i][k] = a[pivot][k]; a[pivot][k] = tmp;
+      }
+      tmp = b[i]; b[i] = b[pivot]; b[pivot] = tmp;
+    }
+    /* 前進消去 */
+    for (j = i + 1; j < 3; j++) {
+      ratio = a[j][i] / a[i][i];
+      for (k = i; k < 3; k++) {
+        a[j][k] -= ratio * a[i][k];
+      }
+      b[j] -= ratio * b[i];
+    }
+  }
+
+  /* 後退代入 */
+  for (i = 3; i-- > 0; ) {
+    tmp = b[i];
+    for (k = i + 1; k < 3; k++) {
+      tmp -= a[i][k] * x[k];
+    }
+    x[i] = tmp / a[i][i];
+  }
+
+  return 1;
+}
+
+/* 予測誤差の絶対値和 */
+static uint64_t ALALTPCalculator_AbsSum(const int32_t* data, uint32_t num_samples)
+{
+  uint32_t smpl;
+  uint64_t sum = 0;
+
+  for (smpl = 0; smpl < num_samples; smpl++) {
+    sum += (uint64_t)((data[smpl] < 0) ? -(int64_t)data[smpl] : data[smpl]);
+  }
+
+  return sum;
+}
+
+/* 長期予測パラメータの計算 */
+ALAPredictorApiResult ALALTPCalculator_CalculateCoef(
+    struct ALALTPCalculator* ltpc, const int32_t* data, uint32_t num_samples,
+    uint32_t min_lag, uint32_t max_lag, uint32_t* lag, int32_t* coef)
+{
+  uint32_t  smpl, i, j, coarse_lag, best_lag, search_min, search_max;
+  uint32_t  num_decimated;
+  double    r[3][3], p[3], b[3];
+  const int32_t half_taps = ALA_LTP_NUM_TAPS / 2;
+
+  /* 引数チェック */
+  if ((ltpc == NULL) || (data == NULL) || (lag == NULL) || (coef == NULL)
+      || (min_lag <= (uint32_t)half_taps) || (min_lag > max_lag)) {
+    return ALAPREDICTOR_APIRESULT_INVALID_ARGUMENT;
+  }
+  if (num_samples > ltpc->max_num_samples) {
+    return ALAPREDICTOR_APIRESULT_EXCEED_MAX_ORDER;
+  }
+
+  /* 予測なしで初期化 */
+  (*lag) = 0;
+  for (i = 0; i < ALA_LTP_NUM_TAPS; i++) {
+    coef[i] = 0;
+  }
+
+  /* ラグの上限はブロック長の半分（相関を取るサンプルが少なすぎると当てにならない） */
+  max_lag = ALAUTILITY_MIN(max_lag, num_samples / 2);
+  if (max_lag < min_lag + 2) {
+    return ALAPREDICTOR_APIRESULT_OK;
+  }
+
+  /* 単精度に変換 */
+  for (smpl = 0; smpl < num_samples; smpl++) {
+    ltpc->signal[smpl] = (float)data[smpl];
+  }
+
+  /* 2:1に間引いた信号で粗探索 */
+  num_decimated = num_samples / 2;
+  for (smpl = 0; smpl < num_decimated; smpl++) {
+    ltpc->decimated[smpl] = ltpc->signal[2 * smpl] + ltpc->signal[2 * smpl + 1];
+  }
+  coarse_lag = ALALTPCalculator_SearchLag(ltpc->decimated, ltpc->energy,
+      num_decimated, (min_lag + 1) / 2, max_lag / 2);
+  if (coarse_lag == 0) {
+    return ALAPREDICTOR_APIRESULT_OK;
+  }
+
+  /* 元の信号で近傍を詳細探索 */
+  search_min = ALAUTILITY_MAX(min_lag, 2 * coarse_lag - 2);
+  search_max = ALAUTILITY_MIN(max_lag, 2 * coarse_lag + 2);
+  best_lag = ALALTPCalculator_SearchLag(ltpc->signal, ltpc->energy, num_samples, search_min, search_max);
+  if (best_lag == 0) {
+    return ALAPREDICTOR_APIRESULT_OK;
+  }
+
+  /* ラグ近傍のタップ係数を最小二乗法で求める */
+  /* 予測値: Σ_k b[k] * data[n - lag + k - half_taps] */
+  for (i = 0; i < 3; i++) {
+    p[i] = 0.0f;
+    for (j = 0; j < 3; j++) {
+      r[i][j] = 0.0f;
+    }
+  }
+  for (smpl = best_lag + (uint32_t)half_taps; smpl < num_samples; smpl++) {
+    double x[3];
+    for (i = 0; i < 3; i++) {
+      x[i] = (double)data[smpl - best_lag + i - (uint32_t)half_taps];
+    }
+    for (i = 0; i < 3; i++) {
+      p[i] += (double)data[smpl] * x[i];
+      for (j = 0; j < 3; j++) {
+        r[i][j] += x[i] * x[j];
+      }
+    }
+  }
+  if (!ALALTPCalculator_Solve3x3(r, p, b)) {
+    return ALAPREDICTOR_APIRESULT_OK;
+  }
+
+  /* 係数の量子化 */
+  for (i = 0; i < ALA_LTP_NUM_TAPS; i++) {
+    double qcoef = ALAUtility_Round(b[i] * (double)(1 << ALA_LTP_COEF_SHIFT));
+    coef[i] = (int32_t)ALAUTILITY_INNER_VALUE(qcoef, INT8_MIN, INT8_MAX);
+  }
+
+  /* 予測誤差を試算し、十分に小さくなる場合に限り採用 */
+  ALALongTermPredictor_PredictInt32(data, num_samples, best_lag, coef, ltpc->work, NULL);
+  if ((double)ALALTPCalculator_AbsSum(ltpc->work, num_samples)
+      < ALALTPCALCULATOR_MIN_GAIN_RATIO * (double)ALALTPCalculator_AbsSum(data, num_samples)) {
+    (*lag) = best_lag;
+  } else {
+    for (i = 0; i < ALA_LTP_NUM_TAPS; i++) {
+      coef[i] = 0;
+    }
+  }
+
+  return ALAPREDICTOR_APIRESULT_OK;
+}
+
+/* 長期予測の予測値 */
+#define ALALONGTERMPREDICTOR_PREDICT(data, smpl, lag, coef) \
+  ((int32_t)ALAUTILITY_SHIFT_RIGHT_ARITHMETIC( \
+      (coef)[0] * (data)[(smpl) - (lag) - 1] + (coef)[1] * (data)[(smpl) - (lag)] + (coef)[2] * (data)[(smpl) - (lag) + 1] \
+      + (1 << (ALA_LTP_COEF_SHIFT - 1)), ALA_LTP_COEF_SHIFT))
+
+/* 長期予測により予測/誤差出力（32bit整数入出力, in-place可） */
+ALAPredictorApiResult ALALongTermPredictor_PredictInt32(
+    const int32_t* data, uint32_t num_samples, uint32_t lag, const int32_t* coef,
+    int32_t* residual, uint64_t* code_sum)
+{
+  uint32_t smpl;
+  uint64_t sum = 0;
+
+  /* 引数チェック */
+  if ((data == NULL) || (coef == NULL) || (residual == NULL)
+      || (lag <= ALA_LTP_NUM_TAPS / 2)) {
+    return ALAPREDICTOR_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* in-placeでも過去の入力を壊さないよう後ろから処理 */
+  for (smpl = num_samples; smpl-- > lag + 1; ) {
+    residual[smpl] = data[smpl] - ALALONGTERMPREDICTOR_PREDICT(data, smpl, lag, coef);
+    sum += ALAUTILITY_SINT32_TO_UINT32(residual[smpl]);
+  }
+  /* 参照先がブロック外になる先頭部分は予測しない */
+  for (smpl = ALAUTILITY_MIN(lag + 1, num_samples); smpl-- > 0; ) {
+    residual[smpl] = data[smpl];
+    sum += ALAUTILITY_SINT32_TO_UINT32(residual[smpl]);
+  }
+
+  if (code_sum != NULL) {
+    (*code_sum) = sum;
+  }
+
+  return ALAPREDICTOR_APIRESULT_OK;
+}
+
+/* 長期予測により誤差信号から合成（32bit整数入出力, in-place可） */
+ALAPredictorApiResult ALALongTermPredictor_SynthesizeInt32(
+    const int32_t* residual, uint32_t num_samples, uint32_t lag, const int32_t* coef, int32_t* output)
+{
+  uint32_t smpl;
+
+  /* 引数チェック */
+  if ((residual == NULL) || (coef == NULL) || (output == NULL)
+      || (lag <= ALA_LTP_NUM_TAPS / 2)) {
+    return ALAPREDICTOR_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  for (smpl = 0; smpl < ALAUTILITY_MIN(lag + 1, num_samples); smpl++) {
+    output[smpl] = residual[smpl];
+  }
+  for (; smpl < num_samples; smpl++) {
+    output[smpl] = residual[smpl] + ALALONGTERMPREDICTOR_PREDICT(output, smpl, lag, coef);
   }
 
   return ALAPREDICTOR_APIRESULT_OK;
@@ -460,8 +1454,8 @@ ALAPredictorApiResult ALAChannelDecorrelator_LRtoMSDouble(double **data,
   double    mid, side;
 
   /* 引数チェック */
-  if ((data != NULL)
-      || (data[0] != NULL) || (data[1] != NULL)
+  if ((data == NULL)
+      || (data[0] == NULL) || (data[1] == NULL)
       || (num_channels < 2)) {
     return ALAPREDICTOR_APIRESULT_INVALID_ARGUMENT;
   }
@@ -485,14 +1479,25 @@ ALAPredictorApiResult ALAChannelDecorrelator_LRtoMSInt32(int32_t **data,
   int32_t   mid, side;
 
   /* 引数チェック */
-  if ((data != NULL)
-      || (data[0] != NULL) || (data[1] != NULL)
+  if ((data == NULL)
+      || (data[0] == NULL) || (data[1] == NULL)
       || (num_channels < 2)) {
     return ALAPREDICTOR_APIRESULT_INVALID_ARGUMENT;
   }
 
+  smpl = 0;
+#if defined(ALAPREDICTOR_USE_SSE2)
+  /* 4サンプル単位でLR -> MS処理 */
+  for (; smpl + 4 <= num_samples; smpl += 4) {
+    __m128i left  = _mm_loadu_si128((const __m128i *)&data[0][smpl]);
+    __m128i right = _mm_loadu_si128((const __m128i *)&data[1][smpl]);
+    _mm_storeu_si128((__m128i *)&data[0][smpl], _mm_srai_epi32(_mm_add_epi32(left, right), 1));
+    _mm_storeu_si128((__m128i *)&data[1][smpl], _mm_sub_epi32(left, right));
+  }
+#endif
+
   /* サンプル単位でLR -> MS処理 */
-  for (smpl = 0; smpl < num_samples; smpl++) {
+  for (; smpl < num_samples; smpl++) {
     /* 注意: 除算は右シフト必須(/2ではだめ。0方向に丸められる) */
     mid   = (int32_t)ALAUTILITY_SHIFT_RIGHT_ARITHMETIC(data[0][smpl] + data[1][smpl], 1); 
     side  = data[0][smpl] - data[1][smpl];
@@ -511,19 +1516,459 @@ ALAPredictorApiResult ALAChannelDecorrelator_MStoLRInt32(int32_t **data,
   int32_t   mid, side;
 
   /* 引数チェック */
-  if ((data != NULL)
-      || (data[0] != NULL) || (data[1] != NULL)
+  if ((data == NULL)
+      || (data[0] == NULL) || (data[1] == NULL)
       || (num_channels < 2)) {
     return ALAPREDICTOR_APIRESULT_INVALID_ARGUMENT;
   }
 
+  smpl = 0;
+#if defined(ALAPREDICTOR_USE_SSE2)
+  /* 4サンプル単位でMS -> LR処理 */
+  {
+    const __m128i one = _mm_set1_epi32(1);
+    for (; smpl + 4 <= num_samples; smpl += 4) {
+      __m128i vside = _mm_loadu_si128((const __m128i *)&data[1][smpl]);
+      __m128i vmid  = _mm_loadu_si128((const __m128i *)&data[0][smpl]);
+      vmid = _mm_or_si128(_mm_slli_epi32(vmid, 1), _mm_and_si128(vside, one));
+      _mm_storeu_si128((__m128i *)&data[0][smpl], _mm_srai_epi32(_mm_add_epi32(vmid, vside), 1));
+      _mm_storeu_si128((__m128i *)&data[1][smpl], _mm_srai_epi32(_mm_sub_epi32(vmid, vside), 1));
+    }
+  }
+#endif
+
   /* サンプル単位でMS -> LR処理 */
-  for (smpl = 0; smpl < num_samples; smpl++) {
+  for (; smpl < num_samples; smpl++) {
     side  = data[1][smpl];
-    mid   = (data[0][smpl] << 1) | (side & 1);
+    mid   = (int32_t)(((uint32_t)data[0][smpl] << 1) | (uint32_t)(side & 1));
     data[0][smpl] = (int32_t)ALAUTILITY_SHIFT_RIGHT_ARITHMETIC(mid + side, 1);
     data[1][smpl] = (int32_t)ALAUTILITY_SHIFT_RIGHT_ARITHMETIC(mid - side, 1);
   }
 
   return ALAPREDICTOR_APIRESULT_OK;
 }
+
+/* LR -> LS/RS（int32_t）: base_chのチャンネルを残し、もう一方をサイドに置き換える */
+/* サイドは常に1チャンネル目に置く */
+static void ALAChannelDecorrelator_LRtoXSInt32(int32_t **data, uint32_t num_samples, uint32_t base_ch)
+{
+  uint32_t  smpl;
+  int32_t   base, side;
+
+  assert(data != NULL);
+  assert(base_ch <= 1);
+
+  smpl = 0;
+#if defined(ALAPREDICTOR_USE_SSE2)
+  for (; smpl + 4 <= num_samples; smpl += 4) {
+    __m128i left  = _mm_loadu_si128((const __m128i *)&data[0][smpl]);
+    __m128i right = _mm_loadu_si128((const __m128i *)&data[1][smpl]);
+    _mm_storeu_si128((__m128i *)&data[0][smpl], (base_ch == 0) ? left : right);
+    _mm_storeu_si128((__m128i *)&data[1][smpl], _mm_sub_epi32(left, right));
+  }
+#endif
+
+  for (; smpl < num_samples; smpl++) {
+    base  = data[base_ch][smpl];
+    side  = data[0][smpl] - data[1][smpl];
+    data[0][smpl] = base;
+    data[1][smpl] = side;
+  }
+}
+
+/* LS/RS -> LR（int32_t） */
+static void ALAChannelDecorrelator_XStoLRInt32(int32_t **data, uint32_t num_samples, uint32_t base_ch)
+{
+  uint32_t  smpl;
+  int32_t   base, side;
+
+  assert(data != NULL);
+  assert(base_ch <= 1);
+
+  smpl = 0;
+#if defined(ALAPREDICTOR_USE_SSE2)
+  for (; smpl + 4 <= num_samples; smpl += 4) {
+    __m128i vbase = _mm_loadu_si128((const __m128i *)&data[0][smpl]);
+    __m128i vside = _mm_loadu_si128((const __m128i *)&data[1][smpl]);
+    if (base_ch == 0) {
+      /* L = L, R = L - S */
+      _mm_storeu_si128((__m128i *)&data[1][smpl], _mm_sub_epi32(vbase, vside));
+    } else {
+      /* L = R + S, R = R */
+      _mm_storeu_si128((__m128i *)&data[0][smpl], _mm_add_epi32(vbase, vside));
+      _mm_storeu_si128((__m128i *)&data[1][smpl], vbase);
+    }
+  }
+#endif
+
+  for (; smpl < num_samples; smpl++) {
+    base  = data[0][smpl];
+    side  = data[1][smpl];
+    if (base_ch == 0) {
+      data[1][smpl] = base - side;
+    } else {
+      data[0][smpl] = base + side;
+      data[1][smpl] = base;
+    }
+  }
+}
+
+/* 1階差分の絶対値和（残差エネルギーの簡易推定値）をL,R,M,Sそれぞれについて計算 */
+static void ALAChannelDecorrelator_CalculateDiffAbsSum(
+    const int32_t* left, const int32_t* right, uint32_t num_samples, uint64_t* sum)
+{
+  uint32_t  smpl, i;
+  int32_t   prev[4], cur[4], diff;
+
+  assert((left != NULL) && (right != NULL) && (sum != NULL));
+
+  for (i = 0; i < 4; i++) {
+    sum[i] = 0;
+  }
+
+  if (num_samples < 2) {
+    return;
+  }
+
+  smpl = 1;
+#if defined(ALAPREDICTOR_USE_SSE2)
+  {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i acc[4];
+    uint64_t acc_buf[2];
+    for (i = 0; i < 4; i++) {
+      acc[i] = _mm_setzero_si128();
+    }
+    for (; smpl + 4 <= num_samples; smpl += 4) {
+      __m128i vx[4], vprev[4];
+      vx[0] = _mm_loadu_si128((const __m128i *)&left[smpl]);
+      vx[1] = _mm_loadu_si128((const __m128i *)&right[smpl]);
+      vx[2] = _mm_srai_epi32(_mm_add_epi32(vx[0], vx[1]), 1);
+      vx[3] = _mm_sub_epi32(vx[0], vx[1]);
+      vprev[0] = _mm_loadu_si128((const __m128i *)&left[smpl - 1]);
+      vprev[1] = _mm_loadu_si128((const __m128i *)&right[smpl - 1]);
+      vprev[2] = _mm_srai_epi32(_mm_add_epi32(vprev[0], vprev[1]), 1);
+      vprev[3] = _mm_sub_epi32(vprev[0], vprev[1]);
+      for (i = 0; i < 4; i++) {
+        /* 差分の絶対値を64bitに拡張して積算 */
+        __m128i vdiff = _mm_sub_epi32(vx[i], vprev[i]);
+        __m128i vsign = _mm_srai_epi32(vdiff, 31);
+        vdiff = _mm_sub_epi32(_mm_xor_si128(vdiff, vsign), vsign);
+        acc[i] = _mm_add_epi64(acc[i], _mm_unpacklo_epi32(vdiff, zero));
+        acc[i] = _mm_add_epi64(acc[i], _mm_unpackhi_epi32(vdiff, zero));
+      }
+    }
+    for (i = 0; i < 4; i++) {
+      _mm_storeu_si128((__m128i *)acc_buf, acc[i]);
+      sum[i] = acc_buf[0] + acc_buf[1];
+    }
+  }
+#endif
+
+  for (; smpl < num_samples; smpl++) {
+    cur[0]  = left[smpl];
+    cur[1]  = right[smpl];
+    cur[2]  = (int32_t)ALAUTILITY_SHIFT_RIGHT_ARITHMETIC(cur[0] + cur[1], 1);
+    cur[3]  = cur[0] - cur[1];
+    prev[0] = left[smpl - 1];
+    prev[1] = right[smpl - 1];
+    prev[2] = (int32_t)ALAUTILITY_SHIFT_RIGHT_ARITHMETIC(prev[0] + prev[1], 1);
+    prev[3] = prev[0] - prev[1];
+    for (i = 0; i < 4; i++) {
+      diff = cur[i] - prev[i];
+      sum[i] += (uint64_t)((diff < 0) ? -diff : diff);
+    }
+  }
+}
+
+/* 残差エネルギーの推定値が最小となるチャンネル処理法の選択（int32_t） */
+ALAPredictorApiResult ALAChannelDecorrelator_SelectMethodInt32(
+    const int32_t* const* data, uint32_t num_channels, uint32_t num_samples,
+    ALAChannelProcessMethod* method)
+{
+  uint32_t  i;
+  uint64_t  sum[4], cost[ALA_CHANNEL_PROCESS_METHOD_NUM], min_cost;
+
+  /* 引数チェック */
+  if ((data == NULL) || (method == NULL)) {
+    return ALAPREDICTOR_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* モノラルは処理なし */
+  if (num_channels < 2) {
+    (*method) = ALA_CHANNEL_PROCESS_METHOD_LR;
+    return ALAPREDICTOR_APIRESULT_OK;
+  }
+
+  /* L, R, M, Sの推定エネルギー */
+  ALAChannelDecorrelator_CalculateDiffAbsSum(data[0], data[1], num_samples, sum);
+
+  /* 各処理法のコスト */
+  cost[ALA_CHANNEL_PROCESS_METHOD_LR] = sum[0] + sum[1];
+  cost[ALA_CHANNEL_PROCESS_METHOD_MS] = sum[2] + sum[3];
+  cost[ALA_CHANNEL_PROCESS_METHOD_LS] = sum[0] + sum[3];
+  cost[ALA_CHANNEL_PROCESS_METHOD_RS] = sum[1] + sum[3];
+
+  /* 最小コストの処理法を選択（同じコストならば番号の小さい方） */
+  (*method) = ALA_CHANNEL_PROCESS_METHOD_LR;
+  min_cost  = cost[ALA_CHANNEL_PROCESS_METHOD_LR];
+  for (i = 1; i < ALA_CHANNEL_PROCESS_METHOD_NUM; i++) {
+    if (cost[i] < min_cost) {
+      min_cost  = cost[i];
+      (*method) = (ALAChannelProcessMethod)i;
+    }
+  }
+
+  return ALAPREDICTOR_APIRESULT_OK;
+}
+
+/* チャンネル処理の適用（int32_t, in-place） */
+ALAPredictorApiResult ALAChannelDecorrelator_DecorrelateInt32(
+    int32_t **data, uint32_t num_channels, uint32_t num_samples,
+    ALAChannelProcessMethod method)
+{
+  /* 引数チェック */
+  if (data == NULL) {
+    return ALAPREDICTOR_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* 処理なし */
+  if (method == ALA_CHANNEL_PROCESS_METHOD_LR) {
+    return ALAPREDICTOR_APIRESULT_OK;
+  }
+
+  /* 2チャンネル以上必要 */
+  if ((num_channels < 2) || (data[0] == NULL) || (data[1] == NULL)) {
+    return ALAPREDICTOR_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  switch (method) {
+    case ALA_CHANNEL_PROCESS_METHOD_MS:
+      return ALAChannelDecorrelator_LRtoMSInt32(data, num_channels, num_samples);
+    case ALA_CHANNEL_PROCESS_METHOD_LS:
+      ALAChannelDecorrelator_LRtoXSInt32(data, num_samples, 0);
+      break;
+    case ALA_CHANNEL_PROCESS_METHOD_RS:
+      ALAChannelDecorrelator_LRtoXSInt32(data, num_samples, 1);
+      break;
+    default:
+      return ALAPREDICTOR_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  return ALAPREDICTOR_APIRESULT_OK;
+}
+
+/* チャンネル処理を元に戻す（int32_t, in-place） */
+ALAPredictorApiResult ALAChannelDecorrelator_ReconstructInt32(
+    int32_t **data, uint32_t num_channels, uint32_t num_samples,
+    ALAChannelProcessMethod method)
+{
+  /* 引数チェック */
+  if (data == NULL) {
+    return ALAPREDICTOR_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* 処理なし */
+  if (method == ALA_CHANNEL_PROCESS_METHOD_LR) {
+    return ALAPREDICTOR_APIRESULT_OK;
+  }
+
+  /* 2チャンネル以上必要 */
+  if ((num_channels < 2) || (data[0] == NULL) || (data[1] == NULL)) {
+    return ALAPREDICTOR_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  switch (method) {
+    case ALA_CHANNEL_PROCESS_METHOD_MS:
+      return ALAChannelDecorrelator_MStoLRInt32(data, num_channels, num_samples);
+    case ALA_CHANNEL_PROCESS_METHOD_LS:
+      ALAChannelDecorrelator_XStoLRInt32(data, num_samples, 0);
+      break;
+    case ALA_CHANNEL_PROCESS_METHOD_RS:
+      ALAChannelDecorrelator_XStoLRInt32(data, num_samples, 1);
+      break;
+    default:
+      return ALAPREDICTOR_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  return ALAPREDICTOR_APIRESULT_OK;
+}
+
+/* 参照チャンネルからの予測値 */
+#define ALACHANNELDECORRELATOR_PREDICT_FROM_REFERENCE(gain, ref, gain_shift) \
+  ((int32_t)ALAUTILITY_SHIFT_RIGHT_ARITHMETIC((gain) * (ref) + (1 << ((gain_shift) - 1)), (gain_shift)))
+
+/* 参照チャンネル予測の誤差の2階差分の絶対値和 */
+/* 2階差分はLPCの残差に近く、低域の相関だけで参照先を選んでしまうことを避けられる */
+static uint64_t ALAChannelDecorrelator_CalculateReferenceCost(
+    const int32_t* target, const int32_t* ref, uint32_t num_samples, int32_t gain, uint32_t gain_shift)
+{
+  uint32_t  smpl;
+  int32_t   prev1, prev2, cur, diff;
+  uint64_t  sum;
+
+  assert((target != NULL) && ((ref != NULL) || (gain == 0)));
+
+  if (num_samples < 3) {
+    return 0;
+  }
+
+  sum   = 0;
+  prev2 = prev1 = 0;
+  for (smpl = 0; smpl < num_samples; smpl++) {
+    cur = (gain == 0) ? target[smpl]
+      : (target[smpl] - ALACHANNELDECORRELATOR_PREDICT_FROM_REFERENCE(gain, ref[smpl], gain_shift));
+    if (smpl >= 2) {
+      diff  = cur - 2 * prev1 + prev2;
+      sum  += (uint64_t)((diff < 0) ? -diff : diff);
+    }
+    prev2 = prev1;
+    prev1 = cur;
+  }
+
+  return sum;
+}
+
+/* 参照チャンネルに対する最小二乗ゲインの計算（2階差分で計算し、固定小数に量子化） */
+static int32_t ALAChannelDecorrelator_CalculateReferenceGain(
+    const int32_t* target, const int32_t* ref, uint32_t num_samples, uint32_t gain_shift)
+{
+  uint32_t  smpl;
+  double    cross, power, dtarget, dref, gain;
+  const double max_gain = (double)ALA_CHANNEL_REFERENCE_MAX_GAIN(gain_shift);
+
+  assert((target != NULL) && (ref != NULL));
+
+  cross = power = 0.0f;
+  for (smpl = 2; smpl < num_samples; smpl++) {
+    dtarget = (double)target[smpl] - 2.0f * (double)target[smpl - 1] + (double)target[smpl - 2];
+    dref    = (double)ref[smpl] - 2.0f * (double)ref[smpl - 1] + (double)ref[smpl - 2];
+    cross  += dtarget * dref;
+    power  += dref * dref;
+  }
+
+  /* 参照チャンネルが無音 */
+  if (power <= 0.0f) {
+    return 0;
+  }
+
+  gain = ALAUtility_Round(cross / power * (double)(1 << gain_shift));
+  gain = ALAUTILITY_INNER_VALUE(gain, -max_gain, max_gain);
+
+  return (int32_t)gain;
+}
+
+/* 参照チャンネル予測のパラメータ選択（int32_t） */
+ALAPredictorApiResult ALAChannelDecorrelator_SelectReferenceInt32(
+    const int32_t* const* data, uint32_t num_channels, uint32_t num_samples,
+    uint32_t max_reference_offset, uint32_t gain_shift,
+    uint32_t* reference_offset, int32_t* reference_gain)
+{
+  uint32_t  ch, offset, best_offset;
+  int32_t   gain, best_gain;
+  uint64_t  cost, best_cost;
+
+  /* 引数チェック */
+  if ((data == NULL) || (reference_offset == NULL) || (reference_gain == NULL)
+      || (gain_shift == 0) || (gain_shift > ALA_CHANNEL_REFERENCE_MAX_GAIN_SHIFT)) {
+    return ALAPREDICTOR_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  for (ch = 0; ch < num_channels; ch++) {
+    reference_offset[ch] = 0;
+    reference_gain[ch]   = 0;
+  }
+
+  /* 先頭2チャンネルはステレオ処理の対象 */
+  for (ch = ALA_CHANNEL_REFERENCE_BEGIN_CHANNEL; ch < num_channels; ch++) {
+    /* 予測なしのコスト */
+    best_offset = 0;
+    best_gain   = 0;
+    best_cost   = ALAChannelDecorrelator_CalculateReferenceCost(data[ch], NULL, num_samples, 0, gain_shift);
+    /* 直前max_reference_offsetチャンネルの中から探す（チャンネル数に対して線形の計算量） */
+    for (offset = 1; (offset <= max_reference_offset) && (offset <= ch); offset++) {
+      gain = ALAChannelDecorrelator_CalculateReferenceGain(
+          data[ch], data[ch - offset], num_samples, gain_shift);
+      if (gain == 0) {
+        continue;
+      }
+      cost = ALAChannelDecorrelator_CalculateReferenceCost(
+          data[ch], data[ch - offset], num_samples, gain, gain_shift);
+      if (cost < best_cost) {
+        best_cost   = cost;
+        best_offset = offset;
+        best_gain   = gain;
+      }
+    }
+    reference_offset[ch] = best_offset;
+    reference_gain[ch]   = best_gain;
+  }
+
+  return ALAPREDICTOR_APIRESULT_OK;
+}
+
+/* 参照チャンネル予測の適用（int32_t, in-place） */
+ALAPredictorApiResult ALAChannelDecorrelator_PredictFromReferenceInt32(
+    int32_t **data, uint32_t num_channels, uint32_t num_samples, uint32_t gain_shift,
+    const uint32_t* reference_offset, const int32_t* reference_gain)
+{
+  uint32_t  ch, smpl;
+  int32_t   gain;
+  const int32_t* ref;
+
+  /* 引数チェック */
+  if ((data == NULL) || (reference_offset == NULL) || (reference_gain == NULL)
+      || (gain_shift == 0) || (gain_shift > ALA_CHANNEL_REFERENCE_MAX_GAIN_SHIFT)) {
+    return ALAPREDICTOR_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* 参照先（若い番号のチャンネル）を壊さないよう後ろのチャンネルから処理 */
+  for (ch = num_channels; ch-- > 0; ) {
+    if (reference_offset[ch] == 0) {
+      continue;
+    }
+    if (reference_offset[ch] > ch) {
+      return ALAPREDICTOR_APIRESULT_INVALID_ARGUMENT;
+    }
+    ref   = data[ch - reference_offset[ch]];
+    gain  = reference_gain[ch];
+    for (smpl = 0; smpl < num_samples; smpl++) {
+      data[ch][smpl] -= ALACHANNELDECORRELATOR_PREDICT_FROM_REFERENCE(gain, ref[smpl], gain_shift);
+    }
+  }
+
+  return ALAPREDICTOR_APIRESULT_OK;
+}
+
+/* 参照チャンネル予測を元に戻す（int32_t, in-place） */
+ALAPredictorApiResult ALAChannelDecorrelator_ReconstructFromReferenceInt32(
+    int32_t **data, uint32_t num_channels, uint32_t num_samples, uint32_t gain_shift,
+    const uint32_t* reference_offset, const int32_t* reference_gain)
+{
+  uint32_t  ch, smpl;
+  int32_t   gain;
+  const int32_t* ref;
+
+  /* 引数チェック */
+  if ((data == NULL) || (reference_offset == NULL) || (reference_gain == NULL)
+      || (gain_shift == 0) || (gain_shift > ALA_CHANNEL_REFERENCE_MAX_GAIN_SHIFT)) {
+    return ALAPREDICTOR_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* 参照先が復元済みとなるよう前のチャンネルから処理 */
+  for (ch = 0; ch < num_channels; ch++) {
+    if (reference_offset[ch] == 0) {
+      continue;
+    }
+    if (reference_offset[ch] > ch) {
+      return ALAPREDICTOR_APIRESULT_INVALID_ARGUMENT;
+    }
+    ref   = data[ch - reference_offset[ch]];
+    gain  = reference_gain[ch];
+    for (smpl = 0; smpl < num_samples; smpl++) {
+      data[ch][smpl] += ALACHANNELDECORRELATOR_PREDICT_FROM_REFERENCE(gain, ref[smpl], gain_shift);
+    }
+  }
+
+  return ALAPREDICTOR_APIRESULT_OK;
+}
@@ -9,9 +9,25 @@ struct ALALPCCalculator;
 /* LPC音声合成ハンドル */
 struct ALALPCSynthesizer;
 
+/* 長期予測パラメータ計算ハンドル */
+struct ALALTPCalculator;
+
+/* 適応フィルタハンドル（符号LMS） */
+struct ALALMSFilter;
+
 /* エンファシスフィルタハンドル */
 struct ALAEmphasisFilter;
 
+/* 長期予測のタップ数（ラグの前後1サンプルを含む） */
+#define ALA_LTP_NUM_TAPS    3
+/* 長期予測係数の小数部ビット数 */
+#define ALA_LTP_COEF_SHIFT  6
+
+/* 適応フィルタの係数の小数部ビット数の最大値 */
+#define ALA_LMS_MAX_SHIFT   15
+/* 適応フィルタの係数更新幅 */
+#define ALA_LMS_STEP_SIZE   2
+
 /* API結果型 */
 typedef enum ALAPredictorApiResultTag {
   ALAPREDICTOR_APIRESULT_OK,                     /* OK */
@@ -21,6 +37,22 @@ typedef enum ALAPredictorApiResultTag {
   ALAPREDICTOR_APIRESULT_FAILED_TO_CALCULATION   /* 計算に失敗 */
 } ALAPredictorApiResult;
 
+/* 参照チャンネル予測を行う先頭チャンネル（それより前はステレオ処理の対象） */
+#define ALA_CHANNEL_REFERENCE_BEGIN_CHANNEL   2
+/* 参照チャンネル予測ゲインの小数部ビット数の最大値 */
+#define ALA_CHANNEL_REFERENCE_MAX_GAIN_SHIFT  8
+/* 参照チャンネル予測ゲインの絶対値の最大値（2.0） */
+#define ALA_CHANNEL_REFERENCE_MAX_GAIN(gain_shift) (2 << (gain_shift))
+
+/* チャンネル処理法（ブロックヘッダに記録する値） */
+typedef enum ALAChannelProcessMethodTag {
+  ALA_CHANNEL_PROCESS_METHOD_LR = 0,  /* 処理なし */
+  ALA_CHANNEL_PROCESS_METHOD_MS,      /* ミッド/サイド */
+  ALA_CHANNEL_PROCESS_METHOD_LS,      /* 左/サイド */
+  ALA_CHANNEL_PROCESS_METHOD_RS,      /* 右/サイド */
+  ALA_CHANNEL_PROCESS_METHOD_NUM      /* 処理法の数 */
+} ALAChannelProcessMethod;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -38,12 +70,27 @@ ALAPredictorApiResult ALALPCCalculator_CalculatePARCORCoefDouble(
     const double* data, uint32_t num_samples,
     double* parcor_coef, uint32_t order);
 
+/* PARCOR係数の量子化 */
+/* 逆正弦で圧伸してから次数毎の精度で量子化し、量子化インデックスを出力する */
+/* parcor_coef, indexはorder+1個の配列（0次は使わない） */
+ALAPredictorApiResult ALAPARCORQuantizer_Quantize(
+    const double* parcor_coef, uint32_t order, int32_t* index);
+
+/* 量子化インデックスからPARCOR係数（2^15を1.0とする固定小数）を復元 */
+/* index, parcor_coef_int32はorder+1個の配列（0次は使わない） */
+/* インデックスがその次数の範囲外ならばALAPREDICTOR_APIRESULT_INVALID_ARGUMENTを返す */
+ALAPredictorApiResult ALAPARCORQuantizer_Dequantize(
+    const int32_t* index, uint32_t order, int32_t* parcor_coef_int32);
+
 /* LPC音声合成ハンドルの作成 */
 struct ALALPCSynthesizer* ALALPCSynthesizer_Create(uint32_t max_order);
 
 /* LPC音声合成ハンドルの破棄 */
 void ALALPCSynthesizer_Destroy(struct ALALPCSynthesizer* lpc);
 
+/* LPC音声合成ハンドルの内部状態リセット */
+ALAPredictorApiResult ALALPCSynthesizer_Reset(struct ALALPCSynthesizer* lpc);
+
 /* PARCOR係数により予測/誤差出力（32bit整数入出力） */
 /* 係数parcor_coefはorder+1個の配列 */
 ALAPredictorApiResult ALALPCSynthesizer_PredictByParcorCoefInt32(
@@ -52,6 +99,15 @@ ALAPredictorApiResult ALALPCSynthesizer_PredictByParcorCoefInt32(
     const int32_t* parcor_coef, uint32_t order,
     int32_t* residual);
 
+/* プリエンファシスし、続けてPARCOR係数により予測/誤差出力（32bit整数入出力） */
+/* 1サンプル毎にプリエンファシスと予測を続けて行い、ALAEmphasisFilter_PreEmphasisInt32を先にかけた結果と一致する
+ * code_sumには残差を符号なし整数に変換した値（ALAUTILITY_SINT32_TO_UINT32）の和を返す（NULLなら返さない） */
+ALAPredictorApiResult ALALPCSynthesizer_PreEmphasizeAndPredictInt32(
+    struct ALALPCSynthesizer* lpcs,
+    const int32_t* data, uint32_t num_samples,
+    const int32_t* parcor_coef, uint32_t order, int32_t emphasis_shift,
+    int32_t* residual, uint64_t* code_sum);
+
 /* PARCOR係数により誤差信号から音声合成（32bit整数入出力） */
 /* 係数parcor_coefはorder+1個の配列 */
 ALAPredictorApiResult ALALPCSynthesizer_SynthesizeByParcorCoefInt32(
@@ -60,6 +116,61 @@ ALAPredictorApiResult ALALPCSynthesizer_SynthesizeByParcorCoefInt32(
     const int32_t* parcor_coef, uint32_t order,
     int32_t* output);
 
+/* PARCOR係数により誤差信号から音声合成し、続けてデエンファシス（32bit整数入出力） */
+/* 1サンプル毎に合成とデエンファシスを続けて行い、ALAEmphasisFilter_DeEmphasisInt32を後からかけた結果と一致する */
+/* デエンファシスの状態も呼び出しをまたいで引き継ぐため、ブロックを分割して呼び出してよい */
+ALAPredictorApiResult ALALPCSynthesizer_SynthesizeAndDeEmphasizeInt32(
+    struct ALALPCSynthesizer* lpcs,
+    const int32_t* residual, uint32_t num_samples,
+    const int32_t* parcor_coef, uint32_t order, int32_t emphasis_shift,
+    int32_t* output);
+
+/* 適応フィルタハンドルの作成 */
+struct ALALMSFilter* ALALMSFilter_Create(uint32_t max_num_taps);
+
+/* 適応フィルタハンドルの破棄 */
+void ALALMSFilter_Destroy(struct ALALMSFilter* lms);
+
+/* 適応フィルタのパラメータ設定と内部状態リセット */
+/* 係数は2^shiftを1.0とする固定小数 */
+ALAPredictorApiResult ALALMSFilter_Reset(struct ALALMSFilter* lms, uint32_t num_taps, uint32_t shift);
+
+/* 適応フィルタにより予測/誤差出力（32bit整数入出力, in-place可） */
+/* 係数は誤差と入力の符号のみで更新する（符号LMS）
+ * code_sumには残差を符号なし整数に変換した値の和を返す（NULLなら返さない） */
+ALAPredictorApiResult ALALMSFilter_PredictInt32(
+    struct ALALMSFilter* lms, const int32_t* data, uint32_t num_samples,
+    int32_t* residual, uint64_t* code_sum);
+
+/* 適応フィルタにより誤差信号から合成（32bit整数入出力, in-place可） */
+ALAPredictorApiResult ALALMSFilter_SynthesizeInt32(
+    struct ALALMSFilter* lms, const int32_t* residual, uint32_t num_samples, int32_t* output);
+
+/* 長期予測パラメータ計算ハンドルの作成 */
+struct ALALTPCalculator* ALALTPCalculator_Create(uint32_t max_num_samples);
+
+/* 長期予測パラメータ計算ハンドルの破棄 */
+void ALALTPCalculator_Destroy(struct ALALTPCalculator* ltpc);
+
+/* 長期予測パラメータの計算 */
+/* [min_lag, max_lag]の範囲で正規化相互相関が最大のラグを探し（2:1間引き信号で粗探索してから近傍を詳細探索）、
+ * ラグ近傍ALA_LTP_NUM_TAPS個のタップ係数を最小二乗法で求める
+ * 予測誤差が十分に小さくならなければlagに0を返す */
+ALAPredictorApiResult ALALTPCalculator_CalculateCoef(
+    struct ALALTPCalculator* ltpc, const int32_t* data, uint32_t num_samples,
+    uint32_t min_lag, uint32_t max_lag, uint32_t* lag, int32_t* coef);
+
+/* 長期予測により予測/誤差出力（32bit整数入出力, in-place可） */
+/* 係数coefはALA_LTP_NUM_TAPS個の配列で、2^ALA_LTP_COEF_SHIFTを1.0とする固定小数
+ * code_sumには残差を符号なし整数に変換した値の和を返す（NULLなら返さない） */
+ALAPredictorApiResult ALALongTermPredictor_PredictInt32(
+    const int32_t* data, uint32_t num_samples, uint32_t lag, const int32_t* coef,
+    int32_t* residual, uint64_t* code_sum);
+
+/* 長期予測により誤差信号から合成（32bit整数入出力, in-place可） */
+ALAPredictorApiResult ALALongTermPredictor_SynthesizeInt32(
+    const int32_t* residual, uint32_t num_samples, uint32_t lag, const int32_t* coef, int32_t* output);
+
 /* プリエンファシス(int32, in-place) */
 ALAPredictorApiResult ALAEmphasisFilter_PreEmphasisInt32(
     int32_t* data, uint32_t num_samples, int32_t coef_shift);
@@ -84,6 +195,42 @@ ALAPredictorApiResult ALAChannelDecorrelator_LRtoMSInt32(
 ALAPredictorApiResult ALAChannelDecorrelator_MStoLRInt32(
     int32_t **data, uint32_t num_channels, uint32_t num_samples);
 
+/* 残差エネルギーの推定値が最小となるチャンネル処理法の選択（int32_t） */
+/* 推定値には先頭2チャンネルの1階差分の絶対値和を使う */
+ALAPredictorApiResult ALAChannelDecorrelator_SelectMethodInt32(
+    const int32_t* const* data, uint32_t num_channels, uint32_t num_samples,
+    ALAChannelProcessMethod* method);
+
+/* チャンネル処理の適用（int32_t, in-place） */
+/* 先頭2チャンネルを処理し、サイドは常に2チャンネル目に置く */
+ALAPredictorApiResult ALAChannelDecorrelator_DecorrelateInt32(
+    int32_t **data, uint32_t num_channels, uint32_t num_samples,
+    ALAChannelProcessMethod method);
+
+/* チャンネル処理を元に戻す（int32_t, in-place） */
+ALAPredictorApiResult ALAChannelDecorrelator_ReconstructInt32(
+    int32_t **data, uint32_t num_channels, uint32_t num_samples,
+    ALAChannelProcessMethod method);
+
+/* 参照チャンネル予測のパラメータ選択（int32_t） */
+/* ALA_CHANNEL_REFERENCE_BEGIN_CHANNEL以降の各チャンネルについて、直前max_reference_offsetチャンネルの中から
+ * 予測誤差の2階差分の絶対値和が最小となる参照先とゲインを選ぶ（参照しないときはオフセット0） */
+ALAPredictorApiResult ALAChannelDecorrelator_SelectReferenceInt32(
+    const int32_t* const* data, uint32_t num_channels, uint32_t num_samples,
+    uint32_t max_reference_offset, uint32_t gain_shift,
+    uint32_t* reference_offset, int32_t* reference_gain);
+
+/* 参照チャンネル予測の適用（int32_t, in-place） */
+/* ch番目のチャンネルからch-reference_offset[ch]番目のチャンネルのreference_gain[ch]/2^gain_shift倍を引く */
+ALAPredictorApiResult ALAChannelDecorrelator_PredictFromReferenceInt32(
+    int32_t **data, uint32_t num_channels, uint32_t num_samples, uint32_t gain_shift,
+    const uint32_t* reference_offset, const int32_t* reference_gain);
+
+/* 参照チャンネル予測を元に戻す（int32_t, in-place） */
+ALAPredictorApiResult ALAChannelDecorrelator_ReconstructFromReferenceInt32(
+    int32_t **data, uint32_t num_channels, uint32_t num_samples, uint32_t gain_shift,
+    const uint32_t* reference_offset, const int32_t* reference_gain);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,261 @@
+#include "ala_push_decoder.h"
+#include "bit_stream.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+/* ブロックのサンプルあたりの最大バイト数（残差復号の作業領域と同じ上限） */
+#define ALAPUSHDECODER_MAX_BYTES_PER_SAMPLE         8
+/* チャンネル毎のブロックヘッダとサブストリームのヘッダ（係数やrANSの表）の最大バイト数の見積もり */
+#define ALAPUSHDECODER_MAX_CHANNEL_OVERHEAD_BYTES   1024
+
+/* 受信バッファの初期バイト数 */
+#define ALAPUSHDECODER_INITIAL_BUFFER_SIZE          4096
+
+/* プッシュ型デコーダハンドル */
+/* 溜めたバイト列の先頭から読み直し、足りなければ何も消費せずに次の試行に必要なバイト数を覚えておく */
+struct ALAPushDecoder {
+  struct ALADecoder*    decoder;          /* デコーダハンドル */
+  struct ALAHeaderInfo  header;           /* ヘッダ情報 */
+  uint8_t               has_header;       /* ヘッダを読んだか？ */
+  uint8_t               end_of_stream;    /* ストリーム終端に達したか？ */
+  uint8_t*              buffer;           /* デコードし終えていないバイト列 */
+  uint32_t              buffer_size;      /* バッファのバイト数 */
+  uint32_t              num_buffered;     /* バッファに溜まっているバイト数 */
+  uint64_t              num_required;     /* 次の試行に最低限必要なバイト数 */
+  uint64_t              max_num_required; /* 1ブロックに必要なバイト数の上限（超えれば不正なデータとする） */
+  void*                 stream_work;      /* ビットストリームのワーク領域 */
+};
+
+/* プッシュ型デコーダハンドルの作成 */
+struct ALAPushDecoder* ALAPushDecoder_Create(const struct ALADecoderConfig* config)
+{
+  struct ALAPushDecoder* decoder;
+
+  /* 引数チェック */
+  if (config == NULL) {
+    return NULL;
+  }
+
+  decoder = (struct ALAPushDecoder *)malloc(sizeof(struct ALAPushDecoder));
+  decoder->decoder          = ALADecoder_Create(config);
+  decoder->has_header       = 0;
+  decoder->end_of_stream    = 0;
+  decoder->buffer_size      = ALAPUSHDECODER_INITIAL_BUFFER_SIZE;
+  decoder->buffer           = (uint8_t *)malloc(decoder->buffer_size);
+  decoder->num_buffered     = 0;
+  decoder->num_required     = 0;
+  decoder->max_num_required = (uint64_t)config->max_num_channels
+    * ((uint64_t)config->max_num_samples_per_block * ALAPUSHDECODER_MAX_BYTES_PER_SAMPLE
+        + ALAPUSHDECODER_MAX_CHANNEL_OVERHEAD_BYTES) + ALAPUSHDECODER_MAX_CHANNEL_OVERHEAD_BYTES;
+  decoder->stream_work      = malloc((size_t)BitStream_CalculateWorkSize());
+
+  return decoder;
+}
+
+/* プッシュ型デコーダハンドルの破棄 */
+void ALAPushDecoder_Destroy(struct ALAPushDecoder* decoder)
+{
+  if (decoder != NULL) {
+    ALADecoder_Destroy(decoder->decoder);
+    free(decoder->buffer);
+    free(decoder->stream_work);
+    free(decoder);
+  }
+}
+
+/* 受信したバイト列の追加 */
+ALAPushDecoderApiResult ALAPushDecoder_Push(
+    struct ALAPushDecoder* decoder, const uint8_t* data, uint32_t size)
+{
+  /* 引数チェック */
+  if ((decoder == NULL) || ((data == NULL) && (size > 0))) {
+    return ALAPUSHDECODER_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* 溜められるバイト数を超える */
+  if (size > (UINT32_MAX - decoder->num_buffered)) {
+    return ALAPUSHDECODER_APIRESULT_EXCEED_HANDLE_CAPACITY;
+  }
+
+  /* 足りなければバッファを倍々に拡張 */
+  if ((decoder->num_buffered + size) > decoder->buffer_size) {
+    uint32_t new_size = decoder->buffer_size;
+    uint8_t* new_buffer;
+    while (new_size < (decoder->num_buffered + size)) {
+      new_size = (new_size <= (UINT32_MAX / 2)) ? (2 * new_size) : UINT32_MAX;
+    }
+    if ((new_buffer = (uint8_t *)realloc(decoder->buffer, new_size)) == NULL) {
+      return ALAPUSHDECODER_APIRESULT_NG;
+    }
+    decoder->buffer       = new_buffer;
+    decoder->buffer_size  = new_size;
+  }
+
+  /* 末尾に追加 */
+  if (size > 0) {
+    memcpy(&decoder->buffer[decoder->num_buffered], data, size);
+    decoder->num_buffered += size;
+  }
+
+  return ALAPUSHDECODER_APIRESULT_OK;
+}
+
+/* デコーダのAPI結果をプッシュ型デコーダのAPI結果に変換 */
+static ALAPushDecoderApiResult ALAPushDecoder_ConvertApiResult(ALADecoderApiResult ret)
+{
+  switch (ret) {
+    case ALADECODER_APIRESULT_OK:                     return ALAPUSHDECODER_APIRESULT_OK;
+    case ALADECODER_APIRESULT_INVALID_ARGUMENT:       return ALAPUSHDECODER_APIRESULT_INVALID_ARGUMENT;
+    case ALADECODER_APIRESULT_INVALID_FORMAT:         return ALAPUSHDECODER_APIRESULT_INVALID_FORMAT;
+    case ALADECODER_APIRESULT_EXCEED_HANDLE_CAPACITY: return ALAPUSHDECODER_APIRESULT_EXCEED_HANDLE_CAPACITY;
+    case ALADECODER_APIRESULT_DETECT_DATA_CORRUPTION: return ALAPUSHDECODER_APIRESULT_DETECT_DATA_CORRUPTION;
+    case ALADECODER_APIRESULT_END_OF_STREAM:          return ALAPUSHDECODER_APIRESULT_END_OF_STREAM;
+    default:                                          return ALAPUSHDECODER_APIRESULT_NG;
+  }
+}
+
+/* 溜めたバイト列の先頭からの読み込みの開始 前回の試行から足りないままならばNULLを返す */
+static struct BitStream* ALAPushDecoder_BeginRead(struct ALAPushDecoder* decoder)
+{
+  assert(decoder != NULL);
+
+  if (decoder->num_buffered < decoder->num_required) {
+    return NULL;
+  }
+
+  return BitStream_OpenMemory(decoder->buffer, decoder->num_buffered,
+      decoder->stream_work, BitStream_CalculateWorkSize());
+}
+
+/* 読み込みの終了 */
+/* データが足りなかった場合は何も消費せずにALAPUSHDECODER_APIRESULT_NEED_MORE_DATAを返す
+ * 足りていた場合は読んだ分をバッファから捨てる */
+static ALAPushDecoderApiResult ALAPushDecoder_EndRead(
+    struct ALAPushDecoder* decoder, struct BitStream* strm)
+{
+  uint64_t num_requested;
+  int64_t  num_read;
+
+  assert((decoder != NULL) && (strm != NULL));
+
+  if ((BitStream_GetNumRequestedBytes(strm, &num_requested) != BITSTREAM_APIRESULT_OK)
+      || (BitStream_Tell(strm, &num_read) != BITSTREAM_APIRESULT_OK)) {
+    BitStream_Close(strm);
+    return ALAPUSHDECODER_APIRESULT_NG;
+  }
+  BitStream_Close(strm);
+
+  /* データ不足: 次は少なくとも要求されたバイト数が揃うまで試行しない */
+  if (num_requested > decoder->num_buffered) {
+    if (num_requested > decoder->max_num_required) {
+      return ALAPUSHDECODER_APIRESULT_INVALID_FORMAT;
+    }
+    decoder->num_required = num_requested;
+    return ALAPUSHDECODER_APIRESULT_NEED_MORE_DATA;
+  }
+
+  /* 読んだ分を捨てて残りを先頭に詰める */
+  assert((num_read >= 0) && ((uint64_t)num_read <= decoder->num_buffered));
+  decoder->num_buffered -= (uint32_t)num_read;
+  memmove(decoder->buffer, &decoder->buffer[num_read], decoder->num_buffered);
+  decoder->num_required = 0;
+
+  return ALAPUSHDECODER_APIRESULT_OK;
+}
+
+/* ヘッダの読み込みとデコーダへのセット */
+static ALAPushDecoderApiResult ALAPushDecoder_ReadHeader(struct ALAPushDecoder* decoder)
+{
+  struct BitStream*       strm;
+  ALADecoderApiResult     dec_ret;
+  ALAPushDecoderApiResult ret;
+
+  assert(decoder != NULL);
+
+  if ((strm = ALAPushDecoder_BeginRead(decoder)) == NULL) {
+    return ALAPUSHDECODER_APIRESULT_NEED_MORE_DATA;
+  }
+  dec_ret = ALADecoder_DecodeHeader(strm, &decoder->header);
+  if ((ret = ALAPushDecoder_EndRead(decoder, strm)) != ALAPUSHDECODER_APIRESULT_OK) {
+    return ret;
+  }
+
+  /* ヘッダの値がハンドルの容量に収まっているか確認してセット */
+  if ((dec_ret != ALADECODER_APIRESULT_OK)
+      || ((dec_ret = ALADecoder_SetHeader(decoder->decoder, &decoder->header)) != ALADECODER_APIRESULT_OK)) {
+    /* ヘッダの範囲外の値は不正なフォーマット */
+    return (dec_ret == ALADECODER_APIRESULT_INVALID_ARGUMENT)
+      ? ALAPUSHDECODER_APIRESULT_INVALID_FORMAT : ALAPushDecoder_ConvertApiResult(dec_ret);
+  }
+  decoder->has_header = 1;
+
+  return ALAPUSHDECODER_APIRESULT_OK;
+}
+
+/* ヘッダ情報の取得 */
+ALAPushDecoderApiResult ALAPushDecoder_GetHeader(
+    struct ALAPushDecoder* decoder, struct ALAHeaderInfo* header)
+{
+  ALAPushDecoderApiResult ret;
+
+  /* 引数チェック */
+  if ((decoder == NULL) || (header == NULL)) {
+    return ALAPUSHDECODER_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* まだ読んでいなければ読む */
+  if ((decoder->has_header == 0)
+      && ((ret = ALAPushDecoder_ReadHeader(decoder)) != ALAPUSHDECODER_APIRESULT_OK)) {
+    return ret;
+  }
+
+  (*header) = decoder->header;
+
+  return ALAPUSHDECODER_APIRESULT_OK;
+}
+
+/* 1ブロックのデコード */
+ALAPushDecoderApiResult ALAPushDecoder_DecodeBlock(
+    struct ALAPushDecoder* decoder, int32_t** output, uint32_t* num_decoded_samples)
+{
+  struct BitStream*       strm;
+  ALADecoderApiResult     dec_ret;
+  ALAPushDecoderApiResult ret;
+
+  /* 引数チェック */
+  if ((decoder == NULL) || (output == NULL) || (num_decoded_samples == NULL)) {
+    return ALAPUSHDECODER_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  *num_decoded_samples = 0;
+
+  /* 終端以降は何もしない */
+  if (decoder->end_of_stream != 0) {
+    return ALAPUSHDECODER_APIRESULT_END_OF_STREAM;
+  }
+
+  /* まだ読んでいなければヘッダを読む */
+  if ((decoder->has_header == 0)
+      && ((ret = ALAPushDecoder_ReadHeader(decoder)) != ALAPUSHDECODER_APIRESULT_OK)) {
+    return ret;
+  }
+
+  /* 溜めたバイト列からデコードを試みる */
+  /* デコーダはブロックを最後まで読めるまで状態を更新しないので、足りなければ同じブロックから読み直せる */
+  if ((strm = ALAPushDecoder_BeginRead(decoder)) == NULL) {
+    return ALAPUSHDECODER_APIRESULT_NEED_MORE_DATA;
+  }
+  dec_ret = ALADecoder_DecodeBlock(decoder->decoder, strm, output, num_decoded_samples);
+  if ((ret = ALAPushDecoder_EndRead(decoder, strm)) != ALAPUSHDECODER_APIRESULT_OK) {
+    *num_decoded_samples = 0;
+    return ret;
+  }
+
+  if (dec_ret == ALADECODER_APIRESULT_END_OF_STREAM) {
+    decoder->end_of_stream = 1;
+  }
+
+  return ALAPushDecoder_ConvertApiResult(dec_ret);
+}
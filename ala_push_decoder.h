@@ -0,0 +1,58 @@
+#ifndef ALAPUSHDECODER_H_INCLUDED
+#define ALAPUSHDECODER_H_INCLUDED
+
+#include "ala_format.h"
+#include "ala_decoder.h"
+#include <stdint.h>
+
+/* プッシュ型デコーダハンドル */
+/* 任意の大きさに区切られて届くバイト列を順に受け取り、揃ったブロックからデコードする */
+/* 内部に溜めるのはデコードし終えていないバイト列（ヘッダまたは途中までのブロック）のみ */
+struct ALAPushDecoder;
+
+/* API結果型 */
+typedef enum ALAPushDecoderApiResultTag {
+  ALAPUSHDECODER_APIRESULT_OK,                    /* OK */
+  ALAPUSHDECODER_APIRESULT_NG,                    /* 分類不能なエラー */
+  ALAPUSHDECODER_APIRESULT_INVALID_ARGUMENT,      /* 不正な引数 */
+  ALAPUSHDECODER_APIRESULT_INVALID_FORMAT,        /* 不正なフォーマット */
+  ALAPUSHDECODER_APIRESULT_EXCEED_HANDLE_CAPACITY,/* ハンドルの容量を超えたパラメータ */
+  ALAPUSHDECODER_APIRESULT_DETECT_DATA_CORRUPTION,/* CRC32の不一致によりデータ破損を検出 */
+  ALAPUSHDECODER_APIRESULT_NEED_MORE_DATA,        /* データが足りない（追加してから呼び直す） */
+  ALAPUSHDECODER_APIRESULT_END_OF_STREAM          /* ストリーム終端に達した */
+} ALAPushDecoderApiResult;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* プッシュ型デコーダハンドルの作成 */
+/* configはストリームのヘッダが収まるべき上限（ヘッダの値が超えていればEXCEED_HANDLE_CAPACITYを返す） */
+struct ALAPushDecoder* ALAPushDecoder_Create(const struct ALADecoderConfig* config);
+
+/* プッシュ型デコーダハンドルの破棄 */
+void ALAPushDecoder_Destroy(struct ALAPushDecoder* decoder);
+
+/* 受信したバイト列の追加 */
+/* dataの内容は内部にコピーするので、呼び出し後は破棄してよい */
+ALAPushDecoderApiResult ALAPushDecoder_Push(
+    struct ALAPushDecoder* decoder, const uint8_t* data, uint32_t size);
+
+/* ヘッダ情報の取得 */
+/* ヘッダのバイト列が揃っていなければALAPUSHDECODER_APIRESULT_NEED_MORE_DATAを返す */
+ALAPushDecoderApiResult ALAPushDecoder_GetHeader(
+    struct ALAPushDecoder* decoder, struct ALAHeaderInfo* header);
+
+/* 1ブロックのデコード */
+/* 出力形式はALADecoder_DecodeBlockと同じ（ヘッダがまだなら先に読む） */
+/* ブロックのバイト列が揃っていなければ何も消費せずにALAPUSHDECODER_APIRESULT_NEED_MORE_DATAを返す
+ * データを追加して呼び直せば同じブロックから再開する */
+/* ストリーム終端に達したらALAPUSHDECODER_APIRESULT_END_OF_STREAMを返す */
+ALAPushDecoderApiResult ALAPushDecoder_DecodeBlock(
+    struct ALAPushDecoder* decoder, int32_t** output, uint32_t* num_decoded_samples);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ALAPUSHDECODER_H_INCLUDED */
@@ -0,0 +1,177 @@
+#define _POSIX_C_SOURCE 200112L
+#include "ala_ring_buffer.h"
+
+#include <stdlib.h>
+#include <pthread.h>
+#include <assert.h>
+
+/* 生産者/消費者間で共有する変数の読み書き */
+/* 要素の書き込みと位置の公開、位置の公開と待ちフラグの確認の順序を保証するため、全て逐次一貫で行う */
+#if defined(__GNUC__) && defined(__ATOMIC_SEQ_CST)
+#define ALARINGBUFFER_LOAD(ring, ptr)         __atomic_load_n((ptr), __ATOMIC_SEQ_CST)
+#define ALARINGBUFFER_STORE(ring, ptr, val)   __atomic_store_n((ptr), (val), __ATOMIC_SEQ_CST)
+#else
+/* アトミック操作が使えなければ、待ち合わせ用とは別のロックで読み書きを囲む */
+#define ALARINGBUFFER_USE_ACCESS_MUTEX
+#define ALARINGBUFFER_LOAD(ring, ptr)         ALARingBuffer_LockedLoad((ring), (ptr))
+#define ALARINGBUFFER_STORE(ring, ptr, val)   ALARingBuffer_LockedStore((ring), (ptr), (val))
+#endif
+
+/* リングバッファハンドル */
+/* head/tailは単調に増やし、格納位置は下位ビットで決める（差が格納数になる） */
+/* 要素配列は2の冪の大きさに切り上げるので、head/tailが2^32で一周しても格納位置は連続する */
+struct ALARingBuffer {
+  void**              items;              /* 要素配列 */
+  uint32_t            capacity;           /* 容量 */
+  uint32_t            index_mask;         /* 格納位置のマスク（要素配列の大きさ-1） */
+  uint32_t            head;               /* 次に取り出す位置（消費者のみ更新） */
+  uint32_t            tail;               /* 次に追加する位置（生産者のみ更新） */
+  uint32_t            producer_waiting;   /* 生産者が空き待ちしているか？ */
+  uint32_t            consumer_waiting;   /* 消費者が要素待ちしているか？ */
+  pthread_mutex_t     mutex;              /* 待ち合わせ用の排他制御 */
+  pthread_cond_t      not_full;           /* 空きができたことの通知 */
+  pthread_cond_t      not_empty;          /* 要素が追加されたことの通知 */
+#if defined(ALARINGBUFFER_USE_ACCESS_MUTEX)
+  pthread_mutex_t     access_mutex;       /* 共有変数の読み書き用 */
+#endif
+};
+
+#if defined(ALARINGBUFFER_USE_ACCESS_MUTEX)
+/* ロックして読み込み */
+static uint32_t ALARingBuffer_LockedLoad(struct ALARingBuffer* ring, const uint32_t* ptr)
+{
+  uint32_t val;
+  pthread_mutex_lock(&ring->access_mutex);
+  val = (*ptr);
+  pthread_mutex_unlock(&ring->access_mutex);
+  return val;
+}
+
+/* ロックして書き込み */
+static void ALARingBuffer_LockedStore(struct ALARingBuffer* ring, uint32_t* ptr, uint32_t val)
+{
+  pthread_mutex_lock(&ring->access_mutex);
+  (*ptr) = val;
+  pthread_mutex_unlock(&ring->access_mutex);
+}
+#endif
+
+/* リングバッファの作成 */
+struct ALARingBuffer* ALARingBuffer_Create(uint32_t capacity)
+{
+  struct ALARingBuffer* ring;
+  uint32_t num_slots;
+
+  /* 引数チェック */
+  if ((capacity == 0) || (capacity > (1UL << 31))) {
+    return NULL;
+  }
+
+  /* 要素配列の大きさは容量以上の2の冪 */
+  num_slots = 1;
+  while (num_slots < capacity) {
+    num_slots <<= 1;
+  }
+
+  ring = (struct ALARingBuffer *)malloc(sizeof(struct ALARingBuffer));
+  ring->items             = (void **)malloc(sizeof(void *) * num_slots);
+  ring->capacity          = capacity;
+  ring->index_mask        = num_slots - 1;
+  ring->head              = 0;
+  ring->tail              = 0;
+  ring->producer_waiting  = 0;
+  ring->consumer_waiting  = 0;
+  pthread_mutex_init(&ring->mutex, NULL);
+  pthread_cond_init(&ring->not_full, NULL);
+  pthread_cond_init(&ring->not_empty, NULL);
+#if defined(ALARINGBUFFER_USE_ACCESS_MUTEX)
+  pthread_mutex_init(&ring->access_mutex, NULL);
+#endif
+
+  return ring;
+}
+
+/* リングバッファの破棄 */
+void ALARingBuffer_Destroy(struct ALARingBuffer* ring)
+{
+  if (ring != NULL) {
+#if defined(ALARINGBUFFER_USE_ACCESS_MUTEX)
+    pthread_mutex_destroy(&ring->access_mutex);
+#endif
+    pthread_cond_destroy(&ring->not_empty);
+    pthread_cond_destroy(&ring->not_full);
+    pthread_mutex_destroy(&ring->mutex);
+    free(ring->items);
+    free(ring);
+  }
+}
+
+/* 要素の追加 */
+void ALARingBuffer_Push(struct ALARingBuffer* ring, void* item)
+{
+  uint32_t tail;
+
+  assert(ring != NULL);
+
+  /* 末尾位置は自分しか更新しない */
+  tail = ring->tail;
+
+  /* 満杯ならば待つ */
+  /* 待ちフラグを立ててから再確認するので、消費者の通知を取りこぼさない */
+  if ((tail - ALARINGBUFFER_LOAD(ring, &ring->head)) >= ring->capacity) {
+    pthread_mutex_lock(&ring->mutex);
+    ALARINGBUFFER_STORE(ring, &ring->producer_waiting, 1);
+    while ((tail - ALARINGBUFFER_LOAD(ring, &ring->head)) >= ring->capacity) {
+      pthread_cond_wait(&ring->not_full, &ring->mutex);
+    }
+    ALARINGBUFFER_STORE(ring, &ring->producer_waiting, 0);
+    pthread_mutex_unlock(&ring->mutex);
+  }
+
+  /* 要素を書き込んでから位置を公開 */
+  ring->items[tail & ring->index_mask] = item;
+  ALARINGBUFFER_STORE(ring, &ring->tail, tail + 1);
+
+  /* 消費者が待っていれば起こす */
+  if (ALARINGBUFFER_LOAD(ring, &ring->consumer_waiting)) {
+    pthread_mutex_lock(&ring->mutex);
+    pthread_cond_signal(&ring->not_empty);
+    pthread_mutex_unlock(&ring->mutex);
+  }
+}
+
+/* 要素の取り出し */
+void* ALARingBuffer_Pop(struct ALARingBuffer* ring)
+{
+  uint32_t head;
+  void* item;
+
+  assert(ring != NULL);
+
+  /* 先頭位置は自分しか更新しない */
+  head = ring->head;
+
+  /* 空ならば待つ */
+  if (ALARINGBUFFER_LOAD(ring, &ring->tail) == head) {
+    pthread_mutex_lock(&ring->mutex);
+    ALARINGBUFFER_STORE(ring, &ring->consumer_waiting, 1);
+    while (ALARINGBUFFER_LOAD(ring, &ring->tail) == head) {
+      pthread_cond_wait(&ring->not_empty, &ring->mutex);
+    }
+    ALARINGBUFFER_STORE(ring, &ring->consumer_waiting, 0);
+    pthread_mutex_unlock(&ring->mutex);
+  }
+
+  /* 要素を読み出してから位置を進める */
+  item = ring->items[head & ring->index_mask];
+  ALARINGBUFFER_STORE(ring, &ring->head, head + 1);
+
+  /* 生産者が待っていれば起こす */
+  if (ALARINGBUFFER_LOAD(ring, &ring->producer_waiting)) {
+    pthread_mutex_lock(&ring->mutex);
+    pthread_cond_signal(&ring->not_full);
+    pthread_mutex_unlock(&ring->mutex);
+  }
+
+  return item;
+}
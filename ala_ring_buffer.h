@@ -0,0 +1,31 @@
+#ifndef ALARINGBUFFER_H_INCLUDED
+#define ALARINGBUFFER_H_INCLUDED
+
+#include <stdint.h>
+
+/* リングバッファハンドル */
+/* 1つの生産者スレッドから1つの消費者スレッドへポインタを順に受け渡す */
+/* 待ちが発生しない限りロックは取らない */
+struct ALARingBuffer;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* リングバッファの作成 capacityは同時に格納できる要素数 */
+struct ALARingBuffer* ALARingBuffer_Create(uint32_t capacity);
+
+/* リングバッファの破棄 */
+void ALARingBuffer_Destroy(struct ALARingBuffer* ring);
+
+/* 要素の追加（生産者スレッドのみ） 満杯ならば空きができるまで待つ */
+void ALARingBuffer_Push(struct ALARingBuffer* ring, void* item);
+
+/* 要素の取り出し（消費者スレッドのみ） 空ならば追加されるまで待つ */
+void* ALARingBuffer_Pop(struct ALARingBuffer* ring);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ALARINGBUFFER_H_INCLUDED */
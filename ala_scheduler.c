@@ -0,0 +1,241 @@
+#define _POSIX_C_SOURCE 200112L
+#include "ala_scheduler.h"
+
+#include <stdlib.h>
+#include <pthread.h>
+#include <assert.h>
+
+/* ジョブ */
+struct ALASchedulerJob {
+  void*     job;          /* ジョブデータ */
+  uint64_t  cost;         /* ジョブの重さ */
+};
+
+/* ワーカ毎の両端キュー */
+/* 持ち主は先頭（重いジョブ）から取り出し、盗む側は末尾（軽いジョブ）から取り出す */
+struct ALASchedulerDeque {
+  pthread_mutex_t mutex;  /* 排他制御 */
+  uint32_t*       jobs;   /* ジョブインデックス配列 */
+  uint32_t        head;   /* 先頭位置 */
+  uint32_t        tail;   /* 末尾位置（この位置は含まない） */
+};
+
+/* ワーカスレッドの引数 */
+struct ALASchedulerWorker {
+  struct ALAScheduler*    scheduler;        /* 所属するスケジューラ */
+  uint32_t                worker_no;        /* ワーカ番号 */
+  void*                   worker_context;   /* ワーカ毎のコンテキスト */
+};
+
+/* ジョブスケジューラハンドル */
+struct ALAScheduler {
+  uint32_t                    num_threads;    /* スレッド数 */
+  uint32_t                    max_num_jobs;   /* 最大ジョブ数 */
+  uint32_t                    num_jobs;       /* 登録済みジョブ数 */
+  struct ALASchedulerJob*     jobs;           /* ジョブ配列 */
+  struct ALASchedulerDeque*   deques;         /* ワーカ毎のキュー */
+  struct ALASchedulerWorker*  workers;        /* ワーカ引数 */
+  ALASchedulerJobFunction     job_function;   /* ジョブ処理関数 */
+};
+
+/* ジョブのコスト降順比較（qsort用） */
+static int ALAScheduler_CompareJobCost(const void* a, const void* b)
+{
+  const struct ALASchedulerJob* ja = (const struct ALASchedulerJob *)a;
+  const struct ALASchedulerJob* jb = (const struct ALASchedulerJob *)b;
+
+  if (ja->cost > jb->cost) {
+    return -1;
+  } else if (ja->cost < jb->cost) {
+    return 1;
+  }
+  return 0;
+}
+
+/* 自分のキューの先頭からジョブを取得 取得できたら1を返す */
+static int ALAScheduler_PopJob(struct ALASchedulerDeque* deque, uint32_t* job_index)
+{
+  int ret = 0;
+
+  pthread_mutex_lock(&deque->mutex);
+  if (deque->head < deque->tail) {
+    (*job_index) = deque->jobs[deque->head++];
+    ret = 1;
+  }
+  pthread_mutex_unlock(&deque->mutex);
+
+  return ret;
+}
+
+/* 他のキューの末尾からジョブを盗む 盗めたら1を返す */
+static int ALAScheduler_StealJob(struct ALASchedulerDeque* deque, uint32_t* job_index)
+{
+  int ret = 0;
+
+  pthread_mutex_lock(&deque->mutex);
+  if (deque->head < deque->tail) {
+    (*job_index) = deque->jobs[--deque->tail];
+    ret = 1;
+  }
+  pthread_mutex_unlock(&deque->mutex);
+
+  return ret;
+}
+
+/* ワーカスレッドのメインループ */
+static void* ALAScheduler_WorkerThread(void* arg)
+{
+  uint32_t i, job_index;
+  struct ALASchedulerWorker* worker = (struct ALASchedulerWorker *)arg;
+  struct ALAScheduler* scheduler = worker->scheduler;
+
+  while (1) {
+    /* 自分のキューから取得 */
+    if (!ALAScheduler_PopJob(&scheduler->deques[worker->worker_no], &job_index)) {
+      /* 空ならば隣のワーカから順に盗みに行く */
+      for (i = 1; i < scheduler->num_threads; i++) {
+        uint32_t victim = (worker->worker_no + i) % scheduler->num_threads;
+        if (ALAScheduler_StealJob(&scheduler->deques[victim], &job_index)) {
+          break;
+        }
+      }
+      /* 実行中にジョブは増えないので、全キューが空ならば終了 */
+      if (i >= scheduler->num_threads) {
+        break;
+      }
+    }
+    /* ジョブ実行 */
+    scheduler->job_function(worker->worker_context, scheduler->jobs[job_index].job);
+  }
+
+  return NULL;
+}
+
+/* ジョブスケジューラハンドルの作成 */
+struct ALAScheduler* ALAScheduler_Create(uint32_t num_threads, uint32_t max_num_jobs)
+{
+  uint32_t i;
+  struct ALAScheduler* scheduler;
+
+  /* 引数チェック */
+  if ((num_threads == 0) || (max_num_jobs == 0)) {
+    return NULL;
+  }
+
+  scheduler = (struct ALAScheduler *)malloc(sizeof(struct ALAScheduler));
+  scheduler->num_threads  = num_threads;
+  scheduler->max_num_jobs = max_num_jobs;
+  scheduler->num_jobs     = 0;
+  scheduler->job_function = NULL;
+
+  /* 領域割当て */
+  scheduler->jobs     = (struct ALASchedulerJob *)malloc(sizeof(struct ALASchedulerJob) * max_num_jobs);
+  scheduler->deques   = (struct ALASchedulerDeque *)malloc(sizeof(struct ALASchedulerDeque) * num_threads);
+  scheduler->workers  = (struct ALASchedulerWorker *)malloc(sizeof(struct ALASchedulerWorker) * num_threads);
+  for (i = 0; i < num_threads; i++) {
+    /* 最悪全てのジョブが1つのキューに入ることを考慮 */
+    scheduler->deques[i].jobs = (uint32_t *)malloc(sizeof(uint32_t) * max_num_jobs);
+    scheduler->deques[i].head = scheduler->deques[i].tail = 0;
+    pthread_mutex_init(&scheduler->deques[i].mutex, NULL);
+  }
+
+  return scheduler;
+}
+
+/* ジョブスケジューラハンドルの破棄 */
+void ALAScheduler_Destroy(struct ALAScheduler* scheduler)
+{
+  uint32_t i;
+
+  if (scheduler != NULL) {
+    for (i = 0; i < scheduler->num_threads; i++) {
+      pthread_mutex_destroy(&scheduler->deques[i].mutex);
+      free(scheduler->deques[i].jobs);
+    }
+    free(scheduler->jobs);
+    free(scheduler->deques);
+    free(scheduler->workers);
+    free(scheduler);
+  }
+}
+
+/* ジョブの登録 */
+ALASchedulerApiResult ALAScheduler_AddJob(
+    struct ALAScheduler* scheduler, void* job, uint64_t cost)
+{
+  /* 引数チェック */
+  if (scheduler == NULL) {
+    return ALASCHEDULER_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* 登録数チェック */
+  if (scheduler->num_jobs >= scheduler->max_num_jobs) {
+    return ALASCHEDULER_APIRESULT_EXCEED_MAX_NUM_JOBS;
+  }
+
+  scheduler->jobs[scheduler->num_jobs].job  = job;
+  scheduler->jobs[scheduler->num_jobs].cost = cost;
+  scheduler->num_jobs++;
+
+  return ALASCHEDULER_APIRESULT_OK;
+}
+
+/* 登録した全ジョブの実行 */
+ALASchedulerApiResult ALAScheduler_Run(
+    struct ALAScheduler* scheduler, ALASchedulerJobFunction job_function, void** worker_contexts)
+{
+  uint32_t i, num_created;
+  pthread_t* threads;
+  ALASchedulerApiResult ret = ALASCHEDULER_APIRESULT_OK;
+
+  /* 引数チェック */
+  if ((scheduler == NULL) || (job_function == NULL) || (worker_contexts == NULL)) {
+    return ALASCHEDULER_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* 重いジョブから処理されるようにコスト降順に並べ替え */
+  qsort(scheduler->jobs, scheduler->num_jobs,
+      sizeof(struct ALASchedulerJob), ALAScheduler_CompareJobCost);
+
+  /* ラウンドロビンで各キューに配る
+   * 各キューは先頭ほど重いジョブが並ぶ */
+  for (i = 0; i < scheduler->num_threads; i++) {
+    scheduler->deques[i].head = scheduler->deques[i].tail = 0;
+  }
+  for (i = 0; i < scheduler->num_jobs; i++) {
+    struct ALASchedulerDeque* deque = &scheduler->deques[i % scheduler->num_threads];
+    deque->jobs[deque->tail++] = i;
+  }
+
+  /* ワーカスレッド起動 */
+  scheduler->job_function = job_function;
+  threads = (pthread_t *)malloc(sizeof(pthread_t) * scheduler->num_threads);
+  for (num_created = 0; num_created < scheduler->num_threads; num_created++) {
+    struct ALASchedulerWorker* worker = &scheduler->workers[num_created];
+    worker->scheduler       = scheduler;
+    worker->worker_no       = num_created;
+    worker->worker_context  = worker_contexts[num_created];
+    if (pthread_create(&threads[num_created], NULL, ALAScheduler_WorkerThread, worker) != 0) {
+      /* 起動できたスレッドだけで処理を続ける（残りのキューは盗まれて処理される） */
+      ret = ALASCHEDULER_APIRESULT_FAILED_TO_CREATE_THREAD;
+      break;
+    }
+  }
+
+  /* 1つもスレッドを起動できなかった */
+  if (num_created == 0) {
+    free(threads);
+    return ALASCHEDULER_APIRESULT_FAILED_TO_CREATE_THREAD;
+  }
+
+  /* 全スレッドの終了待ち */
+  for (i = 0; i < num_created; i++) {
+    pthread_join(threads[i], NULL);
+  }
+  free(threads);
+
+  /* 処理したジョブはクリア */
+  scheduler->num_jobs = 0;
+
+  return ret;
+}
@@ -0,0 +1,46 @@
+#ifndef ALASCHEDULER_H_INCLUDED
+#define ALASCHEDULER_H_INCLUDED
+
+#include <stdint.h>
+
+/* ジョブスケジューラハンドル */
+struct ALAScheduler;
+
+/* ジョブ処理関数 */
+/* worker_contextはワーカスレッド毎のコンテキスト、jobは登録したジョブ */
+typedef void (*ALASchedulerJobFunction)(void* worker_context, void* job);
+
+/* API結果型 */
+typedef enum ALASchedulerApiResultTag {
+  ALASCHEDULER_APIRESULT_OK,                      /* OK */
+  ALASCHEDULER_APIRESULT_NG,                      /* 分類不能なエラー */
+  ALASCHEDULER_APIRESULT_INVALID_ARGUMENT,        /* 不正な引数 */
+  ALASCHEDULER_APIRESULT_EXCEED_MAX_NUM_JOBS,     /* 最大ジョブ数を超えた */
+  ALASCHEDULER_APIRESULT_FAILED_TO_CREATE_THREAD  /* スレッド生成に失敗 */
+} ALASchedulerApiResult;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* ジョブスケジューラハンドルの作成 */
+struct ALAScheduler* ALAScheduler_Create(uint32_t num_threads, uint32_t max_num_jobs);
+
+/* ジョブスケジューラハンドルの破棄 */
+void ALAScheduler_Destroy(struct ALAScheduler* scheduler);
+
+/* ジョブの登録 */
+/* costはジョブの重さの目安（ファイルサイズなど）。重いジョブから先に処理される */
+ALASchedulerApiResult ALAScheduler_AddJob(
+    struct ALAScheduler* scheduler, void* job, uint64_t cost);
+
+/* 登録した全ジョブの実行（全ジョブ完了まで戻らない） */
+/* worker_contextsはスレッド数分の配列で、i番目のスレッドにはworker_contexts[i]が渡される */
+ALASchedulerApiResult ALAScheduler_Run(
+    struct ALAScheduler* scheduler, ALASchedulerJobFunction job_function, void** worker_contexts);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ALASCHEDULER_H_INCLUDED */
@@ -29,6 +29,12 @@
 /* 符号なし32bit数値を符号付き32bit数値に一意変換 */
 #define ALAUTILITY_UINT32_TO_SINT32(uint) ((int32_t)((uint) >> 1) ^ -(int32_t)((uint) & 1))
 
+/* PCMデータのCRC32計算で使う作業バッファのバイト数 */
+#define ALAUTILITY_CRC32_PCM_BUFFER_SIZE 1024
+
+/* 定数判定と共通する下位の0ビット数の計算で、分岐せずにまとめて走査するサンプル数 */
+#define ALAUTILITY_CONSTANT_SCAN_UNIT 16
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -39,6 +45,9 @@ void ALAUtility_ApplyWindow(const double* window, double* data, uint32_t num_sam
 /* サイン窓を作成 */
 void ALAUtility_MakeSinWindow(double* window, uint32_t window_size);
 
+/* ハン窓を作成 */
+void ALAUtility_MakeHannWindow(double* window, uint32_t window_size);
+
 /* ceil(log2(val))の計算 */
 uint32_t ALAUtility_Log2Ceil(uint32_t val);
 
@@ -51,6 +60,28 @@ uint32_t ALAUtility_RoundUp2Powered(uint32_t val);
 /* round関数（C89で定義されてない） */
 double ALAUtility_Round(double d);
 
+/* CRC32の計算 */
+/* 初回はcrcに0を渡し、続けて計算するときは前回の結果を渡す */
+uint32_t ALAUtility_UpdateCRC32(uint32_t crc, const uint8_t* data, uint32_t num_bytes);
+
+/* 連結したバイト列のCRC32の計算 */
+/* crc1, crc2はそれぞれ前半/後半（num_bytes2バイト）を初回から計算した値 */
+uint32_t ALAUtility_CombineCRC32(uint32_t crc1, uint32_t crc2, uint32_t num_bytes2);
+
+/* PCMデータのCRC32の計算 */
+/* チャンネル順に、各サンプルの下位(bits_per_sample+7)/8バイトをリトルエンディアンで並べたバイト列を対象とする */
+uint32_t ALAUtility_UpdateCRC32OfPcm(uint32_t crc,
+    const int32_t* const* data, uint32_t num_channels, uint32_t num_samples, uint32_t bits_per_sample);
+
+/* 全サンプルが先頭サンプルと同じ値か？（num_samplesが0のときも1を返す） */
+uint8_t ALAUtility_IsConstantInt32(const int32_t* data, uint32_t num_samples);
+
+/* 全サンプルに共通する下位の0ビット数（全サンプルが0のときは0を返す） */
+uint32_t ALAUtility_GetNumWastedBitsInt32(const int32_t* data, uint32_t num_samples);
+
+/* 定数値で埋める */
+void ALAUtility_FillInt32(int32_t* data, uint32_t num_samples, int32_t value);
+
 #ifdef __cplusplus
 }
 #endif
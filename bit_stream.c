@@ -1,3 +1,5 @@
+#define _POSIX_C_SOURCE 200112L
+#define _FILE_OFFSET_BITS 64
 #include "bit_stream.h"
 
 #include <string.h>
@@ -10,6 +12,13 @@
 #define BITSTREAM_FLAGS_FILEOPENMODE_READ     (1 << 0)
 /* メモリはワーク渡しか？（1:ワーク渡し, 0:mallocで自前確保） */
 #define BITSTREAM_FLAGS_MEMORYALLOC_BYWORK    (1 << 1)
+/* 標準入出力を使用しているか？（1:標準入出力, 0:自前でオープンしたファイル） */
+#define BITSTREAM_FLAGS_STANDARD_STREAM       (1 << 2)
+/* メモリから読み込むか？（1:メモリ, 0:ファイル） */
+#define BITSTREAM_FLAGS_MEMORY                (1 << 3)
+
+/* 大きい方の値 */
+#define BITSTREAM_MAX(a, b) (((a) > (b)) ? (a) : (b))
 
 /* 下位n_bitsを取得 */
 #define BITSTREAM_GETLOWERBITS(n_bits, val) ((val) & st_lowerbits_mask[(n_bits)])
@@ -21,6 +30,10 @@ struct BitStream {
   uint8_t    bit_buffer;  /* 内部ビット入出力バッファ   */
   uint32_t   bit_count;   /* 内部ビット入出力カウント   */
   void*      work_ptr;    /* ワーク領域先頭ポインタ     */
+  const uint8_t* memory;          /* メモリ読み込みのデータ先頭 */
+  uint32_t   memory_size;         /* メモリ読み込みのデータのバイト数 */
+  uint32_t   memory_pos;          /* メモリ読み込みの次の読み込み位置 */
+  uint64_t   num_requested_bytes; /* 最初にデータ末尾を超えた読み込み要求を満たすのに必要だったバイト数 */
 };
 
 /* 下位ビットを取り出すマスク 32bitまで */
@@ -31,7 +44,7 @@ static const uint32_t st_lowerbits_mask[33] = {
   0x000001FFUL, 0x000003FFUL, 0x000007FFUL, 0x00000FFFUL,
   0x00001FFFUL, 0x00003FFFUL, 0x00007FFFUL, 0x0000FFFFUL,
   0x0001FFFFUL, 0x0003FFFFUL, 0x0007FFFFUL, 0x000FFFFFUL, 
-  0x001FFFFFUL, 0x300FFFFFUL, 0x007FFFFFUL, 0x00FFFFFFUL,
+  0x001FFFFFUL, 0x003FFFFFUL, 0x007FFFFFUL, 0x00FFFFFFUL,
   0x01FFFFFFUL, 0x03FFFFFFUL, 0x07FFFFFFUL, 0x0FFFFFFFUL, 
   0x1FFFFFFFUL, 0x3FFFFFFFUL, 0x7FFFFFFFUL, 0xFFFFFFFFUL
 };
@@ -42,15 +55,13 @@ int32_t BitStream_CalculateWorkSize(void)
   return (sizeof(struct BitStream) + BITSTREAM_ALIGNMENT);
 }
 
-/* ビットストリームのオープン */
-struct BitStream* BitStream_Open(const char* filepath,
-    const char* mode, void *work, int32_t work_size)
+/* ビットストリーム構造体の配置とモードの設定 */
+static struct BitStream* BitStream_Setup(const char* mode, void *work, int32_t work_size)
 {
   struct BitStream*  stream;
   int8_t                is_malloc_by_work = 0;
-  FILE*                 tmp_fp;
   uint8_t*              work_ptr = (uint8_t *)work;
-  
+
   /* 引数チェック */
   if ((mode == NULL) || (work_size < 0)
       || ((work != NULL) && (work_size < BitStream_CalculateWorkSize()))) {
@@ -96,47 +107,112 @@ struct BitStream* BitStream_Open(const char* filepath,
   if (is_malloc_by_work != 0) {
     stream->flags |= BITSTREAM_FLAGS_MEMORYALLOC_BYWORK;
   }
-  if (stream == NULL) {
+
+  /* 内部状態初期化 */
+  stream->fp                  = NULL;
+  stream->bit_buffer          = 0;
+  stream->memory              = NULL;
+  stream->memory_size         = 0;
+  stream->memory_pos          = 0;
+  stream->num_requested_bytes = 0;
+
+  return stream;
+}
+
+/* ビットストリームのオープン */
+struct BitStream* BitStream_Open(const char* filepath,
+    const char* mode, void *work, int32_t work_size)
+{
+  struct BitStream*  stream;
+  FILE*                 tmp_fp;
+
+  /* 構造体の配置 */
+  if ((stream = BitStream_Setup(mode, work, work_size)) == NULL) {
     return NULL;
   }
 
   /* ファイルオープン */
-  tmp_fp = fopen(filepath, mode);
-  if (tmp_fp == NULL) {
-    return NULL;
+  /* ファイル名が"-"のときは標準入出力を使用 */
+  if (strcmp(filepath, "-") == 0) {
+    tmp_fp = (stream->flags & BITSTREAM_FLAGS_FILEOPENMODE_READ) ? stdin : stdout;
+    stream->flags |= BITSTREAM_FLAGS_STANDARD_STREAM;
+  } else {
+    tmp_fp = fopen(filepath, mode);
+    if (tmp_fp == NULL) {
+      return NULL;
+    }
+    fseek(tmp_fp, 0, SEEK_SET);
   }
   stream->fp = tmp_fp;
 
-  /* 内部状態初期化 */
-  fseek(stream->fp, SEEK_SET, 0);
-  stream->bit_buffer  = 0;
+  return stream;
+}
+
+/* メモリ上のデータを読み込むビットストリームのオープン */
+struct BitStream* BitStream_OpenMemory(const uint8_t* data, uint32_t size, void *work, int32_t work_size)
+{
+  struct BitStream* stream;
+
+  /* 引数チェック */
+  if ((data == NULL) && (size > 0)) {
+    return NULL;
+  }
+
+  /* 構造体の配置 */
+  if ((stream = BitStream_Setup("rb", work, work_size)) == NULL) {
+    return NULL;
+  }
+
+  stream->flags       |= BITSTREAM_FLAGS_MEMORY;
+  stream->memory      = data;
+  stream->memory_size = size;
 
   return stream;
 }
 
 /* ビットストリームのクローズ */
-void BitStream_Close(struct BitStream* stream)
+BitStreamApiResult BitStream_Close(struct BitStream* stream)
 {
+  BitStreamApiResult ret;
+  uint8_t is_read;
+
   /* 引数チェック */
   if (stream == NULL) {
-    return;
+    return BITSTREAM_APIRESULT_INVALID_ARGUMENT;
   }
 
-  /* バッファのクリア 返り値は無視する */
-  (void)BitStream_Flush(stream);
+  /* 注意）streamはワーク領域内にあるので解放前に読んでおく */
+  is_read = (stream->flags & BITSTREAM_FLAGS_FILEOPENMODE_READ) ? 1 : 0;
+
+  /* バッファのクリア 書きモードではこれまでの書き出しの失敗もここで分かる */
+  ret = BitStream_Flush(stream);
 
   /* ファイルハンドルクローズ */
-  fclose(stream->fp);
+  /* 標準入出力は閉じずにフラッシュのみ */
+  if (stream->flags & BITSTREAM_FLAGS_MEMORY) {
+    /* メモリ読み込みでは何もしない */
+  } else if (stream->flags & BITSTREAM_FLAGS_STANDARD_STREAM) {
+    /* 標準出力では閉じる代わりのフラッシュで書き出しの失敗が分かる */
+    if (fflush(stream->fp) != 0) {
+      ret = BITSTREAM_APIRESULT_IOERROR;
+    }
+  } else if (fclose(stream->fp) != 0) {
+    /* 閉じる際のバッファ書き出しの失敗 */
+    ret = BITSTREAM_APIRESULT_IOERROR;
+  }
 
   /* 必要ならばメモリ解放 */
+  /* 注意）streamはワーク領域内にあるので解放後は参照しない */
   if (!(stream->flags & BITSTREAM_FLAGS_MEMORYALLOC_BYWORK)) {
     free(stream->work_ptr);
-    stream->work_ptr = NULL;
   }
+
+  /* 読みモードでは読み残しは問わないので常に成功 */
+  return (is_read != 0) ? BITSTREAM_APIRESULT_OK : ret;
 }
 
 /* シーク(fseek準拠) */
-BitStreamApiResult BitStream_Seek(struct BitStream* stream, int32_t offset, int32_t wherefrom)
+BitStreamApiResult BitStream_Seek(struct BitStream* stream, int64_t offset, int32_t wherefrom)
 {
   /* 引数チェック */
   if (stream == NULL) {
@@ -148,8 +224,24 @@ BitStreamApiResult BitStream_Seek(struct BitStream* stream, int32_t offset, int3
     return BITSTREAM_APIRESULT_NG;
   }
 
+  /* メモリ読み込みでは読み込み位置を直接動かす */
+  if (stream->flags & BITSTREAM_FLAGS_MEMORY) {
+    int64_t pos;
+    switch (wherefrom) {
+      case BITSTREAM_SEEK_SET: pos = offset; break;
+      case BITSTREAM_SEEK_CUR: pos = (int64_t)stream->memory_pos + offset; break;
+      case BITSTREAM_SEEK_END: pos = (int64_t)stream->memory_size + offset; break;
+      default: return BITSTREAM_APIRESULT_INVALID_ARGUMENT;
+    }
+    if ((pos < 0) || (pos > (int64_t)stream->memory_size)) {
+      return BITSTREAM_APIRESULT_NG;
+    }
+    stream->memory_pos = (uint32_t)pos;
+    return BITSTREAM_APIRESULT_OK;
+  }
+
   /* シーク実行 */
-  if (fseek(stream->fp, offset, wherefrom) != 0) {
+  if (fseeko(stream->fp, (off_t)offset, wherefrom) != 0) {
     return BITSTREAM_APIRESULT_NG;
   }
 
@@ -157,18 +249,24 @@ BitStreamApiResult BitStream_Seek(struct BitStream* stream, int32_t offset, int3
 }
 
 /* 現在位置(ftell)準拠 */
-BitStreamApiResult BitStream_Tell(struct BitStream* stream, int32_t* result)
+BitStreamApiResult BitStream_Tell(struct BitStream* stream, int64_t* result)
 {
-  long tmp;
+  off_t tmp;
 
   /* 引数チェック */
   if (stream == NULL || result == NULL) {
     return BITSTREAM_APIRESULT_INVALID_ARGUMENT;
   }
 
+  /* メモリ読み込みでは読み込み位置 */
+  if (stream->flags & BITSTREAM_FLAGS_MEMORY) {
+    *result = (int64_t)stream->memory_pos;
+    return BITSTREAM_APIRESULT_OK;
+  }
+
   /* ftell実行/結果の記録 */
-  if ((tmp = ftell(stream->fp)) >= 0) {
-    *result = (int32_t)tmp;
+  if ((tmp = ftello(stream->fp)) >= 0) {
+    *result = (int64_t)tmp;
   }
 
   return (tmp >= 0) ? BITSTREAM_APIRESULT_OK : BITSTREAM_APIRESULT_NG;
@@ -256,10 +354,41 @@ BitStreamApiResult BitStream_PutBits(struct BitStream* stream, uint32_t n_bits,
   return BITSTREAM_APIRESULT_OK;
 }
 
+/* メモリ読み込みでデータ末尾を超えた要求の記録 */
+/* 足りなかった後に読んだ値は信用できないため、最初の要求だけを記録する */
+static void BitStream_RecordShortage(struct BitStream* stream, uint64_t num_required_bytes)
+{
+  if (stream->num_requested_bytes <= stream->memory_size) {
+    stream->num_requested_bytes = num_required_bytes;
+  }
+}
+
+/* 1バイト読み込み（ファイルまたはメモリから） */
+static BitStreamApiResult BitStream_ReadByte(struct BitStream* stream, int32_t* ch)
+{
+  /* メモリ読み込みでは足りなければ必要なバイト数を記録 */
+  if (stream->flags & BITSTREAM_FLAGS_MEMORY) {
+    if (stream->memory_pos >= stream->memory_size) {
+      BitStream_RecordShortage(stream, (uint64_t)stream->memory_pos + 1);
+      return BITSTREAM_APIRESULT_EOS;
+    }
+    (*ch) = stream->memory[stream->memory_pos++];
+    return BITSTREAM_APIRESULT_OK;
+  }
+
+  if (((*ch) = fgetc(stream->fp)) == EOF) {
+    /* ファイル終端とそれ以外のエラーを区別 */
+    return feof(stream->fp) ? BITSTREAM_APIRESULT_EOS : BITSTREAM_APIRESULT_IOERROR;
+  }
+
+  return BITSTREAM_APIRESULT_OK;
+}
+
 /* 1bit取得 */
 BitStreamApiResult BitStream_GetBit(struct BitStream* stream, uint8_t* bit)
 {
   int32_t ch;
+  BitStreamApiResult ret;
 
   /* 引数チェック */
   if (stream == NULL || bit == NULL) {
@@ -278,15 +407,10 @@ BitStreamApiResult BitStream_GetBit(struct BitStream* stream, uint8_t* bit)
     return BITSTREAM_APIRESULT_OK;
   }
 
-  /* 1バイト読み込みとエラー処理 */
-  if ((ch = fgetc(stream->fp)) == EOF) {
-    if (feof(stream->fp)) {
-      /* ファイル終端に達した */
-      return BITSTREAM_APIRESULT_EOS;
-    } else {
-      /* それ以外のエラー */
-      return BITSTREAM_APIRESULT_IOERROR;
-    }
+  /* 1バイト読み込みとエラー処理（読めなかったときのビットは0とする） */
+  if ((ret = BitStream_ReadByte(stream, &ch)) != BITSTREAM_APIRESULT_OK) {
+    (*bit) = 0;
+    return ret;
   }
 
   /* カウンタとバッファの更新 */
@@ -304,6 +428,7 @@ BitStreamApiResult BitStream_GetBits(struct BitStream* stream, uint32_t n_bits,
 {
   int32_t  ch;
   uint64_t tmp = 0;
+  BitStreamApiResult ret;
 
   /* 引数チェック */
   if (stream == NULL || val == NULL) {
@@ -325,22 +450,22 @@ BitStreamApiResult BitStream_GetBits(struct BitStream* stream, uint32_t n_bits,
    * 2回目以降は8bit単位で入力しtmpにセット */
   while (n_bits > stream->bit_count) {
     n_bits  -= stream->bit_count;
-    tmp     |= BITSTREAM_GETLOWERBITS(stream->bit_count, stream->bit_buffer) << n_bits;
+    /* バイト境界では残りビットがないので、64bit取得時に型の幅でシフトしないよう飛ばす */
+    if (stream->bit_count > 0) {
+      tmp   |= (uint64_t)BITSTREAM_GETLOWERBITS(stream->bit_count, stream->bit_buffer) << n_bits;
+    }
     /* 1バイト読み込みとエラー処理 */
-    if ((ch = fgetc(stream->fp)) == EOF) {
-      if (feof(stream->fp)) {
-        /* 途中でファイル終端に達していたら、ループを抜ける */
-        goto END_OF_STREAM;
-      } else {
-        /* それ以外のエラー */
-        return BITSTREAM_APIRESULT_IOERROR;
-      }
+    if ((ret = BitStream_ReadByte(stream, &ch)) != BITSTREAM_APIRESULT_OK) {
+      /* 途中で終端に達していたら、読めた上位ビットだけを返す（残りのビットは0） */
+      /* バッファのビットは使い切っているので、残りビット数を0にしておく */
+      stream->bit_count = 0;
+      *val = tmp;
+      return ret;
     }
     stream->bit_buffer  = (uint8_t)ch;
     stream->bit_count   = 8;
   }
 
-END_OF_STREAM:
   /* 端数ビットの処理 
    * 残ったビット分をtmpの最下位ビットにセット */
   stream->bit_count -= n_bits;
@@ -351,26 +476,159 @@ END_OF_STREAM:
   return BITSTREAM_APIRESULT_OK;
 }
 
+/* バイト列出力（バイト境界にあること） */
+BitStreamApiResult BitStream_PutBytes(struct BitStream* stream, const uint8_t* data, uint32_t num_bytes)
+{
+  /* 引数チェック */
+  if ((stream == NULL) || ((data == NULL) && (num_bytes > 0))) {
+    return BITSTREAM_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* 読み込みモードでは実行不可能 */
+  if (stream->flags & BITSTREAM_FLAGS_FILEOPENMODE_READ) {
+    return BITSTREAM_APIRESULT_INVALID_MODE;
+  }
+
+  /* バイト境界にない */
+  if (stream->bit_count != 8) {
+    return BITSTREAM_APIRESULT_NG;
+  }
+
+  /* バッファを介さずにまとめて書き出す */
+  if (fwrite(data, sizeof(uint8_t), num_bytes, stream->fp) != num_bytes) {
+    return BITSTREAM_APIRESULT_IOERROR;
+  }
+
+  return BITSTREAM_APIRESULT_OK;
+}
+
+/* バイト列取得（バイト境界にあること） */
+BitStreamApiResult BitStream_GetBytes(struct BitStream* stream, uint8_t* data, uint32_t num_bytes)
+{
+  /* 引数チェック */
+  if ((stream == NULL) || ((data == NULL) && (num_bytes > 0))) {
+    return BITSTREAM_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* 読み込みモードでない場合は即時リターン */
+  if (!(stream->flags & BITSTREAM_FLAGS_FILEOPENMODE_READ)) {
+    return BITSTREAM_APIRESULT_INVALID_MODE;
+  }
+
+  /* バイト境界にない */
+  if (stream->bit_count != 0) {
+    return BITSTREAM_APIRESULT_NG;
+  }
+
+  /* メモリ読み込みでは足りなければ何も読まずに終端とし、必要なバイト数を記録 */
+  if (stream->flags & BITSTREAM_FLAGS_MEMORY) {
+    if ((uint64_t)stream->memory_pos + num_bytes > stream->memory_size) {
+      BitStream_RecordShortage(stream, (uint64_t)stream->memory_pos + num_bytes);
+      return BITSTREAM_APIRESULT_EOS;
+    }
+    memcpy(data, &stream->memory[stream->memory_pos], num_bytes);
+    stream->memory_pos += num_bytes;
+    return BITSTREAM_APIRESULT_OK;
+  }
+
+  /* バッファを介さずにまとめて読み込む */
+  if (fread(data, sizeof(uint8_t), num_bytes, stream->fp) != num_bytes) {
+    return feof(stream->fp) ? BITSTREAM_APIRESULT_EOS : BITSTREAM_APIRESULT_IOERROR;
+  }
+
+  return BITSTREAM_APIRESULT_OK;
+}
+
+/* これまでの読み込みでストリーム終端を超えたか？ */
+BitStreamApiResult BitStream_IsEndOfStream(struct BitStream* stream, uint8_t* is_eos)
+{
+  /* 引数チェック */
+  if ((stream == NULL) || (is_eos == NULL)) {
+    return BITSTREAM_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* 読み込みモードでない場合は即時リターン */
+  if (!(stream->flags & BITSTREAM_FLAGS_FILEOPENMODE_READ)) {
+    return BITSTREAM_APIRESULT_INVALID_MODE;
+  }
+
+  if (stream->flags & BITSTREAM_FLAGS_MEMORY) {
+    (*is_eos) = (stream->num_requested_bytes > stream->memory_size) ? 1 : 0;
+  } else {
+    (*is_eos) = feof(stream->fp) ? 1 : 0;
+  }
+
+  return BITSTREAM_APIRESULT_OK;
+}
+
+/* メモリ読み込みで、これまでの読み込み要求を満たすのに必要なデータのバイト数 */
+BitStreamApiResult BitStream_GetNumRequestedBytes(struct BitStream* stream, uint64_t* num_bytes)
+{
+  /* 引数チェック */
+  if ((stream == NULL) || (num_bytes == NULL)) {
+    return BITSTREAM_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* メモリ読み込みでなければ実行不可能 */
+  if (!(stream->flags & BITSTREAM_FLAGS_MEMORY)) {
+    return BITSTREAM_APIRESULT_INVALID_MODE;
+  }
+
+  (*num_bytes) = BITSTREAM_MAX(stream->num_requested_bytes, (uint64_t)stream->memory_pos);
+
+  return BITSTREAM_APIRESULT_OK;
+}
+
+/* 現在位置から続くnum_bytesバイトのデータが揃っているか確認 */
+BitStreamApiResult BitStream_RequireBytes(struct BitStream* stream, uint32_t num_bytes)
+{
+  /* 引数チェック */
+  if (stream == NULL) {
+    return BITSTREAM_APIRESULT_INVALID_ARGUMENT;
+  }
+
+  /* 読み込みモードでない場合は即時リターン */
+  if (!(stream->flags & BITSTREAM_FLAGS_FILEOPENMODE_READ)) {
+    return BITSTREAM_APIRESULT_INVALID_MODE;
+  }
+
+  /* メモリ読み込みでは足りなければ必要なバイト数を記録 */
+  if ((stream->flags & BITSTREAM_FLAGS_MEMORY)
+      && (((uint64_t)stream->memory_pos + num_bytes) > stream->memory_size)) {
+    BitStream_RecordShortage(stream, (uint64_t)stream->memory_pos + num_bytes);
+    return BITSTREAM_APIRESULT_EOS;
+  }
+
+  return BITSTREAM_APIRESULT_OK;
+}
+
 /* バッファにたまったビットをクリア */
 BitStreamApiResult BitStream_Flush(struct BitStream* stream)
 {
+  BitStreamApiResult ret;
+  uint64_t dummy;
+
   /* 引数チェック */
   if (stream == NULL) {
     return BITSTREAM_APIRESULT_INVALID_ARGUMENT;
   }
 
+  /* 書きモードではバッファに余ったビットを強制出力 */
+  if (!(stream->flags & BITSTREAM_FLAGS_FILEOPENMODE_READ)) {
+    if ((stream->bit_count != 8)
+        && ((ret = BitStream_PutBits(stream, (uint16_t)stream->bit_count, 0)) != BITSTREAM_APIRESULT_OK)) {
+      return ret;
+    }
+    /* ファイルのバッファを介して遅れて起きた書き出しの失敗も報告する */
+    return ferror(stream->fp) ? BITSTREAM_APIRESULT_IOERROR : BITSTREAM_APIRESULT_OK;
+  }
+
   /* 既に先頭にあるときは何もしない */
   if (stream->bit_count == 8) {
     return BITSTREAM_APIRESULT_OK;
   }
 
   /* 読み込み位置を次のバイト先頭に */
-  if (stream->flags & BITSTREAM_FLAGS_FILEOPENMODE_READ) {
-    /* 残りビット分を空読み */
-    uint64_t dummy;
-    return BitStream_GetBits(stream, (uint32_t)stream->bit_count, &dummy);
-  } else {
-    /* バッファに余ったビットを強制出力 */
-    return BitStream_PutBits(stream, (uint16_t)stream->bit_count, 0);
-  }
+  /* 残りビット分を空読み */
+  return BitStream_GetBits(stream, (uint32_t)stream->bit_count, &dummy);
 }
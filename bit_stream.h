@@ -30,18 +30,24 @@ extern "C" {
 int32_t BitStream_CalculateWorkSize(void);
 
 /* ビットストリームのオープン */
+/* filepathが"-"のときは、読みモードでは標準入力、書きモードでは標準出力を使用する */
 struct BitStream* BitStream_Open(const char* filepath, 
     const char *mode, void *work, int32_t work_size);
 
+/* メモリ上のデータを読み込むビットストリームのオープン（読みモードのみ） */
+/* dataはクローズするまで保持すること */
+struct BitStream* BitStream_OpenMemory(const uint8_t* data, uint32_t size, void *work, int32_t work_size);
+
 /* ビットストリームのクローズ */
-void BitStream_Close(struct BitStream* stream);
+/* 書きモードではバッファの書き出しやファイルのクローズに失敗するとBITSTREAM_APIRESULT_IOERRORを返す */
+BitStreamApiResult BitStream_Close(struct BitStream* stream);
 
-/* シーク(fseek準拠)
+/* シーク(fseek準拠、オフセットは64bit)
  * 注意）バッファをクリアするので副作用がある */
-BitStreamApiResult BitStream_Seek(struct BitStream* stream, int32_t offset, int32_t wherefrom);
+BitStreamApiResult BitStream_Seek(struct BitStream* stream, int64_t offset, int32_t wherefrom);
 
-/* 現在位置(ftell)準拠 */
-BitStreamApiResult BitStream_Tell(struct BitStream* stream, int32_t* result);
+/* 現在位置(ftell準拠、64bit) */
+BitStreamApiResult BitStream_Tell(struct BitStream* stream, int64_t* result);
 
 /* 1bit出力 */
 BitStreamApiResult BitStream_PutBit(struct BitStream* stream, uint8_t bit);
@@ -59,7 +65,27 @@ BitStreamApiResult BitStream_GetBit(struct BitStream* stream, uint8_t* bit);
 /* n_bits 取得（最大64bit）し、その値を右詰めして出力 */
 BitStreamApiResult BitStream_GetBits(struct BitStream* stream, uint32_t n_bits, uint64_t *val);
 
+/* バイト列出力（バイト境界にあること） */
+BitStreamApiResult BitStream_PutBytes(struct BitStream* stream, const uint8_t* data, uint32_t num_bytes);
+
+/* バイト列取得（バイト境界にあること） */
+BitStreamApiResult BitStream_GetBytes(struct BitStream* stream, uint8_t* data, uint32_t num_bytes);
+
+/* これまでの読み込みでストリーム終端を超えたか？（途中で途切れたデータの検出に使う） */
+BitStreamApiResult BitStream_IsEndOfStream(struct BitStream* stream, uint8_t* is_eos);
+
+/* メモリ読み込みで、これまでの読み込み要求を満たすのに必要なデータのバイト数 */
+/* データの末尾を超えて読もうとした場合（データ不足）はデータのバイト数より大きな値になる
+ * その場合は最初に足りなかった読み込みまでのバイト数を返す（以降の読み込み結果は信用できないため） */
+BitStreamApiResult BitStream_GetNumRequestedBytes(struct BitStream* stream, uint64_t* num_bytes);
+
+/* 現在位置から続くnum_bytesバイトのデータが揃っているか確認（読み込み位置は動かさない） */
+/* メモリ読み込みで足りなければ必要なバイト数を記録してBITSTREAM_APIRESULT_EOSを返す
+ * ファイル読み込みでは確認できないので常にBITSTREAM_APIRESULT_OKを返す */
+BitStreamApiResult BitStream_RequireBytes(struct BitStream* stream, uint32_t num_bytes);
+
 /* バッファにたまったビットをクリア */
+/* 書きモードではこれまでの書き出しに失敗していればBITSTREAM_APIRESULT_IOERRORを返す */
 BitStreamApiResult BitStream_Flush(struct BitStream* stream);
 
 #ifdef __cplusplus
@@ -4,274 +4,923 @@
  * To Public License, Version 2, as published by Sam Hocevar. See
  * http://www.wtfpl.net/ for more details. */
 
+#define _POSIX_C_SOURCE 200112L
+#define _FILE_OFFSET_BITS 64
 #include "wav.h"
 #include "bit_stream.h"
+#include "ala_format.h"
 #include "ala_utility.h"
 #include "ala_coder.h"
 #include "ala_predictor.h"
+#include "ala_encoder.h"
+#include "ala_decoder.h"
+#include "ala_scheduler.h"
+#include "ala_ring_buffer.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
 #include <sys/stat.h>
+#include <sys/time.h>
+#include <dirent.h>
+#include <unistd.h>
 #include <math.h>
 
 /* バージョン番号 */
 #define ALA_VERSION_STRING  "1.0.0"
 
-/* フォーマットバージョン */
-#define ALA_FORMAT_VERSION  1
+/* ブロックあたりサンプル数の最大値（全プリセットの最大） */
+#define ALA_MAX_NUM_SAMPLES_PER_BLOCK 8192
 
-/* ブロックあたりサンプル数 */
-#define ALA_NUM_SAMPLES_PER_BLOCK 4096
+/* PARCOR係数の次数の最大値（全プリセットの最大） */
+#define ALA_MAX_PARCOR_ORDER      8
 
-/* PARCOR係数の次数 */
-#define ALA_PARCOR_ORDER          10
+/* エンコードプリセット数 */
+#define ALA_NUM_PRESETS           9
 
-/* エンファシスフィルタのシフト量 */
-#define ALA_EMPHASIS_FILTER_SHIFT 5
+/* 既定のエンコードプリセット */
+#define ALA_DEFAULT_PRESET        4
 
-/* エンコード 成功時は0、失敗時は0以外を返す */
-int do_encode(const char* in_filename, const char* out_filename)
-{
-  struct WAVFile*           in_wav;
-  struct BitStream*         out_strm;
-  struct ALACoder*          coder;
-  struct ALALPCCalculator*  lpcc;
-  struct ALALPCSynthesizer* lpcs;
-  uint32_t  ch, smpl, ord;
-  double**  parcor_coef;
-  int32_t** parcor_coef_int32;
-  double**  input;
-  int32_t** input_int32;
-  double**  input_ptr;
-  int32_t** input_int32_ptr;
-  int32_t** residual;
-  double*   window;
-  uint32_t  num_channels, num_samples;
-  uint32_t  enc_offset_sample;
+/* 適応フィルタのレベル数 */
+#define ALA_NUM_LMS_LEVELS        4
+
+/* 適応フィルタの最大タップ数（全レベルの最大） */
+#define ALA_LMS_MAX_NUM_TAPS      256
+
+/* バッチモードでエンコーダを作成するときの最小チャンネル数 */
+#define ALA_BATCH_MIN_NUM_CHANNELS  2
+
+/* 既定の先読み/書き出し待ちブロック数 */
+#define ALA_DEFAULT_NUM_PIPELINE_BLOCKS 4
+
+/* 適応フィルタのレベル毎の構成 */
+struct LMSLevel {
+  uint32_t num_stages;                            /* 段数 */
+  uint32_t num_taps[ALA_MAX_NUM_LMS_STAGES];      /* 各段のタップ数 */
+  uint32_t shift[ALA_MAX_NUM_LMS_STAGES];         /* 各段の係数の小数部ビット数 */
+};
+
+/* 適応フィルタのレベル表（レベルが高いほど長いフィルタを多段に使う） */
+static const struct LMSLevel lms_levels[ALA_NUM_LMS_LEVELS] = {
+  { 0, {   0,  0,  0 }, {  0,  0,  0 } },
+  { 1, {  16,  0,  0 }, { 11,  0,  0 } },
+  { 2, {  64, 16,  0 }, { 12, 11,  0 } },
+  { 3, { 256, 32, 16 }, { 13, 12, 11 } }
+};
+
+/* エンコードプリセット */
+struct EncodePreset {
+  uint32_t num_samples_per_block;         /* ブロックあたりサンプル数 */
+  uint32_t parcor_order;                  /* PARCOR係数次数 */
+  uint32_t emphasis_shift;                /* エンファシスフィルタのシフト量 */
+  uint32_t num_window_trials;             /* 係数計算で試す窓の数 */
+  uint32_t enable_channel_process_search; /* ステレオ処理法を探索するか？ */
+  uint32_t max_reference_offset;          /* 参照チャンネル予測で探索する直前チャンネル数 */
+  uint32_t max_ltp_lag;                   /* 長期予測の最大ラグ（0で使わない） */
+  uint32_t lms_level;                     /* 適応フィルタのレベル */
+  uint32_t low_latency;                   /* 低遅延モードか？ */
+  uint32_t enable_rans;                   /* 残差のrANS符号化を試すか？ */
+};
+
+/* エンコードプリセット表（番号が大きいほど圧縮率が高く遅い） */
+/* 各段は評価用の音源で実測し、サイズと速度のトレードオフになるよう選んだ */
+static const struct EncodePreset presets[ALA_NUM_PRESETS] = {
+  /* ブロック, 次数, エンファシス, 窓, ステレオ, 参照, 長期予測, 適応フィルタ, 低遅延, rANS */
+  { 2048, 4, 5, 1, 0, 0,    0, 0, 0, 0 },
+  { 2048, 8, 5, 1, 1, 0,    0, 0, 0, 1 },
+  { 2048, 8, 5, 1, 1, 4,  256, 0, 0, 1 },
+  { 4096, 8, 5, 1, 1, 4, 1024, 0, 0, 1 },
+  { 4096, 8, 5, 1, 1, 4, 1024, 1, 0, 1 },
+  { 8192, 8, 5, 1, 1, 4, 1024, 2, 0, 1 },
+  { 8192, 8, 0, 1, 1, 4, 1024, 3, 0, 1 },
+  { 8192, 8, 0, 2, 1, 4, 1024, 3, 0, 1 },
+  { 8192, 8, 0, 3, 1, 4, 1024, 3, 0, 1 }
+};
+
+/* 低遅延プロファイル */
+/* 48kHzで4msのブロックを短縮ヘッダ/チャンネルインターリーブ順で記録する */
+/* ブロック毎の処理時間を抑えるため、長期予測と適応フィルタは使わない */
+static const struct EncodePreset low_latency_preset =
+  {  192, 8, 5, 1, 1, 0,    0, 0, 1, 0 };
+
+/* ブロック毎の処理時間の計測結果 */
+struct BlockTiming {
+  uint32_t  num_blocks;       /* 計測したブロック数 */
+  double    max_time;         /* 最大処理時間[sec] */
+  double    total_time;       /* 合計処理時間[sec] */
+};
+
+/* エンコード結果 */
+struct EncodeResult {
+  int       error;            /* エラーが起きたか？ */
+  uint64_t  num_samples;      /* サンプル数 */
+  uint32_t  sampling_rate;    /* サンプリングレート */
+  uint64_t  input_size;       /* 入力ファイルサイズ */
+  uint64_t  output_size;      /* 出力ファイルサイズ */
+};
+
+/* エンコードスレッドのコンテキスト */
+/* エンコーダハンドルはファイル間で使い回す */
+struct EncodeWorker {
+  struct ALAEncoder*      encoder;  /* エンコーダハンドル */
+  struct ALAEncoderConfig config;   /* エンコーダハンドルの容量 */
+  struct EncodePreset     preset;   /* エンコードプリセット */
+  uint32_t                num_pipeline_blocks;  /* 先読みするブロック数 */
+};
+
+/* WAVの入出力スレッドとコーデックのスレッドで受け渡すPCMブロック */
+struct PcmBlock {
+  int32_t**     data;         /* チャンネル毎のサンプル（右詰め、エンコード時） */
+  uint8_t*      bytes;        /* WAVのデータチャンクと同じ形式のバイト列（デコード時） */
+  uint32_t      num_samples;  /* サンプル数（0ならばデータ終端） */
+  int           error;        /* 読み込みに失敗したか？ */
+};
+
+/* PCMブロックのパイプライン */
+/* 空きブロックと埋まったブロックを2つのリングバッファで逆向きに受け渡し、
+ * WAVの読み込み（エンコード時）/書き出し（デコード時）をコーデックの処理と並行して行う */
+struct PcmPipeline {
+  struct PcmBlock*        blocks;             /* ブロック配列 */
+  uint32_t                num_blocks;         /* ブロック数（先読みの深さ） */
+  uint32_t                num_channels;       /* チャンネル数 */
+  uint32_t                num_samples_per_block; /* ブロックあたりサンプル数 */
+  struct ALARingBuffer*   free_blocks;        /* 空きブロック */
+  struct ALARingBuffer*   filled_blocks;      /* 埋まったブロック */
+  pthread_t               thread;             /* 入出力スレッド */
+  struct WAVStreamReader* reader;             /* 読み込みハンドル（エンコード時） */
+  uint32_t                shift;              /* 読み込んだサンプルの右シフト量 */
+  struct WAVStreamWriter* writer;             /* 書き出しハンドル（デコード時） */
+  pthread_mutex_t         mutex;              /* stop/errorの排他制御 */
+  int                     stop;               /* 読み込みの中断要求 */
+  int                     error;              /* 書き出しに失敗したか？ */
+  int                     end_of_data;        /* データ終端のブロックを受け取ったか？ */
+};
+
+/* 検証モードのジョブ */
+struct VerifyJob {
+  const char*         filename;       /* 検証するファイル名 */
+  ALADecoderApiResult result;         /* デコード結果 */
+  uint64_t            num_samples;    /* 検証したサンプル数 */
+  uint32_t            sampling_rate;  /* サンプリングレート */
+  uint64_t            input_size;     /* ファイルサイズ */
+};
+
+/* バッチモードのジョブ */
+struct BatchJob {
+  char*               in_filename;    /* 入力ファイル名 */
+  char*               out_filename;   /* 出力ファイル名 */
+  struct EncodeResult result;         /* エンコード結果 */
+};
+
+/* ファイルサイズの取得 取得できなければ0を返す */
+static uint64_t get_file_size(const char* filename)
+{
+  struct stat st;
+
+  if (stat(filename, &st) != 0) {
+    return 0;
+  }
+
+  return (uint64_t)st.st_size;
+}
+
+/* 経過時間計測用の現在時刻[sec] */
+static double get_current_time(void)
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (double)tv.tv_sec + (double)tv.tv_usec * 1.0e-6;
+}
+
+/* ブロック処理時間の記録 */
+static void BlockTiming_Add(struct BlockTiming* timing, double time)
+{
+  timing->num_blocks++;
+  timing->max_time = ALAUTILITY_MAX(timing->max_time, time);
+  timing->total_time += time;
+}
+
+/* ヘッダに記録された適応フィルタの最大タップ数 */
+static uint32_t get_max_lms_num_taps(const struct ALAHeaderInfo* header)
+{
+  uint32_t stage, max_num_taps = 0;
+
+  for (stage = 0; stage < header->num_lms_stages; stage++) {
+    max_num_taps = ALAUTILITY_MAX(max_num_taps, header->lms_num_taps[stage]);
+  }
+
+  return max_num_taps;
+}
+
+/* パイプラインの作成 全ブロックを空きブロックとして登録する */
+/* bytes_per_frameが0ならチャンネル毎のサンプル配列を、0以外ならその大きさのフレームが入るバイト列を確保する */
+static struct PcmPipeline* PcmPipeline_Create(
+    uint32_t num_blocks, uint32_t num_channels, uint32_t num_samples_per_block, uint32_t bytes_per_frame)
+{
+  uint32_t i, ch;
+  struct PcmPipeline* pipeline;
+
+  pipeline = (struct PcmPipeline *)malloc(sizeof(struct PcmPipeline));
+  pipeline->num_blocks            = num_blocks;
+  pipeline->num_channels          = num_channels;
+  pipeline->num_samples_per_block = num_samples_per_block;
+  pipeline->free_blocks           = ALARingBuffer_Create(num_blocks);
+  pipeline->filled_blocks         = ALARingBuffer_Create(num_blocks);
+  pipeline->reader                = NULL;
+  pipeline->shift                 = 0;
+  pipeline->writer                = NULL;
+  pipeline->stop                  = 0;
+  pipeline->error                 = 0;
+  pipeline->end_of_data           = 0;
+  pthread_mutex_init(&pipeline->mutex, NULL);
+  pipeline->blocks = (struct PcmBlock *)malloc(sizeof(struct PcmBlock) * num_blocks);
+  for (i = 0; i < num_blocks; i++) {
+    struct PcmBlock* block = &pipeline->blocks[i];
+    block->data   = NULL;
+    block->bytes  = NULL;
+    if (bytes_per_frame == 0) {
+      block->data = (int32_t **)malloc(sizeof(int32_t *) * num_channels);
+      for (ch = 0; ch < num_channels; ch++) {
+        block->data[ch] = (int32_t *)malloc(sizeof(int32_t) * num_samples_per_block);
+      }
+    } else {
+      block->bytes = (uint8_t *)malloc((size_t)bytes_per_frame * num_samples_per_block);
+    }
+    block->num_samples  = 0;
+    block->error        = 0;
+    ALARingBuffer_Push(pipeline->free_blocks, block);
+  }
+
+  return pipeline;
+}
+
+/* パイプラインの破棄（入出力スレッドは終了していること） */
+static void PcmPipeline_Destroy(struct PcmPipeline* pipeline)
+{
+  uint32_t i, ch;
+
+  if (pipeline != NULL) {
+    for (i = 0; i < pipeline->num_blocks; i++) {
+      if (pipeline->blocks[i].data != NULL) {
+        for (ch = 0; ch < pipeline->num_channels; ch++) {
+          free(pipeline->blocks[i].data[ch]);
+        }
+        free(pipeline->blocks[i].data);
+      }
+      free(pipeline->blocks[i].bytes);
+    }
+    free(pipeline->blocks);
+    ALARingBuffer_Destroy(pipeline->free_blocks);
+    ALARingBuffer_Destroy(pipeline->filled_blocks);
+    pthread_mutex_destroy(&pipeline->mutex);
+    free(pipeline);
+  }
+}
+
+/* フラグの読み取り */
+static int PcmPipeline_GetFlag(struct PcmPipeline* pipeline, const int* flag)
+{
+  int ret;
+  pthread_mutex_lock(&pipeline->mutex);
+  ret = (*flag);
+  pthread_mutex_unlock(&pipeline->mutex);
+  return ret;
+}
+
+/* フラグを立てる */
+static void PcmPipeline_SetFlag(struct PcmPipeline* pipeline, int* flag)
+{
+  pthread_mutex_lock(&pipeline->mutex);
+  (*flag) = 1;
+  pthread_mutex_unlock(&pipeline->mutex);
+}
+
+/* 読み込みスレッド: 空きブロックにWAVを読み込み、エンコーダ用に右詰めして渡す */
+static void* PcmPipeline_ReaderThread(void* arg)
+{
+  uint32_t ch, smpl, num_samples;
+  struct PcmPipeline* pipeline = (struct PcmPipeline *)arg;
+  struct PcmBlock* block;
+
+  do {
+    block = (struct PcmBlock *)ALARingBuffer_Pop(pipeline->free_blocks);
+    num_samples = 0;
+    /* 中断要求があれば終端ブロックを渡して終わる */
+    if (!PcmPipeline_GetFlag(pipeline, &pipeline->stop)) {
+      if (WAVStreamReader_GetPcmData(pipeline->reader,
+            block->data, pipeline->num_samples_per_block, &num_samples) != WAV_APIRESULT_OK) {
+        block->error = 1;
+        num_samples = 0;
+      }
+    }
+    /* 情報が失われない程度に右シフト */
+    for (ch = 0; ch < pipeline->num_channels; ch++) {
+      for (smpl = 0; smpl < num_samples; smpl++) {
+        block->data[ch][smpl] = ALAUTILITY_SHIFT_RIGHT_ARITHMETIC(block->data[ch][smpl], pipeline->shift);
+      }
+    }
+    /* 渡した後のブロックには触れない */
+    block->num_samples = num_samples;
+    ALARingBuffer_Push(pipeline->filled_blocks, block);
+  } while (num_samples > 0);
+
+  return NULL;
+}
+
+/* 書き出しスレッド: 埋まったブロックをWAVに書き出して空きブロックに戻す */
+static void* PcmPipeline_WriterThread(void* arg)
+{
+  struct PcmPipeline* pipeline = (struct PcmPipeline *)arg;
+  struct PcmBlock* block;
+
+  while (1) {
+    block = (struct PcmBlock *)ALARingBuffer_Pop(pipeline->filled_blocks);
+    if (block->num_samples == 0) {
+      break;
+    }
+    /* 失敗した後も、デコード側を止めないようにブロックは戻し続ける */
+    if (!PcmPipeline_GetFlag(pipeline, &pipeline->error)
+        && (WAVStreamWriter_PutInterleavedPcmData(pipeline->writer,
+            block->bytes, block->num_samples) != WAV_APIRESULT_OK)) {
+      PcmPipeline_SetFlag(pipeline, &pipeline->error);
+    }
+    ALARingBuffer_Push(pipeline->free_blocks, block);
+  }
+
+  return NULL;
+}
+
+/* 読み込みスレッドの起動 成功時は0、失敗時は0以外を返す */
+static int PcmPipeline_StartReader(struct PcmPipeline* pipeline,
+    struct WAVStreamReader* reader, uint32_t shift)
+{
+  pipeline->reader  = reader;
+  pipeline->shift   = shift;
+  return pthread_create(&pipeline->thread, NULL, PcmPipeline_ReaderThread, pipeline);
+}
+
+/* 読み込み済みブロックの取得（エンコード時） 使い終わったらPcmPipeline_ReleaseBlockで戻す */
+static struct PcmBlock* PcmPipeline_GetFilledBlock(struct PcmPipeline* pipeline)
+{
+  struct PcmBlock* block = (struct PcmBlock *)ALARingBuffer_Pop(pipeline->filled_blocks);
+  if (block->num_samples == 0) {
+    pipeline->end_of_data = 1;
+  }
+  return block;
+}
+
+/* ブロックを読み込みスレッドに戻す（エンコード時） */
+static void PcmPipeline_ReleaseBlock(struct PcmPipeline* pipeline, struct PcmBlock* block)
+{
+  ALARingBuffer_Push(pipeline->free_blocks, block);
+}
+
+/* 読み込みスレッドの終了待ち 途中で終える場合は読み込みを中断させる */
+static void PcmPipeline_StopReader(struct PcmPipeline* pipeline)
+{
+  PcmPipeline_SetFlag(pipeline, &pipeline->stop);
+  while (!pipeline->end_of_data) {
+    PcmPipeline_ReleaseBlock(pipeline, PcmPipeline_GetFilledBlock(pipeline));
+  }
+  pthread_join(pipeline->thread, NULL);
+}
+
+/* 書き出しスレッドの起動 成功時は0、失敗時は0以外を返す */
+static int PcmPipeline_StartWriter(struct PcmPipeline* pipeline, struct WAVStreamWriter* writer)
+{
+  pipeline->writer = writer;
+  return pthread_create(&pipeline->thread, NULL, PcmPipeline_WriterThread, pipeline);
+}
+
+/* 空きブロックの取得（デコード時） 埋めたらPcmPipeline_PutBlockで書き出しスレッドに渡す */
+static struct PcmBlock* PcmPipeline_GetFreeBlock(struct PcmPipeline* pipeline)
+{
+  return (struct PcmBlock *)ALARingBuffer_Pop(pipeline->free_blocks);
+}
+
+/* ブロックを書き出しスレッドに渡す（デコード時） */
+static void PcmPipeline_PutBlock(struct PcmPipeline* pipeline, struct PcmBlock* block)
+{
+  ALARingBuffer_Push(pipeline->filled_blocks, block);
+}
+
+/* 書き出しスレッドの終了待ち 書き出しに失敗していたら0以外を返す */
+/* blockは取得済みの空きブロックで、終端ブロックとして渡す */
+static int PcmPipeline_StopWriter(struct PcmPipeline* pipeline, struct PcmBlock* block)
+{
+  block->num_samples = 0;
+  PcmPipeline_PutBlock(pipeline, block);
+  pthread_join(pipeline->thread, NULL);
+
+  return pipeline->error;
+}
+
+/* ワーカのエンコーダハンドル取得 容量が足りなければ作り直す */
+static struct ALAEncoder* EncodeWorker_GetEncoder(
+    struct EncodeWorker* worker, uint32_t num_channels)
+{
+  if ((worker->encoder == NULL) || (worker->config.max_num_channels < num_channels)) {
+    ALAEncoder_Destroy(worker->encoder);
+    worker->config.max_num_channels           = ALAUTILITY_MAX(num_channels, ALA_BATCH_MIN_NUM_CHANNELS);
+    worker->config.max_num_samples_per_block  = ALA_MAX_NUM_SAMPLES_PER_BLOCK;
+    worker->config.max_parcor_order           = ALA_MAX_PARCOR_ORDER;
+    worker->config.max_lms_num_taps           = ALA_LMS_MAX_NUM_TAPS;
+    worker->encoder = ALAEncoder_Create(&worker->config);
+  }
+
+  return worker->encoder;
+}
+
+/* 途中で失敗した出力ファイルを消す（標準出力やデバイスなど通常ファイル以外は何もしない） */
+static void remove_partial_output(const char* out_filename)
+{
+  struct stat st;
+
+  if ((strcmp(out_filename, "-") != 0)
+      && (stat(out_filename, &st) == 0) && S_ISREG(st.st_mode)) {
+    (void)remove(out_filename);
+  }
+}
+
+/* 1ファイルのエンコード 成功時は0、失敗時は0以外を返す */
+/* timingがNULLでなければブロック毎のエンコード時間を記録する */
+static int encode_file(struct EncodeWorker* worker,
+    const char* in_filename, const char* out_filename,
+    int show_progress, struct EncodeResult* result, struct BlockTiming* timing)
+{
+  struct WAVStreamReader* in_wav;
+  struct WAVFileFormat    wav_format;
+  struct BitStream*       out_strm;
+  struct ALAEncoder*      encoder;
+  struct ALAHeaderInfo    header;
+  struct ALAEncodeParameter parameter;
+  const struct EncodePreset* preset = &worker->preset;
+  struct PcmPipeline* pipeline;
+  struct PcmBlock*    block;
+  ALAEncoderApiResult enc_ret;
+  uint32_t    ch;
+  uint32_t    num_channels;
+  uint64_t    enc_offset_sample;
+  uint32_t    num_block;
+  double      start_time = 0.0f;
 
   /* WAVファイルオープン */
-  if ((in_wav = WAV_CreateFromFile(in_filename)) == NULL) {
+  if ((in_wav = WAVStreamReader_Open(in_filename)) == NULL) {
     fprintf(stderr, "Failed to open %s. \n", in_filename);
     return 1;
   }
+  WAVStreamReader_GetFormat(in_wav, &wav_format);
+
+  /* 16bitよりも大きい量子化ビットの波形はエンコード不可 */
+  if (wav_format.bits_per_sample > 16) {
+    fprintf(stderr, "Unsupported bit-width(%d) \n", wav_format.bits_per_sample);
+    WAVStreamReader_Close(in_wav);
+    return 1;
+  }
 
   /* 出力ファイルオープン */
   if ((out_strm = BitStream_Open(out_filename, "wb", NULL, 0)) == NULL) {
     fprintf(stderr, "Failed to open %s. \n", out_filename);
+    WAVStreamReader_Close(in_wav);
     return 1;
   }
 
-  /* 16bitよりも大きい量子化ビットの波形はエンコード不可 */
-  if (in_wav->format.bits_per_sample > 16) {
-    fprintf(stderr, "Unsupported bit-width(%d) \n", in_wav->format.bits_per_sample);
-    return 1;
+  /* 頻繁に使用する変数をオート変数に受けておく */
+  num_channels = wav_format.num_channels;
+
+  /* サンプル数が分からない場合は進捗を表示しない */
+  if (wav_format.num_samples == WAV_NUM_SAMPLES_UNKNOWN) {
+    show_progress = 0;
   }
 
-  /* 頻繁に使用する変数をオート変数に受けておく */
-  num_channels  = in_wav->format.num_channels;
-  num_samples   = in_wav->format.num_samples;
-
-  /* 領域割当て */
-  input             = (double **)malloc(sizeof(double *) * num_channels);
-  input_int32       = (int32_t **)malloc(sizeof(int32_t *) * num_channels);
-  input_ptr         = (double **)malloc(sizeof(double *) * num_channels);
-  input_int32_ptr   = (int32_t **)malloc(sizeof(int32_t *) * num_channels);
-  residual          = (int32_t **)malloc(sizeof(int32_t *) * num_channels);
-  parcor_coef       = (double **)malloc(sizeof(double *) * num_channels);
-  parcor_coef_int32 = (int32_t **)malloc(sizeof(int32_t *) * num_channels);
-  for (ch = 0; ch < num_channels; ch++) {
-    input[ch]       = (double *)malloc(sizeof(double) * num_samples);
-    input_int32[ch] = (int32_t *)malloc(sizeof(int32_t) * num_samples);
-    residual[ch]    = (int32_t *)malloc(sizeof(int32_t) * ALA_NUM_SAMPLES_PER_BLOCK);
-    parcor_coef[ch] = (double *)malloc(sizeof(double) * (ALA_PARCOR_ORDER + 1));
-    parcor_coef_int32[ch] = (int32_t *)malloc(sizeof(int32_t) * (ALA_PARCOR_ORDER + 1));
-  }
-  window = (double *)malloc(sizeof(double) * ALA_NUM_SAMPLES_PER_BLOCK);
-
-  /* 分析合成ハンドル作成 */
-  lpcc = ALALPCCalculator_Create(ALA_PARCOR_ORDER);
-  lpcs = ALALPCSynthesizer_Create(ALA_PARCOR_ORDER);
-
-  /* 残差符号化ハンドル作成 */
-  coder = ALACoder_Create(num_channels);
-
-  /* 入力データ取得 */
-  for (ch = 0; ch < num_channels; ch++) {
-    for (smpl = 0; smpl < num_samples; smpl++) {
-      input[ch][smpl] = WAVFile_PCM(in_wav, smpl, ch) * pow(2, -31);
-      input_int32[ch][smpl] = WAVFile_PCM(in_wav, smpl, ch);
-      /* 情報が失われない程度に右シフト */
-      input_int32[ch][smpl] >>= (32 - in_wav->format.bits_per_sample);
-    }
+  /* エンコーダハンドルの取得 */
+  encoder = EncodeWorker_GetEncoder(worker, num_channels);
+
+  /* 読み込みスレッドとのパイプライン作成 */
+  pipeline = PcmPipeline_Create(worker->num_pipeline_blocks, num_channels, preset->num_samples_per_block, 0);
+
+  /* エンコードパラメータの設定 */
+  parameter.num_window_trials             = preset->num_window_trials;
+  parameter.enable_channel_process_search = preset->enable_channel_process_search;
+  parameter.max_reference_offset          = preset->max_reference_offset;
+  parameter.max_ltp_lag                   = preset->max_ltp_lag;
+  parameter.enable_rans                   = preset->enable_rans;
+  if (ALAEncoder_SetEncodeParameter(encoder, &parameter) != ALAENCODER_APIRESULT_OK) {
+    fprintf(stderr, "Failed to set encode parameter. \n");
+    goto EXIT_FAILURE_WITH_DATA_RELEASE;
   }
 
   /* ヘッダの書き出し */
-  /* シグネチャ */
-  BitStream_PutBits(out_strm,  8, 'A');
-  BitStream_PutBits(out_strm,  8, 'L');
-  BitStream_PutBits(out_strm,  8, 'A');
-  BitStream_PutBits(out_strm,  8, '\0');
-  /* フォーマットバージョン */
-  BitStream_PutBits(out_strm, 16, ALA_FORMAT_VERSION);
-  /* チャンネル数 */
-  BitStream_PutBits(out_strm,  8, num_channels);
-  /* サンプル数 */
-  BitStream_PutBits(out_strm, 32, num_samples);
-  /* サンプリングレート */
-  BitStream_PutBits(out_strm, 32, in_wav->format.sampling_rate);
-  /* サンプルあたりbit数 */
-  BitStream_PutBits(out_strm,  8, in_wav->format.bits_per_sample);
-  /* ブロックあたりサンプル数 */
-  BitStream_PutBits(out_strm, 16, ALA_NUM_SAMPLES_PER_BLOCK);
-  /* PARCOR係数次数 */
-  BitStream_PutBits(out_strm,  8, ALA_PARCOR_ORDER);
+  header.num_channels           = num_channels;
+  header.num_samples            = (wav_format.num_samples == WAV_NUM_SAMPLES_UNKNOWN)
+                                  ? ALA_NUM_SAMPLES_UNKNOWN : wav_format.num_samples;
+  header.sampling_rate          = wav_format.sampling_rate;
+  header.bits_per_sample        = wav_format.bits_per_sample;
+  header.num_samples_per_block  = preset->num_samples_per_block;
+  header.parcor_order           = preset->parcor_order;
+  header.emphasis_shift         = preset->emphasis_shift;
+  header.low_latency            = preset->low_latency;
+  header.num_lms_stages         = lms_levels[preset->lms_level].num_stages;
+  for (ch = 0; ch < ALA_MAX_NUM_LMS_STAGES; ch++) {
+    header.lms_num_taps[ch]     = lms_levels[preset->lms_level].num_taps[ch];
+    header.lms_shift[ch]        = lms_levels[preset->lms_level].shift[ch];
+  }
+  if (ALAEncoder_EncodeHeader(encoder, &header, out_strm) != ALAENCODER_APIRESULT_OK) {
+    fprintf(stderr, "Failed to encode header. \n");
+    goto EXIT_FAILURE_WITH_DATA_RELEASE;
+  }
+
+  /* 読み込みスレッドの起動 */
+  /* 以降は読み込みスレッドが先読みしたブロックを順に残差計算/符号化する */
+  if (PcmPipeline_StartReader(pipeline, in_wav, 32 - wav_format.bits_per_sample) != 0) {
+    fprintf(stderr, "Failed to create thread. \n");
+    goto EXIT_FAILURE_WITH_DATA_RELEASE;
+  }
 
   /* ブロック単位で残差計算/符号化 */
   enc_offset_sample = 0;
-  while (enc_offset_sample < num_samples) {
+  num_block = 0;
+  while (1) {
     uint32_t num_encode_samples;
 
-    /* エンコードするサンプル数の決定 */
-    num_encode_samples = ALAUTILITY_MIN(ALA_NUM_SAMPLES_PER_BLOCK, num_samples - enc_offset_sample);
-
-    /* 処理位置にポインタを設定 */
-    for (ch = 0; ch < num_channels; ch++) {
-      input_ptr[ch]       = &input[ch][enc_offset_sample];
-      input_int32_ptr[ch] = &input_int32[ch][enc_offset_sample];
+    /* 入力データ取得 */
+    block = PcmPipeline_GetFilledBlock(pipeline);
+    num_encode_samples = block->num_samples;
+    if (block->error != 0) {
+      fprintf(stderr, "Failed to read %s. \n", in_filename);
+      goto EXIT_FAILURE_WITH_THREAD_STOP;
     }
-
-    /* ステレオチャンネル以上ならばMS処理を行う */
-    if (num_channels >= 2) {
-      ALAChannelDecorrelator_LRtoMSDouble(input_ptr, num_channels, num_encode_samples);
-      ALAChannelDecorrelator_LRtoMSInt32(input_int32_ptr, num_channels, num_encode_samples);
+    /* データ終端 */
+    if (num_encode_samples == 0) {
+      break;
     }
 
-    /* 窓の作成 */
-    ALAUtility_MakeSinWindow(window, num_encode_samples);
-    /* 窓掛け */
-    for (ch = 0; ch < num_channels; ch++) {
-      ALAUtility_ApplyWindow(window, input_ptr[ch], num_encode_samples);
+    /* ブロックエンコード */
+    if (timing != NULL) {
+      start_time = get_current_time();
     }
-
-    /* PARCOR係数の導出 */
-    for (ch = 0; ch < num_channels; ch++) {
-      /* プリエンファシス */
-      ALAEmphasisFilter_PreEmphasisDouble(
-          input_ptr[ch], num_encode_samples, ALA_EMPHASIS_FILTER_SHIFT);
-      if (ALALPCCalculator_CalculatePARCORCoefDouble(lpcc,
-            input_ptr[ch], num_encode_samples,
-            parcor_coef[ch], ALA_PARCOR_ORDER) != ALAPREDICTOR_APIRESULT_OK) {
-        fprintf(stderr, "Failed to calculate PARCOR coefficients. \n");
-        return 1;
+    if ((enc_ret = ALAEncoder_EncodeBlock(encoder,
+          (const int32_t **)block->data, num_encode_samples, out_strm)) != ALAENCODER_APIRESULT_OK) {
+      if (enc_ret == ALAENCODER_APIRESULT_IOERROR) {
+        fprintf(stderr, "Failed to write %s. \n", out_filename);
+      } else {
+        fprintf(stderr, "Failed to encode block. \n");
       }
+      PcmPipeline_ReleaseBlock(pipeline, block);
+      goto EXIT_FAILURE_WITH_THREAD_STOP;
     }
+    if (timing != NULL) {
+      BlockTiming_Add(timing, get_current_time() - start_time);
+    }
+    PcmPipeline_ReleaseBlock(pipeline, block);
 
-    /* PARCOR係数量子化 */
-    for (ch = 0; ch < num_channels; ch++) {
-      /* PARCOR係数の0次成分は0.0のはずなので処理をスキップ */
-      parcor_coef_int32[ch][0] = 0;
-      for (ord = 0; ord < ALA_PARCOR_ORDER; ord++) {
-        /* 整数へ丸める */
-        parcor_coef_int32[ch][ord]
-          = (int32_t)ALAUtility_Round(parcor_coef[ch][ord] * pow(2.0f, 15));
-        /* roundによる丸めによりビット幅をはみ出てしまうことがあるので範囲制限 */
-        parcor_coef_int32[ch][ord] 
-          = ALAUTILITY_INNER_VALUE(parcor_coef_int32[ch][ord], INT16_MIN, INT16_MAX);
-      }
+    /* エンコードしたサンプル分進める */
+    enc_offset_sample += num_encode_samples;
+    num_block++;
+
+    /* 進捗を表示 */
+    if ((show_progress != 0) && ((num_block % 10) == 0)) {
+      printf("Progress... %4.1f %%\r", 100.0f * (double)enc_offset_sample / (double)wav_format.num_samples);
+      fflush(stdout);
     }
+  }
 
-    /* 残差計算 */
-    /* プリエンファシスフィルタ */
-    for (ch = 0; ch < num_channels; ch++) {
-      if (ALAEmphasisFilter_PreEmphasisInt32(input_int32_ptr[ch],
-            num_encode_samples, ALA_EMPHASIS_FILTER_SHIFT) != ALAPREDICTOR_APIRESULT_OK) {
-        fprintf(stderr, "Failed to apply pre-emphasis. \n");
-        return 1;
+  /* 読み込みスレッドの終了待ち */
+  PcmPipeline_StopReader(pipeline);
+
+  /* ストリーム終端の書き出し */
+  if ((enc_ret = ALAEncoder_EncodeEndOfStream(encoder, out_strm)) != ALAENCODER_APIRESULT_OK) {
+    if (enc_ret == ALAENCODER_APIRESULT_IOERROR) {
+      fprintf(stderr, "Failed to write %s. \n", out_filename);
+    } else {
+      fprintf(stderr, "Failed to encode end of stream. \n");
+    }
+    goto EXIT_FAILURE_WITH_DATA_RELEASE;
+  }
+
+  /* 結果の記録 */
+  if (result != NULL) {
+    result->num_samples   = enc_offset_sample;
+    result->sampling_rate = wav_format.sampling_rate;
+  }
+
+  /* 領域開放 */
+  PcmPipeline_Destroy(pipeline);
+  WAVStreamReader_Close(in_wav);
+
+  /* 出力のクローズ 残りの書き出しに失敗したら出力は途中で切れている */
+  if (BitStream_Close(out_strm) != BITSTREAM_APIRESULT_OK) {
+    fprintf(stderr, "Failed to write %s. \n", out_filename);
+    remove_partial_output(out_filename);
+    return 1;
+  }
+
+  return 0;
+
+EXIT_FAILURE_WITH_THREAD_STOP:
+  PcmPipeline_StopReader(pipeline);
+EXIT_FAILURE_WITH_DATA_RELEASE:
+  PcmPipeline_Destroy(pipeline);
+  WAVStreamReader_Close(in_wav);
+  (void)BitStream_Close(out_strm);
+  remove_partial_output(out_filename);
+  return 1;
+}
+
+/* エンコード 成功時は0、失敗時は0以外を返す */
+int do_encode(const char* in_filename, const char* out_filename,
+    const struct EncodePreset* preset, uint32_t num_pipeline_blocks)
+{
+  int ret;
+  struct EncodeWorker worker;
+
+  /* 標準出力に書き出すときは進捗を表示しない */
+  worker.encoder   = NULL;
+  worker.preset    = (*preset);
+  worker.num_pipeline_blocks = num_pipeline_blocks;
+  ret = encode_file(&worker, in_filename, out_filename, strcmp(out_filename, "-") != 0, NULL, NULL);
+  ALAEncoder_Destroy(worker.encoder);
+
+  return ret;
+}
+
+/* バッチモードのジョブ処理関数 */
+static void batch_encode_job(void* worker_context, void* job)
+{
+  struct EncodeWorker*  worker = (struct EncodeWorker *)worker_context;
+  struct BatchJob*      batch_job = (struct BatchJob *)job;
+
+  batch_job->result.error
+    = encode_file(worker, batch_job->in_filename, batch_job->out_filename, 0, &batch_job->result, NULL);
+  if (batch_job->result.error == 0) {
+    batch_job->result.output_size = get_file_size(batch_job->out_filename);
+  } else {
+    fprintf(stderr, "Failed to encode %s. \n", batch_job->in_filename);
+  }
+}
+
+/* ファイル名が拡張子extensionで終わるか？ */
+static int has_extension(const char* filename, const char* extension)
+{
+  size_t length = strlen(filename), extension_length = strlen(extension);
+  return (length > extension_length) && (strcmp(&filename[length - extension_length], extension) == 0);
+}
+
+/* 文字列の複製 */
+static char* duplicate_string(const char* string)
+{
+  char* ret = (char *)malloc(strlen(string) + 1);
+  strcpy(ret, string);
+  return ret;
+}
+
+/* ジョブの追加 出力ファイル名は入力ファイル名の拡張子を.alaにしてout_dirに置く */
+static void add_batch_job(struct BatchJob** jobs, uint32_t* num_jobs, uint32_t* capacity,
+    const char* in_filename, const char* out_dir)
+{
+  const char* basename;
+  const char* extension;
+  size_t      basename_length;
+  struct BatchJob* job;
+
+  /* 配列の拡張 */
+  if (*num_jobs >= *capacity) {
+    *capacity = ALAUTILITY_MAX(2 * (*capacity), 16);
+    *jobs = (struct BatchJob *)realloc(*jobs, sizeof(struct BatchJob) * (*capacity));
+  }
+
+  /* ディレクトリ部と拡張子を除いたファイル名 */
+  basename = strrchr(in_filename, '/');
+  basename = (basename != NULL) ? (basename + 1) : in_filename;
+  extension = strrchr(basename, '.');
+  basename_length = (extension != NULL) ? (size_t)(extension - basename) : strlen(basename);
+
+  job = &(*jobs)[*num_jobs];
+  job->in_filename  = duplicate_string(in_filename);
+  job->out_filename = (char *)malloc(strlen(out_dir) + 1 + basename_length + strlen(".ala") + 1);
+  strcpy(job->out_filename, out_dir);
+  strcat(job->out_filename, "/");
+  strncat(job->out_filename, basename, basename_length);
+  strcat(job->out_filename, ".ala");
+  memset(&job->result, 0, sizeof(struct EncodeResult));
+  job->result.error = 1;
+  job->result.input_size = get_file_size(in_filename);
+  (*num_jobs)++;
+}
+
+/* 入力（ディレクトリかファイルリスト）からジョブを収集 成功時は0、失敗時は0以外を返す */
+static int collect_batch_jobs(const char* input, const char* out_dir,
+    struct BatchJob** jobs, uint32_t* num_jobs)
+{
+  uint32_t    capacity = 0;
+  struct stat st;
+
+  *jobs     = NULL;
+  *num_jobs = 0;
+
+  if (stat(input, &st) != 0) {
+    fprintf(stderr, "Failed to open %s. \n", input);
+    return 1;
+  }
+
+  if (S_ISDIR(st.st_mode)) {
+    /* ディレクトリ内の.wav/.w64ファイルを全て対象とする */
+    DIR*            dir;
+    struct dirent*  entry;
+    char*           path;
+    if ((dir = opendir(input)) == NULL) {
+      fprintf(stderr, "Failed to open %s. \n", input);
+      return 1;
+    }
+    while ((entry = readdir(dir)) != NULL) {
+      size_t length = strlen(entry->d_name);
+      if (!has_extension(entry->d_name, ".wav") && !has_extension(entry->d_name, ".w64")) {
+        continue;
       }
+      path = (char *)malloc(strlen(input) + 1 + length + 1);
+      strcpy(path, input);
+      strcat(path, "/");
+      strcat(path, entry->d_name);
+      add_batch_job(jobs, num_jobs, &capacity, path, out_dir);
+      free(path);
     }
-    /* PARCOR予測フィルタ */
-    for (ch = 0; ch < num_channels; ch++) {
-      if (ALALPCSynthesizer_PredictByParcorCoefInt32(lpcs, 
-            input_int32_ptr[ch], num_encode_samples,
-            parcor_coef_int32[ch], ALA_PARCOR_ORDER, residual[ch]) != ALAPREDICTOR_APIRESULT_OK) {
-        fprintf(stderr, "Failed to predict parcor filter. \n");
-        return 1;
+    closedir(dir);
+  } else {
+    /* 1行1ファイルのリスト */
+    FILE* fp;
+    char  line[FILENAME_MAX + 2];
+    if ((fp = fopen(input, "r")) == NULL) {
+      fprintf(stderr, "Failed to open %s. \n", input);
+      return 1;
+    }
+    while (fgets(line, sizeof(line), fp) != NULL) {
+      /* 末尾の改行を除去 */
+      size_t length = strlen(line);
+      while ((length > 0) && ((line[length - 1] == '\n') || (line[length - 1] == '\r'))) {
+        line[--length] = '\0';
       }
+      if (length == 0) {
+        continue;
+      }
+      add_batch_job(jobs, num_jobs, &capacity, line, out_dir);
     }
+    fclose(fp);
+  }
 
-    /* ブロック符号化 */
-    /* ブロック先頭を示す同期コード */
-    BitStream_PutBits(out_strm, 16, 0xFFFF);
-    /* 各チャンネルのPARCOR係数 */
-    for (ch = 0; ch < num_channels; ch++) {
-      /* 0次係数は0だから飛ばす */
-      for (ord = 1; ord < ALA_PARCOR_ORDER + 1; ord++) {
-        BitStream_PutBits(out_strm, 16, ALAUTILITY_SINT32_TO_UINT32(parcor_coef_int32[ch][ord]));
-      }
+  return 0;
+}
+
+/* ジョブ配列の開放 */
+static void free_batch_jobs(struct BatchJob* jobs, uint32_t num_jobs)
+{
+  uint32_t i;
+
+  for (i = 0; i < num_jobs; i++) {
+    free(jobs[i].in_filename);
+    free(jobs[i].out_filename);
+  }
+  free(jobs);
+}
+
+/* 出力ファイル名の比較（qsort用） */
+static int compare_batch_job_output(const void* a, const void* b)
+{
+  return strcmp((*(const struct BatchJob* const *)a)->out_filename,
+      (*(const struct BatchJob* const *)b)->out_filename);
+}
+
+/* 出力ファイル名が重複するジョブがないか確認 重複がなければ0、あれば0以外を返す */
+/* 拡張子だけが異なる入力（x.wavとx.w64）や別ディレクトリの同名ファイルは同じ出力名になり、後の出力が上書きしてしまう */
+static int check_batch_job_outputs(const struct BatchJob* jobs, uint32_t num_jobs)
+{
+  uint32_t i;
+  int      num_collisions = 0;
+  const struct BatchJob** sorted;
+
+  sorted = (const struct BatchJob **)malloc(sizeof(const struct BatchJob *) * num_jobs);
+  for (i = 0; i < num_jobs; i++) {
+    sorted[i] = &jobs[i];
+  }
+  qsort(sorted, num_jobs, sizeof(const struct BatchJob *), compare_batch_job_output);
+
+  /* 並べると重複は隣り合う */
+  for (i = 1; i < num_jobs; i++) {
+    if (strcmp(sorted[i - 1]->out_filename, sorted[i]->out_filename) == 0) {
+      fprintf(stderr, "%s and %s would both be written to %s. \n",
+          sorted[i - 1]->in_filename, sorted[i]->in_filename, sorted[i]->out_filename);
+      num_collisions++;
     }
-    /* 残差符号化 */
-    ALACoder_PutDataArray(coder, out_strm, 
-        (const int32_t **)residual, num_channels, num_encode_samples);
+  }
 
-    /* バイト境界に揃える */
-    BitStream_Flush(out_strm);
+  free(sorted);
+  return num_collisions;
+}
 
-    /* エンコードしたサンプル分進める */
-    enc_offset_sample += num_encode_samples;
+/* バッチエンコード 全ファイル成功時は0、失敗時は0以外を返す */
+int do_batch_encode(const char* input, const char* out_dir, uint32_t num_threads,
+    const struct EncodePreset* preset, uint32_t num_pipeline_blocks)
+{
+  uint32_t  i, num_jobs, num_failed;
+  uint64_t  total_samples, total_input_size, total_output_size;
+  double    total_duration, start_time, elapsed_time;
+  struct BatchJob*      jobs;
+  struct ALAScheduler*  scheduler;
+  struct EncodeWorker*  workers;
+  void**                worker_contexts;
 
-    /* 進捗を表示 */
-    if ((enc_offset_sample % (10 * ALA_NUM_SAMPLES_PER_BLOCK)) == 0) {
-      printf("Progress... %4.1f %%\r", 100.0f * (double)enc_offset_sample / num_samples);
-      fflush(stdout);
+  /* ジョブ収集 */
+  if (collect_batch_jobs(input, out_dir, &jobs, &num_jobs) != 0) {
+    return 1;
+  }
+  if (num_jobs == 0) {
+    fprintf(stderr, "No input files. \n");
+    free_batch_jobs(jobs, num_jobs);
+    return 1;
+  }
+  if (check_batch_job_outputs(jobs, num_jobs) != 0) {
+    free_batch_jobs(jobs, num_jobs);
+    return 1;
+  }
+
+  /* スケジューラ作成/ジョブ登録 */
+  scheduler = ALAScheduler_Create(num_threads, num_jobs);
+  for (i = 0; i < num_jobs; i++) {
+    ALAScheduler_AddJob(scheduler, &jobs[i], jobs[i].result.input_size);
+  }
+
+  /* ワーカのコンテキスト作成（エンコーダハンドルは最初のジョブで作成） */
+  workers         = (struct EncodeWorker *)malloc(sizeof(struct EncodeWorker) * num_threads);
+  worker_contexts = (void **)malloc(sizeof(void *) * num_threads);
+  for (i = 0; i < num_threads; i++) {
+    workers[i].encoder    = NULL;
+    workers[i].preset     = (*preset);
+    workers[i].num_pipeline_blocks = num_pipeline_blocks;
+    worker_contexts[i]  = &workers[i];
+  }
+
+  /* 実行 */
+  start_time = get_current_time();
+  if (ALAScheduler_Run(scheduler, batch_encode_job, worker_contexts) == ALASCHEDULER_APIRESULT_INVALID_ARGUMENT) {
+    fprintf(stderr, "Failed to run jobs. \n");
+  }
+  elapsed_time = get_current_time() - start_time;
+
+  /* 集計 */
+  num_failed = 0;
+  total_samples = total_input_size = total_output_size = 0;
+  total_duration = 0.0f;
+  for (i = 0; i < num_jobs; i++) {
+    if (jobs[i].result.error != 0) {
+      num_failed++;
+      continue;
     }
+    total_samples     += jobs[i].result.num_samples;
+    total_input_size  += jobs[i].result.input_size;
+    total_output_size += jobs[i].result.output_size;
+    total_duration    += (double)jobs[i].result.num_samples / jobs[i].result.sampling_rate;
+  }
+
+  /* 集計結果の表示 */
+  printf("Files:      %u encoded, %u failed (%u threads) \n", num_jobs - num_failed, num_failed, num_threads);
+  printf("Samples:    %.0f (%.1f sec of audio) \n", (double)total_samples, total_duration);
+  printf("Size:       %.0f -> %.0f bytes (%.2f %%) \n",
+      (double)total_input_size, (double)total_output_size,
+      (total_input_size > 0) ? (100.0f * (double)total_output_size / (double)total_input_size) : 0.0f);
+  printf("Time:       %.3f sec \n", elapsed_time);
+  if (elapsed_time > 0.0f) {
+    printf("Throughput: %.2f MB/s, %.1fx realtime \n",
+        (double)total_input_size / (1024.0f * 1024.0f) / elapsed_time, total_duration / elapsed_time);
   }
 
   /* 領域開放 */
-  for (ch = 0; ch < num_channels; ch++) {
-    free(input[ch]);
-    free(input_int32[ch]);
-    free(residual[ch]);
-    free(parcor_coef[ch]);
-    free(parcor_coef_int32[ch]);
-  }
-  free(input);
-  free(input_int32);
-  free(input_ptr);
-  free(input_int32_ptr);
-  free(residual);
-  free(parcor_coef);
-  free(parcor_coef_int32);
-  free(window);
-
-  /* ハンドル破棄 */
-  ALALPCCalculator_Destroy(lpcc);
-  ALALPCSynthesizer_Destroy(lpcs);
-  ALACoder_Destroy(coder);
-  WAV_Destroy(in_wav);
-  BitStream_Close(out_strm);
+  for (i = 0; i < num_threads; i++) {
+    ALAEncoder_Destroy(workers[i].encoder);
+  }
+  free_batch_jobs(jobs, num_jobs);
+  free(workers);
+  free(worker_contexts);
+  ALAScheduler_Destroy(scheduler);
 
-  return 0;
+  return (num_failed == 0) ? 0 : 1;
 }
 
 /* デコード 成功時は0、失敗時は0以外を返す */
-int do_decode(const char* in_filename, const char* out_filename)
-{
-  struct BitStream*         in_strm;
-  struct WAVFile*           out_wav;
-  struct WAVFileFormat      wav_format;
-  struct ALALPCSynthesizer* lpcs;
-  struct ALACoder*          coder;
-  uint32_t  ch, smpl, ord;
-  uint64_t  bitsbuf;
-  uint32_t  parcor_order;
-  uint32_t  num_block_samples;
-  uint32_t  num_channels, num_samples;
-  uint32_t  dec_offset_sample;
-  int32_t** parcor_coef;
-  int32_t** residual;
-  int32_t** output;
+int do_decode(const char* in_filename, const char* out_filename, uint32_t num_pipeline_blocks)
+{
+  struct BitStream*       in_strm;
+  struct WAVStreamWriter* out_wav;
+  struct WAVFileFormat    wav_format;
+  struct ALADecoder*      decoder;
+  struct ALADecoderConfig config;
+  struct ALAHeaderInfo    header;
+  ALADecoderApiResult     ret;
+  struct PcmPipeline*     pipeline;
+  struct PcmBlock*        block;
+  uint32_t    num_channels, bytes_per_frame;
+  uint64_t    dec_offset_sample;
+  uint32_t    num_block;
+  int         show_progress, failed;
 
   /* 入力ファイルオープン */
   if ((in_strm = BitStream_Open(in_filename, "rb", NULL, 0)) == NULL) {
@@ -280,154 +929,320 @@ int do_decode(const char* in_filename, const char* out_filename)
   }
 
   /* ヘッダの読み出し */
-  /* シグネチャ */
-  BitStream_GetBits(in_strm, 32, &bitsbuf);
-  /* シグネチャの確認 */
-  if (   (((bitsbuf >> 24) & 0xFF) != 'A')
-      || (((bitsbuf >> 16) & 0xFF) != 'L')
-      || (((bitsbuf >>  8) & 0xFF) != 'A')
-      || (((bitsbuf >>  0) & 0xFF) != '\0')) {
-    fprintf(stderr, "Invalid signature. \n");
+  if (ALADecoder_DecodeHeader(in_strm, &header) != ALADECODER_APIRESULT_OK) {
+    fprintf(stderr, "Invalid header. \n");
+    BitStream_Close(in_strm);
     return 1;
   }
-  /* フォーマットバージョン */
-  BitStream_GetBits(in_strm, 16, &bitsbuf);
-  /* シグネチャの確認 */
-  if (bitsbuf != ALA_FORMAT_VERSION) {
-    fprintf(stderr, "Unsupported format version:%d \n", (uint16_t)bitsbuf);
-    return 1;
-  }
-  /* チャンネル数 */
-  BitStream_GetBits(in_strm,  8, &bitsbuf);
-  num_channels = wav_format.num_channels = (uint32_t)bitsbuf;
-  /* サンプル数 */
-  BitStream_GetBits(in_strm, 32, &bitsbuf);
-  num_samples = wav_format.num_samples = (uint32_t)bitsbuf;
-  /* サンプリングレート */
-  BitStream_GetBits(in_strm, 32, &bitsbuf);
-  wav_format.sampling_rate = (uint32_t)bitsbuf;
-  /* サンプルあたりbit数 */
-  BitStream_GetBits(in_strm,  8, &bitsbuf);
-  wav_format.bits_per_sample = (uint32_t)bitsbuf;
-  /* ブロックあたりサンプル数 */
-  BitStream_GetBits(in_strm, 16, &bitsbuf);
-  num_block_samples = (uint32_t)bitsbuf;
-  /* PARCOR係数次数 */
-  BitStream_GetBits(in_strm,  8, &bitsbuf);
-  parcor_order = (uint32_t)bitsbuf;
+  num_channels = header.num_channels;
 
   /* 出力wavハンドルの生成 */
-  wav_format.data_format  = WAV_DATA_FORMAT_PCM;
-  if ((out_wav = WAV_Create(&wav_format)) == NULL) {
-    fprintf(stderr, "Failed to create wav handle. \n");
+  wav_format.data_format      = WAV_DATA_FORMAT_PCM;
+  wav_format.num_channels     = num_channels;
+  wav_format.sampling_rate    = header.sampling_rate;
+  wav_format.bits_per_sample  = header.bits_per_sample;
+  wav_format.num_samples      = (header.num_samples == ALA_NUM_SAMPLES_UNKNOWN)
+                                ? WAV_NUM_SAMPLES_UNKNOWN : header.num_samples;
+  /* 拡張子が.w64ならW64、それ以外はRIFF（4GBを超えるとRF64）で書き出す */
+  wav_format.container        = has_extension(out_filename, ".w64") ? WAV_CONTAINER_W64 : WAV_CONTAINER_RIFF;
+  if ((out_wav = WAVStreamWriter_Open(out_filename, &wav_format)) == NULL) {
+    fprintf(stderr, "Failed to open %s. \n", out_filename);
+    BitStream_Close(in_strm);
     return 1;
   }
 
-  /* 変数領域割当て */
-  parcor_coef = (int32_t **)malloc(sizeof(int32_t*) * num_channels);
-  residual    = (int32_t **)malloc(sizeof(int32_t*) * num_channels);
-  output      = (int32_t **)malloc(sizeof(int32_t*) * num_channels);
-  for (ch = 0; ch < num_channels; ch++) {
-    parcor_coef[ch] = (int32_t *)malloc(sizeof(int32_t) * (parcor_order + 1));
-    residual[ch]    = (int32_t *)malloc(sizeof(int32_t) * num_block_samples);
-    output[ch]      = (int32_t *)malloc(sizeof(int32_t) * num_block_samples);
-  }
+  /* サンプル数が分からないときと標準出力に書き出すときは進捗を表示しない */
+  show_progress = (header.num_samples != ALA_NUM_SAMPLES_UNKNOWN) && (strcmp(out_filename, "-") != 0);
 
-  /* 合成ハンドル作成 */
-  lpcs  = ALALPCSynthesizer_Create(parcor_order);
-  /* 残差復号ハンドル作成 */
-  coder = ALACoder_Create(num_channels);
+  /* デコーダハンドル作成 */
+  config.max_num_channels           = num_channels;
+  config.max_num_samples_per_block  = header.num_samples_per_block;
+  config.max_parcor_order           = header.parcor_order;
+  config.max_lms_num_taps           = get_max_lms_num_taps(&header);
+  decoder = ALADecoder_Create(&config);
+  ALADecoder_SetHeader(decoder, &header);
+
+  /* 書き出しスレッドとのパイプライン作成/起動 */
+  /* デコード結果のブロックは書き出しスレッドが順にWAVに書き出す */
+  bytes_per_frame = num_channels * ((header.bits_per_sample + 7) / 8);
+  pipeline = PcmPipeline_Create(num_pipeline_blocks, num_channels, header.num_samples_per_block, bytes_per_frame);
+  if (PcmPipeline_StartWriter(pipeline, out_wav) != 0) {
+    fprintf(stderr, "Failed to create thread. \n");
+    PcmPipeline_Destroy(pipeline);
+    ALADecoder_Destroy(decoder);
+    BitStream_Close(in_strm);
+    WAVStreamWriter_Close(out_wav);
+    return 1;
+  }
 
   /* ブロックデコード */
   dec_offset_sample = 0;
-  while (dec_offset_sample < num_samples) {
+  num_block = 0;
+  failed = 0;
+  while (1) {
     uint32_t num_decode_samples;
 
-    /* 同期コード */
-    BitStream_GetBits(in_strm, 16, &bitsbuf);
-    if (bitsbuf != 0xFFFF) {
-      fprintf(stderr, "Failed to decode block: it's not sync code(=0x%4x). \n", (uint16_t)bitsbuf);
-      return 1;
-    }
-    /* PARCOR係数 */
-    for (ch = 0; ch < num_channels; ch++) {
-      parcor_coef[ch][0] = 0;
-      for (ord = 1; ord < parcor_order + 1; ord++) {
-        BitStream_GetBits(in_strm, 16, &bitsbuf);
-        parcor_coef[ch][ord] = (int32_t)ALAUTILITY_UINT32_TO_SINT32(bitsbuf);
-      }
-    }
-
-    /* デコードサンプル数の確定 */
-    num_decode_samples = ALAUTILITY_MIN(num_block_samples, num_samples - dec_offset_sample);
-
-    /* 残差復号 */
-    ALACoder_GetDataArray(coder, in_strm, residual, num_channels, num_decode_samples);
-
-    /* バイト境界に揃える */
-    BitStream_Flush(in_strm);
-
-    /* 残差から合成 */
-    /* PARCOR合成フィルタ */
-    for (ch = 0; ch < num_channels; ch++) {
-      if (ALALPCSynthesizer_SynthesizeByParcorCoefInt32(lpcs,
-            residual[ch], num_decode_samples,
-            parcor_coef[ch], parcor_order,
-            output[ch]) != ALAPREDICTOR_APIRESULT_OK) {
-        fprintf(stderr, "Failed to synthesize by parcor filter. \n");
-        return 1;
-      }
-    }
-    /* デエンファシスフィルタ */
-    for (ch = 0; ch < num_channels; ch++) {
-      if (ALAEmphasisFilter_DeEmphasisInt32(output[ch],
-            num_decode_samples, ALA_EMPHASIS_FILTER_SHIFT) != ALAPREDICTOR_APIRESULT_OK) {
-        fprintf(stderr, "Failed to apply de-emphasis. \n");
-        return 1;
-      }
+    /* 書き出しが終わったブロックにデコード */
+    block = PcmPipeline_GetFreeBlock(pipeline);
+    ret = ALADecoder_DecodeBlockInterleaved(decoder, in_strm,
+        block->bytes, bytes_per_frame * header.num_samples_per_block, &num_decode_samples);
+    if (ret == ALADECODER_APIRESULT_END_OF_STREAM) {
+      break;
+    } else if (ret != ALADECODER_APIRESULT_OK) {
+      fprintf(stderr, "Failed to decode block (offset:%.0f). \n", (double)dec_offset_sample);
+      failed = 1;
+      break;
     }
 
-    /* MS処理をしていたら元に戻す */
-    if (num_channels >= 2) {
-      ALAChannelDecorrelator_MStoLRInt32(output, num_channels, num_decode_samples);
+    /* 書き出しスレッドが失敗していたら打ち切る */
+    if (PcmPipeline_GetFlag(pipeline, &pipeline->error)) {
+      break;
     }
 
-    /* エンコード時に右シフトした分を戻す */
-    for (ch = 0; ch < num_channels; ch++) {
-      for (smpl = 0; smpl < num_decode_samples; smpl++) {
-        WAVFile_PCM(out_wav, dec_offset_sample + smpl, ch)
-          = output[ch][smpl] << (32 - wav_format.bits_per_sample);
-      }
-    }
+    /* WAVファイル書き出し（デコード結果はWAVの形式に詰めてある） */
+    block->num_samples = num_decode_samples;
+    PcmPipeline_PutBlock(pipeline, block);
 
     /* デコードしたサンプル分進める */
     dec_offset_sample += num_decode_samples;
+    num_block++;
 
     /* 進捗を表示 */
-    if ((dec_offset_sample % (10 * num_block_samples)) == 0) {
-      printf("Progress... %4.1f %%\r", 100.0f * (double)dec_offset_sample / num_samples);
+    if ((show_progress != 0) && ((num_block % 10) == 0)) {
+      printf("Progress... %4.1f %%\r", 100.0f * (double)dec_offset_sample / (double)header.num_samples);
       fflush(stdout);
     }
   }
 
-  /* WAVファイル書き出し */
-  if (WAV_WriteToFile(out_filename, out_wav) != WAV_APIRESULT_OK) {
+  /* 書き出しスレッドの終了待ち */
+  if (PcmPipeline_StopWriter(pipeline, block) != 0) {
     fprintf(stderr, "Failed to write wav file. \n");
+    failed = 1;
+  }
+
+  /* 領域開放 */
+  PcmPipeline_Destroy(pipeline);
+  ALADecoder_Destroy(decoder);
+  BitStream_Close(in_strm);
+
+  /* WAVファイルを閉じる */
+  if (WAVStreamWriter_Close(out_wav) != WAV_APIRESULT_OK) {
+    if (failed == 0) {
+      fprintf(stderr, "Failed to write wav file. \n");
+    }
     return 1;
   }
 
+  return failed;
+}
+
+/* 1ファイルの検証 デコード結果はメモリ上で捨て、CRC32だけを確認する */
+/* timingがNULLでなければブロック毎のデコード時間を記録する */
+static ALADecoderApiResult verify_file(const char* filename,
+    uint64_t* num_verified_samples, uint32_t* sampling_rate, struct BlockTiming* timing)
+{
+  struct BitStream*       in_strm;
+  struct ALADecoder*      decoder;
+  struct ALADecoderConfig config;
+  struct ALAHeaderInfo    header;
+  ALADecoderApiResult     ret;
+  uint32_t  ch, num_samples;
+  int32_t** output;
+  double    start_time;
+
+  *num_verified_samples = 0;
+
+  /* 入力ファイルオープン */
+  if ((in_strm = BitStream_Open(filename, "rb", NULL, 0)) == NULL) {
+    return ALADECODER_APIRESULT_NG;
+  }
+
+  /* ヘッダの読み出し */
+  if ((ret = ALADecoder_DecodeHeader(in_strm, &header)) != ALADECODER_APIRESULT_OK) {
+    BitStream_Close(in_strm);
+    return ret;
+  }
+  *sampling_rate = header.sampling_rate;
+
+  /* デコーダハンドル作成 */
+  config.max_num_channels           = header.num_channels;
+  config.max_num_samples_per_block  = header.num_samples_per_block;
+  config.max_parcor_order           = header.parcor_order;
+  config.max_lms_num_taps           = get_max_lms_num_taps(&header);
+  decoder = ALADecoder_Create(&config);
+  ALADecoder_SetHeader(decoder, &header);
+
+  /* 出力領域割当て */
+  output = (int32_t **)malloc(sizeof(int32_t*) * header.num_channels);
+  for (ch = 0; ch < header.num_channels; ch++) {
+    output[ch] = (int32_t *)malloc(sizeof(int32_t) * header.num_samples_per_block);
+  }
+
+  /* 終端まで読み捨てる */
+  while (1) {
+    start_time = get_current_time();
+    if ((ret = ALADecoder_DecodeBlock(decoder, in_strm, output, &num_samples)) != ALADECODER_APIRESULT_OK) {
+      break;
+    }
+    if (timing != NULL) {
+      BlockTiming_Add(timing, get_current_time() - start_time);
+    }
+    *num_verified_samples += num_samples;
+  }
+
   /* 領域開放 */
-  for (ch = 0; ch < num_channels; ch++) {
-    free(parcor_coef[ch]);
-    free(residual[ch]);
+  for (ch = 0; ch < header.num_channels; ch++) {
     free(output[ch]);
   }
-  free(parcor_coef);
-  free(residual);
   free(output);
-  WAV_Destroy(out_wav);
+  ALADecoder_Destroy(decoder);
   BitStream_Close(in_strm);
 
+  /* 正常に終端まで到達した */
+  if (ret == ALADECODER_APIRESULT_END_OF_STREAM) {
+    return ALADECODER_APIRESULT_OK;
+  }
+
+  return ret;
+}
+
+/* 検証モードのジョブ処理関数 */
+static void verify_job(void* worker_context, void* job)
+{
+  struct VerifyJob* verify_job = (struct VerifyJob *)job;
+
+  ALAUTILITY_UNUSED_ARGUMENT(worker_context);
+
+  verify_job->result = verify_file(verify_job->filename,
+      &verify_job->num_samples, &verify_job->sampling_rate, NULL);
+}
+
+/* 検証 全ファイル成功時は0、失敗時は0以外を返す */
+int do_verify(const char* const* filenames, uint32_t num_files, uint32_t num_threads)
+{
+  uint32_t  i, num_failed;
+  uint64_t  total_input_size;
+  double    total_duration, start_time, elapsed_time;
+  struct VerifyJob*     jobs;
+  struct ALAScheduler*  scheduler;
+  void**                worker_contexts;
+
+  /* ジョブ作成/登録 */
+  jobs      = (struct VerifyJob *)malloc(sizeof(struct VerifyJob) * num_files);
+  scheduler = ALAScheduler_Create(num_threads, num_files);
+  for (i = 0; i < num_files; i++) {
+    jobs[i].filename      = filenames[i];
+    jobs[i].result        = ALADECODER_APIRESULT_NG;
+    jobs[i].num_samples   = 0;
+    jobs[i].sampling_rate = 0;
+    jobs[i].input_size    = get_file_size(filenames[i]);
+    ALAScheduler_AddJob(scheduler, &jobs[i], jobs[i].input_size);
+  }
+
+  /* ワーカ毎のコンテキストは不要 */
+  worker_contexts = (void **)malloc(sizeof(void *) * num_threads);
+  for (i = 0; i < num_threads; i++) {
+    worker_contexts[i] = NULL;
+  }
+
+  /* 実行 */
+  start_time = get_current_time();
+  if (ALAScheduler_Run(scheduler, verify_job, worker_contexts) == ALASCHEDULER_APIRESULT_INVALID_ARGUMENT) {
+    fprintf(stderr, "Failed to run jobs. \n");
+  }
+  elapsed_time = get_current_time() - start_time;
+
+  /* 結果の表示と集計 */
+  num_failed = 0;
+  total_input_size = 0;
+  total_duration = 0.0f;
+  for (i = 0; i < num_files; i++) {
+    switch (jobs[i].result) {
+      case ALADECODER_APIRESULT_OK:
+        printf("OK   %s \n", jobs[i].filename);
+        break;
+      case ALADECODER_APIRESULT_DETECT_DATA_CORRUPTION:
+        printf("NG   %s: CRC mismatch (after %.0f samples) \n", jobs[i].filename, (double)jobs[i].num_samples);
+        break;
+      case ALADECODER_APIRESULT_INVALID_FORMAT:
+        printf("NG   %s: invalid format (after %.0f samples) \n", jobs[i].filename, (double)jobs[i].num_samples);
+        break;
+      default:
+        printf("NG   %s: failed to decode \n", jobs[i].filename);
+        break;
+    }
+    if (jobs[i].result != ALADECODER_APIRESULT_OK) {
+      num_failed++;
+      continue;
+    }
+    total_input_size  += jobs[i].input_size;
+    total_duration    += (double)jobs[i].num_samples / jobs[i].sampling_rate;
+  }
+  printf("Files:      %u passed, %u failed (%u threads) \n", num_files - num_failed, num_failed, num_threads);
+  printf("Time:       %.3f sec \n", elapsed_time);
+  if (elapsed_time > 0.0f) {
+    printf("Throughput: %.2f MB/s, %.1fx realtime \n",
+        (double)total_input_size / (1024.0f * 1024.0f) / elapsed_time, total_duration / elapsed_time);
+  }
+
+  /* 領域開放 */
+  free(worker_contexts);
+  free(jobs);
+  ALAScheduler_Destroy(scheduler);
+
+  return (num_failed == 0) ? 0 : 1;
+}
+
+/* 遅延の計測 成功時は0、失敗時は0以外を返す */
+/* ブロック毎のエンコード/デコード時間を測り、最悪値からコーデック全体の遅延を見積もる */
+int do_latency_benchmark(const char* in_filename, const char* out_filename,
+    const struct EncodePreset* preset, uint32_t num_pipeline_blocks)
+{
+  int ret;
+  uint64_t  num_samples;
+  uint32_t  sampling_rate;
+  double    block_time, latency;
+  struct EncodeWorker worker;
+  struct EncodeResult result;
+  struct BlockTiming  encode_timing, decode_timing;
+
+  memset(&encode_timing, 0, sizeof(struct BlockTiming));
+  memset(&decode_timing, 0, sizeof(struct BlockTiming));
+
+  /* エンコード */
+  worker.encoder   = NULL;
+  worker.preset    = (*preset);
+  worker.num_pipeline_blocks = num_pipeline_blocks;
+  ret = encode_file(&worker, in_filename, out_filename, 0, &result, &encode_timing);
+  ALAEncoder_Destroy(worker.encoder);
+  if (ret != 0) {
+    return 1;
+  }
+
+  /* デコード（出力は捨てる） */
+  if (verify_file(out_filename, &num_samples, &sampling_rate, &decode_timing) != ALADECODER_APIRESULT_OK) {
+    fprintf(stderr, "Failed to decode %s. \n", out_filename);
+    return 1;
+  }
+  if ((encode_timing.num_blocks == 0) || (decode_timing.num_blocks == 0)) {
+    fprintf(stderr, "No blocks to measure. \n");
+    return 1;
+  }
+
+  /* ブロック長の分だけ入力を待ち、最悪値の時間でエンコード/デコードすると考える */
+  block_time  = (double)preset->num_samples_per_block / sampling_rate;
+  latency     = block_time + encode_timing.max_time + decode_timing.max_time;
+
+  printf("Block:      %u samples (%.3f ms at %u Hz) \n",
+      preset->num_samples_per_block, block_time * 1000.0f, sampling_rate);
+  printf("Encode:     worst %.3f ms, mean %.3f ms per block (%u blocks) \n",
+      encode_timing.max_time * 1000.0f, encode_timing.total_time * 1000.0f / encode_timing.num_blocks,
+      encode_timing.num_blocks);
+  printf("Decode:     worst %.3f ms, mean %.3f ms per block (%u blocks) \n",
+      decode_timing.max_time * 1000.0f, decode_timing.total_time * 1000.0f / decode_timing.num_blocks,
+      decode_timing.num_blocks);
+  printf("Latency:    %.3f ms (block + worst encode + worst decode) \n", latency * 1000.0f);
+
   return 0;
 }
 
@@ -435,41 +1250,137 @@ int do_decode(const char* in_filename, const char* out_filename)
 static void print_usage(char** argv)
 {
   printf("ALA - Ayashi Lossless Audio Compressor Version %s \n", ALA_VERSION_STRING);
-  printf("Usage: %s -[ed] INPUT_FILE_NAME OUTPUT_FILE_NAME \n", argv[0]);
+  printf("Usage: %s -e [-0..-8 | -L] [-l LEVEL] [-r NUM_BLOCKS] INPUT_FILE_NAME OUTPUT_FILE_NAME \n", argv[0]);
+  printf("       %s -d [-r NUM_BLOCKS] INPUT_FILE_NAME OUTPUT_FILE_NAME \n", argv[0]);
+  printf("       (\"-\" as a file name means stdin/stdout) \n");
+  printf("       %s -b [-j NUM_THREADS] [-0..-8 | -L] [-l LEVEL] [-r NUM_BLOCKS] INPUT_DIRECTORY_OR_LIST OUTPUT_DIRECTORY \n", argv[0]);
+  printf("       %s -t [-j NUM_THREADS] INPUT_FILE_NAME ... \n", argv[0]);
+  printf("       %s -m [-0..-8 | -L] [-l LEVEL] [-r NUM_BLOCKS] INPUT_FILE_NAME OUTPUT_FILE_NAME \n", argv[0]);
+  printf("  -e: encode \n");
+  printf("  -d: decode (a .w64 output is written as Wave64, otherwise RIFF, or RF64 above 4 GB) \n");
+  printf("  -b: batch encode (all .wav/.w64 files in the directory, or one file per line in the list) \n");
+  printf("  -t: verify the CRCs of encoded files without writing any output \n");
+  printf("  -m: measure the worst-case per-block encode/decode time and the codec latency \n");
+  printf("  -j: number of threads in batch/verify mode (default: number of processors) \n");
+  printf("  -0..-8: encode preset (default: -%d, higher is smaller and slower) \n", ALA_DEFAULT_PRESET);
+  printf("  -L: low-latency profile (%u-sample blocks, compact block headers) \n",
+      low_latency_preset.num_samples_per_block);
+  printf("  -l: adaptive filter level 0-%d (default: set by the preset, higher is smaller and slower) \n",
+      ALA_NUM_LMS_LEVELS - 1);
+  printf("  -r: number of blocks the WAV reader/writer thread may run ahead of the codec (default: %d) \n",
+      ALA_DEFAULT_NUM_PIPELINE_BLOCKS);
 }
 
 /* メインエントリ */
 int main(int argc, char** argv)
 {
-  const char* option;
+  int         arg;
+  char        mode = '\0';
+  long        num_threads = 0;
+  long        preset_no = ALA_DEFAULT_PRESET;
+  long        lms_level = -1;
+  long        num_pipeline_blocks = ALA_DEFAULT_NUM_PIPELINE_BLOCKS;
+  int         low_latency = 0;
+  struct EncodePreset preset;
   const char* input_file;
   const char* output_file;
 
-  /* 引数が足らない */
-  if (argc < 4) {
+  /* オプションの解析 */
+  for (arg = 1; (arg < argc) && (argv[arg][0] == '-') && (argv[arg][1] != '\0'); arg++) {
+    if ((strcmp(argv[arg], "-e") == 0)
+        || (strcmp(argv[arg], "-d") == 0)
+        || (strcmp(argv[arg], "-b") == 0)
+        || (strcmp(argv[arg], "-t") == 0)
+        || (strcmp(argv[arg], "-m") == 0)) {
+      mode = argv[arg][1];
+    } else if ((strcmp(argv[arg], "-j") == 0) && (arg + 1 < argc)) {
+      num_threads = strtol(argv[++arg], NULL, 10);
+      if (num_threads <= 0) {
+        print_usage(argv);
+        return 1;
+      }
+    } else if ((argv[arg][1] >= '0') && (argv[arg][1] < '0' + ALA_NUM_PRESETS) && (argv[arg][2] == '\0')) {
+      preset_no = argv[arg][1] - '0';
+      low_latency = 0;
+    } else if (strcmp(argv[arg], "-L") == 0) {
+      low_latency = 1;
+    } else if ((strcmp(argv[arg], "-l") == 0) && (arg + 1 < argc)) {
+      lms_level = strtol(argv[++arg], NULL, 10);
+      if ((lms_level < 0) || (lms_level >= ALA_NUM_LMS_LEVELS)) {
+        print_usage(argv);
+        return 1;
+      }
+    } else if ((strcmp(argv[arg], "-r") == 0) && (arg + 1 < argc)) {
+      num_pipeline_blocks = strtol(argv[++arg], NULL, 10);
+      if (num_pipeline_blocks <= 0) {
+        print_usage(argv);
+        return 1;
+      }
+    } else {
+      print_usage(argv);
+      return 1;
+    }
+  }
+
+  /* 引数が足らない（検証モードは入力ファイルのみ） */
+  if ((mode == '\0') || (argc - arg < ((mode == 't') ? 1 : 2))) {
     print_usage(argv);
     return 1;
   }
 
-  /* 引数文字列の取得 */
-  option      = argv[1];
-  input_file  = argv[2];
-  output_file = argv[3];
+  /* スレッド数の指定がなければプロセッサ数 */
+  if (num_threads == 0) {
+    num_threads = ALAUTILITY_MAX(sysconf(_SC_NPROCESSORS_ONLN), 1);
+  }
 
-  /* エンコード/デコード呼び分け */
-  if (strcmp(option, "-e") == 0) {
-    if (do_encode(input_file, output_file) != 0) {
-      fprintf(stderr, "Failed to encode. \n");
+  /* 検証モードは残りの引数全てが入力ファイル */
+  if (mode == 't') {
+    if (do_verify((const char* const*)&argv[arg], (uint32_t)(argc - arg), (uint32_t)num_threads) != 0) {
+      fprintf(stderr, "Verification failed. \n");
       return 1;
     }
-  } else if (strcmp(option, "-d") == 0) {
-    if (do_decode(input_file, output_file) != 0) {
-      fprintf(stderr, "Failed to decode. \n");
+    return 0;
+  }
+
+  /* プリセットの取得（-0..-8と-Lは後の指定を使い、適応フィルタのレベルは指定があれば上書き） */
+  preset = (low_latency != 0) ? low_latency_preset : presets[preset_no];
+  if (lms_level >= 0) {
+    preset.lms_level = (uint32_t)lms_level;
+  }
+
+  /* 引数文字列の取得 */
+  input_file  = argv[arg];
+  output_file = argv[arg + 1];
+
+  /* エンコード/デコード呼び分け */
+  switch (mode) {
+    case 'e':
+      if (do_encode(input_file, output_file, &preset, (uint32_t)num_pipeline_blocks) != 0) {
+        fprintf(stderr, "Failed to encode. \n");
+        return 1;
+      }
+      break;
+    case 'd':
+      if (do_decode(input_file, output_file, (uint32_t)num_pipeline_blocks) != 0) {
+        fprintf(stderr, "Failed to decode. \n");
+        return 1;
+      }
+      break;
+    case 'b':
+      if (do_batch_encode(input_file, output_file, (uint32_t)num_threads, &preset, (uint32_t)num_pipeline_blocks) != 0) {
+        fprintf(stderr, "Failed to batch encode. \n");
+        return 1;
+      }
+      break;
+    case 'm':
+      if (do_latency_benchmark(input_file, output_file, &preset, (uint32_t)num_pipeline_blocks) != 0) {
+        fprintf(stderr, "Failed to measure latency. \n");
+        return 1;
+      }
+      break;
+    default:
+      print_usage(argv);
       return 1;
-    }
-  } else {
-    print_usage(argv);
-    return 1;
   }
 
   return 0;
@@ -1,3 +1,4 @@
+#define _FILE_OFFSET_BITS 64
 #include "wav.h"
 
 #include <stdio.h>
@@ -5,9 +6,35 @@
 #include <string.h>
 #include <assert.h>
 
+/* SSE2が使える環境ではPCMデータの並べ替えをベクトル化する */
+#if defined(__SSE2__)
+#define WAV_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+/* 最小値の取得 */
+#define WAV_Min(a, b) (((a) < (b)) ? (a) : (b))
+
 /* パーサの読み込みバッファサイズ */
 #define WAVBITBUFFER_BUFFER_SIZE         (10 * 1024)
 
+/* RIFF/RF64のヘッダのバイト数（ds64チャンクまたは同じ大きさのJUNKチャンクを含む） */
+#define WAV_DS64_HEADER_SIZE            80
+/* RIFFのヘッダのバイト数（拡張部分を一切含まない） */
+#define WAV_RIFF_HEADER_SIZE            44
+/* W64のヘッダのバイト数 */
+#define WAV_W64_HEADER_SIZE             104
+/* ヘッダの最大バイト数 */
+#define WAV_MAX_HEADER_SIZE             WAV_W64_HEADER_SIZE
+/* ds64チャンクの中身のバイト数（テーブルを含まない） */
+#define WAV_DS64_CHUNK_SIZE             28
+/* W64のチャンクヘッダ（GUIDとサイズ）のバイト数 */
+#define WAV_W64_CHUNK_HEADER_SIZE       24
+/* RIFFのサイズ欄に書ける最大値（RF64ではこの値を書き、実際のサイズはds64チャンクに持つ） */
+#define WAV_RIFF_MAX_SIZE               0xFFFFFFFFUL
+/* データサイズが不明であることを示す値 */
+#define WAV_DATA_SIZE_UNKNOWN           (~(uint64_t)0)
+
 /* 下位n_bitsを取得 */
 /* 補足）((1 << n_bits) - 1)は下位の数値だけ取り出すマスクになる */
 #define WAV_GetLowerBits(n_bits, val) ((val) & (uint32_t)((1 << (n_bits)) - 1))
@@ -21,17 +48,30 @@ typedef enum WAVErrorTag {
   WAV_ERROR_INVALID_FORMAT      /* 不正なフォーマット */
 } WAVError;
 
+/* インターリーブされたPCMのバイト列をチャンネル毎の32bit整数配列に並べ替える関数 */
+/* bytesからnum_samplesサンプル分を読み、data[ch][offset]以降に書き込む */
+typedef void (*WAVDeinterleaveFunction)(
+    const uint8_t* bytes, WAVPcmData** data, uint32_t num_channels, uint32_t offset, uint32_t num_samples);
+
+/* チャンネル毎の32bit整数配列をインターリーブされたPCMのバイト列に並べ替える関数 */
+/* data[ch][offset]以降のnum_samplesサンプル分をshiftだけ右シフトしてファイルのビット幅に詰め、bytesに書き込む */
+typedef void (*WAVInterleaveFunction)(
+    const WAVPcmData** data, uint32_t num_channels, uint32_t offset, uint32_t num_samples,
+    uint32_t shift, uint8_t* bytes);
+
 /* ビットバッファ */
 struct WAVBitBuffer {
   uint8_t   bytes[WAVBITBUFFER_BUFFER_SIZE];   /* ビットバッファ */
   uint32_t  bit_count;                        /* ビット入力カウント */
   int32_t   byte_pos;                         /* バイト列読み込み位置 */
+  int32_t   num_bytes;                        /* バッファ内の有効なバイト数（読み込み時のみ使用） */
 };
 
 /* パーサ */
 struct WAVParser {
-  FILE*               fp;       /* 読み込みファイルポインタ */
-  struct WAVBitBuffer buffer;   /* ビットバッファ */
+  FILE*                   fp;           /* 読み込みファイルポインタ */
+  struct WAVBitBuffer     buffer;       /* ビットバッファ */
+  WAVDeinterleaveFunction deinterleave; /* PCMデータの並べ替え関数（フォーマット読み取り時に決定） */
 };
 
 /* ライタ */
@@ -40,8 +80,39 @@ struct WAVWriter {
   uint32_t  bit_buffer;         /* 出力途中のビット */
   uint32_t  bit_count;          /* 出力カウント     */
   struct WAVBitBuffer buffer;   /* ビットバッファ */
+  WAVInterleaveFunction interleave; /* PCMデータの並べ替え関数（ヘッダ書き出し時に決定） */
+};
+
+/* ストリーム読み込みハンドル */
+struct WAVStreamReader {
+  FILE*                 fp;                 /* 読み込みファイルポインタ */
+  uint8_t               is_standard_stream; /* 標準入力を使用しているか？ */
+  struct WAVParser      parser;             /* パーサ */
+  struct WAVFileFormat  format;             /* フォーマット */
+  uint64_t              num_read_samples;   /* 読み込み済みサンプル数 */
 };
 
+/* ストリーム書き出しハンドル */
+struct WAVStreamWriter {
+  FILE*                 fp;                   /* 書き込みファイルポインタ */
+  uint8_t               is_standard_stream;   /* 標準出力を使用しているか？ */
+  struct WAVWriter      writer;               /* ライタ */
+  struct WAVFileFormat  format;               /* フォーマット */
+  uint64_t              num_written_samples;  /* 書き出し済みサンプル数 */
+  uint32_t              header_size;          /* 書き出したヘッダのバイト数 */
+  uint8_t               reserve_ds64;         /* ヘッダにds64チャンク分の領域を確保したか？ */
+};
+
+/* W64のチャンクID（GUID） */
+static const uint8_t w64_riff_guid[16]
+  = { 'r', 'i', 'f', 'f', 0x2E, 0x91, 0xCF, 0x11, 0xA5, 0xD6, 0x28, 0xDB, 0x04, 0xC1, 0x00, 0x00 };
+static const uint8_t w64_wave_guid[16]
+  = { 'w', 'a', 'v', 'e', 0xF3, 0xAC, 0xD3, 0x11, 0x8C, 0xD1, 0x00, 0xC0, 0x4F, 0x8E, 0xDB, 0x8A };
+static const uint8_t w64_fmt_guid[16]
+  = { 'f', 'm', 't', ' ', 0xF3, 0xAC, 0xD3, 0x11, 0x8C, 0xD1, 0x00, 0xC0, 0x4F, 0x8E, 0xDB, 0x8A };
+static const uint8_t w64_data_guid[16]
+  = { 'd', 'a', 't', 'a', 0xF3, 0xAC, 0xD3, 0x11, 0x8C, 0xD1, 0x00, 0xC0, 0x4F, 0x8E, 0xDB, 0x8A };
+
 /* パーサの初期化 */
 static void WAVParser_Initialize(struct WAVParser* parser, FILE* fp);
 /* パーサの使用終了 */
@@ -49,7 +120,7 @@ static void WAVParser_Finalize(struct WAVParser* parser);
 /* n_bit 取得し、結果を右詰めする */
 static WAVError WAVParser_GetBits(struct WAVParser* parser, uint32_t n_bits, uint64_t* bitsbuf);
 /* シーク（fseek準拠） */
-static WAVError WAVParser_Seek(struct WAVParser* parser, int32_t offset, int32_t wherefrom);
+static WAVError WAVParser_Seek(struct WAVParser* parser, int64_t offset, int32_t wherefrom);
 /* ライタの初期化 */
 static void WAVWriter_Initialize(struct WAVWriter* writer, FILE* fp);
 /* ライタの終了 */
@@ -62,9 +133,12 @@ static WAVError WAVWriter_Flush(struct WAVWriter* writer);
 static WAVError WAVWriter_PutLittleEndianBytes(
     struct WAVWriter* writer, uint32_t nbytes, uint64_t data);
 
-/* ライタを使用してファイルフォーマットに従ったヘッダ部を出力 */
+/* ヘッダのバイト列を作成し、そのバイト数を返す */
+static uint32_t WAV_MakeHeader(
+    const struct WAVFileFormat* format, uint64_t data_size, uint8_t reserve_ds64, uint8_t* header);
+/* ライタを使用してファイルフォーマットに従ったヘッダ部を出力し、そのバイト数をheader_sizeに返す */
 static WAVError WAVWriter_PutWAVHeader(
-    struct WAVWriter* writer, const struct WAVFileFormat* format);
+    struct WAVWriter* writer, const struct WAVFileFormat* format, uint8_t reserve_ds64, uint32_t* header_size);
 /* ライタを使用してPCMデータ出力 */
 static WAVError WAVWriter_PutWAVPcmData(
     struct WAVWriter* writer, const struct WAVFile* wavfile);
@@ -84,6 +158,25 @@ static WAVError WAVParser_GetWAVFormat(
 /* パーサを使用してPCMデータを読み取り */
 static WAVError WAVParser_GetWAVPcmData(
     struct WAVParser* parser, struct WAVFile* wavfile);
+/* パーサを使用して最大num_samplesサンプルのPCMデータを読み取り（ファイル終端で打ち切り） */
+static WAVError WAVParser_GetPcmSamples(
+    struct WAVParser* parser, const struct WAVFileFormat* format,
+    WAVPcmData** data, uint32_t num_samples, uint32_t* num_read_samples);
+/* ライタを使用してnum_samplesサンプルのPCMデータを出力 */
+/* dataの値はshiftだけ右シフトするとファイルのビット幅の符号付き整数になっていること */
+static WAVError WAVWriter_PutPcmSamples(
+    struct WAVWriter* writer, const struct WAVFileFormat* format,
+    const WAVPcmData** data, uint32_t num_samples, uint32_t shift);
+
+/* フォーマットに合ったPCMデータの並べ替え関数を選択（未対応ならNULL） */
+static WAVDeinterleaveFunction WAV_SelectDeinterleaveFunction(const struct WAVFileFormat* format);
+/* バッファ上の未読バイト列を取得 */
+static void WAVParser_PeekBytes(
+    struct WAVParser* parser, uint32_t min_bytes, const uint8_t** bytes, uint32_t* num_bytes);
+/* バッファ上の未読バイト列を読み進める */
+static void WAVParser_SkipBytes(struct WAVParser* parser, uint32_t num_bytes);
+/* フォーマットに合ったPCMデータの並べ替え関数を選択（未対応ならNULL） */
+static WAVInterleaveFunction WAV_SelectInterleaveFunction(const struct WAVFileFormat* format);
 
 /* 8bitPCM形式を32bit形式に変換 */
 static int32_t WAV_Convert8bitPCMto32bitPCM(int32_t in_8bitpcm);
@@ -94,51 +187,31 @@ static int32_t WAV_Convert24bitPCMto32bitPCM(int32_t in_24bitpcm);
 /* 32bitPCM形式を32bit形式に変換 */
 static int32_t WAV_Convert32bitPCMto32bitPCM(int32_t in_32bitpcm);
 
-/* 32bitPCM形式を8bit形式に変換（注意：返り値は32bit整数だが、8bit範囲でクリップされている） */
-static int32_t WAV_Convert32bitPCMto8bitPCM(int32_t in_32bitpcm);
-/* 32bitPCM形式を16bit形式に変換（注意：返り値は32bit整数だが、16bit範囲でクリップされている） */
-static int32_t WAV_Convert32bitPCMto8bitPCM(int32_t in_32bitpcm);
-/* 32bitPCM形式を24bit形式に変換（注意：返り値は32bit整数だが、24bit範囲でクリップされている） */
-static int32_t WAV_Convert32bitPCMto16bitPCM(int32_t in_32bitpcm);
-/* 32bitPCM形式を32bit形式に変換 */
-static int32_t WAV_Convert32bitPCMto32bitPCM(int32_t in_32bitpcm);
-
-/* パーサを使用してファイルフォーマットを読み取り */
-static WAVError WAVParser_GetWAVFormat(
-    struct WAVParser* parser, struct WAVFileFormat* format)
+/* ファイルのビット幅の配列から1サンプルを右詰めで読み出し */
+static int32_t WAV_GetNativeSample(const uint8_t* native, uint32_t bits_per_sample, uint32_t samp);
+/* ファイルのビット幅の配列に右詰めの1サンプルを書き込み */
+static void WAV_SetNativeSample(uint8_t* native, uint32_t bits_per_sample, uint32_t samp, int32_t pcm);
+/* インターリーブされたPCMのバイト列をチャンネル毎のファイルのビット幅の配列に並べ替える */
+static void WAV_DeinterleaveNative(
+    const uint8_t* bytes, uint8_t** native, uint32_t num_channels, uint32_t bits_per_sample,
+    uint32_t offset, uint32_t num_samples);
+/* チャンネル毎のファイルのビット幅の配列をインターリーブされたPCMのバイト列に並べ替える */
+static void WAV_InterleaveNative(
+    const uint8_t* const* native, uint32_t num_channels, uint32_t bits_per_sample,
+    uint32_t offset, uint32_t num_samples, uint8_t* bytes);
+
+
+/* パーサを使用してfmtチャンクの中身を読み取り */
+static WAVError WAVParser_GetFmtChunk(
+    struct WAVParser* parser, uint64_t fmt_chunk_size, struct WAVFileFormat* format)
 {
-  uint64_t  bitsbuf;
-  int32_t   fmt_chunk_size;
-  struct WAVFileFormat tmp_format;
-
-  /* 引数チェック */
-  if (parser == NULL || format == NULL) {
-    return WAV_ERROR_INVALID_PARAMETER;
-  }
-  
-  /* ヘッダ 'R', 'I', 'F', 'F' をチェック */
-  if (WAVParser_CheckSignatureString(parser, "RIFF", 4) != WAV_ERROR_OK) {
-    return WAV_ERROR_INVALID_FORMAT;
-  }
-
-  /* ファイルサイズ-8（読み飛ばし） */
-  if (WAVParser_GetLittleEndianBytes(parser, 4, &bitsbuf) != WAV_ERROR_OK) { return WAV_ERROR_IO; }
-
-  /* ヘッダ 'W', 'A', 'V', 'E' をチェック */
-  if (WAVParser_CheckSignatureString(parser, "WAVE", 4) != WAV_ERROR_OK) {
-    return WAV_ERROR_INVALID_FORMAT;
-  }
+  uint64_t bitsbuf;
 
-  /* fmtチャンクのヘッダ 'f', 'm', 't', ' ' をチェック */
-  if (WAVParser_CheckSignatureString(parser, "fmt ", 4) != WAV_ERROR_OK) {
+  /* 必須のフィールドが収まっていない */
+  if (fmt_chunk_size < 16) {
     return WAV_ERROR_INVALID_FORMAT;
   }
 
-  /* fmtチャンクのバイト数を取得
-   * 補足/注意）16より大きいサイズのfmtチャンクの内容（拡張）は読み飛ばす */
-  if (WAVParser_GetLittleEndianBytes(parser, 4, &bitsbuf) != WAV_ERROR_OK) { return WAV_ERROR_IO; }
-  fmt_chunk_size = (int32_t)bitsbuf;
-
   /* フォーマットIDをチェック
    * 補足）1（リニアPCM）以外対応していない */
   if (WAVParser_GetLittleEndianBytes(parser, 2, &bitsbuf) != WAV_ERROR_OK) { return WAV_ERROR_IO; }
@@ -146,15 +219,15 @@ static WAVError WAVParser_GetWAVFormat(
     /* fprintf(stderr, "Unsupported format: fmt chunk format ID \n"); */
     return WAV_ERROR_INVALID_FORMAT;
   }
-  tmp_format.data_format = WAV_DATA_FORMAT_PCM;
+  format->data_format = WAV_DATA_FORMAT_PCM;
 
   /* チャンネル数 */
   if (WAVParser_GetLittleEndianBytes(parser, 2, &bitsbuf) != WAV_ERROR_OK) { return WAV_ERROR_IO; }
-  tmp_format.num_channels = (uint32_t)bitsbuf;
+  format->num_channels = (uint32_t)bitsbuf;
 
   /* サンプリングレート */
   if (WAVParser_GetLittleEndianBytes(parser, 4, &bitsbuf) != WAV_ERROR_OK) { return WAV_ERROR_IO; }
-  tmp_format.sampling_rate =(uint32_t) bitsbuf;
+  format->sampling_rate =(uint32_t) bitsbuf;
 
   /* データ速度（byte/sec）は読み飛ばし */
   if (WAVParser_GetLittleEndianBytes(parser, 4, &bitsbuf) != WAV_ERROR_OK) { return WAV_ERROR_IO; }
@@ -164,39 +237,175 @@ static WAVError WAVParser_GetWAVFormat(
 
   /* 量子化ビット数（サンプルあたりのビット数） */
   if (WAVParser_GetLittleEndianBytes(parser, 2, &bitsbuf) != WAV_ERROR_OK) { return WAV_ERROR_IO; }
-  tmp_format.bits_per_sample = (uint32_t)bitsbuf;
+  format->bits_per_sample = (uint32_t)bitsbuf;
 
   /* 拡張部分の読み取りには未対応: 読み飛ばしを行う */
   if (fmt_chunk_size > 16) {
     fprintf(stderr, "Warning: skip fmt chunk extention (unsupported). \n");
-    if (WAVParser_Seek(parser, fmt_chunk_size - 16, SEEK_CUR) != WAV_ERROR_OK) { return WAV_ERROR_IO; }
+    if (WAVParser_Seek(parser, (int64_t)(fmt_chunk_size - 16), SEEK_CUR) != WAV_ERROR_OK) { return WAV_ERROR_IO; }
   }
-  
+
+  return WAV_ERROR_OK;
+}
+
+/* パーサを使用してファイルフォーマットを読み取り */
+/* RIFF/RF64は4文字のチャンクIDと32bitのサイズ、W64はGUIDのチャンクIDと（チャンクヘッダを含む）64bitのサイズでチャンクが並ぶ */
+static WAVError WAVParser_GetWAVFormat(
+    struct WAVParser* parser, struct WAVFileFormat* format)
+{
+  uint64_t  bitsbuf, chunk_size, data_size, ds64_data_size;
+  char      id[16];
+  uint32_t  padding, bytes_per_frame;
+  uint8_t   has_fmt, size_unknown;
+  struct WAVFileFormat tmp_format;
+
+  /* 引数チェック */
+  if (parser == NULL || format == NULL) {
+    return WAV_ERROR_INVALID_PARAMETER;
+  }
+
+  /* 先頭4文字でコンテナを判定 */
+  if (WAVParser_GetString(parser, id, 4) != WAV_ERROR_OK) {
+    return WAV_ERROR_IO;
+  }
+  if (strncmp(id, "RIFF", 4) == 0) {
+    tmp_format.container = WAV_CONTAINER_RIFF;
+  } else if (strncmp(id, "RF64", 4) == 0) {
+    tmp_format.container = WAV_CONTAINER_RF64;
+  } else if (strncmp(id, "riff", 4) == 0) {
+    tmp_format.container = WAV_CONTAINER_W64;
+  } else {
+    return WAV_ERROR_INVALID_FORMAT;
+  }
+
+  if (tmp_format.container == WAV_CONTAINER_W64) {
+    /* riffのGUIDの残り、ファイルサイズ（読み飛ばし）、waveのGUIDをチェック */
+    if ((WAVParser_GetString(parser, &id[4], 12) != WAV_ERROR_OK)
+        || (WAVParser_GetLittleEndianBytes(parser, 8, &bitsbuf) != WAV_ERROR_OK)) {
+      return WAV_ERROR_IO;
+    }
+    if (memcmp(id, w64_riff_guid, 16) != 0) {
+      return WAV_ERROR_INVALID_FORMAT;
+    }
+    if (WAVParser_GetString(parser, id, 16) != WAV_ERROR_OK) {
+      return WAV_ERROR_IO;
+    }
+    if (memcmp(id, w64_wave_guid, 16) != 0) {
+      return WAV_ERROR_INVALID_FORMAT;
+    }
+  } else {
+    /* ファイルサイズ-8（読み飛ばし） */
+    if (WAVParser_GetLittleEndianBytes(parser, 4, &bitsbuf) != WAV_ERROR_OK) { return WAV_ERROR_IO; }
+
+    /* ヘッダ 'W', 'A', 'V', 'E' をチェック */
+    if (WAVParser_CheckSignatureString(parser, "WAVE", 4) != WAV_ERROR_OK) {
+      return WAV_ERROR_INVALID_FORMAT;
+    }
+  }
+
   /* チャンク読み取り */
+  has_fmt = 0;
+  ds64_data_size = 0;
   while (1) {
-    char string_buf[4];
-    /* チャンク文字列取得 */
-    if (WAVParser_GetString(parser, string_buf, 4) != WAV_ERROR_OK) {
-      return WAV_ERROR_IO;
+    uint8_t is_fmt, is_data;
+
+    /* チャンクIDとサイズの取得（W64のサイズはチャンクヘッダを含み、チャンクは8バイト境界に並ぶ） */
+    if (tmp_format.container == WAV_CONTAINER_W64) {
+      if ((WAVParser_GetString(parser, id, 16) != WAV_ERROR_OK)
+          || (WAVParser_GetLittleEndianBytes(parser, 8, &bitsbuf) != WAV_ERROR_OK)) {
+        return WAV_ERROR_IO;
+      }
+      is_fmt  = (memcmp(id, w64_fmt_guid, 16) == 0);
+      is_data = (memcmp(id, w64_data_guid, 16) == 0);
+      /* サイズ不明のデータチャンクはチャンクヘッダより小さい値を持ちうる */
+      if (is_data) {
+        break;
+      }
+      if (bitsbuf < WAV_W64_CHUNK_HEADER_SIZE) {
+        return WAV_ERROR_INVALID_FORMAT;
+      }
+      chunk_size = bitsbuf - WAV_W64_CHUNK_HEADER_SIZE;
+      padding = (uint32_t)((8 - (bitsbuf % 8)) % 8);
+    } else {
+      if ((WAVParser_GetString(parser, id, 4) != WAV_ERROR_OK)
+          || (WAVParser_GetLittleEndianBytes(parser, 4, &bitsbuf) != WAV_ERROR_OK)) {
+        return WAV_ERROR_IO;
+      }
+      is_fmt  = (strncmp(id, "fmt ", 4) == 0);
+      is_data = (strncmp(id, "data", 4) == 0);
+      if (is_data) {
+        break;
+      }
+      chunk_size = bitsbuf;
+      padding = (uint32_t)(bitsbuf & 1);
     }
-    if (strncmp(string_buf, "data", 4) == 0) {
-      /* データチャンクを見つけたら終わり */
-      break;
+
+    if (is_fmt) {
+      /* fmtチャンク */
+      WAVError err;
+      if ((err = WAVParser_GetFmtChunk(parser, chunk_size, &tmp_format)) != WAV_ERROR_OK) {
+        return err;
+      }
+      has_fmt = 1;
+    } else if ((tmp_format.container == WAV_CONTAINER_RF64) && (strncmp(id, "ds64", 4) == 0)) {
+      /* ds64チャンク: RIFFのサイズ（読み飛ばし）、データサイズを取得し、残りは読み飛ばす */
+      if (chunk_size < 16) {
+        return WAV_ERROR_INVALID_FORMAT;
+      }
+      if ((WAVParser_GetLittleEndianBytes(parser, 8, &bitsbuf) != WAV_ERROR_OK)
+          || (WAVParser_GetLittleEndianBytes(parser, 8, &ds64_data_size) != WAV_ERROR_OK)) {
+        return WAV_ERROR_IO;
+      }
+      if (WAVParser_Seek(parser, (int64_t)(chunk_size - 16), SEEK_CUR) != WAV_ERROR_OK) {
+        return WAV_ERROR_IO;
+      }
     } else {
-      /* 他のチャンクはサイズだけ取得してシークにより読み飛ばす */
-      if (WAVParser_GetLittleEndianBytes(parser, 4, &bitsbuf) != WAV_ERROR_OK) {
+      /* 他のチャンクはシークにより読み飛ばす */
+      /* printf("chunk:%.4s size:%d \n", id, (int32_t)chunk_size); */
+      if (WAVParser_Seek(parser, (int64_t)chunk_size, SEEK_CUR) != WAV_ERROR_OK) {
         return WAV_ERROR_IO;
       }
-      /* printf("chunk:%s size:%d \n", string_buf, (int32_t)bitsbuf); */
-      WAVParser_Seek(parser, (int32_t)bitsbuf, SEEK_CUR);
     }
+
+    /* チャンク境界までの詰め物を読み飛ばす */
+    if (WAVParser_Seek(parser, padding, SEEK_CUR) != WAV_ERROR_OK) {
+      return WAV_ERROR_IO;
+    }
+  }
+
+  /* データチャンクより前にfmtチャンクがなかった */
+  if (!has_fmt) {
+    return WAV_ERROR_INVALID_FORMAT;
+  }
+
+  /* 波形データバイト数 */
+  /* サイズ欄が最大値ならばストリーミング出力でサイズが確定していない
+   * 0は空のデータとして有効な値なので、シークできない入力（パイプ）の場合のみ不明とみなす */
+  size_unknown = 0;
+  if (tmp_format.container == WAV_CONTAINER_W64) {
+    /* W64のサイズはチャンクヘッダを含むため、ヘッダより小さい値は不明とみなす */
+    size_unknown = (bitsbuf < WAV_W64_CHUNK_HEADER_SIZE) || (bitsbuf == WAV_DATA_SIZE_UNKNOWN);
+    data_size = size_unknown ? 0 : (bitsbuf - WAV_W64_CHUNK_HEADER_SIZE);
+  } else if ((tmp_format.container == WAV_CONTAINER_RF64) && (bitsbuf == WAV_RIFF_MAX_SIZE)) {
+    /* RF64の実際のサイズはds64チャンクにある */
+    data_size = ds64_data_size;
+  } else {
+    size_unknown = (bitsbuf == WAV_RIFF_MAX_SIZE) || ((bitsbuf == 0) && (ftell(parser->fp) < 0));
+    data_size = size_unknown ? 0 : bitsbuf;
   }
 
   /* サンプル数: 波形データバイト数から算出 */
-  if (WAVParser_GetLittleEndianBytes(parser, 4, &bitsbuf) != WAV_ERROR_OK) { return WAV_ERROR_IO; }
-  tmp_format.num_samples = (uint32_t)bitsbuf;
-  assert(tmp_format.num_samples % ((tmp_format.bits_per_sample / 8) * tmp_format.num_channels) == 0);
-  tmp_format.num_samples /= ((tmp_format.bits_per_sample / 8) * tmp_format.num_channels);
+  bytes_per_frame = (tmp_format.bits_per_sample / 8) * tmp_format.num_channels;
+  if ((size_unknown != 0) || (bytes_per_frame == 0)) {
+    /* ストリーミング出力されたWAVはサイズが確定していない */
+    tmp_format.num_samples = WAV_NUM_SAMPLES_UNKNOWN;
+  } else {
+    /* 端数のバイトは途中で切れたフレームなので切り捨てる */
+    tmp_format.num_samples = data_size / bytes_per_frame;
+  }
+
+  /* PCMデータの並べ替え関数はファイル毎に1度だけ決める */
+  parser->deinterleave = WAV_SelectDeinterleaveFunction(&tmp_format);
 
   /* 構造体コピー */
   *format = tmp_format;
@@ -204,21 +413,23 @@ static WAVError WAVParser_GetWAVFormat(
   return WAV_ERROR_OK;
 }
 
-/* パーサを使用してPCMデータを読み取り */
-static WAVError WAVParser_GetWAVPcmData(
-    struct WAVParser* parser, struct WAVFile* wavfile)
+/* パーサを使用して最大num_samplesサンプルのPCMデータを読み取り（ファイル終端で打ち切り） */
+static WAVError WAVParser_GetPcmSamples(
+    struct WAVParser* parser, const struct WAVFileFormat* format,
+    WAVPcmData** data, uint32_t num_samples, uint32_t* num_read_samples)
 {
-  uint32_t  ch, sample, bytes_per_sample;
+  uint32_t  ch, sample, bytes_per_sample, frame_bytes, num_bytes, num_frames;
   uint64_t  bitsbuf;
+  const uint8_t* bytes;
   int32_t   (*convert_to_sint32_func)(int32_t);
 
   /* 引数チェック */
-  if (parser == NULL || wavfile == NULL) {
+  if (parser == NULL || format == NULL || data == NULL || num_read_samples == NULL) {
     return WAV_ERROR_INVALID_PARAMETER;
   }
 
   /* ビット深度に合わせてPCMデータの変換関数を決定 */
-  switch (wavfile->format.bits_per_sample) {
+  switch (format->bits_per_sample) {
     case 8:
       convert_to_sint32_func = WAV_Convert8bitPCMto32bitPCM;
       break;
@@ -232,20 +443,127 @@ static WAVError WAVParser_GetWAVPcmData(
       convert_to_sint32_func = WAV_Convert32bitPCMto32bitPCM;
       break;
     default:
-      /* fprintf(stderr, "Unsupported bits per sample format(=%d). \n", wavfile->format.bits_per_sample); */
+      /* fprintf(stderr, "Unsupported bits per sample format(=%d). \n", format->bits_per_sample); */
       return WAV_ERROR_INVALID_FORMAT;
   }
 
+  bytes_per_sample = format->bits_per_sample / 8;
+  frame_bytes = bytes_per_sample * format->num_channels;
+
+  /* 1サンプル分の全チャンネルがバッファに収まるなら、バッファ上でまとめて並べ替える */
+  if ((parser->deinterleave != NULL) && (frame_bytes > 0) && (frame_bytes <= WAVBITBUFFER_BUFFER_SIZE)) {
+    sample = 0;
+    while (sample < num_samples) {
+      WAVParser_PeekBytes(parser, frame_bytes, &bytes, &num_bytes);
+      num_frames = WAV_Min(num_bytes / frame_bytes, num_samples - sample);
+      if (num_frames == 0) {
+        /* ファイル終端: 読み取れたサンプル数を返す（途中のサンプルは捨てる） */
+        break;
+      }
+      parser->deinterleave(bytes, data, format->num_channels, sample, num_frames);
+      WAVParser_SkipBytes(parser, num_frames * frame_bytes);
+      sample += num_frames;
+    }
+    *num_read_samples = sample;
+    return WAV_ERROR_OK;
+  }
+
   /* データ読み取り */
-  bytes_per_sample = wavfile->format.bits_per_sample / 8;
-  for (sample = 0; sample < wavfile->format.num_samples; sample++) {
-    for (ch = 0; ch < wavfile->format.num_channels; ch++) {
+  for (sample = 0; sample < num_samples; sample++) {
+    for (ch = 0; ch < format->num_channels; ch++) {
       if (WAVParser_GetLittleEndianBytes(parser, bytes_per_sample, &bitsbuf) != WAV_ERROR_OK) {
-        return WAV_ERROR_IO;
+        /* ファイル終端: 読み取れたサンプル数を返す（途中のサンプルは捨てる） */
+        *num_read_samples = sample;
+        return WAV_ERROR_OK;
       }
       /* 32bit整数形式に変形してデータにセット */
-      wavfile->data[ch][sample] = convert_to_sint32_func((int32_t)(bitsbuf));
+      data[ch][sample] = convert_to_sint32_func((int32_t)(bitsbuf));
+    }
+  }
+
+  *num_read_samples = num_samples;
+  return WAV_ERROR_OK;
+}
+
+/* パーサを使用してファイルのビット幅のままPCMデータを読み取り（ファイル終端で打ち切り） */
+static WAVError WAVParser_GetNativePcmSamples(
+    struct WAVParser* parser, const struct WAVFileFormat* format,
+    uint8_t** native, uint32_t num_samples, uint32_t* num_read_samples)
+{
+  uint32_t  ch, sample, bytes_per_sample, frame_bytes, num_bytes, num_frames, shift;
+  uint64_t  bitsbuf;
+  const uint8_t* bytes;
+
+  assert((parser != NULL) && (format != NULL) && (native != NULL) && (num_read_samples != NULL));
+
+  bytes_per_sample = format->bits_per_sample / 8;
+  frame_bytes = bytes_per_sample * format->num_channels;
+
+  /* 1サンプル分の全チャンネルがバッファに収まるなら、バッファ上でまとめて並べ替える */
+  if ((frame_bytes > 0) && (frame_bytes <= WAVBITBUFFER_BUFFER_SIZE)) {
+    sample = 0;
+    while (sample < num_samples) {
+      WAVParser_PeekBytes(parser, frame_bytes, &bytes, &num_bytes);
+      num_frames = WAV_Min(num_bytes / frame_bytes, num_samples - sample);
+      if (num_frames == 0) {
+        break;
+      }
+      WAV_DeinterleaveNative(bytes, native, format->num_channels, format->bits_per_sample, sample, num_frames);
+      WAVParser_SkipBytes(parser, num_frames * frame_bytes);
+      sample += num_frames;
     }
+    *num_read_samples = sample;
+    return WAV_ERROR_OK;
+  }
+
+  /* データ読み取り（リトルエンディアンの値を上位に詰めてから符号付きで右詰めに戻す） */
+  shift = 32 - format->bits_per_sample;
+  for (sample = 0; sample < num_samples; sample++) {
+    for (ch = 0; ch < format->num_channels; ch++) {
+      if (WAVParser_GetLittleEndianBytes(parser, bytes_per_sample, &bitsbuf) != WAV_ERROR_OK) {
+        *num_read_samples = sample;
+        return WAV_ERROR_OK;
+      }
+      /* 8bitは無音に相当する128を引く */
+      if (bytes_per_sample == 1) {
+        bitsbuf ^= 0x80;
+      }
+      WAV_SetNativeSample(native[ch], format->bits_per_sample, sample,
+          (int32_t)((uint32_t)bitsbuf << shift) >> shift);
+    }
+  }
+
+  *num_read_samples = num_samples;
+  return WAV_ERROR_OK;
+}
+
+/* パーサを使用してPCMデータを読み取り */
+static WAVError WAVParser_GetWAVPcmData(
+    struct WAVParser* parser, struct WAVFile* wavfile)
+{
+  WAVError  err;
+  uint32_t  num_read_samples;
+
+  /* 引数チェック */
+  if (parser == NULL || wavfile == NULL) {
+    return WAV_ERROR_INVALID_PARAMETER;
+  }
+
+  /* データ読み取り */
+  if (wavfile->storage == WAV_STORAGE_NATIVE) {
+    err = WAVParser_GetNativePcmSamples(parser, &wavfile->format,
+        wavfile->native_data, (uint32_t)wavfile->format.num_samples, &num_read_samples);
+  } else {
+    err = WAVParser_GetPcmSamples(parser, &wavfile->format,
+        wavfile->data, (uint32_t)wavfile->format.num_samples, &num_read_samples);
+  }
+  if (err != WAV_ERROR_OK) {
+    return err;
+  }
+
+  /* 全サンプル読めなかった */
+  if (num_read_samples != wavfile->format.num_samples) {
+    return WAV_ERROR_IO;
   }
 
   return WAV_ERROR_OK;
@@ -289,6 +607,12 @@ WAVApiResult WAV_GetWAVFormatFromFile(
 
 /* ファイルからWAVファイルハンドルを作成 */
 struct WAVFile* WAV_CreateFromFile(const char* filename)
+{
+  return WAV_CreateFromFileWithStorage(filename, WAV_STORAGE_INT32);
+}
+
+/* 格納形式を指定してファイルからWAVファイルハンドルを作成 */
+struct WAVFile* WAV_CreateFromFileWithStorage(const char* filename, WAVStorage storage)
 {
   struct WAVParser      parser;
   FILE*                 fp;
@@ -312,12 +636,21 @@ struct WAVFile* WAV_CreateFromFile(const char* filename)
 
   /* ヘッダ読み取り */
   if (WAVParser_GetWAVFormat(&parser, &format) != WAV_ERROR_OK) {
+    fclose(fp);
+    return NULL;
+  }
+
+  /* サイズ不明のファイルは全体を読み込めない（ストリーム読み込みを使う） */
+  if (format.num_samples == WAV_NUM_SAMPLES_UNKNOWN) {
+    fclose(fp);
     return NULL;
   }
 
   /* ハンドル作成 */
-  wavfile = WAV_Create(&format);
+  wavfile = WAV_CreateWithStorage(&format, storage);
   if (wavfile == NULL) {
+    WAVParser_Finalize(&parser);
+    fclose(fp);
     return NULL;
   }
 
@@ -346,7 +679,13 @@ EXIT_FAILURE_WITH_DATA_RELEASE:
 /* フォーマットを指定して新規にWAVファイルハンドルを作成 */
 struct WAVFile* WAV_Create(const struct WAVFileFormat* format)
 {
-  uint32_t ch;
+  return WAV_CreateWithStorage(format, WAV_STORAGE_INT32);
+}
+
+/* フォーマットと格納形式を指定して新規にWAVファイルハンドルを作成 */
+struct WAVFile* WAV_CreateWithStorage(const struct WAVFileFormat* format, WAVStorage storage)
+{
+  uint32_t ch, bytes_per_sample;
   struct WAVFile* wavfile;
 
   /* 引数チェック */
@@ -360,6 +699,19 @@ struct WAVFile* WAV_Create(const struct WAVFileFormat* format)
     return NULL;
   }
 
+  /* サンプルの位置は32bitで表す */
+  if ((format->num_samples == WAV_NUM_SAMPLES_UNKNOWN) || (format->num_samples > 0xFFFFFFFFUL)) {
+    return NULL;
+  }
+
+  /* ファイルのビット幅で格納できるのはバイト単位のビット深度のみ */
+  if ((storage != WAV_STORAGE_INT32)
+      && ((storage != WAV_STORAGE_NATIVE)
+        || (format->bits_per_sample == 0) || (format->bits_per_sample > 32)
+        || ((format->bits_per_sample % 8) != 0))) {
+    return NULL;
+  }
+
   /* ハンドル作成 */
   wavfile = (struct WAVFile *)malloc(sizeof(struct WAVFile));
   if (wavfile == NULL) {
@@ -367,15 +719,33 @@ struct WAVFile* WAV_Create(const struct WAVFileFormat* format)
   }
 
   /* 構造体コピーによりフォーマット情報取得 */
-  wavfile->format = (*format);
+  wavfile->format       = (*format);
+  wavfile->storage      = storage;
+  wavfile->data         = NULL;
+  wavfile->native_data  = NULL;
 
   /* データ領域の割り当て */
-  wavfile->data = (WAVPcmData **)malloc(sizeof(WAVPcmData *) * format->num_channels);
+  if (storage == WAV_STORAGE_NATIVE) {
+    bytes_per_sample = format->bits_per_sample / 8;
+    wavfile->native_data = (uint8_t **)calloc(format->num_channels, sizeof(uint8_t *));
+    if (wavfile->native_data == NULL) {
+      goto EXIT_FAILURE_WITH_DATA_RELEASE;
+    }
+    for (ch = 0; ch < format->num_channels; ch++) {
+      wavfile->native_data[ch] = (uint8_t *)calloc((size_t)format->num_samples, bytes_per_sample);
+      if (wavfile->native_data[ch] == NULL) {
+        goto EXIT_FAILURE_WITH_DATA_RELEASE;
+      }
+    }
+    return wavfile;
+  }
+
+  wavfile->data = (WAVPcmData **)calloc(format->num_channels, sizeof(WAVPcmData *));
   if (wavfile->data == NULL) {
     goto EXIT_FAILURE_WITH_DATA_RELEASE;
   }
   for (ch = 0; ch < format->num_channels; ch++) {
-    wavfile->data[ch] = (WAVPcmData *)calloc(format->num_samples, sizeof(WAVPcmData));
+    wavfile->data[ch] = (WAVPcmData *)calloc((size_t)format->num_samples, sizeof(WAVPcmData));
     if (wavfile->data[ch] == NULL) {
       goto EXIT_FAILURE_WITH_DATA_RELEASE;
     }
@@ -416,81 +786,740 @@ static int32_t WAV_Convert32bitPCMto32bitPCM(int32_t in_32bitpcm)
   return in_32bitpcm;
 }
 
-/* 32bitPCM形式を8bit形式に変換（注意：返り値は32bit整数だが、8bit範囲でクリップされている） */
-static int32_t WAV_Convert32bitPCMto8bitPCM(int32_t in_32bitpcm)
+/* ファイルのビット幅の配列から1サンプルを右詰めで読み出し */
+static int32_t WAV_GetNativeSample(const uint8_t* native, uint32_t bits_per_sample, uint32_t samp)
+{
+  const uint8_t* p;
+
+  switch (bits_per_sample) {
+    case 8:
+      return ((const int8_t *)native)[samp];
+    case 16:
+      return ((const int16_t *)native)[samp];
+    case 24:
+      /* 上位に詰めてから算術右シフトで符号拡張 */
+      p = &native[3 * samp];
+      return (int32_t)(((uint32_t)p[0] << 8) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 24)) >> 8;
+    case 32:
+      return ((const int32_t *)native)[samp];
+    default:
+      assert(0);
+  }
+
+  return 0;
+}
+
+/* ファイルのビット幅の配列に右詰めの1サンプルを書き込み */
+static void WAV_SetNativeSample(uint8_t* native, uint32_t bits_per_sample, uint32_t samp, int32_t pcm)
 {
-  /* 128のオフセットを加える */
-  return ((in_32bitpcm >> 24) + 128);
+  uint8_t* p;
+
+  switch (bits_per_sample) {
+    case 8:
+      ((int8_t *)native)[samp] = (int8_t)pcm;
+      break;
+    case 16:
+      ((int16_t *)native)[samp] = (int16_t)pcm;
+      break;
+    case 24:
+      p = &native[3 * samp];
+      p[0] = (uint8_t)(pcm & 0xFF);
+      p[1] = (uint8_t)((pcm >> 8) & 0xFF);
+      p[2] = (uint8_t)((pcm >> 16) & 0xFF);
+      break;
+    case 32:
+      ((int32_t *)native)[samp] = pcm;
+      break;
+    default:
+      assert(0);
+  }
 }
 
-/* 32bitPCM形式を16bit形式に変換（注意：返り値は32bit整数だが、16bit範囲でクリップされている） */
-static int32_t WAV_Convert32bitPCMto16bitPCM(int32_t in_32bitpcm)
+/* インターリーブされたPCMのバイト列をチャンネル毎のファイルのビット幅の配列に並べ替える */
+/* 8bitは無音に相当する128を引き、16/32bitはホストのバイト順に直す（24bitはそのまま3バイトずつ写す） */
+static void WAV_DeinterleaveNative(
+    const uint8_t* bytes, uint8_t** native, uint32_t num_channels, uint32_t bits_per_sample,
+    uint32_t offset, uint32_t num_samples)
 {
-  return (in_32bitpcm >> 16);
+  uint32_t ch, smpl;
+
+  switch (bits_per_sample) {
+    case 8:
+      for (smpl = offset; smpl < offset + num_samples; smpl++) {
+        for (ch = 0; ch < num_channels; ch++) {
+          ((int8_t *)native[ch])[smpl] = (int8_t)((int32_t)bytes[0] - 128);
+          bytes += 1;
+        }
+      }
+      break;
+    case 16:
+      for (smpl = offset; smpl < offset + num_samples; smpl++) {
+        for (ch = 0; ch < num_channels; ch++) {
+          ((int16_t *)native[ch])[smpl]
+            = (int16_t)((int32_t)(((uint32_t)bytes[0] << 16) | ((uint32_t)bytes[1] << 24)) >> 16);
+          bytes += 2;
+        }
+      }
+      break;
+    case 24:
+      for (smpl = offset; smpl < offset + num_samples; smpl++) {
+        for (ch = 0; ch < num_channels; ch++) {
+          uint8_t* p = &native[ch][3 * smpl];
+          p[0] = bytes[0]; p[1] = bytes[1]; p[2] = bytes[2];
+          bytes += 3;
+        }
+      }
+      break;
+    case 32:
+      for (smpl = offset; smpl < offset + num_samples; smpl++) {
+        for (ch = 0; ch < num_channels; ch++) {
+          ((int32_t *)native[ch])[smpl] = (int32_t)((uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8)
+              | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24));
+          bytes += 4;
+        }
+      }
+      break;
+    default:
+      assert(0);
+  }
 }
 
-/* 32bitPCM形式を24bit形式に変換（注意：返り値は32bit整数だが、24bit範囲でクリップされている） */
-static int32_t WAV_Convert32bitPCMto24bitPCM(int32_t in_32bitpcm)
+/* チャンネル毎のファイルのビット幅の配列をインターリーブされたPCMのバイト列に並べ替える */
+static void WAV_InterleaveNative(
+    const uint8_t* const* native, uint32_t num_channels, uint32_t bits_per_sample,
+    uint32_t offset, uint32_t num_samples, uint8_t* bytes)
 {
-  return (in_32bitpcm >> 8);
+  uint32_t ch, smpl, pcm;
+
+  switch (bits_per_sample) {
+    case 8:
+      for (smpl = offset; smpl < offset + num_samples; smpl++) {
+        for (ch = 0; ch < num_channels; ch++) {
+          bytes[0] = (uint8_t)(((uint32_t)((const int8_t *)native[ch])[smpl] + 128) & 0xFF);
+          bytes += 1;
+        }
+      }
+      break;
+    case 16:
+      for (smpl = offset; smpl < offset + num_samples; smpl++) {
+        for (ch = 0; ch < num_channels; ch++) {
+          pcm = (uint32_t)((const int16_t *)native[ch])[smpl];
+          bytes[0] = (uint8_t)(pcm & 0xFF); bytes[1] = (uint8_t)((pcm >> 8) & 0xFF);
+          bytes += 2;
+        }
+      }
+      break;
+    case 24:
+      for (smpl = offset; smpl < offset + num_samples; smpl++) {
+        for (ch = 0; ch < num_channels; ch++) {
+          const uint8_t* p = &native[ch][3 * smpl];
+          bytes[0] = p[0]; bytes[1] = p[1]; bytes[2] = p[2];
+          bytes += 3;
+        }
+      }
+      break;
+    case 32:
+      for (smpl = offset; smpl < offset + num_samples; smpl++) {
+        for (ch = 0; ch < num_channels; ch++) {
+          pcm = (uint32_t)((const int32_t *)native[ch])[smpl];
+          bytes[0] = (uint8_t)(pcm & 0xFF);         bytes[1] = (uint8_t)((pcm >> 8) & 0xFF);
+          bytes[2] = (uint8_t)((pcm >> 16) & 0xFF); bytes[3] = (uint8_t)((pcm >> 24) & 0xFF);
+          bytes += 4;
+        }
+      }
+      break;
+    default:
+      assert(0);
+  }
 }
 
-/* パーサの初期化 */
-static void WAVParser_Initialize(struct WAVParser* parser, FILE* fp)
+/* 1サンプルの読み出し（格納形式によらず左詰めの32bit整数で返す） */
+WAVPcmData WAVFile_GetPcm(const struct WAVFile* wavfile, uint32_t samp, uint32_t ch)
 {
-  parser->fp                = fp;
-  memset(&parser->buffer, 0, sizeof(struct WAVBitBuffer));
-  parser->buffer.byte_pos   = -1;
+  assert(wavfile != NULL);
+  assert((samp < wavfile->format.num_samples) && (ch < wavfile->format.num_channels));
+
+  if (wavfile->storage == WAV_STORAGE_NATIVE) {
+    return (int32_t)((uint32_t)WAV_GetNativeSample(wavfile->native_data[ch],
+          wavfile->format.bits_per_sample, samp) << (32 - wavfile->format.bits_per_sample));
+  }
+
+  return wavfile->data[ch][samp];
 }
 
-/* パーサの使用終了 */
-static void WAVParser_Finalize(struct WAVParser* parser)
+/* 1サンプルの書き込み（pcmは左詰めの32bit整数、ファイルのビット幅を超える下位ビットは捨てる） */
+void WAVFile_SetPcm(struct WAVFile* wavfile, uint32_t samp, uint32_t ch, WAVPcmData pcm)
 {
-  parser->fp                = NULL;
-  memset(&parser->buffer, 0, sizeof(struct WAVBitBuffer));
-  parser->buffer.byte_pos   = -1;
+  assert(wavfile != NULL);
+  assert((samp < wavfile->format.num_samples) && (ch < wavfile->format.num_channels));
+
+  if (wavfile->storage == WAV_STORAGE_NATIVE) {
+    WAV_SetNativeSample(wavfile->native_data[ch], wavfile->format.bits_per_sample, samp,
+        pcm >> (32 - wavfile->format.bits_per_sample));
+    return;
+  }
+
+  wavfile->data[ch][samp] = pcm;
 }
 
-/* n_bit 取得し、結果を右詰めする */
-static WAVError WAVParser_GetBits(struct WAVParser* parser, uint32_t n_bits, uint64_t* bitsbuf)
+/* offsetサンプル目からnum_samplesサンプルを右詰めの符号付き整数でチャンネル毎の配列dataに読み出し */
+WAVApiResult WAVFile_GetRightJustifiedPcm(
+    const struct WAVFile* wavfile, uint32_t offset, uint32_t num_samples, int32_t** data)
 {
-  uint64_t tmp;
-  struct WAVBitBuffer *buf = &(parser->buffer);
+  uint32_t ch, smpl, shift;
 
   /* 引数チェック */
-  if (parser == NULL || bitsbuf == NULL || n_bits > 64) {
-    return WAV_ERROR_INVALID_PARAMETER;
+  if ((wavfile == NULL) || (data == NULL)
+      || (offset > wavfile->format.num_samples)
+      || (num_samples > wavfile->format.num_samples - offset)) {
+    return WAV_APIRESULT_INVALID_PARAMETER;
   }
 
-  /* 初回読み込み */
-  if (buf->byte_pos == -1) {
-      if (fread(buf->bytes, sizeof(uint8_t), WAVBITBUFFER_BUFFER_SIZE, parser->fp) == 0) {
-        return WAV_ERROR_IO;
+  shift = 32 - wavfile->format.bits_per_sample;
+  for (ch = 0; ch < wavfile->format.num_channels; ch++) {
+    int32_t* out = data[ch];
+    if (wavfile->storage == WAV_STORAGE_INT32) {
+      const WAVPcmData* in = &wavfile->data[ch][offset];
+      for (smpl = 0; smpl < num_samples; smpl++) {
+        out[smpl] = in[smpl] >> shift;
       }
-      buf->byte_pos   = 0;
-      buf->bit_count  = 8;
+      continue;
+    }
+    switch (wavfile->format.bits_per_sample) {
+      case 8:
+        {
+          const int8_t* in = &((const int8_t *)wavfile->native_data[ch])[offset];
+          for (smpl = 0; smpl < num_samples; smpl++) {
+            out[smpl] = in[smpl];
+          }
+        }
+        break;
+      case 16:
+        {
+          const int16_t* in = &((const int16_t *)wavfile->native_data[ch])[offset];
+          for (smpl = 0; smpl < num_samples; smpl++) {
+            out[smpl] = in[smpl];
+          }
+        }
+        break;
+      case 24:
+        {
+          const uint8_t* in = &wavfile->native_data[ch][3 * offset];
+          for (smpl = 0; smpl < num_samples; smpl++) {
+            out[smpl] = (int32_t)(((uint32_t)in[0] << 8) | ((uint32_t)in[1] << 16) | ((uint32_t)in[2] << 24)) >> 8;
+            in += 3;
+          }
+        }
+        break;
+      case 32:
+        memcpy(out, &((const int32_t *)wavfile->native_data[ch])[offset], sizeof(int32_t) * num_samples);
+        break;
+      default:
+        return WAV_APIRESULT_INVALID_FORMAT;
+    }
   }
 
-  /* 最上位ビットからデータを埋めていく
-   * 初回ループではtmpの上位ビットにセット
-   * 2回目以降は8bit単位で入力しtmpにセット */
-  tmp = 0;
-  while (n_bits > buf->bit_count) {
-    /* 上位bitから埋めていく */
+  return WAV_APIRESULT_OK;
+}
+
+/* チャンネル毎の右詰めの符号付き整数の配列dataを、offsetサンプル目からnum_samplesサンプル書き込み */
+WAVApiResult WAVFile_PutRightJustifiedPcm(
+    struct WAVFile* wavfile, uint32_t offset, uint32_t num_samples, const int32_t** data)
+{
+  uint32_t ch, smpl, shift;
+
+  /* 引数チェック */
+  if ((wavfile == NULL) || (data == NULL)
+      || (offset > wavfile->format.num_samples)
+      || (num_samples > wavfile->format.num_samples - offset)) {
+    return WAV_APIRESULT_INVALID_PARAMETER;
+  }
+
+  shift = 32 - wavfile->format.bits_per_sample;
+  for (ch = 0; ch < wavfile->format.num_channels; ch++) {
+    const int32_t* in = data[ch];
+    if (wavfile->storage == WAV_STORAGE_INT32) {
+      WAVPcmData* out = &wavfile->data[ch][offset];
+      for (smpl = 0; smpl < num_samples; smpl++) {
+        out[smpl] = (int32_t)((uint32_t)in[smpl] << shift);
+      }
+      continue;
+    }
+    switch (wavfile->format.bits_per_sample) {
+      case 8:
+        {
+          int8_t* out = &((int8_t *)wavfile->native_data[ch])[offset];
+          for (smpl = 0; smpl < num_samples; smpl++) {
+            out[smpl] = (int8_t)in[smpl];
+          }
+        }
+        break;
+      case 16:
+        {
+          int16_t* out = &((int16_t *)wavfile->native_data[ch])[offset];
+          for (smpl = 0; smpl < num_samples; smpl++) {
+            out[smpl] = (int16_t)in[smpl];
+          }
+        }
+        break;
+      case 24:
+        {
+          uint8_t* out = &wavfile->native_data[ch][3 * offset];
+          for (smpl = 0; smpl < num_samples; smpl++) {
+            out[0] = (uint8_t)(in[smpl] & 0xFF);
+            out[1] = (uint8_t)((in[smpl] >> 8) & 0xFF);
+            out[2] = (uint8_t)((in[smpl] >> 16) & 0xFF);
+            out += 3;
+          }
+        }
+        break;
+      case 32:
+        memcpy(&((int32_t *)wavfile->native_data[ch])[offset], in, sizeof(int32_t) * num_samples);
+        break;
+      default:
+        return WAV_APIRESULT_INVALID_FORMAT;
+    }
+  }
+
+  return WAV_APIRESULT_OK;
+}
+
+/* 8bitPCMの並べ替え（無音に相当する128を引いてから32bit整数に切り上げる） */
+static void WAV_Deinterleave8bit(
+    const uint8_t* bytes, WAVPcmData** data, uint32_t num_channels, uint32_t offset, uint32_t num_samples)
+{
+  uint32_t ch, smpl;
+
+  for (smpl = offset; smpl < offset + num_samples; smpl++) {
+    for (ch = 0; ch < num_channels; ch++) {
+      data[ch][smpl] = (int32_t)(((uint32_t)bytes[0] ^ 0x80UL) << 24);
+      bytes += 1;
+    }
+  }
+}
+
+/* 16bitPCMの並べ替え */
+static void WAV_Deinterleave16bit(
+    const uint8_t* bytes, WAVPcmData** data, uint32_t num_channels, uint32_t offset, uint32_t num_samples)
+{
+  uint32_t ch, smpl;
+
+  for (smpl = offset; smpl < offset + num_samples; smpl++) {
+    for (ch = 0; ch < num_channels; ch++) {
+      data[ch][smpl] = (int32_t)(((uint32_t)bytes[0] << 16) | ((uint32_t)bytes[1] << 24));
+      bytes += 2;
+    }
+  }
+}
+
+/* 24bitPCMの並べ替え */
+static void WAV_Deinterleave24bit(
+    const uint8_t* bytes, WAVPcmData** data, uint32_t num_channels, uint32_t offset, uint32_t num_samples)
+{
+  uint32_t ch, smpl;
+
+  for (smpl = offset; smpl < offset + num_samples; smpl++) {
+    for (ch = 0; ch < num_channels; ch++) {
+      data[ch][smpl] = (int32_t)(((uint32_t)bytes[0] << 8) | ((uint32_t)bytes[1] << 16) | ((uint32_t)bytes[2] << 24));
+      bytes += 3;
+    }
+  }
+}
+
+/* 32bitPCMの並べ替え */
+static void WAV_Deinterleave32bit(
+    const uint8_t* bytes, WAVPcmData** data, uint32_t num_channels, uint32_t offset, uint32_t num_samples)
+{
+  uint32_t ch, smpl;
+
+  for (smpl = offset; smpl < offset + num_samples; smpl++) {
+    for (ch = 0; ch < num_channels; ch++) {
+      data[ch][smpl] = (int32_t)((uint32_t)bytes[0] | ((uint32_t)bytes[1] << 8)
+          | ((uint32_t)bytes[2] << 16) | ((uint32_t)bytes[3] << 24));
+      bytes += 4;
+    }
+  }
+}
+
+#if defined(WAV_USE_SSE2)
+/* 16bitPCMモノラルの並べ替え（8サンプルずつ上位16bitに展開） */
+static void WAV_Deinterleave16bitMonoSSE2(
+    const uint8_t* bytes, WAVPcmData** data, uint32_t num_channels, uint32_t offset, uint32_t num_samples)
+{
+  uint32_t smpl;
+  const __m128i zero = _mm_setzero_si128();
+
+  assert(num_channels == 1);
+
+  for (smpl = 0; smpl + 8 <= num_samples; smpl += 8) {
+    const __m128i pcm = _mm_loadu_si128((const __m128i *)&bytes[2 * smpl]);
+    _mm_storeu_si128((__m128i *)&data[0][offset + smpl + 0], _mm_unpacklo_epi16(zero, pcm));
+    _mm_storeu_si128((__m128i *)&data[0][offset + smpl + 4], _mm_unpackhi_epi16(zero, pcm));
+  }
+  WAV_Deinterleave16bit(&bytes[2 * smpl], data, num_channels, offset + smpl, num_samples - smpl);
+}
+
+/* 16bitPCMステレオの並べ替え（4サンプルずつ、32bit毎に下位がL・上位がRになっている） */
+static void WAV_Deinterleave16bitStereoSSE2(
+    const uint8_t* bytes, WAVPcmData** data, uint32_t num_channels, uint32_t offset, uint32_t num_samples)
+{
+  uint32_t smpl;
+  const __m128i upper_mask = _mm_set1_epi32((int32_t)0xFFFF0000UL);
+
+  assert(num_channels == 2);
+
+  for (smpl = 0; smpl + 4 <= num_samples; smpl += 4) {
+    const __m128i pcm = _mm_loadu_si128((const __m128i *)&bytes[4 * smpl]);
+    _mm_storeu_si128((__m128i *)&data[0][offset + smpl], _mm_slli_epi32(pcm, 16));
+    _mm_storeu_si128((__m128i *)&data[1][offset + smpl], _mm_and_si128(pcm, upper_mask));
+  }
+  WAV_Deinterleave16bit(&bytes[4 * smpl], data, num_channels, offset + smpl, num_samples - smpl);
+}
+
+/* 32bitPCMステレオの並べ替え（4サンプルずつ） */
+static void WAV_Deinterleave32bitStereoSSE2(
+    const uint8_t* bytes, WAVPcmData** data, uint32_t num_channels, uint32_t offset, uint32_t num_samples)
+{
+  uint32_t smpl;
+
+  assert(num_channels == 2);
+
+  for (smpl = 0; smpl + 4 <= num_samples; smpl += 4) {
+    /* (L0 R0 L1 R1), (L2 R2 L3 R3) を (L0 L1 R0 R1), (L2 L3 R2 R3) に並べ替えてから64bit毎に組む */
+    const __m128i pcm0 = _mm_shuffle_epi32(
+        _mm_loadu_si128((const __m128i *)&bytes[8 * smpl + 0]), _MM_SHUFFLE(3, 1, 2, 0));
+    const __m128i pcm1 = _mm_shuffle_epi32(
+        _mm_loadu_si128((const __m128i *)&bytes[8 * smpl + 16]), _MM_SHUFFLE(3, 1, 2, 0));
+    _mm_storeu_si128((__m128i *)&data[0][offset + smpl], _mm_unpacklo_epi64(pcm0, pcm1));
+    _mm_storeu_si128((__m128i *)&data[1][offset + smpl], _mm_unpackhi_epi64(pcm0, pcm1));
+  }
+  WAV_Deinterleave32bit(&bytes[8 * smpl], data, num_channels, offset + smpl, num_samples - smpl);
+}
+#endif /* WAV_USE_SSE2 */
+
+/* フォーマットに合ったPCMデータの並べ替え関数を選択（未対応ならNULL） */
+static WAVDeinterleaveFunction WAV_SelectDeinterleaveFunction(const struct WAVFileFormat* format)
+{
+  assert(format != NULL);
+
+  switch (format->bits_per_sample) {
+    case 8:
+      return WAV_Deinterleave8bit;
+    case 16:
+#if defined(WAV_USE_SSE2)
+      if (format->num_channels == 1) {
+        return WAV_Deinterleave16bitMonoSSE2;
+      } else if (format->num_channels == 2) {
+        return WAV_Deinterleave16bitStereoSSE2;
+      }
+#endif
+      return WAV_Deinterleave16bit;
+    case 24:
+      return WAV_Deinterleave24bit;
+    case 32:
+#if defined(WAV_USE_SSE2)
+      if (format->num_channels == 2) {
+        return WAV_Deinterleave32bitStereoSSE2;
+      }
+#endif
+      return WAV_Deinterleave32bit;
+    default:
+      break;
+  }
+
+  return NULL;
+}
+
+/* 8bitPCMの並べ替え（無音に相当する128を足して符号なしにする） */
+static void WAV_Interleave8bit(
+    const WAVPcmData** data, uint32_t num_channels, uint32_t offset, uint32_t num_samples,
+    uint32_t shift, uint8_t* bytes)
+{
+  uint32_t ch, smpl;
+
+  for (smpl = offset; smpl < offset + num_samples; smpl++) {
+    for (ch = 0; ch < num_channels; ch++) {
+      bytes[0] = (uint8_t)(((uint32_t)(data[ch][smpl] >> shift) + 128) & 0xFF);
+      bytes += 1;
+    }
+  }
+}
+
+/* 16bitPCMの並べ替え */
+static void WAV_Interleave16bit(
+    const WAVPcmData** data, uint32_t num_channels, uint32_t offset, uint32_t num_samples,
+    uint32_t shift, uint8_t* bytes)
+{
+  uint32_t ch, smpl;
+
+  for (smpl = offset; smpl < offset + num_samples; smpl++) {
+    for (ch = 0; ch < num_channels; ch++) {
+      const uint32_t pcm = (uint32_t)(data[ch][smpl] >> shift);
+      bytes[0] = (uint8_t)((pcm >> 0) & 0xFF);
+      bytes[1] = (uint8_t)((pcm >> 8) & 0xFF);
+      bytes += 2;
+    }
+  }
+}
+
+/* 24bitPCMの並べ替え */
+static void WAV_Interleave24bit(
+    const WAVPcmData** data, uint32_t num_channels, uint32_t offset, uint32_t num_samples,
+    uint32_t shift, uint8_t* bytes)
+{
+  uint32_t ch, smpl;
+
+  for (smpl = offset; smpl < offset + num_samples; smpl++) {
+    for (ch = 0; ch < num_channels; ch++) {
+      const uint32_t pcm = (uint32_t)(data[ch][smpl] >> shift);
+      bytes[0] = (uint8_t)((pcm >>  0) & 0xFF);
+      bytes[1] = (uint8_t)((pcm >>  8) & 0xFF);
+      bytes[2] = (uint8_t)((pcm >> 16) & 0xFF);
+      bytes += 3;
+    }
+  }
+}
+
+/* 32bitPCMの並べ替え */
+static void WAV_Interleave32bit(
+    const WAVPcmData** data, uint32_t num_channels, uint32_t offset, uint32_t num_samples,
+    uint32_t shift, uint8_t* bytes)
+{
+  uint32_t ch, smpl;
+
+  for (smpl = offset; smpl < offset + num_samples; smpl++) {
+    for (ch = 0; ch < num_channels; ch++) {
+      const uint32_t pcm = (uint32_t)(data[ch][smpl] >> shift);
+      bytes[0] = (uint8_t)((pcm >>  0) & 0xFF);
+      bytes[1] = (uint8_t)((pcm >>  8) & 0xFF);
+      bytes[2] = (uint8_t)((pcm >> 16) & 0xFF);
+      bytes[3] = (uint8_t)((pcm >> 24) & 0xFF);
+      bytes += 4;
+    }
+  }
+}
+
+#if defined(WAV_USE_SSE2)
+/* 16bitPCMモノラルの並べ替え（8サンプルずつ下位16bitを詰める） */
+static void WAV_Interleave16bitMonoSSE2(
+    const WAVPcmData** data, uint32_t num_channels, uint32_t offset, uint32_t num_samples,
+    uint32_t shift, uint8_t* bytes)
+{
+  uint32_t smpl;
+  const __m128i count = _mm_cvtsi32_si128((int32_t)shift);
+
+  assert(num_channels == 1);
+
+  for (smpl = 0; smpl + 8 <= num_samples; smpl += 8) {
+    __m128i pcm0 = _mm_sra_epi32(_mm_loadu_si128((const __m128i *)&data[0][offset + smpl + 0]), count);
+    __m128i pcm1 = _mm_sra_epi32(_mm_loadu_si128((const __m128i *)&data[0][offset + smpl + 4]), count);
+    /* 飽和させずに下位16bitだけを残すため、符号拡張してからパックする */
+    pcm0 = _mm_srai_epi32(_mm_slli_epi32(pcm0, 16), 16);
+    pcm1 = _mm_srai_epi32(_mm_slli_epi32(pcm1, 16), 16);
+    _mm_storeu_si128((__m128i *)&bytes[2 * smpl], _mm_packs_epi32(pcm0, pcm1));
+  }
+  WAV_Interleave16bit(data, num_channels, offset + smpl, num_samples - smpl, shift, &bytes[2 * smpl]);
+}
+
+/* 16bitPCMステレオの並べ替え（4サンプルずつ、32bit毎に下位がL・上位がRになるように組む） */
+static void WAV_Interleave16bitStereoSSE2(
+    const WAVPcmData** data, uint32_t num_channels, uint32_t offset, uint32_t num_samples,
+    uint32_t shift, uint8_t* bytes)
+{
+  uint32_t smpl;
+  const __m128i count = _mm_cvtsi32_si128((int32_t)shift);
+  const __m128i lower_mask = _mm_set1_epi32(0xFFFF);
+
+  assert(num_channels == 2);
+
+  for (smpl = 0; smpl + 4 <= num_samples; smpl += 4) {
+    const __m128i lch = _mm_sra_epi32(_mm_loadu_si128((const __m128i *)&data[0][offset + smpl]), count);
+    const __m128i rch = _mm_sra_epi32(_mm_loadu_si128((const __m128i *)&data[1][offset + smpl]), count);
+    _mm_storeu_si128((__m128i *)&bytes[4 * smpl],
+        _mm_or_si128(_mm_and_si128(lch, lower_mask), _mm_slli_epi32(rch, 16)));
+  }
+  WAV_Interleave16bit(data, num_channels, offset + smpl, num_samples - smpl, shift, &bytes[4 * smpl]);
+}
+
+/* 32bitPCMステレオの並べ替え（4サンプルずつ） */
+static void WAV_Interleave32bitStereoSSE2(
+    const WAVPcmData** data, uint32_t num_channels, uint32_t offset, uint32_t num_samples,
+    uint32_t shift, uint8_t* bytes)
+{
+  uint32_t smpl;
+  const __m128i count = _mm_cvtsi32_si128((int32_t)shift);
+
+  assert(num_channels == 2);
+
+  for (smpl = 0; smpl + 4 <= num_samples; smpl += 4) {
+    const __m128i lch = _mm_sra_epi32(_mm_loadu_si128((const __m128i *)&data[0][offset + smpl]), count);
+    const __m128i rch = _mm_sra_epi32(_mm_loadu_si128((const __m128i *)&data[1][offset + smpl]), count);
+    _mm_storeu_si128((__m128i *)&bytes[8 * smpl +  0], _mm_unpacklo_epi32(lch, rch));
+    _mm_storeu_si128((__m128i *)&bytes[8 * smpl + 16], _mm_unpackhi_epi32(lch, rch));
+  }
+  WAV_Interleave32bit(data, num_channels, offset + smpl, num_samples - smpl, shift, &bytes[8 * smpl]);
+}
+#endif /* WAV_USE_SSE2 */
+
+/* フォーマットに合ったPCMデータの並べ替え関数を選択（未対応ならNULL） */
+static WAVInterleaveFunction WAV_SelectInterleaveFunction(const struct WAVFileFormat* format)
+{
+  assert(format != NULL);
+
+  switch (format->bits_per_sample) {
+    case 8:
+      return WAV_Interleave8bit;
+    case 16:
+#if defined(WAV_USE_SSE2)
+      if (format->num_channels == 1) {
+        return WAV_Interleave16bitMonoSSE2;
+      } else if (format->num_channels == 2) {
+        return WAV_Interleave16bitStereoSSE2;
+      }
+#endif
+      return WAV_Interleave16bit;
+    case 24:
+      return WAV_Interleave24bit;
+    case 32:
+#if defined(WAV_USE_SSE2)
+      if (format->num_channels == 2) {
+        return WAV_Interleave32bitStereoSSE2;
+      }
+#endif
+      return WAV_Interleave32bit;
+    default:
+      break;
+  }
+
+  return NULL;
+}
+
+/* パーサの初期化 */
+static void WAVParser_Initialize(struct WAVParser* parser, FILE* fp)
+{
+  parser->fp                = fp;
+  memset(&parser->buffer, 0, sizeof(struct WAVBitBuffer));
+  parser->buffer.byte_pos   = -1;
+  parser->deinterleave      = NULL;
+}
+
+/* パーサの使用終了 */
+static void WAVParser_Finalize(struct WAVParser* parser)
+{
+  parser->fp                = NULL;
+  memset(&parser->buffer, 0, sizeof(struct WAVBitBuffer));
+  parser->buffer.byte_pos   = -1;
+  parser->deinterleave      = NULL;
+}
+
+/* バッファ上で次に読むバイトの位置（バイト境界にあること） */
+static int32_t WAVParser_GetNextBytePosition(const struct WAVParser* parser)
+{
+  const struct WAVBitBuffer* buf = &(parser->buffer);
+
+  /* 未読み込みならバッファは空 */
+  if (buf->byte_pos == -1) {
+    return 0;
+  }
+
+  /* bit_countが0なら現在のバイトは読み終わっている */
+  assert((buf->bit_count == 0) || (buf->bit_count == 8));
+  return buf->byte_pos + ((buf->bit_count == 0) ? 1 : 0);
+}
+
+/* バッファ上の未読バイト列を取得 */
+/* 未読がmin_bytesに満たなければ未読分を先頭に詰めて補充する（ファイル終端ではmin_bytes未満を返す） */
+static void WAVParser_PeekBytes(
+    struct WAVParser* parser, uint32_t min_bytes, const uint8_t** bytes, uint32_t* num_bytes)
+{
+  int32_t pos, num_remain;
+  struct WAVBitBuffer *buf = &(parser->buffer);
+
+  assert((parser != NULL) && (bytes != NULL) && (num_bytes != NULL));
+  assert(min_bytes <= WAVBITBUFFER_BUFFER_SIZE);
+
+  pos = WAVParser_GetNextBytePosition(parser);
+  num_remain = ((buf->byte_pos != -1) && (pos < buf->num_bytes)) ? (buf->num_bytes - pos) : 0;
+
+  if ((uint32_t)num_remain < min_bytes) {
+    memmove(buf->bytes, &buf->bytes[pos], (size_t)num_remain);
+    buf->num_bytes = num_remain + (int32_t)fread(&buf->bytes[num_remain],
+        sizeof(uint8_t), (size_t)(WAVBITBUFFER_BUFFER_SIZE - num_remain), parser->fp);
+    pos = 0;
+    num_remain = buf->num_bytes;
+    /* ビット単位の読み込みと状態を合わせる（空ならば次の読み込みで補充させる） */
+    if (buf->num_bytes > 0) {
+      buf->byte_pos   = 0;
+      buf->bit_count  = 8;
+    } else {
+      buf->byte_pos   = -1;
+    }
+  }
+
+  *bytes      = &buf->bytes[pos];
+  *num_bytes  = (uint32_t)num_remain;
+}
+
+/* バッファ上の未読バイト列を読み進める（WAVParser_PeekBytesで得たバイト数以下であること） */
+static void WAVParser_SkipBytes(struct WAVParser* parser, uint32_t num_bytes)
+{
+  int32_t pos;
+  struct WAVBitBuffer *buf = &(parser->buffer);
+
+  assert(parser != NULL);
+
+  if (num_bytes == 0) {
+    return;
+  }
+
+  /* 最後に読んだバイトを指し、ビットは読み終わった状態にする */
+  pos = WAVParser_GetNextBytePosition(parser) + (int32_t)num_bytes;
+  assert(pos <= buf->num_bytes);
+  buf->byte_pos   = pos - 1;
+  buf->bit_count  = 0;
+}
+
+/* n_bit 取得し、結果を右詰めする */
+static WAVError WAVParser_GetBits(struct WAVParser* parser, uint32_t n_bits, uint64_t* bitsbuf)
+{
+  uint64_t tmp;
+  struct WAVBitBuffer *buf = &(parser->buffer);
+
+  /* 引数チェック */
+  if (parser == NULL || bitsbuf == NULL || n_bits > 64) {
+    return WAV_ERROR_INVALID_PARAMETER;
+  }
+
+  /* 初回読み込み */
+  if (buf->byte_pos == -1) {
+      if ((buf->num_bytes = (int32_t)fread(buf->bytes, sizeof(uint8_t), WAVBITBUFFER_BUFFER_SIZE, parser->fp)) == 0) {
+        return WAV_ERROR_IO;
+      }
+      buf->byte_pos   = 0;
+      buf->bit_count  = 8;
+  }
+
+  /* 最上位ビットからデータを埋めていく
+   * 初回ループではtmpの上位ビットにセット
+   * 2回目以降は8bit単位で入力しtmpにセット */
+  tmp = 0;
+  while (n_bits > buf->bit_count) {
+    /* 上位bitから埋めていく */
     n_bits  -= buf->bit_count;
     tmp     |= (uint64_t)WAV_GetLowerBits(buf->bit_count, buf->bytes[buf->byte_pos]) << n_bits;
 
-    /* 1バイト読み進める */
-    buf->byte_pos++;
-    buf->bit_count   = 8;
-
-    /* バッファが一杯ならば、再度読み込み */
-    if (buf->byte_pos == WAVBITBUFFER_BUFFER_SIZE) {
-      if (fread(buf->bytes, sizeof(uint8_t), WAVBITBUFFER_BUFFER_SIZE, parser->fp) == 0) {
+    /* バッファを読み切っていたら、再度読み込み */
+    if (buf->byte_pos + 1 >= buf->num_bytes) {
+      if ((buf->num_bytes = (int32_t)fread(buf->bytes, sizeof(uint8_t), WAVBITBUFFER_BUFFER_SIZE, parser->fp)) == 0) {
+        /* 読み込み位置は進めない（ファイル終端） */
         return WAV_ERROR_IO;
       }
-      buf->byte_pos = 0;
+      buf->byte_pos = -1;
     }
+
+    /* 1バイト読み進める */
+    buf->byte_pos++;
+    buf->bit_count   = 8;
   }
 
   /* 端数ビットの処理 
@@ -503,16 +1532,23 @@ static WAVError WAVParser_GetBits(struct WAVParser* parser, uint32_t n_bits, uin
 }
 
 /* シーク（fseek準拠） */
-static WAVError WAVParser_Seek(struct WAVParser* parser, int32_t offset, int32_t wherefrom)
+/* 標準入力のようにシークできない入力にも対応するため、前方へのシークは読み捨てで行う */
+static WAVError WAVParser_Seek(struct WAVParser* parser, int64_t offset, int32_t wherefrom)
 {
-  if (parser->buffer.byte_pos != -1) {
-    /* バッファに取り込んだ分先読みしているので戻す */
-    offset -= (WAVBITBUFFER_BUFFER_SIZE - (parser->buffer.byte_pos + 1));
+  uint64_t bitsbuf;
+
+  /* 現在位置から前方へのシークのみ対応 */
+  if ((wherefrom != SEEK_CUR) || (offset < 0)) {
+    return WAV_ERROR_INVALID_PARAMETER;
+  }
+
+  /* 読み捨て */
+  while (offset > 0) {
+    if (WAVParser_GetBits(parser, 8, &bitsbuf) != WAV_ERROR_OK) {
+      return WAV_ERROR_IO;
+    }
+    offset--;
   }
-  /* 移動 */
-  fseek(parser->fp, offset, wherefrom);
-  /* バッファをクリア */
-  parser->buffer.byte_pos = -1;
 
   return WAV_ERROR_OK;
 }
@@ -531,24 +1567,131 @@ void WAV_Destroy(struct WAVFile* wavfile)
 }
 
   if (wavfile != NULL) {
-    for (ch = 0; ch < wavfile->format.num_channels; ch++) {
-      NULLCHECK_AND_FREE(wavfile->data[ch]);
+    if (wavfile->data != NULL) {
+      for (ch = 0; ch < wavfile->format.num_channels; ch++) {
+        NULLCHECK_AND_FREE(wavfile->data[ch]);
+      }
+      NULLCHECK_AND_FREE(wavfile->data);
+    }
+    if (wavfile->native_data != NULL) {
+      for (ch = 0; ch < wavfile->format.num_channels; ch++) {
+        NULLCHECK_AND_FREE(wavfile->native_data[ch]);
+      }
+      NULLCHECK_AND_FREE(wavfile->native_data);
     }
-    NULLCHECK_AND_FREE(wavfile->data);
     free(wavfile);
   }
 
 #undef NULLCHECK_AND_FREE
 }
 
-/* ライタを使用してファイルフォーマットに従ったヘッダ部を出力 */
+/* pの位置からnbytesバイトのリトルエンディアンでvalを書き込む */
+static void WAV_SetLittleEndianBytes(uint8_t* p, uint32_t nbytes, uint64_t val)
+{
+  uint32_t i_byte;
+
+  for (i_byte = 0; i_byte < nbytes; i_byte++) {
+    p[i_byte] = (uint8_t)((val >> (8 * i_byte)) & 0xFF);
+  }
+}
+
+/* ヘッダのバイト列を作成し、そのバイト数を返す */
+/* data_sizeが不明（WAV_DATA_SIZE_UNKNOWN）ならサイズ欄は最大値にする
+ * RIFFでもデータが4GBを超えるならRF64にする。reserve_ds64が真ならRIFFのままでもds64チャンクと同じ大きさのJUNKチャンクを置く */
+static uint32_t WAV_MakeHeader(
+    const struct WAVFileFormat* format, uint64_t data_size, uint8_t reserve_ds64, uint8_t* header)
+{
+  uint8_t*  p = header;
+  uint32_t  header_size, bytes_per_frame;
+  uint8_t   use_ds64 = 0;
+  const uint8_t data_size_unknown = (data_size == WAV_DATA_SIZE_UNKNOWN);
+
+  bytes_per_frame = (format->bits_per_sample / 8) * format->num_channels;
+
+  if (format->container == WAV_CONTAINER_W64) {
+    /* riffのGUIDとファイルサイズ、waveのGUID */
+    memcpy(p, w64_riff_guid, 16);
+    WAV_SetLittleEndianBytes(&p[16], 8,
+        data_size_unknown ? WAV_DATA_SIZE_UNKNOWN : (WAV_W64_HEADER_SIZE + data_size));
+    memcpy(&p[24], w64_wave_guid, 16);
+    p += 40;
+    /* fmtチャンクのGUIDとサイズ（チャンクヘッダを含む） */
+    memcpy(p, w64_fmt_guid, 16);
+    WAV_SetLittleEndianBytes(&p[16], 8, WAV_W64_CHUNK_HEADER_SIZE + 16);
+    p += WAV_W64_CHUNK_HEADER_SIZE;
+  } else {
+    /* RIFFのサイズ欄に収まらなければRF64にする */
+    use_ds64 = (format->container == WAV_CONTAINER_RF64)
+      || (!data_size_unknown && (data_size > (WAV_RIFF_MAX_SIZE - WAV_DS64_HEADER_SIZE)));
+    header_size = (use_ds64 || reserve_ds64) ? WAV_DS64_HEADER_SIZE : WAV_RIFF_HEADER_SIZE;
+
+    /* ヘッダ 'R', 'I', 'F', 'F' または 'R', 'F', '6', '4' */
+    memcpy(p, use_ds64 ? "RF64" : "RIFF", 4);
+    /* ファイルサイズ-8（この要素以降のサイズ） */
+    WAV_SetLittleEndianBytes(&p[4], 4,
+        (use_ds64 || data_size_unknown) ? WAV_RIFF_MAX_SIZE : (header_size - 8 + data_size));
+    /* ヘッダ 'W', 'A', 'V', 'E' */
+    memcpy(&p[8], "WAVE", 4);
+    p += 12;
+
+    /* ds64チャンク（RIFFのサイズ、データサイズ、サンプル数、テーブル長）またはその領域を確保するJUNKチャンク */
+    if (use_ds64 || reserve_ds64) {
+      memcpy(p, use_ds64 ? "ds64" : "JUNK", 4);
+      WAV_SetLittleEndianBytes(&p[4], 4, WAV_DS64_CHUNK_SIZE);
+      memset(&p[8], 0, WAV_DS64_CHUNK_SIZE);
+      if (use_ds64 && !data_size_unknown) {
+        WAV_SetLittleEndianBytes(&p[8],  8, header_size - 8 + data_size);
+        WAV_SetLittleEndianBytes(&p[16], 8, data_size);
+        WAV_SetLittleEndianBytes(&p[24], 8, format->num_samples);
+      }
+      p += 8 + WAV_DS64_CHUNK_SIZE;
+    }
+
+    /* fmtチャンクのヘッダ 'f', 'm', 't', ' ' とバイト数 （補足）現在は16byte決め打ち */
+    memcpy(p, "fmt ", 4);
+    WAV_SetLittleEndianBytes(&p[4], 4, 16);
+    p += 8;
+  }
+
+  /* フォーマットID （補足）現在は1（リニアPCM）決め打ち */
+  WAV_SetLittleEndianBytes(&p[0], 2, 1);
+  /* チャンネル数 */
+  WAV_SetLittleEndianBytes(&p[2], 2, format->num_channels);
+  /* サンプリングレート */
+  WAV_SetLittleEndianBytes(&p[4], 4, format->sampling_rate);
+  /* データ速度（byte/sec） */
+  WAV_SetLittleEndianBytes(&p[8], 4, (uint64_t)format->sampling_rate * bytes_per_frame);
+  /* ブロックあたりサイズ数 */
+  WAV_SetLittleEndianBytes(&p[12], 2, bytes_per_frame);
+  /* 量子化ビット数（サンプルあたりのビット数） */
+  WAV_SetLittleEndianBytes(&p[14], 2, format->bits_per_sample);
+  p += 16;
+
+  /* "data" チャンクのヘッダと波形データバイト数 */
+  if (format->container == WAV_CONTAINER_W64) {
+    memcpy(p, w64_data_guid, 16);
+    WAV_SetLittleEndianBytes(&p[16], 8,
+        data_size_unknown ? WAV_DATA_SIZE_UNKNOWN : (WAV_W64_CHUNK_HEADER_SIZE + data_size));
+    p += WAV_W64_CHUNK_HEADER_SIZE;
+  } else {
+    memcpy(p, "data", 4);
+    WAV_SetLittleEndianBytes(&p[4], 4, (use_ds64 || data_size_unknown) ? WAV_RIFF_MAX_SIZE : data_size);
+    p += 8;
+  }
+
+  assert((uint32_t)(p - header) <= WAV_MAX_HEADER_SIZE);
+  return (uint32_t)(p - header);
+}
+
+/* ライタを使用してファイルフォーマットに従ったヘッダ部を出力し、そのバイト数をheader_sizeに返す */
 static WAVError WAVWriter_PutWAVHeader(
-    struct WAVWriter* writer, const struct WAVFileFormat* format)
+    struct WAVWriter* writer, const struct WAVFileFormat* format, uint8_t reserve_ds64, uint32_t* header_size)
 {
-  uint32_t filesize, pcm_data_size;
+  uint8_t   header[WAV_MAX_HEADER_SIZE];
+  uint32_t  i_byte, num_bytes;
 
   /* 引数チェック */
-  if (writer == NULL || format == NULL) {
+  if (writer == NULL || format == NULL || header_size == NULL) {
     return WAV_ERROR_INVALID_PARAMETER;
   }
 
@@ -558,107 +1701,116 @@ static WAVError WAVWriter_PutWAVHeader(
     return WAV_ERROR_INVALID_FORMAT;
   }
 
-  /* PCM データサイズ */
-  pcm_data_size 
-    = format->num_samples * (format->bits_per_sample / 8) * format->num_channels;
-
-  /* ファイルサイズ */
-  filesize 
-    = pcm_data_size
-    + 44; /* "RIFF" から ("data"のサイズ) までのフィールドのバイト数
-             拡張部分を一切含まない */
-  
-  /* ヘッダ 'R', 'I', 'F', 'F' を出力 */
-  if (WAVWriter_PutBits(writer, 'R', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
-  if (WAVWriter_PutBits(writer, 'I', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
-  if (WAVWriter_PutBits(writer, 'F', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
-  if (WAVWriter_PutBits(writer, 'F', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
-
-  /* ファイルサイズ-8（この要素以降のサイズ） */
-  if (WAVWriter_PutLittleEndianBytes(writer, 4, filesize - 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; }
-
-  /* ヘッダ 'W', 'A', 'V', 'E' を出力 */
-  if (WAVWriter_PutBits(writer, 'W', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
-  if (WAVWriter_PutBits(writer, 'A', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
-  if (WAVWriter_PutBits(writer, 'V', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
-  if (WAVWriter_PutBits(writer, 'E', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
-
-  /* fmtチャンクのヘッダ 'f', 'm', 't', ' ' を出力 */
-  if (WAVWriter_PutBits(writer, 'f', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
-  if (WAVWriter_PutBits(writer, 'm', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
-  if (WAVWriter_PutBits(writer, 't', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
-  if (WAVWriter_PutBits(writer, ' ', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
-
-  /* fmtチャンクのバイト数を出力 （補足）現在は16byte決め打ち */
-  if (WAVWriter_PutLittleEndianBytes(writer, 4, 16) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
-
-  /* フォーマットIDを出力 （補足）現在は1（リニアPCM）決め打ち */
-  if (WAVWriter_PutLittleEndianBytes(writer, 2,  1) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
-
-  /* チャンネル数 */
-  if (WAVWriter_PutLittleEndianBytes(writer, 2, format->num_channels) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
+  /* ヘッダ作成/出力 */
+  num_bytes = WAV_MakeHeader(format,
+      (format->num_samples == WAV_NUM_SAMPLES_UNKNOWN) ? WAV_DATA_SIZE_UNKNOWN
+      : (format->num_samples * (format->bits_per_sample / 8) * format->num_channels),
+      reserve_ds64, header);
+  for (i_byte = 0; i_byte < num_bytes; i_byte++) {
+    if (WAVWriter_PutBits(writer, header[i_byte], 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; }
+  }
+  *header_size = num_bytes;
 
-  /* サンプリングレート */
-  if (WAVWriter_PutLittleEndianBytes(writer, 4, format->sampling_rate) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
+  /* PCMデータの並べ替え関数はファイル毎に1度だけ決める */
+  writer->interleave = WAV_SelectInterleaveFunction(format);
 
-  /* データ速度（byte/sec） */
-  if (WAVWriter_PutLittleEndianBytes(writer, 4,
-        format->sampling_rate * (format->bits_per_sample / 8) * format->num_channels)
-      != WAV_ERROR_OK) { return WAV_ERROR_IO; }
+  return WAV_ERROR_OK;
+}
 
-  /* ブロックあたりサイズ数 */
-  if (WAVWriter_PutLittleEndianBytes(writer, 2,
-        (format->bits_per_sample / 8) * format->num_channels)
-      != WAV_ERROR_OK) { return WAV_ERROR_IO; }
+/* ライタを使用してnum_samplesサンプルのPCMデータを出力 */
+/* dataの値はshiftだけ右シフトするとファイルのビット幅の符号付き整数になっていること */
+static WAVError WAVWriter_PutPcmSamples(
+    struct WAVWriter* writer, const struct WAVFileFormat* format,
+    const WAVPcmData** data, uint32_t num_samples, uint32_t shift)
+{
+  uint32_t  ch, sample, bytes_per_sample, frame_bytes, num_frames;
+  int32_t   pcm;
+  struct WAVBitBuffer* buf = &(writer->buffer);
 
-  /* 量子化ビット数（サンプルあたりのビット数） */
-  if (WAVWriter_PutLittleEndianBytes(writer, 2, format->bits_per_sample) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
+  /* 未対応のビット深度では並べ替え関数が決まっていない */
+  if (writer->interleave == NULL) {
+    /* fprintf(stderr, "Unsupported bits per sample format(=%d). \n", format->bits_per_sample); */
+    return WAV_ERROR_INVALID_FORMAT;
+  }
 
-  /* "data" チャンクのヘッダ出力 */
-  if (WAVWriter_PutBits(writer, 'd', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
-  if (WAVWriter_PutBits(writer, 'a', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
-  if (WAVWriter_PutBits(writer, 't', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
-  if (WAVWriter_PutBits(writer, 'a', 8) != WAV_ERROR_OK) { return WAV_ERROR_IO; };
+  bytes_per_sample = format->bits_per_sample / 8;
+  frame_bytes = bytes_per_sample * format->num_channels;
+
+  /* バイト境界にあり、1サンプル分の全チャンネルがバッファに収まるなら、バッファ上に直接並べる */
+  if ((writer->bit_count == 8) && (frame_bytes > 0) && (frame_bytes <= WAVBITBUFFER_BUFFER_SIZE)) {
+    sample = 0;
+    while (sample < num_samples) {
+      num_frames = WAV_Min((WAVBITBUFFER_BUFFER_SIZE - (uint32_t)buf->byte_pos) / frame_bytes, num_samples - sample);
+      if (num_frames == 0) {
+        /* バッファが一杯になったら書き出し */
+        if (WAVWriter_Flush(writer) != WAV_ERROR_OK) {
+          return WAV_ERROR_IO;
+        }
+        continue;
+      }
+      writer->interleave(data, format->num_channels, sample, num_frames, shift, &buf->bytes[buf->byte_pos]);
+      buf->byte_pos += (int32_t)(num_frames * frame_bytes);
+      sample += num_frames;
+    }
+    return WAV_ERROR_OK;
+  }
 
-  /* 波形データバイト数 */
-  if (WAVWriter_PutLittleEndianBytes(writer, 4, pcm_data_size) != WAV_ERROR_OK) { return WAV_ERROR_IO; }
+  /* チャンネルインターリーブしつつ出力 */
+  for (sample = 0; sample < num_samples; sample++) {
+    for (ch = 0; ch < format->num_channels; ch++) {
+      pcm = data[ch][sample] >> shift;
+      /* 8bitは無音に相当する128のオフセットを加える */
+      if (bytes_per_sample == 1) {
+        pcm += 128;
+      }
+      if (WAVWriter_PutLittleEndianBytes(writer, bytes_per_sample, (uint64_t)pcm) != WAV_ERROR_OK) {
+        return WAV_ERROR_IO;
+      }
+    }
+  }
 
   return WAV_ERROR_OK;
 }
 
-/* ライタを使用してPCMデータ出力 */
-static WAVError WAVWriter_PutWAVPcmData(
-    struct WAVWriter* writer, const struct WAVFile* wavfile)
+/* ライタを使用してファイルのビット幅の配列からPCMデータ出力 */
+static WAVError WAVWriter_PutNativePcmSamples(
+    struct WAVWriter* writer, const struct WAVFileFormat* format,
+    const uint8_t* const* native, uint32_t num_samples)
 {
-  uint32_t  ch, sample, bytes_per_sample;
-  int32_t   (*convert_sint32_to_pcmdata_func)(int32_t);
-
-  /* ビット深度に合わせてPCMデータの変換関数を決定 */
-  switch (wavfile->format.bits_per_sample) {
-    case 8:
-      convert_sint32_to_pcmdata_func = WAV_Convert32bitPCMto8bitPCM;
-      break;
-    case 16:
-      convert_sint32_to_pcmdata_func = WAV_Convert32bitPCMto16bitPCM;
-      break;
-    case 24:
-      convert_sint32_to_pcmdata_func = WAV_Convert32bitPCMto24bitPCM;
-      break;
-    case 32:
-      convert_sint32_to_pcmdata_func = WAV_Convert32bitPCMto32bitPCM;
-      break;
-    default:
-      /* fprintf(stderr, "Unsupported bits per sample format(=%d). \n", wavfile->format.bits_per_sample); */
-      return WAV_ERROR_INVALID_FORMAT;
+  uint32_t  ch, sample, bytes_per_sample, frame_bytes, num_frames;
+  int32_t   pcm;
+  struct WAVBitBuffer* buf = &(writer->buffer);
+
+  bytes_per_sample = format->bits_per_sample / 8;
+  frame_bytes = bytes_per_sample * format->num_channels;
+
+  /* バイト境界にあり、1サンプル分の全チャンネルがバッファに収まるなら、バッファ上に直接並べる */
+  if ((writer->bit_count == 8) && (frame_bytes > 0) && (frame_bytes <= WAVBITBUFFER_BUFFER_SIZE)) {
+    sample = 0;
+    while (sample < num_samples) {
+      num_frames = WAV_Min((WAVBITBUFFER_BUFFER_SIZE - (uint32_t)buf->byte_pos) / frame_bytes, num_samples - sample);
+      if (num_frames == 0) {
+        if (WAVWriter_Flush(writer) != WAV_ERROR_OK) {
+          return WAV_ERROR_IO;
+        }
+        continue;
+      }
+      WAV_InterleaveNative(native, format->num_channels, format->bits_per_sample,
+          sample, num_frames, &buf->bytes[buf->byte_pos]);
+      buf->byte_pos += (int32_t)(num_frames * frame_bytes);
+      sample += num_frames;
+    }
+    return WAV_ERROR_OK;
   }
 
   /* チャンネルインターリーブしつつ出力 */
-  bytes_per_sample = wavfile->format.bits_per_sample / 8;
-  for (sample = 0; sample < wavfile->format.num_samples; sample++) {
-    for (ch = 0; ch < wavfile->format.num_channels; ch++) {
-      if (WAVWriter_PutLittleEndianBytes(writer,
-            bytes_per_sample,
-            (uint64_t)convert_sint32_to_pcmdata_func(WAVFile_PCM(wavfile, sample, ch))) != WAV_ERROR_OK) {
+  for (sample = 0; sample < num_samples; sample++) {
+    for (ch = 0; ch < format->num_channels; ch++) {
+      pcm = WAV_GetNativeSample(native[ch], format->bits_per_sample, sample);
+      if (bytes_per_sample == 1) {
+        pcm += 128;
+      }
+      if (WAVWriter_PutLittleEndianBytes(writer, bytes_per_sample, (uint64_t)pcm) != WAV_ERROR_OK) {
         return WAV_ERROR_IO;
       }
     }
@@ -667,12 +1819,26 @@ static WAVError WAVWriter_PutWAVPcmData(
   return WAV_ERROR_OK;
 }
 
+/* ライタを使用してPCMデータ出力 */
+static WAVError WAVWriter_PutWAVPcmData(
+    struct WAVWriter* writer, const struct WAVFile* wavfile)
+{
+  if (wavfile->storage == WAV_STORAGE_NATIVE) {
+    return WAVWriter_PutNativePcmSamples(writer, &wavfile->format,
+        (const uint8_t* const*)wavfile->native_data, (uint32_t)wavfile->format.num_samples);
+  }
+  return WAVWriter_PutPcmSamples(writer,
+      &wavfile->format, (const WAVPcmData **)wavfile->data, (uint32_t)wavfile->format.num_samples,
+      32 - wavfile->format.bits_per_sample);
+}
+
 /* ファイル書き出し */
 WAVApiResult WAV_WriteToFile(
     const char* filename, const struct WAVFile* wavfile)
 {
   struct WAVWriter  writer;
   FILE*             fp;
+  uint32_t          header_size;
   
   /* 引数チェック */
   if (filename == NULL || wavfile == NULL) {
@@ -690,7 +1856,7 @@ WAVApiResult WAV_WriteToFile(
   WAVWriter_Initialize(&writer, fp);
 
   /* ヘッダ書き出し */
-  if (WAVWriter_PutWAVHeader(&writer, &wavfile->format) != WAV_ERROR_OK) {
+  if (WAVWriter_PutWAVHeader(&writer, &wavfile->format, 0, &header_size) != WAV_ERROR_OK) {
     return WAV_APIRESULT_NG;
   }
 
@@ -717,6 +1883,7 @@ static void WAVWriter_Initialize(struct WAVWriter* writer, FILE* fp)
   writer->bit_buffer        = 0;
   memset(&writer->buffer, 0, sizeof(struct WAVBitBuffer));
   writer->buffer.byte_pos   = 0;
+  writer->interleave        = NULL;
 }
 
 /* ライタの終了 */
@@ -731,6 +1898,7 @@ static void WAVWriter_Finalize(struct WAVWriter* writer)
   writer->bit_buffer      = 0;
   memset(&writer->buffer, 0, sizeof(struct WAVBitBuffer));
   writer->buffer.byte_pos = 0;
+  writer->interleave      = NULL;
 }
 
 /* valの下位n_bitを書き込む（ビッグエンディアンで） */
@@ -831,6 +1999,16 @@ static WAVError WAVParser_GetLittleEndianBytes(
   uint64_t tmp, ret;
   uint32_t i_byte;
 
+  /* 4バイトを超える値はビット読み込みのシフト幅が型の幅に達しないよう下位/上位に分けて取得 */
+  if (nbytes > 4) {
+    if ((WAVParser_GetLittleEndianBytes(parser, 4, &ret) != WAV_ERROR_OK)
+        || (WAVParser_GetLittleEndianBytes(parser, nbytes - 4, &tmp) != WAV_ERROR_OK)) {
+      return WAV_ERROR_IO;
+    }
+    *bitsbuf = ret | (tmp << 32);
+    return WAV_ERROR_OK;
+  }
+
   /* ビッグエンディアンで取得 */
   if (WAVParser_GetBits(parser, nbytes * 8, &tmp) != WAV_ERROR_OK) {
     return WAV_ERROR_IO; 
@@ -891,3 +2069,275 @@ static WAVError WAVParser_CheckSignatureString(
 
   return WAV_ERROR_OK;
 }
+
+/* ファイル名に対応するファイルポインタを取得（"-"のときは標準入出力） */
+static FILE* WAV_OpenFile(const char* filename, const char* mode, uint8_t* is_standard_stream)
+{
+  if (strcmp(filename, "-") == 0) {
+    *is_standard_stream = 1;
+    return (mode[0] == 'r') ? stdin : stdout;
+  }
+
+  *is_standard_stream = 0;
+  return fopen(filename, mode);
+}
+
+/* ストリーム読み込みハンドルの作成 */
+struct WAVStreamReader* WAVStreamReader_Open(const char* filename)
+{
+  struct WAVStreamReader* reader;
+
+  /* 引数チェック */
+  if (filename == NULL) {
+    return NULL;
+  }
+
+  reader = (struct WAVStreamReader *)malloc(sizeof(struct WAVStreamReader));
+  if (reader == NULL) {
+    return NULL;
+  }
+
+  /* wavファイルを開く */
+  reader->fp = WAV_OpenFile(filename, "rb", &reader->is_standard_stream);
+  if (reader->fp == NULL) {
+    free(reader);
+    return NULL;
+  }
+
+  /* パーサ初期化/ヘッダ読み取り */
+  WAVParser_Initialize(&reader->parser, reader->fp);
+  if (WAVParser_GetWAVFormat(&reader->parser, &reader->format) != WAV_ERROR_OK) {
+    WAVStreamReader_Close(reader);
+    return NULL;
+  }
+  reader->num_read_samples = 0;
+
+  return reader;
+}
+
+/* ストリーム読み込みハンドルの破棄 */
+void WAVStreamReader_Close(struct WAVStreamReader* reader)
+{
+  if (reader != NULL) {
+    WAVParser_Finalize(&reader->parser);
+    if (!reader->is_standard_stream) {
+      fclose(reader->fp);
+    }
+    free(reader);
+  }
+}
+
+/* フォーマットの取得 */
+/* サンプル数が不明な場合はnum_samplesにWAV_NUM_SAMPLES_UNKNOWNが入る */
+WAVApiResult WAVStreamReader_GetFormat(
+    const struct WAVStreamReader* reader, struct WAVFileFormat* format)
+{
+  /* 引数チェック */
+  if (reader == NULL || format == NULL) {
+    return WAV_APIRESULT_INVALID_PARAMETER;
+  }
+
+  *format = reader->format;
+  return WAV_APIRESULT_OK;
+}
+
+/* 最大num_samplesサンプルのPCMデータを読み込み */
+WAVApiResult WAVStreamReader_GetPcmData(
+    struct WAVStreamReader* reader,
+    WAVPcmData** data, uint32_t num_samples, uint32_t* num_read_samples)
+{
+  /* 引数チェック */
+  if (reader == NULL || data == NULL || num_read_samples == NULL) {
+    return WAV_APIRESULT_INVALID_PARAMETER;
+  }
+
+  /* サイズが分かっている場合は、データチャンクの後ろを読まないよう制限 */
+  if (reader->format.num_samples != WAV_NUM_SAMPLES_UNKNOWN) {
+    num_samples = (uint32_t)WAV_Min((uint64_t)num_samples, reader->format.num_samples - reader->num_read_samples);
+  }
+
+  /* データ読み取り */
+  if (WAVParser_GetPcmSamples(&reader->parser, &reader->format,
+        data, num_samples, num_read_samples) != WAV_ERROR_OK) {
+    return WAV_APIRESULT_NG;
+  }
+  reader->num_read_samples += (*num_read_samples);
+
+  return WAV_APIRESULT_OK;
+}
+
+/* 書き出したサンプル数でヘッダを作り直して上書き */
+/* ヘッダの大きさが変わる場合（RIFFのヘッダを確保せずに4GBを超えた場合）は書き換えられない */
+static WAVError WAVStreamWriter_RewriteHeader(struct WAVStreamWriter* writer)
+{
+  uint8_t   header[WAV_MAX_HEADER_SIZE];
+  uint32_t  header_size;
+  struct WAVFileFormat format = writer->format;
+
+  format.num_samples = writer->num_written_samples;
+  header_size = WAV_MakeHeader(&format,
+      format.num_samples * (format.bits_per_sample / 8) * format.num_channels,
+      writer->reserve_ds64, header);
+  if (header_size != writer->header_size) {
+    return WAV_ERROR_INVALID_FORMAT;
+  }
+
+  if (fseek(writer->fp, 0, SEEK_SET) != 0) {
+    return WAV_ERROR_IO;
+  }
+  if (fwrite(header, sizeof(uint8_t), header_size, writer->fp) < header_size) {
+    return WAV_ERROR_IO;
+  }
+
+  return WAV_ERROR_OK;
+}
+
+/* ストリーム書き出しハンドルの作成（ヘッダを書き出す） */
+/* formatのnum_samplesはWAV_NUM_SAMPLES_UNKNOWNでもよい */
+struct WAVStreamWriter* WAVStreamWriter_Open(
+    const char* filename, const struct WAVFileFormat* format)
+{
+  struct WAVStreamWriter* writer;
+
+  /* 引数チェック */
+  if (filename == NULL || format == NULL) {
+    return NULL;
+  }
+
+  writer = (struct WAVStreamWriter *)malloc(sizeof(struct WAVStreamWriter));
+  if (writer == NULL) {
+    return NULL;
+  }
+
+  /* wavファイルを開く */
+  writer->fp = WAV_OpenFile(filename, "wb", &writer->is_standard_stream);
+  if (writer->fp == NULL) {
+    free(writer);
+    return NULL;
+  }
+
+  /* ライタ初期化/ヘッダ書き出し */
+  /* サイズ不明のRIFFをシーク可能な出力に書き出すときは、閉じるときにRF64に書き換えられるようにする */
+  writer->format              = (*format);
+  writer->num_written_samples = 0;
+  writer->reserve_ds64        = (format->container == WAV_CONTAINER_RIFF)
+    && (format->num_samples == WAV_NUM_SAMPLES_UNKNOWN) && (fseek(writer->fp, 0, SEEK_CUR) == 0);
+  WAVWriter_Initialize(&writer->writer, writer->fp);
+  if (WAVWriter_PutWAVHeader(&writer->writer,
+        &writer->format, writer->reserve_ds64, &writer->header_size) != WAV_ERROR_OK) {
+    WAVWriter_Finalize(&writer->writer);
+    if (!writer->is_standard_stream) {
+      fclose(writer->fp);
+    }
+    free(writer);
+    return NULL;
+  }
+
+  return writer;
+}
+
+/* PCMデータの書き出し */
+WAVApiResult WAVStreamWriter_PutPcmData(
+    struct WAVStreamWriter* writer, const WAVPcmData** data, uint32_t num_samples)
+{
+  /* 引数チェック */
+  if (writer == NULL || data == NULL) {
+    return WAV_APIRESULT_INVALID_PARAMETER;
+  }
+
+  if (WAVWriter_PutPcmSamples(&writer->writer,
+        &writer->format, data, num_samples, 32 - writer->format.bits_per_sample) != WAV_ERROR_OK) {
+    return WAV_APIRESULT_IOERROR;
+  }
+  writer->num_written_samples += num_samples;
+
+  return WAV_APIRESULT_OK;
+}
+
+/* 右詰めのPCMデータの書き出し */
+WAVApiResult WAVStreamWriter_PutRightJustifiedPcmData(
+    struct WAVStreamWriter* writer, const int32_t** data, uint32_t num_samples)
+{
+  /* 引数チェック */
+  if (writer == NULL || data == NULL) {
+    return WAV_APIRESULT_INVALID_PARAMETER;
+  }
+
+  /* ファイルのビット幅の値をそのまま詰める */
+  if (WAVWriter_PutPcmSamples(&writer->writer,
+        &writer->format, data, num_samples, 0) != WAV_ERROR_OK) {
+    return WAV_APIRESULT_IOERROR;
+  }
+  writer->num_written_samples += num_samples;
+
+  return WAV_APIRESULT_OK;
+}
+
+/* インターリーブ済みのPCMデータの書き出し */
+WAVApiResult WAVStreamWriter_PutInterleavedPcmData(
+    struct WAVStreamWriter* writer, const uint8_t* bytes, uint32_t num_samples)
+{
+  size_t num_bytes;
+
+  /* 引数チェック */
+  if (writer == NULL || bytes == NULL) {
+    return WAV_APIRESULT_INVALID_PARAMETER;
+  }
+
+  /* 未対応のビット深度では並べ替え関数が決まっていない */
+  if (writer->writer.interleave == NULL) {
+    return WAV_APIRESULT_INVALID_FORMAT;
+  }
+
+  /* バッファに残ったデータを先に出してから直接書き出す */
+  num_bytes = (size_t)num_samples * (writer->format.bits_per_sample / 8) * writer->format.num_channels;
+  if ((WAVWriter_Flush(&writer->writer) != WAV_ERROR_OK)
+      || (fwrite(bytes, sizeof(uint8_t), num_bytes, writer->fp) < num_bytes)) {
+    return WAV_APIRESULT_IOERROR;
+  }
+  writer->num_written_samples += num_samples;
+
+  return WAV_APIRESULT_OK;
+}
+
+/* ストリーム書き出しハンドルの破棄 */
+/* 書き出したサンプル数がヘッダと異なり、かつシーク可能ならばヘッダのサイズ欄を修正する */
+WAVApiResult WAVStreamWriter_Close(struct WAVStreamWriter* writer)
+{
+  WAVApiResult ret = WAV_APIRESULT_OK;
+
+  /* 引数チェック */
+  if (writer == NULL) {
+    return WAV_APIRESULT_INVALID_PARAMETER;
+  }
+
+  /* バッファに残ったデータを書き出し */
+  WAVWriter_Finalize(&writer->writer);
+
+  /* ヘッダのサイズ欄の修正 */
+  if (writer->num_written_samples != writer->format.num_samples) {
+    /* シークできない出力ではサイズ不明のまま */
+    if (WAVStreamWriter_RewriteHeader(writer) == WAV_ERROR_OK) {
+      fseek(writer->fp, 0, SEEK_END);
+    } else if (!writer->is_standard_stream) {
+      ret = WAV_APIRESULT_IOERROR;
+    }
+  }
+
+  /* これまでの書き出しの失敗 */
+  if (ferror(writer->fp)) {
+    ret = WAV_APIRESULT_IOERROR;
+  }
+
+  /* ファイルを閉じる 閉じる際のバッファ書き出しの失敗も報告する */
+  if (writer->is_standard_stream) {
+    if (fflush(writer->fp) != 0) {
+      ret = WAV_APIRESULT_IOERROR;
+    }
+  } else if (fclose(writer->fp) != 0) {
+    ret = WAV_APIRESULT_IOERROR;
+  }
+  free(writer);
+
+  return ret;
+}
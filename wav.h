@@ -6,11 +6,27 @@
 /* PCM型 - ファイルのビット深度如何によらず、メモリ上では全て符号付き32bitで取り扱う */
 typedef int32_t WAVPcmData;
 
+/* サンプル数が不明（ストリーミング入出力）であることを示す値 */
+#define WAV_NUM_SAMPLES_UNKNOWN   (~(uint64_t)0)
+
 /* WAVデータのフォーマット */
 typedef enum WAVDataFormatTag {
   WAV_DATA_FORMAT_PCM             /* PCMのみ対応 */
 } WAVDataFormat;
 
+/* WAVファイルのコンテナ形式 */
+typedef enum WAVContainerTag {
+  WAV_CONTAINER_RIFF = 0,         /* RIFF（データが4GBを超える場合は書き出し時にRF64にする） */
+  WAV_CONTAINER_RF64,             /* RF64（EBU Tech 3306、ds64チャンクに64bitのサイズを持つ） */
+  WAV_CONTAINER_W64               /* Sony Wave64（GUIDのチャンクIDと64bitのチャンクサイズ） */
+} WAVContainer;
+
+/* WAVファイルハンドルのPCMデータの格納形式 */
+typedef enum WAVStorageTag {
+  WAV_STORAGE_INT32 = 0,          /* チャンネル毎に左詰めの32bit整数（WAVPcmData）で格納 */
+  WAV_STORAGE_NATIVE              /* チャンネル毎にファイルのビット幅のまま格納 */
+} WAVStorage;
+
 /* API結果型 */
 typedef enum WAVApiResultTag {
   WAV_APIRESULT_OK = 0,
@@ -26,16 +42,27 @@ struct WAVFileFormat {
   uint32_t      num_channels;     /* チャンネル数 */
   uint32_t      sampling_rate;    /* サンプリングレート */
   uint32_t      bits_per_sample;  /* 量子化ビット数 */
-  uint32_t      num_samples;      /* サンプル数 */
+  uint64_t      num_samples;      /* サンプル数 */
+  WAVContainer  container;        /* コンテナ形式（読み込み時はファイルの形式が入る） */
 };
 
 /* WAVファイルハンドル */
+/* WAV_STORAGE_NATIVEのnative_data[ch]は、8bitはint8_t、16bitはint16_t、32bitはint32_tの配列（ホストのバイト順）、
+ * 24bitは1サンプル3バイトのリトルエンディアンのバイト列で、値は右詰めの符号付き整数（8bitも128のオフセットを含まない） */
 struct WAVFile {
-  struct WAVFileFormat  format;   /* フォーマット */
-  WAVPcmData**          data;     /* 実データ     */
+  struct WAVFileFormat  format;       /* フォーマット */
+  WAVStorage            storage;      /* 格納形式 */
+  WAVPcmData**          data;         /* 実データ（WAV_STORAGE_INT32のみ、それ以外はNULL） */
+  uint8_t**             native_data;  /* ファイルのビット幅の実データ（WAV_STORAGE_NATIVEのみ、それ以外はNULL） */
 };
 
-/* アクセサ */
+/* ストリーム読み込みハンドル */
+struct WAVStreamReader;
+
+/* ストリーム書き出しハンドル */
+struct WAVStreamWriter;
+
+/* アクセサ（WAV_STORAGE_INT32のみ。格納形式によらない読み書きはWAVFile_GetPcm/WAVFile_SetPcmを使う） */
 #define WAVFile_PCM(wavfile, samp, ch)  (wavfile->data[(ch)][(samp)])
 
 #ifdef __cplusplus
@@ -48,6 +75,14 @@ struct WAVFile* WAV_CreateFromFile(const char* filename);
 /* フォーマットを指定して新規にWAVファイルハンドルを作成 */
 struct WAVFile* WAV_Create(const struct WAVFileFormat* format);
 
+/* 格納形式を指定してファイルからWAVファイルハンドルを作成 */
+/* WAV_STORAGE_NATIVEは8/16/24/32bitのみ対応し、16bitではWAV_STORAGE_INT32の半分のメモリで済む */
+/* メモリ上に展開できるのは2^32サンプル未満のファイルに限る（それより長いファイルはストリーム読み込みを使う） */
+struct WAVFile* WAV_CreateFromFileWithStorage(const char* filename, WAVStorage storage);
+
+/* フォーマットと格納形式を指定して新規にWAVファイルハンドルを作成 */
+struct WAVFile* WAV_CreateWithStorage(const struct WAVFileFormat* format, WAVStorage storage);
+
 /* WAVファイルハンドルを破棄 */
 void WAV_Destroy(struct WAVFile* wavfile);
 
@@ -55,10 +90,72 @@ void WAV_Destroy(struct WAVFile* wavfile);
 WAVApiResult WAV_WriteToFile(
     const char* filename, const struct WAVFile* wavfile);
 
+/* 1サンプルの読み出し（格納形式によらず左詰めの32bit整数で返す） */
+WAVPcmData WAVFile_GetPcm(const struct WAVFile* wavfile, uint32_t samp, uint32_t ch);
+
+/* 1サンプルの書き込み（pcmは左詰めの32bit整数、ファイルのビット幅を超える下位ビットは捨てる） */
+void WAVFile_SetPcm(struct WAVFile* wavfile, uint32_t samp, uint32_t ch, WAVPcmData pcm);
+
+/* offsetサンプル目からnum_samplesサンプルを右詰めの符号付き整数でチャンネル毎の配列dataに読み出し */
+/* 値はエンコーダの入力と同じ形式（bits_per_sampleビットの符号付き整数）で、ブロック毎に取り出して使う */
+WAVApiResult WAVFile_GetRightJustifiedPcm(
+    const struct WAVFile* wavfile, uint32_t offset, uint32_t num_samples, int32_t** data);
+
+/* チャンネル毎の右詰めの符号付き整数の配列dataを、offsetサンプル目からnum_samplesサンプル書き込み */
+/* 値はデコーダの出力と同じ形式で、ブロック毎に書き込んで使う */
+WAVApiResult WAVFile_PutRightJustifiedPcm(
+    struct WAVFile* wavfile, uint32_t offset, uint32_t num_samples, const int32_t** data);
+
 /* ファイルからWAVファイルフォーマットだけ読み取り */
 WAVApiResult WAV_GetWAVFormatFromFile(
     const char* filename, struct WAVFileFormat* format);
 
+/* ストリーム読み込みハンドルの作成（ヘッダまで読み込む） */
+/* ファイル名が"-"のときは標準入力から読み込む */
+/* RIFF/RF64/W64のいずれも読み込め、ファイルの大きさによらず使用するメモリは一定 */
+struct WAVStreamReader* WAVStreamReader_Open(const char* filename);
+
+/* ストリーム読み込みハンドルの破棄 */
+void WAVStreamReader_Close(struct WAVStreamReader* reader);
+
+/* フォーマットの取得 */
+/* サンプル数が不明な場合はnum_samplesにWAV_NUM_SAMPLES_UNKNOWNが入る */
+WAVApiResult WAVStreamReader_GetFormat(
+    const struct WAVStreamReader* reader, struct WAVFileFormat* format);
+
+/* 最大num_samplesサンプルのPCMデータを読み込み */
+/* 実際に読み込んだサンプル数をnum_read_samplesに返す（0ならばデータ終端） */
+WAVApiResult WAVStreamReader_GetPcmData(
+    struct WAVStreamReader* reader,
+    WAVPcmData** data, uint32_t num_samples, uint32_t* num_read_samples);
+
+/* ストリーム書き出しハンドルの作成（ヘッダを書き出す） */
+/* ファイル名が"-"のときは標準出力に書き出す */
+/* formatのnum_samplesはWAV_NUM_SAMPLES_UNKNOWNでもよい */
+/* RIFFでサンプル数が不明かつシーク可能な出力では、ヘッダにds64チャンク分の領域（JUNKチャンク）を確保しておき、
+ * 書き出したデータが4GBを超えたらWAVStreamWriter_CloseでRF64に書き換える */
+struct WAVStreamWriter* WAVStreamWriter_Open(
+    const char* filename, const struct WAVFileFormat* format);
+
+/* PCMデータの書き出し */
+WAVApiResult WAVStreamWriter_PutPcmData(
+    struct WAVStreamWriter* writer, const WAVPcmData** data, uint32_t num_samples);
+
+/* 右詰めのPCMデータの書き出し */
+/* dataの値はbits_per_sampleビットの符号付き整数（8bitでも128のオフセットを含まない） */
+/* 32bitへの左詰めを経由せずにファイルのビット幅に詰めて書き出す */
+WAVApiResult WAVStreamWriter_PutRightJustifiedPcmData(
+    struct WAVStreamWriter* writer, const int32_t** data, uint32_t num_samples);
+
+/* インターリーブ済みのPCMデータの書き出し */
+/* bytesはWAVのデータチャンクと同じ形式のnum_samplesサンプル分のバイト列で、そのまま書き出す */
+WAVApiResult WAVStreamWriter_PutInterleavedPcmData(
+    struct WAVStreamWriter* writer, const uint8_t* bytes, uint32_t num_samples);
+
+/* ストリーム書き出しハンドルの破棄 */
+/* 書き出したサンプル数がヘッダと異なり、かつシーク可能ならばヘッダのサイズ欄を修正する */
+WAVApiResult WAVStreamWriter_Close(struct WAVStreamWriter* writer);
+
 #ifdef __cplusplus
 }
 #endif